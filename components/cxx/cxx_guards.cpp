@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -8,18 +8,28 @@
 #include <assert.h>
 #include <cxxabi.h>
 #include <stdint.h>
-#include <limits.h>
 #include <algorithm>
-#include <sys/lock.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include "freertos/task.h"
 
 using __cxxabiv1::__guard;
 
-static SemaphoreHandle_t s_static_init_mutex = NULL;        //!< lock used for the critical section
-static SemaphoreHandle_t s_static_init_wait_sem = NULL;     //!< counting semaphore used by the waiting tasks
-static portMUX_TYPE s_init_spinlock = portMUX_INITIALIZER_UNLOCKED;   //!< spinlock used to guard initialization of the above two primitives
+/**
+ * Task waiting for the initialization of a static object by another task.
+ *
+ * Waiters live on the stack of the waiting task, and are linked in s_static_init_waiters
+ * while the task is blocked on its semaphore.
+ */
+typedef struct guard_waiter {
+    const void* guard;                  //!< guard object the task waits for
+    SemaphoreHandle_t sem;              //!< given when the guard object is not pending anymore
+    StaticSemaphore_t sem_buffer;       //!< storage of the above semaphore
+    struct guard_waiter* next;          //!< next waiter in s_static_init_waiters
+} guard_waiter_t;
+
+static portMUX_TYPE s_static_init_spinlock = portMUX_INITIALIZER_UNLOCKED;    //!< spinlock protecting the list of waiters
+static guard_waiter_t* s_static_init_waiters = NULL;        //!< tasks waiting for any guard object
 static size_t s_static_init_waiting_count = 0;              //!< number of tasks which are waiting for static init guards
 #ifndef _NDEBUG
 static size_t s_static_init_max_waiting_count = 0;          //!< maximum ever value of the above; can be inspected using GDB for debugging purposes
@@ -31,182 +41,149 @@ extern "C" void __cxa_guard_abort(__guard* pg) throw();
 extern "C" void __cxa_guard_dummy(void);
 
 /**
- * Layout of the guard object (defined by the ABI).
+ * Layout of the guard object.
  *
- * Compiler will check lower byte before calling guard functions.
+ * The ABI only defines the lower byte, which is nonzero if initialization is done, and which
+ * the compiler checks before calling guard functions. The guard functions access the first
+ * 32-bit word of the guard object atomically. All supported targets are little-endian, so the
+ * lower byte of the word is the lower byte of the guard object.
  */
-typedef struct {
-    uint8_t ready;      //!< nonzero if initialization is done
-    uint8_t pending;    //!< nonzero if initialization is in progress
-} guard_t;
+#define GUARD_READY     ((uint32_t) 0x00000001)     //!< initialization is done
+#define GUARD_PENDING   ((uint32_t) 0x00000100)     //!< initialization is in progress
+#define GUARD_WAITING   ((uint32_t) 0x00010000)     //!< tasks are waiting for the pending initialization
 
-static void static_init_prepare()
+static_assert(sizeof(__guard) >= sizeof(uint32_t), "guard object is too small");
+
+static inline uint32_t* guard_word(__guard* pg)
 {
-    portENTER_CRITICAL(&s_init_spinlock);
-    if (s_static_init_mutex == NULL) {
-        s_static_init_mutex = xSemaphoreCreateMutex();
-        s_static_init_wait_sem = xSemaphoreCreateCounting(INT_MAX, 0);
-        if (s_static_init_mutex == NULL || s_static_init_wait_sem == NULL) {
-            // no way to bail out of static initialization without these
-            abort();
-        }
-    }
-    portEXIT_CRITICAL(&s_init_spinlock);
+    return reinterpret_cast<uint32_t*>(pg);
 }
 
 /**
- * Use s_static_init_wait_sem to wait until guard->pending == 0.
- * Preconditions:
- * - s_static_init_mutex taken
- * - guard.pending == 1
- * Postconditions:
- * - s_static_init_mutex taken
- * - guard.pending == 0
+ * Block until the guard object is not pending anymore, or until its state has changed.
+ *
+ * The state of the guard object is re-checked by the caller.
  */
-static void wait_for_guard_obj(guard_t* g)
+static void wait_for_guard_obj(__guard* pg, uint32_t state)
 {
+    guard_waiter_t waiter;
+    waiter.guard = pg;
+    waiter.sem = xSemaphoreCreateBinaryStatic(&waiter.sem_buffer);
+
+    portENTER_CRITICAL(&s_static_init_spinlock);
+    /* The waiter is registered only if the guard object is still pending. The task releasing
+     * the guard object checks GUARD_WAITING after clearing GUARD_PENDING, then takes the
+     * spinlock to find the waiters, so it can't miss this one.
+     */
+    if (!__atomic_compare_exchange_n(guard_word(pg), &state, state | GUARD_WAITING,
+                                     false, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+        portEXIT_CRITICAL(&s_static_init_spinlock);
+        vSemaphoreDelete(waiter.sem);
+        return;
+    }
+    waiter.next = s_static_init_waiters;
+    s_static_init_waiters = &waiter;
     s_static_init_waiting_count++;
 #ifndef _NDEBUG
     s_static_init_max_waiting_count = std::max(s_static_init_waiting_count,
                                                s_static_init_max_waiting_count);
 #endif
+    portEXIT_CRITICAL(&s_static_init_spinlock);
 
-    do {
-        auto result = xSemaphoreGive(s_static_init_mutex);
-        assert(result);
-        static_cast<void>(result);
-        /* Task may be preempted here, but this isn't a problem,
-         * as the semaphore will be given exactly the s_static_init_waiting_count
-         * number of times; eventually the current task will execute next statement,
-         * which will immediately succeed.
-         */
-        result = xSemaphoreTake(s_static_init_wait_sem, portMAX_DELAY);
-        assert(result);
-        /* At this point the semaphore was given, so all waiting tasks have woken up.
-         * We take s_static_init_mutex before accessing the state of the guard
-         * object again.
-         */
-        result = xSemaphoreTake(s_static_init_mutex, portMAX_DELAY);
-        assert(result);
-        /* Semaphore may have been given because some other guard object became ready.
-         * Check the guard object we need and wait again if it is still pending.
-         */
-    } while (g->pending);
-    s_static_init_waiting_count--;
+    auto result = xSemaphoreTake(waiter.sem, portMAX_DELAY);
+    assert(result);
+    static_cast<void>(result);
+    vSemaphoreDelete(waiter.sem);
 }
 
 /**
- * Unblock tasks waiting for static initialization to complete.
- * Preconditions:
- * - s_static_init_mutex taken
- * Postconditions:
- * - s_static_init_mutex taken
+ * Unblock the tasks waiting for the given guard object. Tasks waiting for other
+ * guard objects are not woken up.
  */
-static void signal_waiting_tasks()
+static void signal_waiting_tasks(__guard* pg)
 {
-    auto count = s_static_init_waiting_count;
-    while (count--) {
-        xSemaphoreGive(s_static_init_wait_sem);
+    guard_waiter_t* woken = NULL;
+
+    portENTER_CRITICAL(&s_static_init_spinlock);
+    guard_waiter_t** prev = &s_static_init_waiters;
+    while (*prev != NULL) {
+        guard_waiter_t* waiter = *prev;
+        if (waiter->guard == pg) {
+            *prev = waiter->next;
+            waiter->next = woken;
+            woken = waiter;
+            s_static_init_waiting_count--;
+        } else {
+            prev = &waiter->next;
+        }
+    }
+    portEXIT_CRITICAL(&s_static_init_spinlock);
+
+    /* A waiter may return as soon as its semaphore is given, so read the next waiter before */
+    while (woken != NULL) {
+        guard_waiter_t* next = woken->next;
+        xSemaphoreGive(woken->sem);
+        woken = next;
     }
 }
 
 extern "C" int __cxa_guard_acquire(__guard* pg)
 {
-    guard_t* g = reinterpret_cast<guard_t*>(pg);
+    uint32_t* word = guard_word(pg);
     const auto scheduler_started = xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED;
-    if (!scheduler_started) {
-        if (g->pending) {
+
+    /* The compiler checks the first byte of *pg before calling __cxa_guard_acquire, but another
+     * task may have completed the initialization in the meantime.
+     */
+    uint32_t state = __atomic_load_n(word, __ATOMIC_ACQUIRE);
+    while (true) {
+        if (state & GUARD_READY) {
+            /* Static initialization has been done by another task; nothing to do here */
+            return 0;
+        }
+        if (!(state & GUARD_PENDING)) {
+            /* Current task can start doing static initialization */
+            if (__atomic_compare_exchange_n(word, &state, GUARD_PENDING,
+                                            false, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+                return 1;
+            }
+            continue;
+        }
+        if (!scheduler_started) {
             /* Before the scheduler has started, there we don't support simultaneous
-             * static initialization. This may be implemented using a spinlock and a
-             * s32c1i instruction, though.
+             * static initialization.
              */
             abort();
         }
-    } else {
-        if (s_static_init_mutex == NULL) {
-            static_init_prepare();
-        }
-
-        /* We don't need to use double-checked locking pattern here, as the compiler
-         * must generate code to check if the first byte of *pg is non-zero, before
-         * calling __cxa_guard_acquire.
+        /* Another task is doing initialization at the moment; wait until it calls
+         * __cxa_guard_release or __cxa_guard_abort. Afterwards, either the guard object
+         * is ready and we return 0, or the initialization was aborted and the current task
+         * can try to acquire the guard object, same as if it didn't have to wait.
          */
-        auto result = xSemaphoreTake(s_static_init_mutex, portMAX_DELAY);
-        assert(result);
-        static_cast<void>(result);
-        if (g->pending) {
-            /* Another task is doing initialization at the moment; wait until it calls
-             * __cxa_guard_release or __cxa_guard_abort
-             */
-            wait_for_guard_obj(g);
-            /* At this point there are two scenarios:
-             * - the task which was doing static initialization has called __cxa_guard_release,
-             *   which means that g->ready is set. We need to return 0.
-             * - the task which was doing static initialization has called __cxa_guard_abort,
-             *   which means that g->ready is not set; we should acquire the guard and return 1,
-             *   same as for the case if we didn't have to wait.
-             * Note: actually the second scenario is unlikely to occur in the current
-             * configuration because exception support is disabled.
-             */
-        }
-    }
-    int ret;
-    if (g->ready) {
-        /* Static initialization has been done by another task; nothing to do here */
-        ret = 0;
-    } else {
-        /* Current task can start doing static initialization */
-        g->pending = 1;
-        ret = 1;
-    }
-    if (scheduler_started) {
-        auto result = xSemaphoreGive(s_static_init_mutex);
-        assert(result);
-        static_cast<void>(result);
+        wait_for_guard_obj(pg, state);
+        state = __atomic_load_n(word, __ATOMIC_ACQUIRE);
     }
-    return ret;
 }
 
 extern "C" void __cxa_guard_release(__guard* pg) throw()
 {
-    guard_t* g = reinterpret_cast<guard_t*>(pg);
-    const auto scheduler_started = xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED;
-    if (scheduler_started) {
-        auto result = xSemaphoreTake(s_static_init_mutex, portMAX_DELAY);
-        assert(result);
-        static_cast<void>(result);
-    }
-    assert(g->pending && "tried to release a guard which wasn't acquired");
-    g->pending = 0;
     /* Initialization was successful */
-    g->ready = 1;
-    if (scheduler_started) {
+    uint32_t state = __atomic_exchange_n(guard_word(pg), GUARD_READY, __ATOMIC_RELEASE);
+    assert((state & GUARD_PENDING) && "tried to release a guard which wasn't acquired");
+    if (state & GUARD_WAITING) {
         /* Unblock the tasks waiting for static initialization to complete */
-        signal_waiting_tasks();
-        auto result = xSemaphoreGive(s_static_init_mutex);
-        assert(result);
-        static_cast<void>(result);
+        signal_waiting_tasks(pg);
     }
 }
 
 extern "C" void __cxa_guard_abort(__guard* pg) throw()
 {
-    guard_t* g = reinterpret_cast<guard_t*>(pg);
-    const auto scheduler_started = xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED;
-    if (scheduler_started) {
-        auto result = xSemaphoreTake(s_static_init_mutex, portMAX_DELAY);
-        assert(result);
-        static_cast<void>(result);
-    }
-    assert(!g->ready && "tried to abort a guard which is ready");
-    assert(g->pending && "tried to release a guard which is not acquired");
-    g->pending = 0;
-    if (scheduler_started) {
+    uint32_t state = __atomic_exchange_n(guard_word(pg), 0, __ATOMIC_RELEASE);
+    assert(!(state & GUARD_READY) && "tried to abort a guard which is ready");
+    assert((state & GUARD_PENDING) && "tried to release a guard which is not acquired");
+    if (state & GUARD_WAITING) {
         /* Unblock the tasks waiting for static initialization to complete */
-        signal_waiting_tasks();
-        auto result = xSemaphoreGive(s_static_init_mutex);
-        assert(result);
-        static_cast<void>(result);
+        signal_waiting_tasks(pg);
     }
 }
 
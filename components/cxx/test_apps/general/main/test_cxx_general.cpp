@@ -6,6 +6,9 @@
 
 #include <vector>
 #include <numeric>
+#include <array>
+#include <atomic>
+#include <utility>
 #include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -130,6 +133,80 @@ TEST_CASE("static initialization guards work as expected", "[misc]")
     vTaskDelay(10); // Allow tasks to clean up, avoids race with leak detector
 }
 
+/*
+ * This test exercises static initialization guards for many objects, which several tasks
+ * access for the first time concurrently, each task in a different order.
+ * We check that each constructor runs exactly once, and that every task sees initialized objects.
+ */
+
+#define MANY_STATICS_COUNT 16
+#define MANY_STATICS_TASKS 4
+
+static std::atomic<int> s_many_statics_init_count[MANY_STATICS_COUNT];
+static SemaphoreHandle_t s_many_statics_done_sem = NULL;
+
+template<int obj>
+class ManyStatics {
+public:
+    ManyStatics() : value(obj)
+    {
+        ++s_many_statics_init_count[obj];
+        vTaskDelay(1); // let other tasks reach the guard while the initialization is pending
+    }
+
+    static int get()
+    {
+        static ManyStatics instance;
+        return instance.value;
+    }
+private:
+    int value;
+};
+
+template<size_t... obj>
+static constexpr std::array<int (*)(), sizeof...(obj)> many_statics_getters(std::index_sequence<obj...>)
+{
+    return {{ &ManyStatics<obj>::get... }};
+}
+
+static void many_statics_task(void* arg)
+{
+    static constexpr auto getters = many_statics_getters(std::make_index_sequence<MANY_STATICS_COUNT>());
+    int task_id = reinterpret_cast<int>(arg);
+
+    for (int i = 0; i < MANY_STATICS_COUNT; i++) {
+        // Start from a different object in each task, and go backwards in every other task
+        int obj = (task_id * MANY_STATICS_COUNT / MANY_STATICS_TASKS + i) % MANY_STATICS_COUNT;
+        if (task_id % 2) {
+            obj = MANY_STATICS_COUNT - 1 - obj;
+        }
+        TEST_ASSERT_EQUAL(obj, getters[obj]());
+    }
+    xSemaphoreGive(s_many_statics_done_sem);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("static initialization guards of many objects accessed concurrently", "[misc]")
+{
+    s_many_statics_done_sem = xSemaphoreCreateCounting(MANY_STATICS_TASKS, 0);
+    TEST_ASSERT_NOT_NULL(s_many_statics_done_sem);
+    for (int i = 0; i < MANY_STATICS_TASKS; i++) {
+        TEST_ASSERT(xTaskCreatePinnedToCore(&many_statics_task, "many_statics", 2048, reinterpret_cast<void*>(i),
+                                            3, NULL, i % CONFIG_FREERTOS_NUMBER_OF_CORES));
+    }
+
+    for (int i = 0; i < MANY_STATICS_TASKS; i++) {
+        TEST_ASSERT_TRUE(xSemaphoreTake(s_many_statics_done_sem, 1000 / portTICK_PERIOD_MS));
+    }
+    vSemaphoreDelete(s_many_statics_done_sem);
+
+    for (int i = 0; i < MANY_STATICS_COUNT; i++) {
+        TEST_ASSERT_EQUAL(1, s_many_statics_init_count[i].load());
+    }
+
+    vTaskDelay(10); // Allow tasks to clean up, avoids race with leak detector
+}
+
 struct GlobalInitTest {
     GlobalInitTest() : index(order++)
     {
@@ -18,6 +18,8 @@
 #include "esp_transport_ssl.h"
 #include "http_utils.h"
 #include "http_auth.h"
+#include "http_pool.h"
+#include "http_client_internal.h"
 #include "sdkconfig.h"
 #include "esp_http_client.h"
 #include "errno.h"
@@ -123,8 +125,6 @@ struct esp_http_client {
     char                        *post_data;
     char                        *location;
     char                        *auth_header;
-    char                        *current_header_key;
-    char                        *current_header_value;
     int                         post_len;
     connection_info_t           connection_info;
     bool                        is_chunk_complete;
@@ -143,6 +143,9 @@ struct esp_http_client {
     esp_transport_keep_alive_t  keep_alive_cfg;
     struct ifreq                *if_name;
     unsigned                    cache_data_in_fetch_hdr: 1;
+    esp_http_client_pool_handle_t   pool;
+    char                        *pool_key;
+    char                        *pool_settings;
 #ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
     session_ticket_state_t      session_ticket_state;
 #endif
@@ -225,6 +228,8 @@ static int http_on_message_begin(http_parser *parser)
 
     client->response->is_chunked = false;
     client->is_chunk_complete = false;
+    /* Keep the header arena of the previous response for this one */
+    http_header_clean(client->response->headers);
     return 0;
 }
 
@@ -241,41 +246,19 @@ static int http_on_status(http_parser *parser, const char *at, size_t length)
 
 static int http_on_header_event(esp_http_client_handle_t client)
 {
-    if (client->current_header_key != NULL && client->current_header_value != NULL) {
-        ESP_LOGD(TAG, "HEADER=%s:%s", client->current_header_key, client->current_header_value);
-        client->event.header_key = client->current_header_key;
-        client->event.header_value = client->current_header_value;
-        http_dispatch_event(client, HTTP_EVENT_ON_HEADER, NULL, 0);
-        http_dispatch_event_to_event_loop(HTTP_EVENT_ON_HEADER, &client, sizeof(esp_http_client_handle_t));
-        free(client->current_header_key);
-        free(client->current_header_value);
-        client->current_header_key = NULL;
-        client->current_header_value = NULL;
-    }
-    return 0;
-}
-
-static int http_on_header_field(http_parser *parser, const char *at, size_t length)
-{
-    esp_http_client_t *client = parser->data;
-    http_on_header_event(client);
-    HTTP_RET_ON_FALSE_DBG(http_utils_append_string(&client->current_header_key, at, length), -1, TAG, "Failed to append string");
-
-    return 0;
-}
-
-static int http_on_header_value(http_parser *parser, const char *at, size_t length)
-{
-    esp_http_client_handle_t client = parser->data;
-    if (client->current_header_key == NULL) {
+    const char *key, *value;
+    /* The received header is stored in the response header arena, its
+     * fragments were appended in place so no copy is needed here */
+    esp_err_t err = http_header_commit(client->response->headers, &key, &value);
+    if (err == ESP_ERR_NOT_FOUND) {
         return 0;
     }
-    if (strcasecmp(client->current_header_key, "Content-Range") == 0) {
-        HTTP_RET_ON_FALSE_DBG(http_utils_append_string(&client->current_header_value, at, length), -1, TAG, "Failed to append string");
+    HTTP_RET_ON_FALSE_DBG(err == ESP_OK, -1, TAG, "Failed to store header");
 
+    if (strcasecmp(key, "Content-Range") == 0) {
         int64_t total_size = -1;
         client->response->content_range = -1;
-        char *slash_pos = strchr(client->current_header_value, '/');
+        char *slash_pos = strchr(value, '/');
 
         if (slash_pos) {
             if (slash_pos[1] == '*') {
@@ -292,15 +275,41 @@ static int http_on_header_value(http_parser *parser, const char *at, size_t leng
         } else {
             ESP_LOGE(TAG, "Invalid Content-Range format (missing '/')");
         }
-    } else if (strcasecmp(client->current_header_key, "Location") == 0) {
-        HTTP_RET_ON_FALSE_DBG(http_utils_append_string(&client->location, at, length), -1, TAG, "Failed to append string");
-    } else if (strcasecmp(client->current_header_key, "Transfer-Encoding") == 0
-               && memcmp(at, "chunked", length) == 0) {
+    } else if (strcasecmp(key, "Location") == 0) {
+        HTTP_RET_ON_FALSE_DBG(http_utils_append_string(&client->location, value, -1), -1, TAG, "Failed to append string");
+    } else if (strcasecmp(key, "Transfer-Encoding") == 0
+               && strcasecmp(value, "chunked") == 0) {
         client->response->is_chunked = true;
-    } else if (strcasecmp(client->current_header_key, "WWW-Authenticate") == 0) {
-        HTTP_RET_ON_FALSE_DBG(http_utils_append_string(&client->auth_header, at, length), -1, TAG, "Failed to append string");
+    } else if (strcasecmp(key, "WWW-Authenticate") == 0) {
+        HTTP_RET_ON_FALSE_DBG(http_utils_append_string(&client->auth_header, value, -1), -1, TAG, "Failed to append string");
+    }
+
+    ESP_LOGD(TAG, "HEADER=%s:%s", key, value);
+    client->event.header_key = (char *)key;
+    client->event.header_value = (char *)value;
+    http_dispatch_event(client, HTTP_EVENT_ON_HEADER, NULL, 0);
+    http_dispatch_event_to_event_loop(HTTP_EVENT_ON_HEADER, &client, sizeof(esp_http_client_handle_t));
+    return 0;
+}
+
+static int http_on_header_field(http_parser *parser, const char *at, size_t length)
+{
+    esp_http_client_t *client = parser->data;
+    if (http_header_has_pending(client->response->headers)) {
+        HTTP_RET_ON_FALSE_DBG(http_on_header_event(client) == 0, -1, TAG, "Failed to process header");
+    }
+    HTTP_RET_ON_FALSE_DBG(http_header_append_field(client->response->headers, at, length) == ESP_OK, -1, TAG, "Failed to append string");
+
+    return 0;
+}
+
+static int http_on_header_value(http_parser *parser, const char *at, size_t length)
+{
+    esp_http_client_handle_t client = parser->data;
+    if (http_header_append_value(client->response->headers, at, length) == ESP_ERR_NO_MEM) {
+        ESP_LOGD(TAG, "Failed to append string");
+        return -1;
     }
-    HTTP_RET_ON_FALSE_DBG(http_utils_append_string(&client->current_header_value, at, length), -1, TAG, "Failed to append string");
     return 0;
 }
 
@@ -520,6 +529,57 @@ esp_err_t esp_http_client_set_user_data(esp_http_client_handle_t client, void *d
     return ESP_OK;
 }
 
+/* Describes the transport configuration of a client, so that pooled connections are only handed to
+ * clients that would have configured their transports the same way. Buffers are compared by address,
+ * as the transports only keep pointers to them */
+static char *http_client_pool_settings(const esp_http_client_config_t *config)
+{
+    const char **alpn_protos = NULL;
+    bool use_secure_element = false;
+    void *ds_data = NULL;
+    int ecdsa_key_efuse_blk = -1;
+    int tls_dyn_buf_strategy = 0;
+    /* Same precedence as in esp_http_client_init(): bundle, global CA store, then cert_pem */
+    int ca_store = (config->crt_bundle_attach != NULL) ? 1 : (config->use_global_ca_store ? 2 : 0);
+#if CONFIG_ESP_HTTP_CLIENT_ENABLE_HTTPS
+    alpn_protos = config->alpn_protos;
+#endif
+#if CONFIG_ESP_TLS_USE_SECURE_ELEMENT
+    use_secure_element = config->use_secure_element;
+#endif
+#if CONFIG_ESP_TLS_USE_DS_PERIPHERAL
+    ds_data = config->ds_data;
+#endif
+#ifdef CONFIG_MBEDTLS_HARDWARE_ECDSA_SIGN
+    if (config->use_ecdsa_peripheral) {
+        ecdsa_key_efuse_blk = config->ecdsa_key_efuse_blk;
+    }
+#endif
+#if CONFIG_MBEDTLS_DYNAMIC_BUFFER
+    tls_dyn_buf_strategy = config->tls_dyn_buf_strategy;
+#endif
+    int keep_alive_idle = 0, keep_alive_interval = 0, keep_alive_count = 0;
+    if (config->keep_alive_enable) {
+        keep_alive_idle = (config->keep_alive_idle == 0) ? DEFAULT_KEEP_ALIVE_IDLE : config->keep_alive_idle;
+        keep_alive_interval = (config->keep_alive_interval == 0) ? DEFAULT_KEEP_ALIVE_INTERVAL : config->keep_alive_interval;
+        keep_alive_count = (config->keep_alive_count == 0) ? DEFAULT_KEEP_ALIVE_COUNT : config->keep_alive_count;
+    }
+    char *settings = NULL;
+    if (asprintf(&settings, "ka=%d/%d/%d/%d if=%.*s af=%d ca=%d/%p/%u cc=%p/%u ck=%p/%u pw=%p/%u "
+                 "cn=%s/%p skip=%d alpn=%p tls=%d se=%d ds=%p ecdsa=%d dyn=%d",
+                 config->keep_alive_enable, keep_alive_idle, keep_alive_interval, keep_alive_count,
+                 (int) sizeof(config->if_name->ifr_name), config->if_name ? config->if_name->ifr_name : "", config->addr_type,
+                 ca_store, config->cert_pem, (unsigned) config->cert_len,
+                 config->client_cert_pem, (unsigned) config->client_cert_len,
+                 config->client_key_pem, (unsigned) config->client_key_len,
+                 config->client_key_password, (unsigned) config->client_key_password_len,
+                 config->common_name ? config->common_name : "", config->common_name, config->skip_cert_common_name_check,
+                 alpn_protos, config->tls_version, use_secure_element, ds_data, ecdsa_key_efuse_blk, tls_dyn_buf_strategy) < 0) {
+        return NULL;
+    }
+    return settings;
+}
+
 static esp_err_t _set_config(esp_http_client_handle_t client, const esp_http_client_config_t *config)
 {
     esp_err_t ret = ESP_OK;
@@ -534,6 +594,11 @@ static esp_err_t _set_config(esp_http_client_handle_t client, const esp_http_cli
     client->buffer_size_rx = config->buffer_size;
     client->buffer_size_tx = config->buffer_size_tx;
     client->disable_auto_redirect = config->disable_auto_redirect;
+    client->pool = config->connection_pool;
+    if (client->pool) {
+        client->pool_settings = http_client_pool_settings(config);
+        ESP_RETURN_ON_FALSE(client->pool_settings, ESP_ERR_NO_MEM, TAG, "Memory exhausted");
+    }
 
     if (config->buffer_size == 0) {
         client->buffer_size_rx = DEFAULT_HTTP_BUF_SIZE;
@@ -1011,6 +1076,13 @@ esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *co
 
     client->state = HTTP_STATE_INIT;
 
+#if CONFIG_ESP_HTTP_CLIENT_ENABLE_CUSTOM_TRANSPORT
+    if (config->transport && client->pool) {
+        ESP_LOGW(TAG, "Connection pool is not used with a custom transport");
+        client->pool = NULL;
+    }
+#endif
+
     if (ret == ESP_OK) {
         return client;
     }
@@ -1031,11 +1103,89 @@ static void esp_http_client_cached_buf_cleanup(esp_http_buffer_t *res_buffer)
     }
 }
 
+/* The transports keep the keep-alive configuration and interface name as pointers into the client
+ * that set them up. Point them at the storage of the client owning the list, or at nothing while the
+ * list sits in the pool, so a pooled list never refers to a client that has been freed */
+static void http_client_bind_transport_list(esp_http_client_handle_t client, esp_transport_list_handle_t list)
+{
+    static const char *const schemes[] = { "http", "https" };
+    for (size_t i = 0; i < sizeof(schemes) / sizeof(schemes[0]); i++) {
+        esp_transport_handle_t transport = esp_transport_list_get_transport(list, schemes[i]);
+        if (transport == NULL) {
+            continue;
+        }
+        bool keep_alive = client && client->keep_alive_cfg.keep_alive_enable;
+        esp_transport_tcp_set_keep_alive(transport, keep_alive ? &client->keep_alive_cfg : NULL);
+        esp_transport_tcp_set_interface_name(transport, client ? client->if_name : NULL);
+    }
+}
+
+/* Hands the connection of the client over to its pool: an idle keep-alive connection is kept open,
+ * a closed TLS connection is only kept for its session ticket. Anything else is closed as usual */
+static void http_client_pool_release(esp_http_client_handle_t client)
+{
+    if (client->pool == NULL || client->pool_key == NULL || client->transport_list == NULL) {
+        return;
+    }
+    bool idle = (client->state == HTTP_STATE_CONNECTED) ||
+                (client->state >= HTTP_STATE_RES_ON_DATA_START &&
+                 esp_http_client_is_complete_data_received(client) && http_should_keep_alive(client->parser));
+    if (idle) {
+        ESP_LOGD(TAG, "Return connection to %s to the pool", client->pool_key);
+        http_client_bind_transport_list(NULL, client->transport_list);
+        http_pool_release(client->pool, client->pool_key, client->transport_list, client->transport);
+    } else {
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+        if (client->session_ticket_state != SESSION_TICKET_SAVED ||
+                client->transport != esp_transport_list_get_transport(client->transport_list, "https")) {
+            return;
+        }
+        esp_http_client_close(client);
+        http_client_bind_transport_list(NULL, client->transport_list);
+        http_pool_release(client->pool, client->pool_key, client->transport_list, NULL);
+#else
+        return;
+#endif
+    }
+    client->transport_list = NULL;
+    client->transport = NULL;
+    client->state = HTTP_STATE_INIT;
+}
+
+/* Swaps the transport list of the client for a pooled one to the same host, if any.
+ * Returns true if the pooled list came with an idle connection that can be used right away */
+static bool http_client_pool_acquire(esp_http_client_handle_t client)
+{
+    free(client->pool_key);
+    client->pool_key = http_pool_make_key(client->connection_info.scheme, client->connection_info.host,
+                                          client->connection_info.port, client->pool_settings);
+    if (client->pool_key == NULL) {
+        return false;
+    }
+    esp_transport_list_handle_t list;
+    esp_transport_handle_t transport;
+    if (!http_pool_acquire(client->pool, client->pool_key, &list, &transport)) {
+        return false;
+    }
+    esp_transport_list_destroy(client->transport_list);
+    http_client_bind_transport_list(client, list);
+    client->transport_list = list;
+    client->transport = transport;
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    if (transport == NULL) {
+        /* Only the session ticket of a previous connection is left, resume it on connect */
+        client->session_ticket_state = SESSION_TICKET_SAVED;
+    }
+#endif
+    return transport != NULL;
+}
+
 esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client)
 {
     if (client == NULL) {
         return ESP_FAIL;
     }
+    http_client_pool_release(client);
     esp_http_client_close(client);
     if (client->transport_list) {
         esp_transport_list_destroy(client->transport_list);
@@ -1065,9 +1215,10 @@ esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client)
     _clear_connection_info(client);
     _clear_auth_data(client);
     free(client->auth_data);
-    free(client->current_header_key);
     free(client->location);
     free(client->auth_header);
+    free(client->pool_key);
+    free(client->pool_settings);
     free(client);
     return ESP_OK;
 }
@@ -1567,6 +1718,13 @@ static esp_err_t esp_http_client_connect(esp_http_client_handle_t client)
 #endif
         {
             ESP_LOGD(TAG, "Begin connect to: %s://%s:%d", client->connection_info.scheme, client->connection_info.host, client->connection_info.port);
+            if (client->pool && http_client_pool_acquire(client)) {
+                ESP_LOGD(TAG, "Reuse pooled connection to %s", client->pool_key);
+                client->state = HTTP_STATE_CONNECTED;
+                http_dispatch_event(client, HTTP_EVENT_ON_CONNECTED, NULL, 0);
+                http_dispatch_event_to_event_loop(HTTP_EVENT_ON_CONNECTED, &client, sizeof(esp_http_client_handle_t));
+                return ESP_OK;
+            }
             client->transport = esp_transport_list_get_transport(client->transport_list, client->connection_info.scheme);
         }
 
@@ -1617,6 +1775,33 @@ static esp_err_t esp_http_client_connect(esp_http_client_handle_t client)
     return ESP_OK;
 }
 
+esp_err_t http_client_connect_transport(esp_http_client_handle_t client, esp_transport_handle_t *transport)
+{
+    esp_err_t err = esp_http_client_connect(client);
+    if (err != ESP_OK) {
+        return err;
+    }
+    *transport = client->transport;
+    return ESP_OK;
+}
+
+int http_client_generate_headers(esp_http_client_handle_t client, char *buffer, int buffer_len)
+{
+    /* Content-Length depends on the request, it is added by the caller. A value set on the client is
+     * left in place for requests made with esp_http_client_perform() */
+    return http_header_generate_string_except(client->request->headers, "Content-Length", buffer, buffer_len);
+}
+
+const char *http_client_method_str(esp_http_client_method_t method)
+{
+    return (method >= 0 && method < HTTP_METHOD_MAX) ? HTTP_METHOD_MAPPING[method] : NULL;
+}
+
+int http_client_get_timeout_ms(esp_http_client_handle_t client)
+{
+    return client->timeout_ms;
+}
+
 static int http_client_prepare_first_line(esp_http_client_handle_t client, int write_len)
 {
     if (write_len >= 0) {
@@ -0,0 +1,256 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "esp_log.h"
+#include "esp_http_client.h"
+#include "esp_transport.h"
+
+#include "unity.h"
+#include "unity_fixture.h"
+
+/* Count the heap allocations made by the code under test. The glibc allocator entry points are
+ * called directly so that allocations made inside libc (strdup, vasprintf...) are counted too */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static volatile size_t s_alloc_count;
+
+void *malloc(size_t size)
+{
+    s_alloc_count++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+    s_alloc_count++;
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    s_alloc_count++;
+    return __libc_realloc(ptr, size);
+}
+
+#define RESPONSE_HEADER_COUNT   8
+static const char s_response[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/plain\r\n"
+    "Content-Length: 5\r\n"
+    "Server: host-test\r\n"
+    "Date: Mon, 06 Jan 2025 10:00:00 GMT\r\n"
+    "Cache-Control: no-cache\r\n"
+    "ETag: \"5-1736157600\"\r\n"
+    "X-Request-Id: 0123456789abcdef\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n"
+    "hello";
+
+/* In-memory transport answering every request with s_response */
+static size_t s_response_pos = sizeof(s_response) - 1;
+
+static int mem_connect(esp_transport_handle_t t, const char *host, int port, int timeout_ms)
+{
+    return 0;
+}
+
+static int mem_write(esp_transport_handle_t t, const char *buffer, int len, int timeout_ms)
+{
+    s_response_pos = 0;
+    return len;
+}
+
+static int mem_read(esp_transport_handle_t t, char *buffer, int len, int timeout_ms)
+{
+    size_t left = sizeof(s_response) - 1 - s_response_pos;
+    if (left == 0) {
+        return 0;
+    }
+    len = (size_t)len < left ? len : (int)left;
+    memcpy(buffer, s_response + s_response_pos, len);
+    s_response_pos += len;
+    return len;
+}
+
+static int mem_poll(esp_transport_handle_t t, int timeout_ms)
+{
+    return 1;
+}
+
+static int mem_close(esp_transport_handle_t t)
+{
+    return 0;
+}
+
+static esp_transport_handle_t mem_transport_init(void)
+{
+    esp_transport_handle_t t = esp_transport_init();
+    TEST_ASSERT_NOT_NULL(t);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_transport_set_func(t, mem_connect, mem_read, mem_write, mem_close, mem_poll, mem_poll, NULL));
+    return t;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int s_on_header_count;
+
+static esp_err_t count_header_event(esp_http_client_event_t *evt)
+{
+    if (evt->event_id == HTTP_EVENT_ON_HEADER) {
+        TEST_ASSERT_NOT_NULL(evt->header_key);
+        TEST_ASSERT_NOT_NULL(evt->header_value);
+        s_on_header_count++;
+    }
+    return ESP_OK;
+}
+
+static esp_transport_handle_t s_transport;
+static esp_http_client_handle_t s_client;
+
+TEST_GROUP(esp_http_client);
+
+TEST_SETUP(esp_http_client)
+{
+    /* The default event loop is not created here, keep the client quiet about it */
+    esp_log_level_set("HTTP_CLIENT", ESP_LOG_NONE);
+    s_transport = mem_transport_init();
+    esp_http_client_config_t config = {
+        .url = "http://host-test/",
+        .transport = s_transport,
+        .event_handler = count_header_event,
+    };
+    s_client = esp_http_client_init(&config);
+    TEST_ASSERT_NOT_NULL(s_client);
+    s_on_header_count = 0;
+}
+
+TEST_TEAR_DOWN(esp_http_client)
+{
+    esp_http_client_cleanup(s_client);
+    esp_transport_destroy(s_transport);
+}
+
+TEST(esp_http_client, header_lookup)
+{
+    char key[32];
+    char value[32];
+    const int header_count = 16;
+    for (int i = 0; i < header_count; i++) {
+        snprintf(key, sizeof(key), "X-Header-%d", i);
+        snprintf(value, sizeof(value), "value-%d", i);
+        TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_set_header(s_client, key, value));
+    }
+
+    const int lookups = 200000;
+    char *found = NULL;
+    uint64_t start = now_ns();
+    for (int i = 0; i < lookups; i++) {
+        /* Lower-case keys, the lookup is case-insensitive */
+        static const char *keys[] = { "x-header-0", "x-header-7", "x-header-15", "user-agent", "x-missing" };
+        esp_http_client_get_header(s_client, keys[i % 5], &found);
+    }
+    uint64_t elapsed = now_ns() - start;
+    printf("header lookup with %d headers: %llu ns\n", header_count + 2, (unsigned long long)(elapsed / lookups));
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_get_header(s_client, "x-header-15", &found));
+    TEST_ASSERT_EQUAL_STRING("value-15", found);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_get_header(s_client, "X-MISSING", &found));
+    TEST_ASSERT_NULL(found);
+}
+
+TEST(esp_http_client, header_reset_does_not_allocate)
+{
+    char key[32];
+    for (int round = 0; round < 100; round++) {
+        if (round == 1) {
+            s_alloc_count = 0;
+        }
+        TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_delete_all_headers(s_client));
+        for (int i = 0; i < 8; i++) {
+            snprintf(key, sizeof(key), "X-Header-%d", i);
+            TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_set_header(s_client, key, "some header value"));
+        }
+        /* Updating a value of similar length is done in place */
+        TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_set_header(s_client, "X-Header-0", "another value"));
+    }
+    TEST_ASSERT_EQUAL(0, s_alloc_count);
+}
+
+TEST(esp_http_client, header_value_stays_valid)
+{
+    char key[32];
+    char *kept = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_set_header(s_client, "X-Kept", "kept value"));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_get_header(s_client, "X-Kept", &kept));
+    TEST_ASSERT_NOT_NULL(kept);
+
+    s_alloc_count = 0;
+    for (int round = 0; round < 100; round++) {
+        /* Churn through other headers, growing and deleting them */
+        for (int i = 0; i < 8; i++) {
+            snprintf(key, sizeof(key), "X-Header-%d", i);
+            TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_set_header(s_client, key, "short"));
+            TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_set_header(s_client, key, "a value that no longer fits in place"));
+            TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_delete_header(s_client, key));
+        }
+    }
+    char *found = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_get_header(s_client, "x-kept", &found));
+    TEST_ASSERT_EQUAL_PTR(kept, found);
+    TEST_ASSERT_EQUAL_STRING("kept value", kept);
+    /* The storage of deleted headers is reused, the arena does not keep growing */
+    printf("allocations for 800 header set/delete cycles: %u\n", (unsigned)s_alloc_count);
+    TEST_ASSERT_LESS_THAN(8, s_alloc_count);
+}
+
+TEST(esp_http_client, allocations_per_request)
+{
+    const int requests = 1000;
+    for (int i = 0; i < requests + 1; i++) {
+        if (i == 1) {
+            /* The first request warms up the header arenas */
+            s_alloc_count = 0;
+            s_on_header_count = 0;
+        }
+        TEST_ASSERT_EQUAL(ESP_OK, esp_http_client_perform(s_client));
+        TEST_ASSERT_EQUAL(200, esp_http_client_get_status_code(s_client));
+    }
+    TEST_ASSERT_EQUAL(requests * RESPONSE_HEADER_COUNT, s_on_header_count);
+    printf("allocations per request on a reused handle: %.2f\n", (double)s_alloc_count / requests);
+    /* Receiving the response headers must not allocate for each of them */
+    TEST_ASSERT_LESS_THAN(RESPONSE_HEADER_COUNT, s_alloc_count / requests);
+}
+
+TEST_GROUP_RUNNER(esp_http_client)
+{
+    RUN_TEST_CASE(esp_http_client, header_lookup);
+    RUN_TEST_CASE(esp_http_client, header_reset_does_not_allocate);
+    RUN_TEST_CASE(esp_http_client, header_value_stays_valid);
+    RUN_TEST_CASE(esp_http_client, allocations_per_request);
+}
+
+static void run_all_tests(void)
+{
+    RUN_TEST_GROUP(esp_http_client);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_MAIN_FUNC(run_all_tests);
+    return 0;
+}
@@ -8,6 +8,7 @@
 #define _ESP_HTTP_CLIENT_H
 
 #include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
 #include "sdkconfig.h"
 #include "esp_err.h"
 #include <sys/socket.h>
@@ -23,6 +24,8 @@ ESP_EVENT_DECLARE_BASE(ESP_HTTP_CLIENT_EVENT);
 
 typedef struct esp_http_client *esp_http_client_handle_t;
 typedef struct esp_http_client_event *esp_http_client_event_handle_t;
+typedef struct esp_http_client_pool *esp_http_client_pool_handle_t;
+typedef struct esp_http_client_pipeline *esp_http_client_pipeline_handle_t;
 
 #if CONFIG_ESP_HTTP_CLIENT_ENABLE_CUSTOM_TRANSPORT
 // Forward declares transport handle item to keep the dependency private (even if ENABLE_CUSTOM_TRANSPORT=y)
@@ -224,8 +227,100 @@ typedef struct {
 #if CONFIG_MBEDTLS_DYNAMIC_BUFFER
     esp_http_client_tls_dyn_buf_strategy_t tls_dyn_buf_strategy; /*!< TLS dynamic buffer strategy */
 #endif
+    esp_http_client_pool_handle_t connection_pool;  /*!< Connection pool to borrow keep-alive connections from and return them to
+                                                         on cleanup, see `esp_http_client_pool_create`. NULL disables pooling */
 } esp_http_client_config_t;
 
+/**
+ * @brief HTTP client connection pool configuration
+ */
+typedef struct {
+    int max_idle_per_host;  /*!< Maximum number of idle connections kept for one scheme://host:port and transport configuration */
+    int max_idle;           /*!< Maximum number of idle connections kept in the pool in total */
+    int idle_timeout_ms;    /*!< Idle connections older than this are closed instead of being reused, -1 to keep them until evicted */
+} esp_http_client_pool_config_t;
+
+/**
+ * @brief Default connection pool configuration
+ */
+#define ESP_HTTP_CLIENT_POOL_DEFAULT_CONFIG() {     \
+    .max_idle_per_host = 2,                         \
+    .max_idle = 8,                                  \
+    .idle_timeout_ms = 30000,                       \
+}
+
+/**
+ * @brief HTTP client connection pool statistics
+ */
+typedef struct {
+    uint32_t reused;        /*!< Number of connections handed out from the pool */
+    uint32_t resumed;       /*!< Number of new TLS connections started with a pooled session ticket */
+    uint32_t missed;        /*!< Number of connections that had to be opened from scratch */
+    uint32_t evicted;       /*!< Number of idle connections closed because of limits, timeouts or peer close */
+    uint32_t idle;          /*!< Number of connections currently idle in the pool */
+} esp_http_client_pool_stats_t;
+
+/**
+ * @brief Request submitted to a pipeline
+ */
+typedef struct {
+    esp_http_client_method_t method;    /*!< HTTP method */
+    const char *path;                   /*!< Path and query of the request, e.g. "/records?id=1" */
+    const char *data;                   /*!< Request body, copied on submit. NULL if none */
+    size_t data_len;                    /*!< Length of the request body */
+    void *user_ctx;                     /*!< User context, passed back with the result */
+} esp_http_client_pipeline_request_t;
+
+/**
+ * @brief Completion of a pipelined request
+ */
+typedef struct {
+    esp_err_t err;                      /*!< ESP_OK if a response was received, error of the connection otherwise */
+    int status_code;                    /*!< HTTP status code of the response, 0 on error */
+    const char *body;                   /*!< Response body, only valid during the `on_complete` callback, NULL in results posted to `completion_queue` */
+    size_t body_len;                    /*!< Length of the response body, up to `max_body_len` bytes are kept */
+    bool body_truncated;                /*!< The response body was longer than `max_body_len` */
+    void *user_ctx;                     /*!< User context of the request */
+} esp_http_client_pipeline_result_t;
+
+/**
+ * @brief Callback invoked from the pipeline task when a request completes
+ */
+typedef void (*esp_http_client_pipeline_cb_t)(const esp_http_client_pipeline_result_t *result, void *arg);
+
+/**
+ * @brief HTTP client pipeline configuration
+ */
+typedef struct {
+    const esp_http_client_config_t *client_config;  /*!< Configuration of the client used by the pipeline, its URL selects the server */
+    int max_in_flight;                  /*!< Maximum number of requests sent on the connection before their responses are received, 1 disables pipelining */
+    int queue_size;                     /*!< Number of submitted requests waiting to be sent */
+    size_t max_body_len;                /*!< Maximum response body length kept for the result, the rest is discarded */
+    int buffer_size;                    /*!< Size of the receive and transmit buffers of the pipeline */
+    esp_http_client_pipeline_cb_t on_complete;      /*!< Completion callback, may be NULL */
+    void *on_complete_arg;              /*!< Argument passed to `on_complete` */
+    QueueHandle_t completion_queue;     /*!< Queue of esp_http_client_pipeline_result_t receiving the completions, may be NULL */
+    int task_priority;                  /*!< Priority of the pipeline task */
+    int task_stack;                     /*!< Stack size of the pipeline task */
+} esp_http_client_pipeline_config_t;
+
+/**
+ * @brief Default pipeline configuration, `client_config` must be set by the caller
+ */
+#define ESP_HTTP_CLIENT_PIPELINE_DEFAULT_CONFIG() {     \
+    .client_config = NULL,                              \
+    .max_in_flight = 4,                                 \
+    .queue_size = 16,                                   \
+    .max_body_len = 512,                                \
+    .buffer_size = 1024,                                \
+    .on_complete = NULL,                                \
+    .on_complete_arg = NULL,                            \
+    .completion_queue = NULL,                           \
+    .task_priority = 5,                                 \
+    .task_stack = 4096,                                 \
+}
+
+
 /**
  * Enum for the HTTP status codes.
  */
@@ -819,6 +914,153 @@ esp_err_t esp_http_client_get_url(esp_http_client_handle_t client, char *url, co
  */
 esp_err_t esp_http_client_get_chunk_length(esp_http_client_handle_t client, int *len);
 
+/**
+ * @brief      Create a connection pool that can be shared by several client handles
+ *
+ *             A client initialized with `connection_pool` set takes an idle connection to the same
+ *             scheme://host:port from the pool when it connects, and hands its connection back to the
+ *             pool in esp_http_client_cleanup() if the last response allowed keep-alive. This removes
+ *             the TCP (and TLS) handshake from every request made through a short lived handle.
+ *             For clients configured with `save_client_session` (CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS), closed
+ *             HTTPS connections also leave their session ticket in the pool so the next handshake to that host
+ *             can be resumed.
+ *
+ * @note       A pooled connection is only handed to clients whose transport configuration (certificates, TLS
+ *             version, common name, ALPN, interface, keep-alive settings) matches the one of the client that
+ *             opened it. Certificate, key and common name buffers are compared by address, so clients have to
+ *             share the same buffers to share connections, and those buffers must stay valid until the pool is
+ *             deleted.
+ *
+ * @param[in]  config    Pool configuration, see `ESP_HTTP_CLIENT_POOL_DEFAULT_CONFIG`
+ * @param[out] ret_pool  Handle of the created pool
+ *
+ * @return
+ *     - ESP_OK                 on success
+ *     - ESP_ERR_INVALID_ARG    if an argument is invalid
+ *     - ESP_ERR_NO_MEM         if the pool could not be allocated
+ */
+esp_err_t esp_http_client_pool_create(const esp_http_client_pool_config_t *config, esp_http_client_pool_handle_t *ret_pool);
+
+/**
+ * @brief      Close all idle connections held by the pool
+ *
+ * @param[in]  pool  The connection pool handle
+ *
+ * @return
+ *     - ESP_OK                 on success
+ *     - ESP_ERR_INVALID_ARG    if the pool is NULL
+ */
+esp_err_t esp_http_client_pool_flush(esp_http_client_pool_handle_t pool);
+
+/**
+ * @brief      Get usage statistics of the pool
+ *
+ * @param[in]  pool   The connection pool handle
+ * @param[out] stats  Statistics of the pool
+ *
+ * @return
+ *     - ESP_OK                 on success
+ *     - ESP_ERR_INVALID_ARG    if an argument is NULL
+ */
+esp_err_t esp_http_client_pool_get_stats(esp_http_client_pool_handle_t pool, esp_http_client_pool_stats_t *stats);
+
+/**
+ * @brief      Close all idle connections and free the pool
+ *
+ * @note       All client handles using the pool must have been cleaned up before calling this function.
+ *
+ * @param[in]  pool  The connection pool handle
+ *
+ * @return
+ *     - ESP_OK                 on success
+ *     - ESP_ERR_INVALID_ARG    if the pool is NULL
+ */
+esp_err_t esp_http_client_pool_delete(esp_http_client_pool_handle_t pool);
+
+/**
+ * @brief      Create a request pipeline
+ *
+ *             A pipeline owns a client handle and a task that sends the submitted requests to the server
+ *             of `client_config->url` over a single keep-alive connection. Once the server has answered a
+ *             first request with an HTTP/1.1 keep-alive response, up to `max_in_flight` requests are written
+ *             before their responses are read (HTTP pipelining), removing a round trip per request.
+ *             Responses are matched to requests in order and reported through `on_complete` and/or
+ *             `completion_queue`, interim 1xx responses are skipped. If the server closes the connection,
+ *             idempotent requests (e.g. GET, HEAD, PUT, DELETE) that were not answered are sent again once on a
+ *             new connection, the others (e.g. POST, PATCH) complete with ESP_ERR_HTTP_CONNECTION_CLOSED as the
+ *             server may already have processed them.
+ *
+ * @note       A Content-Length header set on the client is not sent with pipelined requests, their length
+ *             is taken from the submitted data.
+ *
+ * @param[in]  config        Pipeline configuration, see `ESP_HTTP_CLIENT_PIPELINE_DEFAULT_CONFIG`
+ * @param[out] ret_pipeline  Handle of the created pipeline
+ *
+ * @return
+ *     - ESP_OK                 on success
+ *     - ESP_ERR_INVALID_ARG    if an argument is invalid
+ *     - ESP_ERR_NO_MEM         if the pipeline could not be allocated
+ *     - ESP_FAIL               if the client could not be initialized
+ */
+esp_err_t esp_http_client_pipeline_create(const esp_http_client_pipeline_config_t *config, esp_http_client_pipeline_handle_t *ret_pipeline);
+
+/**
+ * @brief      Get the client handle of the pipeline
+ *
+ *             The handle may be used to set the request headers (esp_http_client_set_header(),
+ *             esp_http_client_set_authtype()...) before the first request is submitted. The headers are
+ *             sent with every request of a connection and are read again when the pipeline reconnects.
+ *
+ * @param[in]  pipeline  The pipeline handle
+ *
+ * @return
+ *     - The client handle
+ *     - NULL if the pipeline is NULL
+ */
+esp_http_client_handle_t esp_http_client_pipeline_get_client(esp_http_client_pipeline_handle_t pipeline);
+
+/**
+ * @brief      Submit a request to the pipeline
+ *
+ * @param[in]  pipeline    The pipeline handle
+ * @param[in]  request     The request, its path and data are copied
+ * @param[in]  ticks_to_wait  Time to wait for room in the submission queue
+ *
+ * @return
+ *     - ESP_OK                 if the request was queued, its completion is reported later
+ *     - ESP_ERR_INVALID_ARG    if an argument is invalid
+ *     - ESP_ERR_NO_MEM         if the request could not be copied
+ *     - ESP_ERR_TIMEOUT        if the submission queue stayed full
+ */
+esp_err_t esp_http_client_pipeline_submit(esp_http_client_pipeline_handle_t pipeline, const esp_http_client_pipeline_request_t *request, TickType_t ticks_to_wait);
+
+/**
+ * @brief      Wait until all submitted requests have completed
+ *
+ * @param[in]  pipeline       The pipeline handle
+ * @param[in]  ticks_to_wait  Maximum time to wait
+ *
+ * @return
+ *     - ESP_OK                 if no request is outstanding
+ *     - ESP_ERR_INVALID_ARG    if the pipeline is NULL
+ *     - ESP_ERR_TIMEOUT        if requests are still outstanding
+ */
+esp_err_t esp_http_client_pipeline_flush(esp_http_client_pipeline_handle_t pipeline, TickType_t ticks_to_wait);
+
+/**
+ * @brief      Stop the pipeline task, close the connection and free the pipeline
+ *
+ *             Requests that have not completed yet are completed with ESP_ERR_INVALID_STATE.
+ *             Call esp_http_client_pipeline_flush() first to wait for them.
+ *
+ * @param[in]  pipeline  The pipeline handle
+ *
+ * @return
+ *     - ESP_OK                 on success
+ *     - ESP_ERR_INVALID_ARG    if the pipeline is NULL
+ */
+esp_err_t esp_http_client_pipeline_destroy(esp_http_client_pipeline_handle_t pipeline);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -11,13 +11,31 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <sys/param.h>
 #include "esp_log.h"
 #include "esp_check.h"
 #include "http_header.h"
 #include "http_utils.h"
 
 static const char *TAG = "HTTP_HEADER";
-#define HEADER_BUFFER (1024)
+
+/* Headers are stored in an arena made of chunks of at least this size. The chunks are kept
+ * when the headers are cleaned, so a reused header object stops allocating once warmed up */
+#define HEADER_CHUNK_SIZE   (256)
+/* Values are stored with some spare room, so that updating a header with a value of similar
+ * length (e.g. Content-Length) overwrites it in place */
+#define HEADER_VALUE_ALIGN  (16)
+#define HEADER_ITEM_ALIGN   (sizeof(void *))
+/* Number of hash buckets indexing the items, must be a power of two */
+#define HEADER_BUCKET_COUNT (16)
+
+typedef struct http_header_chunk {
+    struct http_header_chunk    *next;      /*!< Next chunk of the arena */
+    size_t                      size;       /*!< Size of data */
+    size_t                      used;       /*!< Bytes of data handed out */
+    char                        data[];
+} http_header_chunk_t;
 
 /**
  * dictionary item struct, with key-value pair
@@ -25,25 +43,181 @@ static const char *TAG = "HTTP_HEADER";
 typedef struct http_header_item {
     char *key;                          /*!< key */
     char *value;                        /*!< value */
-    STAILQ_ENTRY(http_header_item) next;   /*!< Point to next entry */
+    uint32_t hash;                      /*!< case-insensitive hash of the key */
+    size_t key_size;                    /*!< bytes available for the key, including the terminator */
+    size_t value_size;                  /*!< bytes available for the value, including the terminator */
+    STAILQ_ENTRY(http_header_item) next;   /*!< Point to next entry, in the header list or in the free list */
+    STAILQ_ENTRY(http_header_item) bucket_next;    /*!< Point to next entry of the same hash bucket */
 } http_header_item_t;
 
-STAILQ_HEAD(http_header, http_header_item);
+STAILQ_HEAD(http_header_list, http_header_item);
+
+struct http_header {
+    struct http_header_list items;          /*!< Headers in insertion order */
+    struct http_header_list buckets[HEADER_BUCKET_COUNT];   /*!< Headers by hash of the key, in insertion order */
+    struct http_header_list free_items;     /*!< Deleted headers, whose storage is reused by new ones */
+    http_header_chunk_t *first;             /*!< First chunk of the arena */
+    http_header_chunk_t *current;           /*!< Chunk allocations are made from */
+    char *pending_key;                      /*!< Key being received with http_header_append_field() */
+    size_t pending_key_len;
+    char *pending_value;                    /*!< Value being received with http_header_append_value() */
+    size_t pending_value_len;
+};
+
+/* FNV-1a over the lower-cased key */
+static uint32_t http_header_hash(const char *key, size_t len)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (uint8_t)tolower((unsigned char)key[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
 
+static void *http_header_alloc(http_header_handle_t header, size_t size, size_t align)
+{
+    http_header_chunk_t *chunk = header->current;
+    while (chunk) {
+        size_t offset = (chunk->used + align - 1) & ~(align - 1);
+        if (offset + size <= chunk->size) {
+            chunk->used = offset + size;
+            header->current = chunk;
+            return chunk->data + offset;
+        }
+        if (chunk->next == NULL) {
+            break;
+        }
+        /* Chunks past the current one are empty after http_header_clean() */
+        chunk = chunk->next;
+    }
+
+    size_t chunk_size = MAX(HEADER_CHUNK_SIZE, size);
+    http_header_chunk_t *new_chunk = malloc(sizeof(http_header_chunk_t) + chunk_size);
+    ESP_RETURN_ON_FALSE(new_chunk, NULL, TAG, "Memory exhausted");
+    new_chunk->next = NULL;
+    new_chunk->size = chunk_size;
+    new_chunk->used = size;
+    if (chunk) {
+        chunk->next = new_chunk;
+    } else {
+        header->first = new_chunk;
+    }
+    header->current = new_chunk;
+    return new_chunk->data;
+}
+
+static void http_header_free_chunks(http_header_chunk_t *chunk)
+{
+    while (chunk) {
+        http_header_chunk_t *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+}
+
+/* Returns the bounds of str without leading and trailing whitespace */
+static const char *http_header_trim(const char *str, size_t *len)
+{
+    while (*len > 0 && isspace((unsigned char)*str)) {
+        str++;
+        (*len)--;
+    }
+    while (*len > 0 && isspace((unsigned char)str[*len - 1])) {
+        (*len)--;
+    }
+    return str;
+}
+
+static char *http_header_copy_value(http_header_handle_t header, const char *value, size_t len, size_t *size)
+{
+    *size = (len + HEADER_VALUE_ALIGN) & ~(HEADER_VALUE_ALIGN - 1);
+    char *copy = http_header_alloc(header, *size, 1);
+    if (copy) {
+        memcpy(copy, value, len);
+        copy[len] = '\0';
+    }
+    return copy;
+}
+
+static struct http_header_list *http_header_bucket(http_header_handle_t header, uint32_t hash)
+{
+    return &header->buckets[hash & (HEADER_BUCKET_COUNT - 1)];
+}
+
+static void http_header_insert_item(http_header_handle_t header, http_header_item_handle_t item)
+{
+    STAILQ_INSERT_TAIL(&header->items, item, next);
+    STAILQ_INSERT_TAIL(http_header_bucket(header, item->hash), item, bucket_next);
+}
+
+/* Takes the storage of a deleted header that can hold the key and value, so that headers which are
+ * deleted and set again (e.g. Authorization) do not make the arena grow */
+static http_header_item_handle_t http_header_reuse_item(http_header_handle_t header, size_t key_len, size_t value_len)
+{
+    http_header_item_handle_t item;
+    STAILQ_FOREACH(item, &header->free_items, next) {
+        if (key_len < item->key_size && value_len < item->value_size) {
+            STAILQ_REMOVE(&header->free_items, item, http_header_item, next);
+            return item;
+        }
+    }
+    return NULL;
+}
+
+static http_header_item_handle_t http_header_add_item(http_header_handle_t header, const char *key, size_t key_len,
+                                                      const char *value, size_t value_len)
+{
+    http_header_item_handle_t item = http_header_reuse_item(header, key_len, value_len);
+    if (item) {
+        memmove(item->value, value, value_len);
+        item->value[value_len] = '\0';
+    } else {
+        item = http_header_alloc(header, sizeof(http_header_item_t), HEADER_ITEM_ALIGN);
+        if (item == NULL) {
+            return NULL;
+        }
+        item->key_size = key_len + 1;
+        item->key = http_header_alloc(header, item->key_size, 1);
+        if (item->key == NULL) {
+            return NULL;
+        }
+        item->value = http_header_copy_value(header, value, value_len, &item->value_size);
+        if (item->value == NULL) {
+            return NULL;
+        }
+    }
+    memcpy(item->key, key, key_len);
+    item->key[key_len] = '\0';
+    item->hash = http_header_hash(key, key_len);
+    http_header_insert_item(header, item);
+    return item;
+}
+
+static void http_header_reset_pending(http_header_handle_t header)
+{
+    header->pending_key = NULL;
+    header->pending_key_len = 0;
+    header->pending_value = NULL;
+    header->pending_value_len = 0;
+}
 
 http_header_handle_t http_header_init(void)
 {
     http_header_handle_t header = calloc(1, sizeof(struct http_header));
     ESP_RETURN_ON_FALSE(header, NULL, TAG, "Memory exhausted");
-    STAILQ_INIT(header);
+    http_header_clean(header);
     return header;
 }
 
 esp_err_t http_header_destroy(http_header_handle_t header)
 {
-    esp_err_t err = http_header_clean(header);
+    if (header == NULL) {
+        return ESP_OK;
+    }
+    http_header_free_chunks(header->first);
     free(header);
-    return err;
+    return ESP_OK;
 }
 
 http_header_item_handle_t http_header_get_item(http_header_handle_t header, const char *key)
@@ -52,8 +226,9 @@ http_header_item_handle_t http_header_get_item(http_header_handle_t header, cons
     if (header == NULL || key == NULL) {
         return NULL;
     }
-    STAILQ_FOREACH(item, header, next) {
-        if (strcasecmp(item->key, key) == 0) {
+    uint32_t hash = http_header_hash(key, strlen(key));
+    STAILQ_FOREACH(item, http_header_bucket(header, hash), bucket_next) {
+        if (item->hash == hash && strcasecmp(item->key, key) == 0) {
             return item;
         }
     }
@@ -74,26 +249,6 @@ esp_err_t http_header_get(http_header_handle_t header, const char *key, char **v
     return ESP_OK;
 }
 
-static esp_err_t http_header_new_item(http_header_handle_t header, const char *key, const char *value)
-{
-    esp_err_t ret = ESP_OK;
-    http_header_item_handle_t item;
-
-    item = calloc(1, sizeof(http_header_item_t));
-    ESP_RETURN_ON_FALSE(item, ESP_ERR_NO_MEM, TAG, "Memory exhausted");
-    HTTP_GOTO_ON_FALSE_DBG(http_utils_assign_string(&item->key, key, -1), ESP_ERR_NO_MEM, _header_new_item_exit, TAG, "Failed to assign string");
-    http_utils_trim_whitespace(&item->key);
-    HTTP_GOTO_ON_FALSE_DBG(http_utils_assign_string(&item->value, value, -1), ESP_ERR_NO_MEM, _header_new_item_exit, TAG, "Failed to assign string");
-    http_utils_trim_whitespace(&item->value);
-    STAILQ_INSERT_TAIL(header, item, next);
-    return ret;
-_header_new_item_exit:
-    free(item->key);
-    free(item->value);
-    free(item);
-    return ret;
-}
-
 esp_err_t http_header_set(http_header_handle_t header, const char *key, const char *value)
 {
     http_header_item_handle_t item;
@@ -102,15 +257,27 @@ esp_err_t http_header_set(http_header_handle_t header, const char *key, const ch
         return http_header_delete(header, key);
     }
 
+    size_t value_len = strlen(value);
+    value = http_header_trim(value, &value_len);
     item = http_header_get_item(header, key);
 
     if (item) {
-        free(item->value);
-        item->value = strdup(value);
-        http_utils_trim_whitespace(&item->value);
-        return ESP_OK;
+        if (value_len < item->value_size) {
+            memmove(item->value, value, value_len);
+            item->value[value_len] = '\0';
+            return ESP_OK;
+        }
+        size_t size;
+        char *new_value = http_header_copy_value(header, value, value_len, &size);
+        ESP_RETURN_ON_FALSE(new_value, ESP_ERR_NO_MEM, TAG, "Memory exhausted");
+        item->value = new_value;
+        item->value_size = size;
+    } else {
+        size_t key_len = strlen(key);
+        key = http_header_trim(key, &key_len);
+        ESP_RETURN_ON_FALSE(http_header_add_item(header, key, key_len, value, value_len), ESP_ERR_NO_MEM, TAG, "Memory exhausted");
     }
-    return http_header_new_item(header, key, value);
+    return ESP_OK;
 }
 
 esp_err_t http_header_set_from_string(http_header_handle_t header, const char *key_value_data)
@@ -137,10 +304,9 @@ esp_err_t http_header_delete(http_header_handle_t header, const char *key)
 {
     http_header_item_handle_t item = http_header_get_item(header, key);
     if (item) {
-        STAILQ_REMOVE(header, item, http_header_item, next);
-        free(item->key);
-        free(item->value);
-        free(item);
+        STAILQ_REMOVE(&header->items, item, http_header_item, next);
+        STAILQ_REMOVE(http_header_bucket(header, item->hash), item, http_header_item, bucket_next);
+        STAILQ_INSERT_TAIL(&header->free_items, item, next);
     } else {
         return ESP_ERR_NOT_FOUND;
     }
@@ -152,13 +318,23 @@ int http_header_set_format(http_header_handle_t header, const char *key, const c
 {
     va_list argptr;
     int len = 0;
-    char *buf = NULL;
+    char buf[HEADER_VALUE_ALIGN * 4];
+    char *value = buf;
     va_start(argptr, format);
-    len = vasprintf(&buf, format, argptr);
+    len = vsnprintf(buf, sizeof(buf), format, argptr);
     va_end(argptr);
-    ESP_RETURN_ON_FALSE(buf, 0, TAG, "Memory exhausted");
-    http_header_set(header, key, buf);
-    free(buf);
+    if (len >= (int)sizeof(buf)) {
+        /* Only long values need a temporary heap buffer */
+        va_start(argptr, format);
+        len = vasprintf(&value, format, argptr);
+        va_end(argptr);
+        ESP_RETURN_ON_FALSE(len >= 0, 0, TAG, "Memory exhausted");
+    }
+    ESP_RETURN_ON_FALSE(len >= 0, 0, TAG, "Invalid format");
+    http_header_set(header, key, value);
+    if (value != buf) {
+        free(value);
+    }
     return len;
 }
 
@@ -171,7 +347,7 @@ int http_header_generate_string(http_header_handle_t header, int index, char *bu
     bool is_end = false;
 
     // iterate over the header entries to calculate buffer size and determine last item
-    STAILQ_FOREACH(item, header, next) {
+    STAILQ_FOREACH(item, &header->items, next) {
         if (item->value && idx >= index) {
             size += strlen(item->key);
             size += strlen(item->value);
@@ -199,7 +375,7 @@ int http_header_generate_string(http_header_handle_t header, int index, char *bu
     // iterate again over the header entries to write only the fitting indices
     int str_len = 0;
     idx = 0;
-    STAILQ_FOREACH(item, header, next) {
+    STAILQ_FOREACH(item, &header->items, next) {
         if (item->value && idx >= index && idx < ret_idx) {
             str_len += snprintf(buffer + str_len, *buffer_len - str_len, "%s: %s\r\n", item->key, item->value);
         }
@@ -213,26 +389,101 @@ int http_header_generate_string(http_header_handle_t header, int index, char *bu
     return ret_idx;
 }
 
+int http_header_generate_string_except(http_header_handle_t header, const char *skip_key, char *buffer, int buffer_len)
+{
+    http_header_item_handle_t item;
+    int len = 0;
+    STAILQ_FOREACH(item, &header->items, next) {
+        if (strcasecmp(item->key, skip_key) == 0) {
+            continue;
+        }
+        len += snprintf(buffer + len, buffer_len - len, "%s: %s\r\n", item->key, item->value);
+        if (len >= buffer_len) {
+            return -1;
+        }
+    }
+    len += snprintf(buffer + len, buffer_len - len, "\r\n");
+    return len < buffer_len ? len : -1;
+}
+
 esp_err_t http_header_clean(http_header_handle_t header)
 {
-    http_header_item_handle_t item = STAILQ_FIRST(header), tmp;
-    while (item != NULL) {
-        tmp = STAILQ_NEXT(item, next);
-        free(item->key);
-        free(item->value);
-        free(item);
-        item = tmp;
+    STAILQ_INIT(&header->items);
+    for (int i = 0; i < HEADER_BUCKET_COUNT; i++) {
+        STAILQ_INIT(&header->buckets[i]);
+    }
+    STAILQ_INIT(&header->free_items);
+    for (http_header_chunk_t *chunk = header->first; chunk; chunk = chunk->next) {
+        chunk->used = 0;
     }
-    STAILQ_INIT(header);
+    header->current = header->first;
+    http_header_reset_pending(header);
     return ESP_OK;
 }
 
-int http_header_count(http_header_handle_t header)
+/* Appends to a string that is the last allocation of the arena, moving it to a new chunk if needed */
+static esp_err_t http_header_append_string(http_header_handle_t header, char **str, size_t *len, const char *at, size_t length)
 {
-    http_header_item_handle_t item;
-    int count = 0;
-    STAILQ_FOREACH(item, header, next) {
-        count ++;
+    http_header_chunk_t *chunk = header->current;
+    if (*str && chunk && *str + *len + 1 == chunk->data + chunk->used && chunk->used + length <= chunk->size) {
+        chunk->used += length;
+    } else {
+        char *moved = http_header_alloc(header, *len + length + 1, 1);
+        ESP_RETURN_ON_FALSE(moved, ESP_ERR_NO_MEM, TAG, "Memory exhausted");
+        if (*str) {
+            memcpy(moved, *str, *len);
+        }
+        *str = moved;
+    }
+    memcpy(*str + *len, at, length);
+    *len += length;
+    (*str)[*len] = '\0';
+    return ESP_OK;
+}
+
+esp_err_t http_header_append_field(http_header_handle_t header, const char *at, size_t length)
+{
+    if (header->pending_value) {
+        /* The previous header was not committed, drop it */
+        http_header_reset_pending(header);
+    }
+    return http_header_append_string(header, &header->pending_key, &header->pending_key_len, at, length);
+}
+
+esp_err_t http_header_append_value(http_header_handle_t header, const char *at, size_t length)
+{
+    ESP_RETURN_ON_FALSE(header->pending_key, ESP_ERR_INVALID_STATE, TAG, "No header field");
+    return http_header_append_string(header, &header->pending_value, &header->pending_value_len, at, length);
+}
+
+bool http_header_has_pending(http_header_handle_t header)
+{
+    return header->pending_key != NULL && header->pending_value != NULL;
+}
+
+esp_err_t http_header_commit(http_header_handle_t header, const char **key, const char **value)
+{
+    if (!http_header_has_pending(header)) {
+        return ESP_ERR_NOT_FOUND;
     }
-    return count;
+    size_t key_len = header->pending_key_len;
+    size_t value_len = header->pending_value_len;
+    char *k = (char *)http_header_trim(header->pending_key, &key_len);
+    char *v = (char *)http_header_trim(header->pending_value, &value_len);
+    k[key_len] = '\0';
+    v[value_len] = '\0';
+    http_header_reset_pending(header);
+
+    /* The strings already live in the arena, only the item has to be allocated */
+    http_header_item_handle_t item = http_header_alloc(header, sizeof(http_header_item_t), HEADER_ITEM_ALIGN);
+    ESP_RETURN_ON_FALSE(item, ESP_ERR_NO_MEM, TAG, "Memory exhausted");
+    item->key = k;
+    item->value = v;
+    item->hash = http_header_hash(k, key_len);
+    item->key_size = key_len + 1;
+    item->value_size = value_len + 1;
+    http_header_insert_item(header, item);
+    *key = k;
+    *value = v;
+    return ESP_OK;
 }
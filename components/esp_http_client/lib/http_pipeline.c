@@ -0,0 +1,505 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <sys/queue.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "http_parser.h"
+#include "esp_transport.h"
+#include "esp_http_client.h"
+#include "http_client_internal.h"
+
+static const char *TAG = "HTTP_PIPELINE";
+
+/* An idempotent request is sent at most twice: once more if the connection was closed before its response arrived */
+#define HTTP_PIPELINE_MAX_ATTEMPTS  2
+
+typedef struct http_pipeline_request {
+    esp_http_client_method_t            method;
+    void                                *user_ctx;
+    int                                 attempts;
+    size_t                              data_len;
+    char                                *data;      /*!< Points into buf, after the path */
+    STAILQ_ENTRY(http_pipeline_request) next;
+    char                                path[];     /*!< Path, followed by the request body */
+} http_pipeline_request_t;
+
+STAILQ_HEAD(http_pipeline_list, http_pipeline_request);
+
+struct esp_http_client_pipeline {
+    esp_http_client_pipeline_config_t   config;
+    esp_http_client_handle_t            client;
+    QueueHandle_t                       submit_queue;   /*!< http_pipeline_request_t pointers, NULL stops the task */
+    TaskHandle_t                        task;
+    SemaphoreHandle_t                   lock;           /*!< Protects outstanding */
+    SemaphoreHandle_t                   idle;           /*!< Given when outstanding drops to zero */
+    SemaphoreHandle_t                   stopped;        /*!< Given by the task before it exits */
+    int                                 outstanding;    /*!< Submitted requests not completed yet */
+
+    /* Engine state, only accessed by the pipeline task */
+    struct http_pipeline_list           ready;          /*!< Requests waiting to be sent */
+    struct http_pipeline_list           in_flight;      /*!< Requests sent, in the order of their responses */
+    int                                 in_flight_count;
+    esp_transport_handle_t              transport;      /*!< NULL when not connected */
+    bool                                can_pipeline;   /*!< The server answered with an HTTP/1.1 keep-alive response */
+    bool                                closing;        /*!< The last response closes the connection */
+    int                                 timeout_ms;
+    char                                *headers;       /*!< Client headers, generated on connect */
+    int                                 headers_len;
+    char                                *tx_buf;
+    char                                *rx_buf;
+    http_parser                         parser;
+    http_parser_settings                parser_settings;
+    char                                *body;
+    size_t                              body_len;
+    bool                                body_truncated;
+};
+
+static void http_pipeline_complete(esp_http_client_pipeline_handle_t pipeline, http_pipeline_request_t *req, esp_err_t err, int status_code)
+{
+    esp_http_client_pipeline_result_t result = {
+        .err = err,
+        .status_code = status_code,
+        .body = err == ESP_OK ? pipeline->body : NULL,
+        .body_len = err == ESP_OK ? pipeline->body_len : 0,
+        .body_truncated = err == ESP_OK && pipeline->body_truncated,
+        .user_ctx = req->user_ctx,
+    };
+    if (pipeline->config.on_complete) {
+        pipeline->config.on_complete(&result, pipeline->config.on_complete_arg);
+    }
+    if (pipeline->config.completion_queue) {
+        result.body = NULL;
+        xQueueSend(pipeline->config.completion_queue, &result, portMAX_DELAY);
+    }
+    free(req);
+
+    xSemaphoreTake(pipeline->lock, portMAX_DELAY);
+    if (--pipeline->outstanding == 0) {
+        xSemaphoreGive(pipeline->idle);
+    }
+    xSemaphoreGive(pipeline->lock);
+}
+
+static void http_pipeline_fail_list(esp_http_client_pipeline_handle_t pipeline, struct http_pipeline_list *list, esp_err_t err)
+{
+    http_pipeline_request_t *req;
+    while ((req = STAILQ_FIRST(list)) != NULL) {
+        STAILQ_REMOVE_HEAD(list, next);
+        http_pipeline_complete(pipeline, req, err, 0);
+    }
+}
+
+/* Requests that can be sent again without side effects if the server may already have processed them (RFC 9110, 9.2.2) */
+static bool http_pipeline_is_idempotent(esp_http_client_method_t method)
+{
+    switch (method) {
+    case HTTP_METHOD_GET:
+    case HTTP_METHOD_HEAD:
+    case HTTP_METHOD_PUT:
+    case HTTP_METHOD_DELETE:
+    case HTTP_METHOD_OPTIONS:
+    case HTTP_METHOD_PROPFIND:
+    case HTTP_METHOD_PROPPATCH:
+    case HTTP_METHOD_MKCOL:
+    case HTTP_METHOD_COPY:
+    case HTTP_METHOD_MOVE:
+    case HTTP_METHOD_REPORT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/* Closes the connection. Idempotent requests left in flight go back to the front of the ready list if
+ * they may be sent again, the others are completed with err */
+static void http_pipeline_disconnect(esp_http_client_pipeline_handle_t pipeline, esp_err_t err)
+{
+    struct http_pipeline_list retry = STAILQ_HEAD_INITIALIZER(retry);
+    http_pipeline_request_t *req;
+    while ((req = STAILQ_FIRST(&pipeline->in_flight)) != NULL) {
+        STAILQ_REMOVE_HEAD(&pipeline->in_flight, next);
+        if (req->attempts < HTTP_PIPELINE_MAX_ATTEMPTS && http_pipeline_is_idempotent(req->method)) {
+            STAILQ_INSERT_TAIL(&retry, req, next);
+        } else {
+            http_pipeline_complete(pipeline, req, err, 0);
+        }
+    }
+    pipeline->in_flight_count = 0;
+    STAILQ_CONCAT(&retry, &pipeline->ready);
+    STAILQ_INIT(&pipeline->ready);
+    STAILQ_CONCAT(&pipeline->ready, &retry);
+
+    if (pipeline->transport) {
+        esp_http_client_close(pipeline->client);
+        pipeline->transport = NULL;
+    }
+    pipeline->can_pipeline = false;
+    pipeline->closing = false;
+}
+
+static esp_err_t http_pipeline_connect(esp_http_client_pipeline_handle_t pipeline)
+{
+    esp_err_t err = http_client_connect_transport(pipeline->client, &pipeline->transport);
+    if (err != ESP_OK) {
+        pipeline->transport = NULL;
+        return err;
+    }
+    pipeline->headers_len = http_client_generate_headers(pipeline->client, pipeline->headers, pipeline->config.buffer_size);
+    if (pipeline->headers_len < 0) {
+        ESP_LOGE(TAG, "Request headers do not fit in %d bytes", pipeline->config.buffer_size);
+        esp_http_client_close(pipeline->client);
+        pipeline->transport = NULL;
+        return ESP_ERR_INVALID_SIZE;
+    }
+    http_parser_init(&pipeline->parser, HTTP_RESPONSE);
+    pipeline->parser.data = pipeline;
+    pipeline->timeout_ms = http_client_get_timeout_ms(pipeline->client);
+    return ESP_OK;
+}
+
+static esp_err_t http_pipeline_send(esp_http_client_pipeline_handle_t pipeline, http_pipeline_request_t *req)
+{
+    char *buf = pipeline->tx_buf;
+    int size = pipeline->config.buffer_size;
+    int len = snprintf(buf, size, "%s %s HTTP/1.1\r\n", http_client_method_str(req->method), req->path);
+    if (len < size && (req->data_len || req->method == HTTP_METHOD_POST || req->method == HTTP_METHOD_PUT || req->method == HTTP_METHOD_PATCH)) {
+        len += snprintf(buf + len, size - len, "Content-Length: %zu\r\n", req->data_len);
+    }
+    if (len + pipeline->headers_len > size) {
+        ESP_LOGE(TAG, "Request line of %s does not fit in %d bytes", req->path, size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(buf + len, pipeline->headers, pipeline->headers_len);
+    len += pipeline->headers_len;
+
+    /* Small bodies go out in the same segment as the head */
+    const char *data = req->data;
+    size_t data_len = req->data_len;
+    if (data_len && data_len <= (size_t)(size - len)) {
+        memcpy(buf + len, data, data_len);
+        len += data_len;
+        data_len = 0;
+    }
+    if (esp_transport_write(pipeline->transport, buf, len, pipeline->timeout_ms) != len) {
+        return ESP_ERR_HTTP_WRITE_DATA;
+    }
+    while (data_len > 0) {
+        int written = esp_transport_write(pipeline->transport, data, data_len, pipeline->timeout_ms);
+        if (written <= 0) {
+            return ESP_ERR_HTTP_WRITE_DATA;
+        }
+        data += written;
+        data_len -= written;
+    }
+    return ESP_OK;
+}
+
+static int http_pipeline_on_message_begin(http_parser *parser)
+{
+    esp_http_client_pipeline_handle_t pipeline = parser->data;
+    pipeline->body_len = 0;
+    pipeline->body_truncated = false;
+    return 0;
+}
+
+static int http_pipeline_on_headers_complete(http_parser *parser)
+{
+    esp_http_client_pipeline_handle_t pipeline = parser->data;
+    http_pipeline_request_t *req = STAILQ_FIRST(&pipeline->in_flight);
+    /* Responses to HEAD carry a Content-Length but no body */
+    return (req && req->method == HTTP_METHOD_HEAD) ? 1 : 0;
+}
+
+static int http_pipeline_on_body(http_parser *parser, const char *at, size_t length)
+{
+    esp_http_client_pipeline_handle_t pipeline = parser->data;
+    size_t room = pipeline->config.max_body_len - pipeline->body_len;
+    if (length > room) {
+        pipeline->body_truncated = true;
+        length = room;
+    }
+    memcpy(pipeline->body + pipeline->body_len, at, length);
+    pipeline->body_len += length;
+    return 0;
+}
+
+static int http_pipeline_on_message_complete(http_parser *parser)
+{
+    esp_http_client_pipeline_handle_t pipeline = parser->data;
+    if (parser->status_code / 100 == 1 && parser->status_code != 101) {
+        /* Interim response (e.g. 100 Continue), the final response to the request follows */
+        return 0;
+    }
+    http_pipeline_request_t *req = STAILQ_FIRST(&pipeline->in_flight);
+    if (req == NULL) {
+        ESP_LOGW(TAG, "Unexpected response from the server");
+        pipeline->closing = true;
+        return 0;
+    }
+    STAILQ_REMOVE_HEAD(&pipeline->in_flight, next);
+    pipeline->in_flight_count--;
+
+    if (parser->status_code == 101) {
+        /* The connection no longer speaks HTTP/1.1, the requests behind this one cannot be answered on it */
+        pipeline->closing = true;
+    } else if (http_should_keep_alive(parser)) {
+        /* Pipelining is only safe once the server has shown it keeps HTTP/1.1 connections open */
+        pipeline->can_pipeline = parser->http_major > 1 || (parser->http_major == 1 && parser->http_minor >= 1);
+    } else {
+        pipeline->closing = true;
+    }
+    http_pipeline_complete(pipeline, req, ESP_OK, parser->status_code);
+    return 0;
+}
+
+static void http_pipeline_receive(esp_http_client_pipeline_handle_t pipeline)
+{
+    int len = esp_transport_read(pipeline->transport, pipeline->rx_buf, pipeline->config.buffer_size, pipeline->timeout_ms);
+    if (len == ERR_TCP_TRANSPORT_CONNECTION_TIMEOUT) {
+        ESP_LOGW(TAG, "Timed out waiting for %d responses", pipeline->in_flight_count);
+        /* The server did not answer, sending the requests again would likely time out as well */
+        http_pipeline_fail_list(pipeline, &pipeline->in_flight, ESP_ERR_HTTP_EAGAIN);
+        http_pipeline_disconnect(pipeline, ESP_ERR_HTTP_EAGAIN);
+        return;
+    }
+    if (len < 0) {
+        ESP_LOGD(TAG, "Connection closed with %d requests in flight", pipeline->in_flight_count);
+        /* Completes a response delimited by the end of the connection */
+        http_parser_execute(&pipeline->parser, &pipeline->parser_settings, NULL, 0);
+        http_pipeline_disconnect(pipeline, ESP_ERR_HTTP_CONNECTION_CLOSED);
+        return;
+    }
+    http_parser_execute(&pipeline->parser, &pipeline->parser_settings, pipeline->rx_buf, len);
+    if (pipeline->closing) {
+        /* Data following a "Connection: close" response is ignored, the parser reports it as an error */
+        http_pipeline_disconnect(pipeline, ESP_ERR_HTTP_CONNECTION_CLOSED);
+    } else if (HTTP_PARSER_ERRNO(&pipeline->parser) != HPE_OK) {
+        ESP_LOGE(TAG, "Invalid response: %s", http_errno_description(HTTP_PARSER_ERRNO(&pipeline->parser)));
+        http_pipeline_fail_list(pipeline, &pipeline->in_flight, ESP_ERR_HTTP_FETCH_HEADER);
+        http_pipeline_disconnect(pipeline, ESP_ERR_HTTP_FETCH_HEADER);
+    }
+}
+
+static void http_pipeline_task(void *arg)
+{
+    esp_http_client_pipeline_handle_t pipeline = arg;
+    http_pipeline_request_t *req;
+
+    while (true) {
+        /* Wait for work only when nothing is queued or in flight */
+        TickType_t wait = (STAILQ_EMPTY(&pipeline->ready) && pipeline->in_flight_count == 0) ? portMAX_DELAY : 0;
+        bool stop = false;
+        while (xQueueReceive(pipeline->submit_queue, &req, wait) == pdTRUE) {
+            if (req == NULL) {
+                stop = true;
+                break;
+            }
+            STAILQ_INSERT_TAIL(&pipeline->ready, req, next);
+            wait = 0;
+        }
+        if (stop) {
+            break;
+        }
+
+        int max_in_flight = pipeline->can_pipeline ? pipeline->config.max_in_flight : 1;
+        while ((req = STAILQ_FIRST(&pipeline->ready)) != NULL && pipeline->in_flight_count < max_in_flight) {
+            if (pipeline->transport == NULL) {
+                esp_err_t err = http_pipeline_connect(pipeline);
+                if (err != ESP_OK) {
+                    STAILQ_REMOVE_HEAD(&pipeline->ready, next);
+                    http_pipeline_complete(pipeline, req, err, 0);
+                    continue;
+                }
+            }
+            STAILQ_REMOVE_HEAD(&pipeline->ready, next);
+            STAILQ_INSERT_TAIL(&pipeline->in_flight, req, next);
+            pipeline->in_flight_count++;
+            req->attempts++;
+            esp_err_t err = http_pipeline_send(pipeline, req);
+            if (err == ESP_ERR_INVALID_SIZE) {
+                STAILQ_REMOVE(&pipeline->in_flight, req, http_pipeline_request, next);
+                pipeline->in_flight_count--;
+                http_pipeline_complete(pipeline, req, err, 0);
+            } else if (err != ESP_OK) {
+                http_pipeline_disconnect(pipeline, err);
+                break;
+            }
+        }
+        if (pipeline->in_flight_count > 0) {
+            http_pipeline_receive(pipeline);
+        }
+    }
+
+    /* Stopped by esp_http_client_pipeline_destroy() */
+    http_pipeline_fail_list(pipeline, &pipeline->in_flight, ESP_ERR_INVALID_STATE);
+    http_pipeline_fail_list(pipeline, &pipeline->ready, ESP_ERR_INVALID_STATE);
+    pipeline->in_flight_count = 0;
+    if (pipeline->transport) {
+        esp_http_client_close(pipeline->client);
+        pipeline->transport = NULL;
+    }
+    xSemaphoreGive(pipeline->stopped);
+    vTaskDelete(NULL);
+}
+
+static void http_pipeline_free(esp_http_client_pipeline_handle_t pipeline)
+{
+    if (pipeline->client) {
+        esp_http_client_cleanup(pipeline->client);
+    }
+    if (pipeline->submit_queue) {
+        vQueueDelete(pipeline->submit_queue);
+    }
+    if (pipeline->lock) {
+        vSemaphoreDelete(pipeline->lock);
+    }
+    if (pipeline->idle) {
+        vSemaphoreDelete(pipeline->idle);
+    }
+    if (pipeline->stopped) {
+        vSemaphoreDelete(pipeline->stopped);
+    }
+    free(pipeline->headers);
+    free(pipeline->tx_buf);
+    free(pipeline->rx_buf);
+    free(pipeline->body);
+    free(pipeline);
+}
+
+esp_err_t esp_http_client_pipeline_create(const esp_http_client_pipeline_config_t *config, esp_http_client_pipeline_handle_t *ret_pipeline)
+{
+    ESP_RETURN_ON_FALSE(config && config->client_config && ret_pipeline, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    ESP_RETURN_ON_FALSE(config->max_in_flight > 0 && config->queue_size > 0 && config->buffer_size > 0,
+                        ESP_ERR_INVALID_ARG, TAG, "Invalid pipeline limits");
+
+    esp_http_client_pipeline_handle_t pipeline = calloc(1, sizeof(struct esp_http_client_pipeline));
+    ESP_RETURN_ON_FALSE(pipeline, ESP_ERR_NO_MEM, TAG, "Memory exhausted");
+    pipeline->config = *config;
+    STAILQ_INIT(&pipeline->ready);
+    STAILQ_INIT(&pipeline->in_flight);
+
+    http_parser_settings_init(&pipeline->parser_settings);
+    pipeline->parser_settings.on_message_begin = http_pipeline_on_message_begin;
+    pipeline->parser_settings.on_headers_complete = http_pipeline_on_headers_complete;
+    pipeline->parser_settings.on_body = http_pipeline_on_body;
+    pipeline->parser_settings.on_message_complete = http_pipeline_on_message_complete;
+
+    pipeline->submit_queue = xQueueCreate(config->queue_size, sizeof(http_pipeline_request_t *));
+    pipeline->lock = xSemaphoreCreateMutex();
+    pipeline->idle = xSemaphoreCreateBinary();
+    pipeline->stopped = xSemaphoreCreateBinary();
+    pipeline->headers = malloc(config->buffer_size);
+    pipeline->tx_buf = malloc(config->buffer_size);
+    pipeline->rx_buf = malloc(config->buffer_size);
+    pipeline->body = malloc(config->max_body_len ? config->max_body_len : 1);
+    if (!pipeline->submit_queue || !pipeline->lock || !pipeline->idle || !pipeline->stopped ||
+            !pipeline->headers || !pipeline->tx_buf || !pipeline->rx_buf || !pipeline->body) {
+        ESP_LOGE(TAG, "Memory exhausted");
+        http_pipeline_free(pipeline);
+        return ESP_ERR_NO_MEM;
+    }
+
+    pipeline->client = esp_http_client_init(config->client_config);
+    if (pipeline->client == NULL) {
+        ESP_LOGE(TAG, "Failed to initialize the client");
+        http_pipeline_free(pipeline);
+        return ESP_FAIL;
+    }
+
+    if (xTaskCreate(http_pipeline_task, "http_pipeline", config->task_stack, pipeline, config->task_priority, &pipeline->task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create the pipeline task");
+        http_pipeline_free(pipeline);
+        return ESP_ERR_NO_MEM;
+    }
+    *ret_pipeline = pipeline;
+    return ESP_OK;
+}
+
+esp_http_client_handle_t esp_http_client_pipeline_get_client(esp_http_client_pipeline_handle_t pipeline)
+{
+    return pipeline ? pipeline->client : NULL;
+}
+
+esp_err_t esp_http_client_pipeline_submit(esp_http_client_pipeline_handle_t pipeline, const esp_http_client_pipeline_request_t *request, TickType_t ticks_to_wait)
+{
+    ESP_RETURN_ON_FALSE(pipeline && request && request->path && http_client_method_str(request->method),
+                        ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    ESP_RETURN_ON_FALSE(request->data || request->data_len == 0, ESP_ERR_INVALID_ARG, TAG, "Invalid request data");
+
+    size_t path_len = strlen(request->path) + 1;
+    http_pipeline_request_t *req = malloc(sizeof(http_pipeline_request_t) + path_len + request->data_len);
+    ESP_RETURN_ON_FALSE(req, ESP_ERR_NO_MEM, TAG, "Memory exhausted");
+    req->method = request->method;
+    req->user_ctx = request->user_ctx;
+    req->attempts = 0;
+    memcpy(req->path, request->path, path_len);
+    req->data = req->path + path_len;
+    req->data_len = request->data_len;
+    if (request->data_len) {
+        memcpy(req->data, request->data, request->data_len);
+    }
+
+    xSemaphoreTake(pipeline->lock, portMAX_DELAY);
+    pipeline->outstanding++;
+    xSemaphoreGive(pipeline->lock);
+
+    if (xQueueSend(pipeline->submit_queue, &req, ticks_to_wait) != pdTRUE) {
+        xSemaphoreTake(pipeline->lock, portMAX_DELAY);
+        if (--pipeline->outstanding == 0) {
+            xSemaphoreGive(pipeline->idle);
+        }
+        xSemaphoreGive(pipeline->lock);
+        free(req);
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_pipeline_flush(esp_http_client_pipeline_handle_t pipeline, TickType_t ticks_to_wait)
+{
+    ESP_RETURN_ON_FALSE(pipeline, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    TimeOut_t timeout;
+    vTaskSetTimeOutState(&timeout);
+    while (true) {
+        xSemaphoreTake(pipeline->lock, portMAX_DELAY);
+        int outstanding = pipeline->outstanding;
+        xSemaphoreGive(pipeline->lock);
+        if (outstanding == 0) {
+            return ESP_OK;
+        }
+        /* The idle semaphore may have been given by an earlier batch, so check the count again */
+        if (xTaskCheckForTimeOut(&timeout, &ticks_to_wait) == pdTRUE ||
+                xSemaphoreTake(pipeline->idle, ticks_to_wait) != pdTRUE) {
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+}
+
+esp_err_t esp_http_client_pipeline_destroy(esp_http_client_pipeline_handle_t pipeline)
+{
+    ESP_RETURN_ON_FALSE(pipeline, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    http_pipeline_request_t *stop = NULL;
+    xQueueSend(pipeline->submit_queue, &stop, portMAX_DELAY);
+    xSemaphoreTake(pipeline->stopped, portMAX_DELAY);
+
+    /* Requests still queued behind the stop request */
+    http_pipeline_request_t *req;
+    while (xQueueReceive(pipeline->submit_queue, &req, 0) == pdTRUE) {
+        if (req) {
+            http_pipeline_complete(pipeline, req, ESP_ERR_INVALID_STATE, 0);
+        }
+    }
+    http_pipeline_free(pipeline);
+    return ESP_OK;
+}
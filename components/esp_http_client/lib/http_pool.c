@@ -0,0 +1,239 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <sys/queue.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "http_pool.h"
+
+static const char *TAG = "HTTP_POOL";
+
+/**
+ * Pooled connection, either connected and idle, or closed but still holding a TLS session ticket
+ */
+typedef struct http_pool_entry {
+    char                            *key;           /*!< "scheme://host:port settings" */
+    esp_transport_list_handle_t     list;           /*!< Transport list owning the connection */
+    esp_transport_handle_t          transport;      /*!< Idle connected transport, NULL if only the session is kept */
+    TickType_t                      released;       /*!< Tick count when the connection was handed to the pool */
+    TAILQ_ENTRY(http_pool_entry)    next;
+} http_pool_entry_t;
+
+TAILQ_HEAD(http_pool_list, http_pool_entry);
+
+struct esp_http_client_pool {
+    SemaphoreHandle_t               lock;
+    esp_http_client_pool_config_t   config;
+    struct http_pool_list           entries;        /*!< Most recently released first */
+    esp_http_client_pool_stats_t    stats;
+};
+
+static void http_pool_entry_free(http_pool_entry_t *entry)
+{
+    esp_transport_list_destroy(entry->list);
+    free(entry->key);
+    free(entry);
+}
+
+static bool http_pool_entry_expired(esp_http_client_pool_handle_t pool, http_pool_entry_t *entry, TickType_t now)
+{
+    return entry->transport && pool->config.idle_timeout_ms >= 0 &&
+           (now - entry->released) >= pdMS_TO_TICKS(pool->config.idle_timeout_ms);
+}
+
+/* Moves expired entries of the pool to the garbage list. Must be called with the pool locked */
+static void http_pool_collect_expired(esp_http_client_pool_handle_t pool, struct http_pool_list *garbage)
+{
+    TickType_t now = xTaskGetTickCount();
+    http_pool_entry_t *entry, *tmp;
+    for (entry = TAILQ_FIRST(&pool->entries); entry != NULL; entry = tmp) {
+        tmp = TAILQ_NEXT(entry, next);
+        if (http_pool_entry_expired(pool, entry, now)) {
+            TAILQ_REMOVE(&pool->entries, entry, next);
+            TAILQ_INSERT_TAIL(garbage, entry, next);
+            pool->stats.idle--;
+            pool->stats.evicted++;
+        }
+    }
+}
+
+/* Entries are destroyed outside of the pool lock, closing a TLS connection may take a while */
+static void http_pool_free_garbage(struct http_pool_list *garbage)
+{
+    http_pool_entry_t *entry;
+    while ((entry = TAILQ_FIRST(garbage)) != NULL) {
+        TAILQ_REMOVE(garbage, entry, next);
+        http_pool_entry_free(entry);
+    }
+}
+
+char *http_pool_make_key(const char *scheme, const char *host, int port, const char *settings)
+{
+    char *key = NULL;
+    if (asprintf(&key, "%s://%s:%d %s", scheme, host, port, settings ? settings : "") < 0) {
+        return NULL;
+    }
+    return key;
+}
+
+bool http_pool_acquire(esp_http_client_pool_handle_t pool, const char *key, esp_transport_list_handle_t *list, esp_transport_handle_t *transport)
+{
+    struct http_pool_list garbage = TAILQ_HEAD_INITIALIZER(garbage);
+    http_pool_entry_t *found = NULL;
+    http_pool_entry_t *session = NULL;
+
+    xSemaphoreTake(pool->lock, portMAX_DELAY);
+    http_pool_collect_expired(pool, &garbage);
+    http_pool_entry_t *entry, *tmp;
+    for (entry = TAILQ_FIRST(&pool->entries); entry != NULL; entry = tmp) {
+        tmp = TAILQ_NEXT(entry, next);
+        if (strcmp(entry->key, key) != 0) {
+            continue;
+        }
+        if (entry->transport == NULL) {
+            if (session == NULL) {
+                session = entry;
+            }
+            continue;
+        }
+        TAILQ_REMOVE(&pool->entries, entry, next);
+        pool->stats.idle--;
+        /* An idle keep-alive connection must not be readable: data or FIN means the
+         * server has closed it (or it is out of sync) and it cannot be reused */
+        if (esp_transport_poll_read(entry->transport, 0) != 0) {
+            ESP_LOGD(TAG, "Drop pooled connection to %s closed by peer", key);
+            TAILQ_INSERT_TAIL(&garbage, entry, next);
+            pool->stats.evicted++;
+            continue;
+        }
+        found = entry;
+        pool->stats.reused++;
+        break;
+    }
+    if (found == NULL && session != NULL) {
+        TAILQ_REMOVE(&pool->entries, session, next);
+        pool->stats.idle--;
+        pool->stats.resumed++;
+        found = session;
+    }
+    if (found == NULL) {
+        pool->stats.missed++;
+    }
+    xSemaphoreGive(pool->lock);
+
+    http_pool_free_garbage(&garbage);
+    if (found == NULL) {
+        return false;
+    }
+    *list = found->list;
+    *transport = found->transport;
+    free(found->key);
+    free(found);
+    return true;
+}
+
+void http_pool_release(esp_http_client_pool_handle_t pool, const char *key, esp_transport_list_handle_t list, esp_transport_handle_t transport)
+{
+    struct http_pool_list garbage = TAILQ_HEAD_INITIALIZER(garbage);
+    http_pool_entry_t *entry = calloc(1, sizeof(http_pool_entry_t));
+    if (entry == NULL || (entry->key = strdup(key)) == NULL) {
+        ESP_LOGD(TAG, "No memory to pool connection to %s", key);
+        free(entry);
+        esp_transport_list_destroy(list);
+        return;
+    }
+    entry->list = list;
+    entry->transport = transport;
+    entry->released = xTaskGetTickCount();
+
+    xSemaphoreTake(pool->lock, portMAX_DELAY);
+    http_pool_collect_expired(pool, &garbage);
+    TAILQ_INSERT_HEAD(&pool->entries, entry, next);
+    pool->stats.idle++;
+
+    /* Enforce the limits by evicting the least recently used entries, walking from the tail */
+    int per_host = 0;
+    http_pool_entry_t *it, *tmp;
+    TAILQ_FOREACH(it, &pool->entries, next) {
+        if (strcmp(it->key, key) == 0) {
+            per_host++;
+        }
+    }
+    for (it = TAILQ_LAST(&pool->entries, http_pool_list); it != NULL; it = tmp) {
+        tmp = TAILQ_PREV(it, http_pool_list, next);
+        bool same_host = (strcmp(it->key, key) == 0);
+        if ((int)pool->stats.idle <= pool->config.max_idle && (!same_host || per_host <= pool->config.max_idle_per_host)) {
+            continue;
+        }
+        if (same_host) {
+            per_host--;
+        }
+        TAILQ_REMOVE(&pool->entries, it, next);
+        TAILQ_INSERT_TAIL(&garbage, it, next);
+        pool->stats.idle--;
+        pool->stats.evicted++;
+    }
+    xSemaphoreGive(pool->lock);
+
+    http_pool_free_garbage(&garbage);
+}
+
+esp_err_t esp_http_client_pool_create(const esp_http_client_pool_config_t *config, esp_http_client_pool_handle_t *ret_pool)
+{
+    ESP_RETURN_ON_FALSE(config && ret_pool, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    ESP_RETURN_ON_FALSE(config->max_idle_per_host >= 0 && config->max_idle >= 0, ESP_ERR_INVALID_ARG, TAG, "Invalid pool limits");
+
+    esp_http_client_pool_handle_t pool = calloc(1, sizeof(struct esp_http_client_pool));
+    ESP_RETURN_ON_FALSE(pool, ESP_ERR_NO_MEM, TAG, "Memory exhausted");
+    pool->lock = xSemaphoreCreateMutex();
+    if (pool->lock == NULL) {
+        free(pool);
+        ESP_LOGE(TAG, "Failed to create pool lock");
+        return ESP_ERR_NO_MEM;
+    }
+    pool->config = *config;
+    TAILQ_INIT(&pool->entries);
+    *ret_pool = pool;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_pool_flush(esp_http_client_pool_handle_t pool)
+{
+    ESP_RETURN_ON_FALSE(pool, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    struct http_pool_list garbage = TAILQ_HEAD_INITIALIZER(garbage);
+
+    xSemaphoreTake(pool->lock, portMAX_DELAY);
+    TAILQ_CONCAT(&garbage, &pool->entries, next);
+    pool->stats.idle = 0;
+    xSemaphoreGive(pool->lock);
+
+    http_pool_free_garbage(&garbage);
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_pool_get_stats(esp_http_client_pool_handle_t pool, esp_http_client_pool_stats_t *stats)
+{
+    ESP_RETURN_ON_FALSE(pool && stats, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    xSemaphoreTake(pool->lock, portMAX_DELAY);
+    *stats = pool->stats;
+    xSemaphoreGive(pool->lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_pool_delete(esp_http_client_pool_handle_t pool)
+{
+    ESP_RETURN_ON_FALSE(pool, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    esp_http_client_pool_flush(pool);
+    vSemaphoreDelete(pool->lock);
+    free(pool);
+    return ESP_OK;
+}
@@ -0,0 +1,69 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _HTTP_CLIENT_INTERNAL_H_
+#define _HTTP_CLIENT_INTERNAL_H_
+
+#include "esp_err.h"
+#include "esp_transport.h"
+#include "esp_http_client.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief      Connect the client, if not connected yet, and get its transport
+ *             Used by the request engines built on top of a client handle
+ *
+ * @param[in]  client     The esp_http_client handle
+ * @param[out] transport  The connected transport
+ *
+ * @return
+ *     - ESP_OK on success
+ *     - Error code of the connection otherwise
+ */
+esp_err_t http_client_connect_transport(esp_http_client_handle_t client, esp_transport_handle_t *transport);
+
+/**
+ * @brief      Generate the headers set on the client, terminated by an empty line
+ *             Content-Length is left out and left to the caller, a value set on the client is kept
+ *
+ * @param[in]  client      The esp_http_client handle
+ * @param[out] buffer      The buffer
+ * @param[in]  buffer_len  The buffer length
+ *
+ * @return
+ *     - Length of the generated headers
+ *     - -1 if they do not fit in the buffer
+ */
+int http_client_generate_headers(esp_http_client_handle_t client, char *buffer, int buffer_len);
+
+/**
+ * @brief      Get the request line name of an HTTP method
+ *
+ * @param[in]  method  The HTTP method
+ *
+ * @return
+ *     - Method name, e.g. "GET"
+ *     - NULL if the method is invalid
+ */
+const char *http_client_method_str(esp_http_client_method_t method);
+
+/**
+ * @brief      Get the network timeout of the client
+ *
+ * @param[in]  client  The esp_http_client handle
+ *
+ * @return     Timeout in milliseconds
+ */
+int http_client_get_timeout_ms(esp_http_client_handle_t client);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HTTP_CLIENT_INTERNAL_H_ */
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2021 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -7,6 +7,8 @@
 #ifndef _HTTP_HEADER_H_
 #define _HTTP_HEADER_H_
 
+#include <stdbool.h>
+#include <stddef.h>
 #include "sys/queue.h"
 #include "esp_err.h"
 
@@ -27,7 +29,8 @@ typedef struct http_header_item *http_header_item_handle_t;
 http_header_handle_t http_header_init(void);
 
 /**
- * @brief      Cleanup and free all http header pairs
+ * @brief      Remove all http header pairs
+ *             The memory holding the headers is kept and reused by the next headers added to the object
  *
  * @param[in]  header  The header
  *
@@ -76,7 +79,9 @@ int http_header_set_format(http_header_handle_t header, const char *key, const c
 
 /**
  * @brief      Get a value of header in header list
- *             The address of the value will be assign set to `value` parameter or NULL if no header with the key exists in the list
+ *             The address of the value will be assign set to `value` parameter or NULL if no header with the key exists in the list.
+ *             It stays valid until the header with this key is set again or deleted, or the header object is cleaned.
+ *             Adding, changing or removing other headers does not move it
  *
  * @param[in]  header  The header
  * @param[in]  key     The key
@@ -101,6 +106,21 @@ esp_err_t http_header_get(http_header_handle_t header, const char *key, char **v
  */
 int http_header_generate_string(http_header_handle_t header, int index, char *buffer, int *buffer_len);
 
+/**
+ * @brief      Create the HTTP header string of all headers but the one with `skip_key`,
+ *             terminated by an empty line
+ *
+ * @param[in]  header      The header
+ * @param[in]  skip_key    The key of the header to leave out
+ * @param[out] buffer      The buffer
+ * @param[in]  buffer_len  The buffer length
+ *
+ * @return
+ *     - Length of the generated string
+ *     - -1 if it does not fit in the buffer
+ */
+int http_header_generate_string_except(http_header_handle_t header, const char *skip_key, char *buffer, int buffer_len);
+
 /**
  * @brief      Remove the header with key from the headers list
  *
@@ -113,6 +133,57 @@ int http_header_generate_string(http_header_handle_t header, int index, char *bu
  */
 esp_err_t http_header_delete(http_header_handle_t header, const char *key);
 
+/**
+ * @brief      Append a fragment of the name of a received header
+ *             Fragments are concatenated in the header storage, until http_header_commit() is called
+ *
+ * @param[in]  header  The header
+ * @param[in]  at      The fragment
+ * @param[in]  length  The fragment length
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_NO_MEM
+ */
+esp_err_t http_header_append_field(http_header_handle_t header, const char *at, size_t length);
+
+/**
+ * @brief      Append a fragment of the value of the received header started with http_header_append_field()
+ *
+ * @param[in]  header  The header
+ * @param[in]  at      The fragment
+ * @param[in]  length  The fragment length
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_STATE if no header name was received
+ *     - ESP_ERR_NO_MEM
+ */
+esp_err_t http_header_append_value(http_header_handle_t header, const char *at, size_t length);
+
+/**
+ * @brief      Check whether a received header has both its name and value pending to be committed
+ *
+ * @param[in]  header  The header
+ *
+ * @return     true if http_header_commit() would add a header
+ */
+bool http_header_has_pending(http_header_handle_t header);
+
+/**
+ * @brief      Add the received header to the list, with whitespace trimmed from its name and value
+ *
+ * @param[in]  header  The header
+ * @param[out] key     The name of the added header, valid until the header object is cleaned
+ * @param[out] value   The value of the added header, valid until the header object is cleaned
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_NOT_FOUND if no complete header is pending
+ *     - ESP_ERR_NO_MEM
+ */
+esp_err_t http_header_commit(http_header_handle_t header, const char **key, const char **value);
+
 #ifdef __cplusplus
 }
 #endif
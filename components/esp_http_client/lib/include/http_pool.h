@@ -0,0 +1,71 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _HTTP_POOL_H_
+#define _HTTP_POOL_H_
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_transport.h"
+#include "esp_http_client.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief      Build the key used to match pooled connections, "scheme://host:port settings"
+ *
+ *             Connections are only handed out to clients with the same key, so the transport
+ *             configuration of the client must be part of `settings`.
+ *
+ * @param[in]  scheme    The URL scheme
+ * @param[in]  host      The host name
+ * @param[in]  port      The port
+ * @param[in]  settings  Description of the transport configuration of the client
+ *
+ * @return
+ *     - Allocated key string, to be freed by the caller
+ *     - NULL if out of memory
+ */
+char *http_pool_make_key(const char *scheme, const char *host, int port, const char *settings);
+
+/**
+ * @brief      Take an idle connection for the key out of the pool
+ *
+ *             Connections that have been idle for too long, or whose peer has closed them meanwhile,
+ *             are dropped. If only a closed connection carrying a TLS session ticket is available,
+ *             its transport list is returned with `*transport` set to NULL so the caller can
+ *             reconnect with the saved ticket.
+ *
+ * @param[in]  pool       The connection pool
+ * @param[in]  key        Key built with http_pool_make_key()
+ * @param[out] list       Transport list owning the connection
+ * @param[out] transport  Connected transport, or NULL if only a session ticket was found
+ *
+ * @return
+ *     - true   if a transport list was taken from the pool
+ *     - false  if nothing usable was pooled for this key
+ */
+bool http_pool_acquire(esp_http_client_pool_handle_t pool, const char *key, esp_transport_list_handle_t *list, esp_transport_handle_t *transport);
+
+/**
+ * @brief      Hand a transport list over to the pool
+ *
+ *             The pool takes ownership of the list, and destroys it right away if it cannot be kept.
+ *
+ * @param[in]  pool       The connection pool
+ * @param[in]  key        Key built with http_pool_make_key()
+ * @param[in]  list       Transport list owning the connection
+ * @param[in]  transport  Idle connected transport, or NULL to only keep the TLS session ticket of the list
+ */
+void http_pool_release(esp_http_client_pool_handle_t pool, const char *key, esp_transport_list_handle_t list, esp_transport_handle_t transport);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HTTP_POOL_H_ */
@@ -6,8 +6,16 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
 #include <esp_system.h>
 #include <esp_http_client.h>
+#include <esp_timer.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "lwip/sockets.h"
 
 #include "unity.h"
 #include "test_utils.h"
@@ -186,6 +194,351 @@ TEST_CASE("esp_http_client_set_header() should not return error if header value
     esp_http_client_cleanup(client);
 }
 
+#define LOOPBACK_SERVER_PORT        8071
+#define LOOPBACK_SERVER_URL         "http://127.0.0.1:8071/"
+#define LOOPBACK_SERVER_RESPONSE    "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok"
+#define LOOPBACK_SERVER_INTERIM     "HTTP/1.1 100 Continue\r\n\r\n"
+
+typedef struct {
+    volatile bool stop;
+    int connections;
+    int requests;
+    int close_after;    /*!< Close the connection after answering this many requests on it, 0 to keep it open */
+    bool interim;       /*!< Send a 100 Continue response before every response */
+    SemaphoreHandle_t done;
+} loopback_server_t;
+
+/* Minimal keep-alive HTTP server on the loopback interface, serving one connection at a time
+ * and answering every request header block with a fixed response */
+static void loopback_server_task(void *arg)
+{
+    loopback_server_t *server = arg;
+    int listen_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    TEST_ASSERT(listen_sock >= 0);
+    int opt = 1;
+    setsockopt(listen_sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(LOOPBACK_SERVER_PORT),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    TEST_ASSERT_EQUAL(0, bind(listen_sock, (struct sockaddr *)&addr, sizeof(addr)));
+    TEST_ASSERT_EQUAL(0, listen(listen_sock, 4));
+    xSemaphoreGive(server->done);
+
+    struct timeval timeout = { .tv_sec = 0, .tv_usec = 100 * 1000 };
+    while (!server->stop) {
+        fd_set readset;
+        FD_ZERO(&readset);
+        FD_SET(listen_sock, &readset);
+        struct timeval select_timeout = timeout;
+        if (select(listen_sock + 1, &readset, NULL, NULL, &select_timeout) <= 0) {
+            continue;
+        }
+        int sock = accept(listen_sock, NULL, NULL);
+        if (sock < 0) {
+            continue;
+        }
+        server->connections++;
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        char buf[512];
+        size_t len = 0;
+        int answered = 0;
+        while (!server->stop && (server->close_after == 0 || answered < server->close_after)) {
+            int n = recv(sock, buf + len, sizeof(buf) - 1 - len, 0);
+            if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                break;
+            }
+            if (n < 0) {
+                continue;
+            }
+            len += n;
+            buf[len] = '\0';
+            char *end;
+            while ((end = strstr(buf, "\r\n\r\n")) != NULL) {
+                /* Skip the request body, pipelined requests may follow it in the buffer */
+                size_t request_len = end + 4 - buf;
+                char *content_length = strstr(buf, "Content-Length: ");
+                if (content_length && content_length < end) {
+                    request_len += strtoul(content_length + strlen("Content-Length: "), NULL, 10);
+                }
+                if (request_len > len || (server->close_after && answered == server->close_after)) {
+                    break;
+                }
+                server->requests++;
+                answered++;
+                if (server->interim) {
+                    send(sock, LOOPBACK_SERVER_INTERIM, strlen(LOOPBACK_SERVER_INTERIM), 0);
+                }
+                send(sock, LOOPBACK_SERVER_RESPONSE, strlen(LOOPBACK_SERVER_RESPONSE), 0);
+                len -= request_len;
+                memmove(buf, buf + request_len, len + 1);
+            }
+        }
+        close(sock);
+    }
+    close(listen_sock);
+    xSemaphoreGive(server->done);
+    vTaskDelete(NULL);
+}
+
+static void loopback_server_start(loopback_server_t *server)
+{
+    memset(server, 0, sizeof(*server));
+    server->done = xSemaphoreCreateBinary();
+    TEST_ASSERT_NOT_NULL(server->done);
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(loopback_server_task, "loopback_srv", 4096, server, 5, NULL));
+    TEST_ASSERT(xSemaphoreTake(server->done, pdMS_TO_TICKS(1000)));
+}
+
+static void loopback_server_stop(loopback_server_t *server)
+{
+    server->stop = true;
+    TEST_ASSERT(xSemaphoreTake(server->done, pdMS_TO_TICKS(1000)));
+    vSemaphoreDelete(server->done);
+}
+
+/* Performs requests through short lived client handles, as an application issuing independent
+ * requests from different places would, and returns the elapsed time in microseconds */
+static int64_t pool_test_run(esp_http_client_pool_handle_t pool, int requests)
+{
+    esp_http_client_config_t config = {
+        .url = LOOPBACK_SERVER_URL,
+        .connection_pool = pool,
+    };
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < requests; i++) {
+        esp_http_client_handle_t client = esp_http_client_init(&config);
+        TEST_ASSERT_NOT_NULL(client);
+        TEST_ESP_OK(esp_http_client_perform(client));
+        TEST_ASSERT_EQUAL(200, esp_http_client_get_status_code(client));
+        esp_http_client_cleanup(client);
+    }
+    return esp_timer_get_time() - start;
+}
+
+#define POOL_TEST_REQUESTS  50
+
+TEST_CASE("Connection pool reuses keep-alive connections across handles", "[ESP HTTP CLIENT]")
+{
+    test_case_uses_tcpip();
+    loopback_server_t server;
+    loopback_server_start(&server);
+
+    int64_t plain_us = pool_test_run(NULL, POOL_TEST_REQUESTS);
+    TEST_ASSERT_EQUAL(POOL_TEST_REQUESTS, server.connections);
+
+    esp_http_client_pool_config_t pool_config = ESP_HTTP_CLIENT_POOL_DEFAULT_CONFIG();
+    esp_http_client_pool_handle_t pool = NULL;
+    TEST_ESP_OK(esp_http_client_pool_create(&pool_config, &pool));
+    server.connections = 0;
+    int64_t pooled_us = pool_test_run(pool, POOL_TEST_REQUESTS);
+
+    esp_http_client_pool_stats_t stats;
+    TEST_ESP_OK(esp_http_client_pool_get_stats(pool, &stats));
+    TEST_ASSERT_EQUAL(1, server.connections);
+    TEST_ASSERT_EQUAL(1, stats.missed);
+    TEST_ASSERT_EQUAL(POOL_TEST_REQUESTS - 1, stats.reused);
+    TEST_ASSERT_EQUAL(1, stats.idle);
+
+    printf("%d requests: %" PRId64 " req/s without pool, %" PRId64 " req/s with pool\n", POOL_TEST_REQUESTS,
+           POOL_TEST_REQUESTS * 1000000LL / plain_us, POOL_TEST_REQUESTS * 1000000LL / pooled_us);
+
+    /* A connection closed by the server while idle in the pool must not be handed out again */
+    loopback_server_stop(&server);
+    loopback_server_start(&server);
+    pool_test_run(pool, 1);
+    TEST_ESP_OK(esp_http_client_pool_get_stats(pool, &stats));
+    TEST_ASSERT_EQUAL(1, server.connections);
+    TEST_ASSERT_EQUAL(1, stats.evicted);
+
+    TEST_ESP_OK(esp_http_client_pool_flush(pool));
+    TEST_ESP_OK(esp_http_client_pool_get_stats(pool, &stats));
+    TEST_ASSERT_EQUAL(0, stats.idle);
+    TEST_ESP_OK(esp_http_client_pool_delete(pool));
+    loopback_server_stop(&server);
+}
+
+TEST_CASE("Connection pool does not share connections between transport configurations", "[ESP HTTP CLIENT]")
+{
+    test_case_uses_tcpip();
+    loopback_server_t server;
+    loopback_server_start(&server);
+
+    esp_http_client_pool_config_t pool_config = ESP_HTTP_CLIENT_POOL_DEFAULT_CONFIG();
+    esp_http_client_pool_handle_t pool = NULL;
+    TEST_ESP_OK(esp_http_client_pool_create(&pool_config, &pool));
+    pool_test_run(pool, 1);
+
+    /* The pooled transport was set up without TCP keep-alive, a client asking for it must open its own connection */
+    esp_http_client_config_t config = {
+        .url = LOOPBACK_SERVER_URL,
+        .connection_pool = pool,
+        .keep_alive_enable = true,
+    };
+    for (int i = 0; i < 2; i++) {
+        esp_http_client_handle_t client = esp_http_client_init(&config);
+        TEST_ASSERT_NOT_NULL(client);
+        TEST_ESP_OK(esp_http_client_perform(client));
+        TEST_ASSERT_EQUAL(200, esp_http_client_get_status_code(client));
+        /* Frees the keep-alive configuration referenced by the transport, the pooled connection must not need it */
+        esp_http_client_cleanup(client);
+    }
+
+    esp_http_client_pool_stats_t stats;
+    TEST_ESP_OK(esp_http_client_pool_get_stats(pool, &stats));
+    TEST_ASSERT_EQUAL(2, server.connections);
+    TEST_ASSERT_EQUAL(2, stats.missed);
+    TEST_ASSERT_EQUAL(1, stats.reused);
+    TEST_ASSERT_EQUAL(2, stats.idle);
+
+    TEST_ESP_OK(esp_http_client_pool_delete(pool));
+    loopback_server_stop(&server);
+}
+
+#define PIPELINE_TEST_RECORDS   200
+
+typedef struct {
+    int completed;
+    int ok;
+} pipeline_test_ctx_t;
+
+static void pipeline_test_on_complete(const esp_http_client_pipeline_result_t *result, void *arg)
+{
+    pipeline_test_ctx_t *ctx = arg;
+    ctx->completed++;
+    if (result->err == ESP_OK && result->status_code == 200 && result->body_len == 2 && memcmp(result->body, "ok", 2) == 0) {
+        ctx->ok++;
+    }
+}
+
+/* Posts small records through a pipeline and returns the elapsed time in microseconds */
+static int64_t pipeline_test_run(int max_in_flight, pipeline_test_ctx_t *ctx)
+{
+    esp_http_client_config_t client_config = {
+        .url = LOOPBACK_SERVER_URL,
+    };
+    esp_http_client_pipeline_config_t config = ESP_HTTP_CLIENT_PIPELINE_DEFAULT_CONFIG();
+    config.client_config = &client_config;
+    config.max_in_flight = max_in_flight;
+    config.queue_size = 32;
+    config.on_complete = pipeline_test_on_complete;
+    config.on_complete_arg = ctx;
+    esp_http_client_pipeline_handle_t pipeline = NULL;
+    TEST_ESP_OK(esp_http_client_pipeline_create(&config, &pipeline));
+    TEST_ESP_OK(esp_http_client_set_header(esp_http_client_pipeline_get_client(pipeline), "Content-Type", "application/json"));
+
+    char record[64];
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < PIPELINE_TEST_RECORDS; i++) {
+        int len = snprintf(record, sizeof(record), "{\"id\":%d,\"value\":%d}", i, i * 7);
+        esp_http_client_pipeline_request_t request = {
+            .method = HTTP_METHOD_POST,
+            .path = "/records",
+            .data = record,
+            .data_len = len,
+        };
+        TEST_ESP_OK(esp_http_client_pipeline_submit(pipeline, &request, portMAX_DELAY));
+    }
+    TEST_ESP_OK(esp_http_client_pipeline_flush(pipeline, pdMS_TO_TICKS(10000)));
+    int64_t elapsed = esp_timer_get_time() - start;
+    TEST_ESP_OK(esp_http_client_pipeline_destroy(pipeline));
+    return elapsed;
+}
+
+TEST_CASE("Pipeline posts records with 1, 4 and 16 requests in flight", "[ESP HTTP CLIENT]")
+{
+    test_case_uses_tcpip();
+    loopback_server_t server;
+    loopback_server_start(&server);
+
+    const int in_flight[] = { 1, 4, 16 };
+    for (size_t i = 0; i < sizeof(in_flight) / sizeof(in_flight[0]); i++) {
+        pipeline_test_ctx_t ctx = { 0 };
+        server.connections = 0;
+        server.requests = 0;
+        int64_t elapsed_us = pipeline_test_run(in_flight[i], &ctx);
+        TEST_ASSERT_EQUAL(PIPELINE_TEST_RECORDS, ctx.completed);
+        TEST_ASSERT_EQUAL(PIPELINE_TEST_RECORDS, ctx.ok);
+        TEST_ASSERT_EQUAL(PIPELINE_TEST_RECORDS, server.requests);
+        TEST_ASSERT_EQUAL(1, server.connections);
+        printf("%d records with %d in flight: %" PRId64 " records/s\n", PIPELINE_TEST_RECORDS, in_flight[i],
+               PIPELINE_TEST_RECORDS * 1000000LL / elapsed_us);
+    }
+    loopback_server_stop(&server);
+}
+
+TEST_CASE("Pipeline skips interim responses", "[ESP HTTP CLIENT]")
+{
+    test_case_uses_tcpip();
+    loopback_server_t server;
+    loopback_server_start(&server);
+    server.interim = true;
+
+    pipeline_test_ctx_t ctx = { 0 };
+    pipeline_test_run(16, &ctx);
+    TEST_ASSERT_EQUAL(PIPELINE_TEST_RECORDS, ctx.completed);
+    TEST_ASSERT_EQUAL(PIPELINE_TEST_RECORDS, ctx.ok);
+    TEST_ASSERT_EQUAL(1, server.connections);
+    loopback_server_stop(&server);
+}
+
+static void pipeline_test_store_result(const esp_http_client_pipeline_result_t *result, void *arg)
+{
+    esp_err_t *err = result->user_ctx;
+    *err = (result->err == ESP_OK && result->status_code != 200) ? ESP_FAIL : result->err;
+}
+
+TEST_CASE("Pipeline replays only idempotent requests on a closed connection", "[ESP HTTP CLIENT]")
+{
+    test_case_uses_tcpip();
+    loopback_server_t server;
+    loopback_server_start(&server);
+    server.close_after = 2;
+
+    esp_http_client_config_t client_config = {
+        .url = LOOPBACK_SERVER_URL,
+    };
+    esp_http_client_pipeline_config_t config = ESP_HTTP_CLIENT_PIPELINE_DEFAULT_CONFIG();
+    config.client_config = &client_config;
+    config.max_in_flight = 4;
+    config.on_complete = pipeline_test_store_result;
+    esp_http_client_pipeline_handle_t pipeline = NULL;
+    TEST_ESP_OK(esp_http_client_pipeline_create(&config, &pipeline));
+
+    /* The first request is sent alone, the next four are in flight when the server closes the
+     * connection after answering the second one */
+    const esp_http_client_method_t methods[] = {
+        HTTP_METHOD_GET, HTTP_METHOD_GET, HTTP_METHOD_POST, HTTP_METHOD_GET, HTTP_METHOD_POST,
+    };
+    esp_err_t results[sizeof(methods) / sizeof(methods[0])];
+    for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++) {
+        results[i] = ESP_ERR_INVALID_STATE;
+        esp_http_client_pipeline_request_t request = {
+            .method = methods[i],
+            .path = "/records",
+            .data = methods[i] == HTTP_METHOD_POST ? "{}" : NULL,
+            .data_len = methods[i] == HTTP_METHOD_POST ? 2 : 0,
+            .user_ctx = &results[i],
+        };
+        TEST_ESP_OK(esp_http_client_pipeline_submit(pipeline, &request, portMAX_DELAY));
+    }
+    TEST_ESP_OK(esp_http_client_pipeline_flush(pipeline, pdMS_TO_TICKS(10000)));
+    TEST_ESP_OK(esp_http_client_pipeline_destroy(pipeline));
+
+    for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++) {
+        if (methods[i] == HTTP_METHOD_POST) {
+            /* The server may have processed it, it must not be sent again */
+            TEST_ASSERT_EQUAL(ESP_ERR_HTTP_CONNECTION_CLOSED, results[i]);
+        } else {
+            TEST_ASSERT_EQUAL(ESP_OK, results[i]);
+        }
+    }
+    TEST_ASSERT_EQUAL(2, server.connections);
+    TEST_ASSERT_GREATER_OR_EQUAL(3, server.requests);
+    loopback_server_stop(&server);
+}
+
 void app_main(void)
 {
     unity_run_menu();
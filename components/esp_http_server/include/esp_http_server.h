@@ -14,6 +14,7 @@
 #include <http_parser.h>
 #include <sdkconfig.h>
 #include <esp_err.h>
+#include <esp_heap_caps.h>
 #include <esp_event.h>
 #include <esp_event_base.h>
 
@@ -1668,6 +1669,129 @@ esp_err_t httpd_queue_work(httpd_handle_t handle, httpd_work_fn_t work, void *ar
  * @}
  */
 
+/* ************** Group: Static Files ************** */
+/** @name Static Files
+ * APIs related to serving files from a VFS path
+ * @{
+ */
+
+/**
+ * @brief Static file handler configuration
+ */
+typedef struct httpd_static_config {
+    /**
+     * URI template under which files are served, e.g. "/static/?*".
+     * Requires httpd_uri_match_wildcard() as the server's uri_match_fn
+     * unless the template names a single file. The part of the request URI
+     * following the template prefix is appended to base_path.
+     */
+    const char *uri;
+
+    /**
+     * VFS directory the files are served from, e.g. "/spiffs/www"
+     */
+    const char *base_path;
+
+    /**
+     * File served for request URIs ending in '/', NULL to respond with 404 instead
+     */
+    const char *index_file;
+
+    /**
+     * Value of the Cache-Control response header, NULL to omit the header
+     */
+    const char *cache_control;
+
+    /**
+     * Size of the transfer buffer. It is allocated once at registration and
+     * reused for every request served by this handler.
+     */
+    size_t buf_size;
+
+    /**
+     * Serve "<file>.br" or "<file>.gz" in place of "<file>" when present and
+     * accepted by the client's Accept-Encoding header
+     */
+    bool serve_precompressed;
+
+    /**
+     * Files of up to this size are kept in an in-memory LRU cache after being
+     * read once, 0 to disable caching. Cached data is revalidated with the
+     * modification time and size of the file, so files whose modification
+     * time is 0 are never cached.
+     */
+    size_t cache_max_file_size;
+
+    /**
+     * Upper bound on the total size of cached file data
+     */
+    size_t cache_max_total;
+
+    /**
+     * Heap capabilities used for cached file data, e.g. MALLOC_CAP_SPIRAM
+     */
+    uint32_t cache_caps;
+} httpd_static_config_t;
+
+#define HTTPD_STATIC_DEFAULT_CONFIG() {                 \
+        .uri                 = "/*",                    \
+        .base_path           = NULL,                    \
+        .index_file          = "index.html",            \
+        .cache_control       = NULL,                    \
+        .buf_size            = 4096,                    \
+        .serve_precompressed = true,                    \
+        .cache_max_file_size = 0,                       \
+        .cache_max_total     = 0,                       \
+        .cache_caps          = MALLOC_CAP_DEFAULT,      \
+}
+
+/**
+ * @brief   Registers a handler serving files from a VFS directory
+ *
+ * The handler is registered for both HTTP_GET and HTTP_HEAD on config->uri.
+ * Responses carry Content-Length, Content-Type (derived from the file
+ * extension), ETag and Last-Modified headers. Requests with If-None-Match
+ * or If-Modified-Since are answered with "304 Not Modified" when the file
+ * is unchanged, and a single "bytes=" Range is answered with
+ * "206 Partial Content" (or "416 Range Not Satisfiable").
+ *
+ * @note    The validators are derived from the modification time and size of
+ *          the file. File systems that do not track modification times report
+ *          0 (e.g. SPIFFS without CONFIG_SPIFFS_USE_MTIME), so such files are
+ *          served without ETag and Last-Modified, conditional requests always
+ *          get the full file and the files are not cached.
+ *
+ * @note    Up to 7 response headers are set per request, so max_resp_headers
+ *          in httpd_config_t must allow for them.
+ *
+ * @param[in] handle  Handle to server returned by httpd_start
+ * @param[in] config  Static file handler configuration. Strings are copied.
+ *
+ * @return
+ *  - ESP_OK : On successfully registering the handler
+ *  - ESP_ERR_INVALID_ARG : Null arguments or zero buf_size
+ *  - ESP_ERR_HTTPD_ALLOC_MEM : Failed to allocate the handler context
+ *  - Errors returned by httpd_register_uri_handler()
+ */
+esp_err_t httpd_register_static_handler(httpd_handle_t handle, const httpd_static_config_t *config);
+
+/**
+ * @brief   Unregisters a static file handler and frees its buffer and cache
+ *
+ * @param[in] handle  Handle to server returned by httpd_start
+ * @param[in] uri     URI template passed at registration
+ *
+ * @return
+ *  - ESP_OK : On successfully unregistering the handler
+ *  - ESP_ERR_INVALID_ARG : Null arguments
+ *  - ESP_ERR_NOT_FOUND   : No static file handler registered for uri
+ */
+esp_err_t httpd_unregister_static_handler(httpd_handle_t handle, const char *uri);
+
+/** End of Group Static Files
+ * @}
+ */
+
 /* ************** Group: WebSocket ************** */
 /** @name WebSocket
  * Functions and structs for WebSocket server
@@ -1755,6 +1879,11 @@ esp_err_t httpd_ws_send_frame(httpd_req_t *req, httpd_ws_frame_t *pkt);
  *
  * This API should rarely be called directly, with an exception of asynchronous send using httpd_queue_work.
  *
+ * @note    Broadcast frames still queued for the client are sent first only
+ *          when this is called from the server task, i.e. from a URI handler
+ *          or a function queued with httpd_queue_work(). Called from another
+ *          task, the frame may overtake them.
+ *
  * @param[in] hd      Server instance data
  * @param[in] fd      Socket descriptor for sending data
  * @param[in] frame     WebSocket frame
@@ -1808,6 +1937,49 @@ esp_err_t httpd_ws_send_data(httpd_handle_t handle, int socket, httpd_ws_frame_t
 esp_err_t httpd_ws_send_data_async(httpd_handle_t handle, int socket, httpd_ws_frame_t *frame,
                                    transfer_complete_cb callback, void *arg);
 
+/**
+ * @brief Prototype of the filter selecting the recipients of httpd_ws_broadcast()
+ *
+ * @param[in] hd    Server instance data
+ * @param[in] fd    Socket descriptor of a WebSocket client
+ * @param[in] arg   User data passed to httpd_ws_broadcast()
+ * @return true if the frame is to be sent to this client
+ */
+typedef bool (*httpd_ws_filter_fn_t)(httpd_handle_t hd, int fd, void *arg);
+
+/**
+ * @brief Sends a frame to many websocket clients asynchronously
+ *
+ * The frame is encoded and its payload copied once, then sent to every
+ * WebSocket client accepted by the filter in a single pass of the server
+ * task. Sends do not block: data that does not fit in a client's socket
+ * buffer is queued and sent once the socket becomes writable. Clients that
+ * already have CONFIG_HTTPD_WS_BROADCAST_QUEUE_LEN frames queued either
+ * miss this frame or get disconnected, according to the
+ * CONFIG_HTTPD_WS_BROADCAST_OVERFLOW setting.
+ *
+ * @note    The filter is called from the server task, the payload can be
+ *          freed as soon as this function returns.
+ *
+ * @note    Sends are done with the MSG_DONTWAIT flag. A send function
+ *          installed with httpd_sess_set_send_override(), such as the one of
+ *          esp_https_server, may ignore the flag and block until the data is
+ *          written. Slow clients of such sessions then block the server task
+ *          instead of being queued.
+ *
+ * @param[in] handle  Server instance data
+ * @param[in] filter  Function selecting the recipients, NULL for all WebSocket clients
+ * @param[in] arg     User data passed to the filter
+ * @param[in] frame   Websocket frame
+ * @return
+ *  - ESP_OK                    : On successfully queueing the broadcast
+ *  - ESP_ERR_INVALID_ARG       : Null arguments
+ *  - ESP_ERR_NO_MEM            : Unable to allocate memory
+ *  - ESP_FAIL                  : Failure in ctrl socket
+ */
+esp_err_t httpd_ws_broadcast(httpd_handle_t handle, httpd_ws_filter_fn_t filter, void *arg,
+                             const httpd_ws_frame_t *frame);
+
 #endif /* CONFIG_HTTPD_WS_SUPPORT || __DOXYGEN__ */
 /** End of WebSocket related stuff
  * @}
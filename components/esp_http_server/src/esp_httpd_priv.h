@@ -9,6 +9,7 @@
 #define _HTTPD_PRIV_H_
 
 #include <stdbool.h>
+#include <sys/queue.h>
 #include <sys/socket.h>
 #include <sys/param.h>
 #include <netinet/in.h>
@@ -75,6 +76,9 @@ struct sock_db {
     esp_err_t (*ws_handler)(httpd_req_t *r);   /*!< WebSocket handler, leave to null if it's not WebSocket */
     bool ws_control_frames;                         /*!< WebSocket flag indicating that control frames should be passed to user handlers */
     void *ws_user_ctx;                         /*!< Pointer to user context data which will be available to handler for websocket*/
+    struct ws_tx_entry *ws_tx_head;         /*!< Queue of broadcast frames not yet fully sent */
+    struct ws_tx_entry *ws_tx_tail;         /*!< Last entry of the broadcast queue */
+    uint8_t ws_tx_count;                    /*!< Number of entries in the broadcast queue */
 #endif
 };
 
@@ -108,6 +112,9 @@ struct httpd_req_aux {
 #endif
 };
 
+/* Context of a static file handler, private to httpd_static.c */
+struct httpd_static_ctx;
+
 /**
  * @brief   Server data for each instance. This is exposed publicly as
  *          httpd_handle_t but internal structure/members are kept private.
@@ -130,6 +137,9 @@ struct httpd_data {
 
     /* Array of registered error handler functions */
     httpd_err_handler_func_t *err_handler_fns;
+
+    /* List of static file handler contexts, see httpd_static.c */
+    SLIST_HEAD(, httpd_static_ctx) static_ctxs;
 };
 
 /******************* Group : Session Management ********************/
@@ -417,6 +427,44 @@ esp_err_t httpd_req_handle_err(httpd_req_t *req, httpd_err_code_t error);
  */
 int httpd_send(httpd_req_t *req, const char *buf, size_t buf_len);
 
+/**
+ * @brief   For sending out the whole of a buffer, retrying on partial sends.
+ *
+ * @param[in] req     Pointer to the HTTP request for which the response needs to be sent
+ * @param[in] buf     Pointer to the buffer to be sent
+ * @param[in] buf_len Length of the buffer
+ *
+ * @return
+ *  - ESP_OK   : if all the data was sent
+ *  - ESP_FAIL : if failed
+ */
+esp_err_t httpd_send_all(httpd_req_t *req, const char *buf, size_t buf_len);
+
+/**
+ * @brief   Value of content_len for httpd_resp_send_hdrs() for responses
+ *          without a body, such as 304 Not Modified
+ */
+#define HTTPD_RESP_NO_BODY  ((size_t) -1)
+
+/**
+ * @brief   Sends the status line and headers of a response with a fixed
+ *          Content-Length, leaving the body to be sent with httpd_send_all()
+ *
+ * This is the header part of httpd_resp_send(), for handlers that stream
+ * a body of known length from a source other than a single buffer.
+ *
+ * @param[in] req         Pointer to the HTTP request for which the response needs to be sent
+ * @param[in] content_len Value of the Content-Length header, or HTTPD_RESP_NO_BODY
+ *                        to send neither Content-Type nor Content-Length
+ *
+ * @return
+ *  - ESP_OK                 : if the headers were sent
+ *  - ESP_ERR_HTTPD_RESP_HDR : if the essential headers do not fit
+ *  - ESP_ERR_HTTPD_ALLOC_MEM: if the header buffer could not be allocated
+ *  - ESP_ERR_HTTPD_RESP_SEND: if sending failed
+ */
+esp_err_t httpd_resp_send_hdrs(httpd_req_t *req, size_t content_len);
+
 /**
  * @brief   For receiving HTTP request data
  *
@@ -497,6 +545,26 @@ int httpd_default_recv(httpd_handle_t hd, int sockfd, char *buf, size_t buf_len,
  * @}
  */
 
+/****************** Group : Static Files ********************/
+/** @name Static Files
+ * Methods for managing static file handlers
+ * @{
+ */
+
+/**
+ * @brief   Free all static file handler contexts of a server instance
+ *
+ * @note    The URI handlers themselves are released separately by
+ *          httpd_unregister_all_uri_handlers().
+ *
+ * @param[in] hd  Server instance data
+ */
+void httpd_static_free_all(struct httpd_data *hd);
+
+/** End of Group : Static Files
+ * @}
+ */
+
 /* ************** Group: WebSocket ************** */
 /** @name WebSocket
  * Functions for WebSocket header parsing
@@ -549,6 +617,43 @@ esp_err_t httpd_ws_get_frame_type(httpd_req_t *req);
  */
 esp_err_t httpd_sess_trigger_close_(httpd_handle_t handle, struct sock_db *session);
 
+/**
+ * @brief   Sends broadcast frames queued for a session
+ *
+ * @param[in] sess      Session
+ * @param[in] blocking  If false, stop as soon as the socket would block
+ *
+ * @return
+ *  - ESP_OK    : if the queue was sent, or the socket would block
+ *  - ESP_FAIL  : on socket errors, the session should then be closed
+ */
+esp_err_t httpd_ws_sess_flush(struct sock_db *sess, bool blocking);
+
+/**
+ * @brief   Frees broadcast frames queued for a session that is being closed
+ *
+ * @param[in] sess  Session
+ */
+void httpd_ws_sess_free_tx(struct sock_db *sess);
+
+/**
+ * @brief   Adds sessions with queued broadcast frames to an fdset for
+ *          select() to wait for them to become writable
+ *
+ * @param[in]     hd     Server instance data
+ * @param[out]    fdset  File descriptor set to be updated
+ * @param[in,out] maxfd  Maximum value among all file descriptors
+ */
+void httpd_ws_sess_set_wr_descriptors(struct httpd_data *hd, fd_set *fdset, int *maxfd);
+
+/**
+ * @brief   Continues sending queued broadcast frames on writable sessions
+ *
+ * @param[in] hd     Server instance data
+ * @param[in] fdset  File descriptor set of writable sockets returned by select()
+ */
+void httpd_ws_sess_process_writable(struct httpd_data *hd, fd_set *fdset);
+
 /** End of WebSocket related functions
  * @}
  */
@@ -290,8 +290,15 @@ static esp_err_t httpd_server(struct httpd_data *hd)
     tmp_max_fd = maxfd;
     maxfd = MAX(hd->ctrl_fd, tmp_max_fd);
 
+    /* Also wait for sockets with queued WebSocket broadcast frames to become writable */
+    fd_set write_set;
+    FD_ZERO(&write_set);
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    httpd_ws_sess_set_wr_descriptors(hd, &write_set, &maxfd);
+#endif
+
     ESP_LOGD(TAG, LOG_FMT("doing select maxfd+1 = %d"), maxfd + 1);
-    int active_cnt = select(maxfd + 1, &read_set, NULL, NULL, NULL);
+    int active_cnt = select(maxfd + 1, &read_set, &write_set, NULL, NULL);
     if (active_cnt < 0) {
         ESP_LOGE(TAG, LOG_FMT("error in select (%d)"), errno);
         httpd_sess_delete_invalid(hd);
@@ -316,6 +323,10 @@ static esp_err_t httpd_server(struct httpd_data *hd)
     };
     httpd_sess_enum(hd, httpd_process_session, &context);
 
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    httpd_ws_sess_process_writable(hd, &write_set);
+#endif
+
     /* Case2: Do we have any incoming connection requests to
      * process? */
     if (FD_ISSET(hd->listen_fd, &read_set)) {
@@ -477,6 +488,9 @@ static void httpd_delete(struct httpd_data *hd)
     /* Free registered URI handlers */
     httpd_unregister_all_uri_handlers(hd);
     free(hd->hd_calls);
+
+    /* Free contexts of static file handlers */
+    httpd_static_free_all(hd);
     free(hd);
 }
 
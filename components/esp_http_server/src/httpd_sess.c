@@ -379,6 +379,11 @@ void httpd_sess_delete(struct httpd_data *hd, struct sock_db *session)
     // clear all contexts
     httpd_sess_clear_ctx(session);
 
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    // drop broadcast frames that were not sent
+    httpd_ws_sess_free_tx(session);
+#endif
+
     // mark session slot as available
     session->fd = -1;
 
@@ -0,0 +1,703 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <esp_log.h>
+#include <esp_err.h>
+#include <esp_heap_caps.h>
+
+#include <esp_http_server.h>
+#include "esp_httpd_priv.h"
+
+static const char *TAG = "httpd_static";
+
+/* Longest path served, including base_path and a ".br"/".gz" suffix */
+#define HTTPD_STATIC_PATH_MAX       (CONFIG_HTTPD_MAX_URI_LEN + 64)
+
+/* Size of the buffers for request headers consulted by the handler */
+#define HTTPD_STATIC_HDR_VAL_LEN    64
+
+/* Length of an IMF-fixdate such as "Sun, 06 Nov 1994 08:49:37 GMT" plus null */
+#define HTTPD_STATIC_DATE_LEN       30
+
+typedef enum {
+    STATIC_ENCODING_IDENTITY = 0,
+    STATIC_ENCODING_BR,
+    STATIC_ENCODING_GZIP,
+} static_encoding_t;
+
+/**
+ * @brief An entry of the in-memory file cache
+ */
+struct static_cache_entry {
+    TAILQ_ENTRY(static_cache_entry) next;   /*!< LRU list linkage, most recently used first */
+    char *path;                             /*!< Full VFS path of the cached file */
+    time_t mtime;                           /*!< Modification time of the file when cached */
+    size_t size;                            /*!< Size of the file, and of data */
+    uint8_t *data;                          /*!< File contents */
+};
+
+/**
+ * @brief Per-request strings of the handler, kept off the stack of the server task
+ */
+struct static_req_bufs {
+    char path[HTTPD_STATIC_PATH_MAX];                   /*!< VFS path of the requested file */
+    char accept_enc[HTTPD_STATIC_HDR_VAL_LEN];          /*!< Accept-Encoding request header */
+    char if_none_match[HTTPD_STATIC_HDR_VAL_LEN];       /*!< If-None-Match request header */
+    char if_modified_since[HTTPD_STATIC_HDR_VAL_LEN];   /*!< If-Modified-Since request header */
+    char if_range[HTTPD_STATIC_HDR_VAL_LEN];            /*!< If-Range request header */
+    char range[HTTPD_STATIC_HDR_VAL_LEN];               /*!< Range request header */
+    char etag[48];                                      /*!< ETag response header */
+    char last_modified[HTTPD_STATIC_DATE_LEN];          /*!< Last-Modified response header */
+    char content_range[64];                             /*!< Content-Range response header */
+};
+
+struct httpd_static_ctx {
+    SLIST_ENTRY(httpd_static_ctx) next;     /*!< Linkage in httpd_data's list */
+    char *uri;                              /*!< URI template the handler is registered with */
+    size_t prefix_len;                      /*!< Length of the template without trailing '*' and '?' */
+    char *base_path;                        /*!< VFS directory files are served from */
+    char *index_file;                       /*!< File served for directory URIs, or NULL */
+    char *cache_control;                    /*!< Cache-Control header value, or NULL */
+    bool serve_precompressed;               /*!< Look for .br/.gz siblings */
+    char *buf;                              /*!< Transfer buffer reused for all requests */
+    struct static_req_bufs *req_bufs;       /*!< Request strings reused for all requests */
+    size_t buf_size;                        /*!< Size of buf */
+    size_t cache_max_file_size;             /*!< Files up to this size are cached */
+    size_t cache_max_total;                 /*!< Limit of cache_used */
+    size_t cache_used;                      /*!< Bytes of file data currently cached */
+    uint32_t cache_caps;                    /*!< Heap caps for cached file data */
+    TAILQ_HEAD(static_cache_head, static_cache_entry) cache; /*!< Cached files in LRU order */
+};
+
+static const struct {
+    const char *ext;
+    const char *type;
+} s_mime_types[] = {
+    { ".html", "text/html" },
+    { ".htm",  "text/html" },
+    { ".css",  "text/css" },
+    { ".js",   "application/javascript" },
+    { ".mjs",  "application/javascript" },
+    { ".json", "application/json" },
+    { ".txt",  "text/plain" },
+    { ".xml",  "text/xml" },
+    { ".svg",  "image/svg+xml" },
+    { ".png",  "image/png" },
+    { ".jpg",  "image/jpeg" },
+    { ".jpeg", "image/jpeg" },
+    { ".gif",  "image/gif" },
+    { ".ico",  "image/x-icon" },
+    { ".webp", "image/webp" },
+    { ".wasm", "application/wasm" },
+    { ".woff", "font/woff" },
+    { ".woff2", "font/woff2" },
+    { ".pdf",  "application/pdf" },
+    { ".bin",  "application/octet-stream" },
+};
+
+static const char *static_mime_type(const char *path)
+{
+    const char *ext = strrchr(path, '.');
+    if (ext && !strchr(ext, '/')) {
+        for (size_t i = 0; i < sizeof(s_mime_types) / sizeof(s_mime_types[0]); i++) {
+            if (strcasecmp(ext, s_mime_types[i].ext) == 0) {
+                return s_mime_types[i].type;
+            }
+        }
+    }
+    return "application/octet-stream";
+}
+
+static int hex_val(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/* Appends the percent-decoded URI path (up to the query string) to out.
+ * Rejects paths containing ".." segments or encoded nulls. */
+static esp_err_t static_decode_path(const char *uri, char *out, size_t out_size)
+{
+    size_t len = strlen(out);
+
+    for (const char *p = uri; *p && *p != '?' && *p != '#'; p++) {
+        char c = *p;
+        if (c == '%') {
+            int hi = hex_val(p[1]);
+            int lo = (hi < 0) ? -1 : hex_val(p[2]);
+            if (lo < 0) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            c = (char)((hi << 4) | lo);
+            if (c == '\0') {
+                return ESP_ERR_INVALID_ARG;
+            }
+            p += 2;
+        }
+        if (len + 1 >= out_size) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        out[len++] = c;
+    }
+    out[len] = '\0';
+
+    /* Decoding may have produced "/../", so check after it */
+    if (strstr(out, "/../") || (len >= 3 && strcmp(&out[len - 3], "/..") == 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+/* Checks whether a comma separated Accept-Encoding value allows the coding */
+static bool static_accepts_encoding(const char *accept, const char *coding)
+{
+    size_t coding_len = strlen(coding);
+    const char *p = accept;
+
+    while (*p) {
+        while (*p == ' ' || *p == ',') {
+            p++;
+        }
+        const char *tok = p;
+        while (*p && *p != ',' && *p != ';' && *p != ' ') {
+            p++;
+        }
+        bool match = ((size_t)(p - tok) == coding_len) && strncasecmp(tok, coding, coding_len) == 0;
+        bool rejected = false;
+        /* Parameters, only "q=0" matters here */
+        while (*p && *p != ',') {
+            if (*p == 'q' && p[1] == '=') {
+                rejected = (strtod(p + 2, NULL) == 0.0);
+            }
+            p++;
+        }
+        if (match) {
+            return !rejected;
+        }
+    }
+    return false;
+}
+
+static void static_format_date(time_t t, char *out, size_t out_size)
+{
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    strftime(out, out_size, "%a, %d %b %Y %H:%M:%S GMT", &tm);
+}
+
+/* Parses an IMF-fixdate, e.g. "Sun, 06 Nov 1994 08:49:37 GMT" */
+static bool static_parse_date(const char *str, time_t *out)
+{
+    static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    char mon[4];
+    int day, year, hour, min, sec;
+
+    if (sscanf(str, "%*3s, %2d %3s %4d %2d:%2d:%2d GMT", &day, mon, &year, &hour, &min, &sec) != 6) {
+        return false;
+    }
+    const char *m = strstr(months, mon);
+    if (m == NULL || (m - months) % 3 != 0) {
+        return false;
+    }
+    int month = (m - months) / 3 + 1;
+
+    /* Days since the epoch of a proleptic Gregorian civil date */
+    int y = year - (month <= 2);
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int64_t days = (int64_t)era * 146097 + doe - 719468;
+
+    *out = (time_t)(days * 86400 + hour * 3600 + min * 60 + sec);
+    return true;
+}
+
+/* Parses a single "bytes=first-last" range against a representation of
+ * the given size. Returns ESP_ERR_NOT_SUPPORTED for ranges that are to be
+ * ignored (multiple ranges, other units), and ESP_ERR_INVALID_SIZE for
+ * unsatisfiable ones. */
+static esp_err_t static_parse_range(const char *range, size_t size, size_t *start, size_t *end)
+{
+    if (strncasecmp(range, "bytes=", 6) != 0 || strchr(range, ',')) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    const char *p = range + 6;
+    char *endp;
+
+    if (*p == '-') {
+        /* Suffix range: last N bytes */
+        unsigned long long n = strtoull(p + 1, &endp, 10);
+        if (endp == p + 1 || *endp != '\0') {
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        if (n == 0 || size == 0) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        *start = (n >= size) ? 0 : size - n;
+        *end = size - 1;
+        return ESP_OK;
+    }
+
+    unsigned long long first = strtoull(p, &endp, 10);
+    if (endp == p || *endp != '-') {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    p = endp + 1;
+    unsigned long long last = size ? size - 1 : 0;
+    if (*p != '\0') {
+        last = strtoull(p, &endp, 10);
+        if (endp == p || *endp != '\0' || last < first) {
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        if (last >= size) {
+            last = size - 1;
+        }
+    }
+    if (first >= size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    *start = first;
+    *end = last;
+    return ESP_OK;
+}
+
+static void static_cache_remove(struct httpd_static_ctx *ctx, struct static_cache_entry *e)
+{
+    TAILQ_REMOVE(&ctx->cache, e, next);
+    ctx->cache_used -= e->size;
+    free(e->path);
+    heap_caps_free(e->data);
+    free(e);
+}
+
+static struct static_cache_entry *static_cache_lookup(struct httpd_static_ctx *ctx, const char *path,
+                                                      const struct stat *st)
+{
+    struct static_cache_entry *e;
+    TAILQ_FOREACH(e, &ctx->cache, next) {
+        if (strcmp(e->path, path) == 0) {
+            if (e->mtime != st->st_mtime || e->size != st->st_size) {
+                /* File changed since it was cached */
+                static_cache_remove(ctx, e);
+                return NULL;
+            }
+            /* Move to front of LRU list */
+            TAILQ_REMOVE(&ctx->cache, e, next);
+            TAILQ_INSERT_HEAD(&ctx->cache, e, next);
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/* Reads a small file into a new cache entry, evicting least recently
+ * used entries to make room. Returns NULL if the file cannot be cached. */
+static struct static_cache_entry *static_cache_insert(struct httpd_static_ctx *ctx, const char *path,
+                                                      int fd, const struct stat *st)
+{
+    size_t size = st->st_size;
+    if (size == 0 || size > ctx->cache_max_file_size || size > ctx->cache_max_total) {
+        return NULL;
+    }
+    while (ctx->cache_used + size > ctx->cache_max_total) {
+        static_cache_remove(ctx, TAILQ_LAST(&ctx->cache, static_cache_head));
+    }
+
+    struct static_cache_entry *e = calloc(1, sizeof(struct static_cache_entry));
+    if (e == NULL) {
+        return NULL;
+    }
+    e->path = strdup(path);
+    e->data = heap_caps_malloc(size, ctx->cache_caps);
+    if (e->path == NULL || e->data == NULL) {
+        goto err;
+    }
+    size_t off = 0;
+    while (off < size) {
+        ssize_t n = read(fd, e->data + off, size - off);
+        if (n <= 0) {
+            goto err;
+        }
+        off += n;
+    }
+    e->mtime = st->st_mtime;
+    e->size = size;
+    TAILQ_INSERT_HEAD(&ctx->cache, e, next);
+    ctx->cache_used += size;
+    ESP_LOGD(TAG, LOG_FMT("cached %s (%"NEWLIB_NANO_COMPAT_FORMAT" bytes)"), path, NEWLIB_NANO_COMPAT_CAST(size));
+    return e;
+
+err:
+    free(e->path);
+    heap_caps_free(e->data);
+    free(e);
+    /* Let the caller stream the file instead */
+    lseek(fd, 0, SEEK_SET);
+    return NULL;
+}
+
+/* Finds the file to serve, preferring a precompressed sibling if accepted */
+static esp_err_t static_find_file(struct httpd_static_ctx *ctx, char *path, const char *accept_enc,
+                                  struct stat *st, static_encoding_t *enc)
+{
+    size_t len = strlen(path);
+
+    *enc = STATIC_ENCODING_IDENTITY;
+    if (ctx->serve_precompressed && accept_enc[0] != '\0' && len + 4 <= HTTPD_STATIC_PATH_MAX) {
+        if (static_accepts_encoding(accept_enc, "br")) {
+            strcpy(path + len, ".br");
+            if (stat(path, st) == 0 && S_ISREG(st->st_mode)) {
+                *enc = STATIC_ENCODING_BR;
+                return ESP_OK;
+            }
+        }
+        if (static_accepts_encoding(accept_enc, "gzip")) {
+            strcpy(path + len, ".gz");
+            if (stat(path, st) == 0 && S_ISREG(st->st_mode)) {
+                *enc = STATIC_ENCODING_GZIP;
+                return ESP_OK;
+            }
+        }
+        path[len] = '\0';
+    }
+    if (stat(path, st) != 0 || !S_ISREG(st->st_mode)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    return ESP_OK;
+}
+
+static bool static_etag_matches(const char *if_none_match, const char *etag)
+{
+    if (strcmp(if_none_match, "*") == 0) {
+        return true;
+    }
+    /* Weak comparison, so also accept W/"..." forms of our tag */
+    return strstr(if_none_match, etag) != NULL;
+}
+
+static esp_err_t static_get_hdr(httpd_req_t *req, const char *field, char *val, size_t val_size)
+{
+    esp_err_t ret = httpd_req_get_hdr_value_str(req, field, val, val_size);
+    if (ret != ESP_OK && ret != ESP_ERR_HTTPD_RESULT_TRUNC) {
+        val[0] = '\0';
+    }
+    return ret;
+}
+
+static esp_err_t static_send_body(httpd_req_t *req, struct httpd_static_ctx *ctx, int fd,
+                                  const struct static_cache_entry *cached, size_t start, size_t len)
+{
+    if (cached) {
+        if (httpd_send_all(req, (const char *)cached->data + start, len) != ESP_OK) {
+            return ESP_ERR_HTTPD_RESP_SEND;
+        }
+        return ESP_OK;
+    }
+    if (start && lseek(fd, start, SEEK_SET) != (off_t)start) {
+        return ESP_FAIL;
+    }
+    while (len > 0) {
+        ssize_t n = read(fd, ctx->buf, MIN(len, ctx->buf_size));
+        if (n <= 0) {
+            ESP_LOGE(TAG, LOG_FMT("read failed (%d)"), errno);
+            return ESP_FAIL;
+        }
+        if (httpd_send_all(req, ctx->buf, n) != ESP_OK) {
+            return ESP_ERR_HTTPD_RESP_SEND;
+        }
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t static_handler(httpd_req_t *req)
+{
+    struct httpd_static_ctx *ctx = req->user_ctx;
+    /* Handlers run one at a time in the server task, so the buffers of the context can be reused */
+    struct static_req_bufs *b = ctx->req_bufs;
+    char *path = b->path;
+
+    /* Map the URI onto the file system */
+    strlcpy(path, ctx->base_path, sizeof(b->path));
+    const char *rel = req->uri + MIN(ctx->prefix_len, strlen(req->uri));
+    if (*rel != '/' && path[strlen(path) - 1] != '/') {
+        strlcat(path, "/", sizeof(b->path));
+    }
+    if (static_decode_path(rel, path, sizeof(b->path)) != ESP_OK) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, NULL);
+    }
+    if (path[strlen(path) - 1] == '/') {
+        if (ctx->index_file == NULL) {
+            return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, NULL);
+        }
+        strlcat(path, ctx->index_file, sizeof(b->path));
+    }
+    const char *content_type = static_mime_type(path);
+
+    /* Request headers have to be read before anything is sent */
+    static_get_hdr(req, "Accept-Encoding", b->accept_enc, sizeof(b->accept_enc));
+    static_get_hdr(req, "If-None-Match", b->if_none_match, sizeof(b->if_none_match));
+    static_get_hdr(req, "If-Modified-Since", b->if_modified_since, sizeof(b->if_modified_since));
+    static_get_hdr(req, "If-Range", b->if_range, sizeof(b->if_range));
+    if (static_get_hdr(req, "Range", b->range, sizeof(b->range)) == ESP_ERR_HTTPD_RESULT_TRUNC) {
+        b->range[0] = '\0';
+    }
+
+    struct stat st;
+    static_encoding_t enc;
+    if (static_find_file(ctx, path, b->accept_enc, &st, &enc) != ESP_OK) {
+        ESP_LOGD(TAG, LOG_FMT("%s not found"), path);
+        return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, NULL);
+    }
+    size_t size = st.st_size;
+
+    /* Validators: the ETag differs per content coding. A file system that
+     * does not track modification times (e.g. SPIFFS without
+     * CONFIG_SPIFFS_USE_MTIME) reports 0, and a file rewritten with the same
+     * size would then keep its validators, so none are sent. */
+    bool has_validators = st.st_mtime != 0;
+    static const char *enc_suffix[] = { "", "-br", "-gz" };
+    b->etag[0] = '\0';
+    b->last_modified[0] = '\0';
+    if (has_validators) {
+        snprintf(b->etag, sizeof(b->etag), "\"%" PRIx64 "-%" PRIx64 "%s\"",
+                 (uint64_t)st.st_mtime, (uint64_t)size, enc_suffix[enc]);
+        static_format_date(st.st_mtime, b->last_modified, sizeof(b->last_modified));
+    }
+
+    httpd_resp_set_type(req, content_type);
+    if (has_validators) {
+        httpd_resp_set_hdr(req, "ETag", b->etag);
+        httpd_resp_set_hdr(req, "Last-Modified", b->last_modified);
+    }
+    if (ctx->cache_control) {
+        httpd_resp_set_hdr(req, "Cache-Control", ctx->cache_control);
+    }
+    if (ctx->serve_precompressed) {
+        httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+    }
+    if (enc != STATIC_ENCODING_IDENTITY) {
+        httpd_resp_set_hdr(req, "Content-Encoding", enc == STATIC_ENCODING_BR ? "br" : "gzip");
+    }
+
+    /* Conditional requests, If-None-Match takes precedence (RFC 9110 13.2.2) */
+    bool not_modified = false;
+    if (!has_validators) {
+        /* The file cannot be told apart from an older version */
+    } else if (b->if_none_match[0] != '\0') {
+        not_modified = static_etag_matches(b->if_none_match, b->etag);
+    } else if (b->if_modified_since[0] != '\0') {
+        time_t since;
+        not_modified = static_parse_date(b->if_modified_since, &since) && st.st_mtime <= since;
+    }
+    if (not_modified) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send_hdrs(req, HTTPD_RESP_NO_BODY);
+    }
+
+    /* Byte ranges, ignored if If-Range does not match the current file */
+    size_t start = 0;
+    size_t len = size;
+    httpd_resp_set_hdr(req, "Accept-Ranges", "bytes");
+    if (b->range[0] != '\0' && (b->if_range[0] == '\0' ||
+                                (has_validators && (strcmp(b->if_range, b->etag) == 0 ||
+                                                    strcmp(b->if_range, b->last_modified) == 0)))) {
+        size_t end;
+        esp_err_t ret = static_parse_range(b->range, size, &start, &end);
+        if (ret == ESP_ERR_INVALID_SIZE) {
+            snprintf(b->content_range, sizeof(b->content_range), "bytes */%" PRIu64, (uint64_t)size);
+            httpd_resp_set_hdr(req, "Content-Range", b->content_range);
+            httpd_resp_set_status(req, "416 Range Not Satisfiable");
+            return httpd_resp_send_hdrs(req, 0);
+        }
+        if (ret == ESP_OK) {
+            len = end - start + 1;
+            snprintf(b->content_range, sizeof(b->content_range), "bytes %" PRIu64 "-%" PRIu64 "/%" PRIu64,
+                     (uint64_t)start, (uint64_t)end, (uint64_t)size);
+            httpd_resp_set_hdr(req, "Content-Range", b->content_range);
+            httpd_resp_set_status(req, "206 Partial Content");
+        } else {
+            start = 0;
+        }
+    }
+
+    if (req->method == HTTP_HEAD) {
+        return httpd_resp_send_hdrs(req, len);
+    }
+
+    /* Cached data is only known to be current if the file has validators */
+    const struct static_cache_entry *cached = NULL;
+    int fd = -1;
+    bool use_cache = ctx->cache_max_file_size && has_validators;
+    if (use_cache) {
+        cached = static_cache_lookup(ctx, path, &st);
+    }
+    if (cached == NULL) {
+        fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            ESP_LOGE(TAG, LOG_FMT("failed to open %s (%d)"), path, errno);
+            return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, NULL);
+        }
+        if (use_cache) {
+            cached = static_cache_insert(ctx, path, fd, &st);
+        }
+    }
+
+    esp_err_t ret = httpd_resp_send_hdrs(req, len);
+    if (ret == ESP_OK && len) {
+        ret = static_send_body(req, ctx, fd, cached, start, len);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (ret == ESP_OK) {
+        esp_http_server_event_data evt_data = {
+            .fd = httpd_req_to_sockfd(req),
+            .data_len = len,
+        };
+        esp_http_server_dispatch_event(HTTP_SERVER_EVENT_SENT_DATA, &evt_data, sizeof(esp_http_server_event_data));
+    }
+    return ret;
+}
+
+static void static_ctx_free(struct httpd_static_ctx *ctx)
+{
+    while (!TAILQ_EMPTY(&ctx->cache)) {
+        static_cache_remove(ctx, TAILQ_FIRST(&ctx->cache));
+    }
+    free(ctx->uri);
+    free(ctx->base_path);
+    free(ctx->index_file);
+    free(ctx->cache_control);
+    free(ctx->buf);
+    free(ctx->req_bufs);
+    free(ctx);
+}
+
+static char *strdup_or_null(const char *s, bool *failed)
+{
+    if (s == NULL) {
+        return NULL;
+    }
+    char *ret = strdup(s);
+    if (ret == NULL) {
+        *failed = true;
+    }
+    return ret;
+}
+
+esp_err_t httpd_register_static_handler(httpd_handle_t handle, const httpd_static_config_t *config)
+{
+    if (handle == NULL || config == NULL || config->uri == NULL ||
+            config->base_path == NULL || config->base_path[0] == '\0' || config->buf_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct httpd_data *hd = (struct httpd_data *) handle;
+    struct httpd_static_ctx *ctx = calloc(1, sizeof(struct httpd_static_ctx));
+    if (ctx == NULL) {
+        return ESP_ERR_HTTPD_ALLOC_MEM;
+    }
+    TAILQ_INIT(&ctx->cache);
+
+    bool failed = false;
+    ctx->uri = strdup_or_null(config->uri, &failed);
+    ctx->base_path = strdup_or_null(config->base_path, &failed);
+    ctx->index_file = strdup_or_null(config->index_file, &failed);
+    ctx->cache_control = strdup_or_null(config->cache_control, &failed);
+    ctx->buf = malloc(config->buf_size);
+    ctx->req_bufs = malloc(sizeof(struct static_req_bufs));
+    if (failed || ctx->buf == NULL || ctx->req_bufs == NULL) {
+        static_ctx_free(ctx);
+        return ESP_ERR_HTTPD_ALLOC_MEM;
+    }
+    ctx->buf_size = config->buf_size;
+    ctx->serve_precompressed = config->serve_precompressed;
+    ctx->cache_max_file_size = config->cache_max_file_size;
+    ctx->cache_max_total = config->cache_max_total;
+    ctx->cache_caps = config->cache_caps;
+
+    /* Part of the request URI matched by the template, e.g. "/static/" of "/static/?*" */
+    ctx->prefix_len = strlen(ctx->uri);
+    while (ctx->prefix_len && (ctx->uri[ctx->prefix_len - 1] == '*' || ctx->uri[ctx->prefix_len - 1] == '?')) {
+        ctx->prefix_len--;
+    }
+    if (ctx->prefix_len == strlen(ctx->uri)) {
+        /* Template names a single file, serve base_path plus the full URI */
+        ctx->prefix_len = 0;
+    }
+
+    httpd_uri_t uri = {
+        .uri      = config->uri,
+        .method   = HTTP_GET,
+        .handler  = static_handler,
+        .user_ctx = ctx,
+    };
+    esp_err_t ret = httpd_register_uri_handler(handle, &uri);
+    if (ret != ESP_OK) {
+        static_ctx_free(ctx);
+        return ret;
+    }
+    uri.method = HTTP_HEAD;
+    ret = httpd_register_uri_handler(handle, &uri);
+    if (ret != ESP_OK) {
+        httpd_unregister_uri_handler(handle, config->uri, HTTP_GET);
+        static_ctx_free(ctx);
+        return ret;
+    }
+
+    SLIST_INSERT_HEAD(&hd->static_ctxs, ctx, next);
+    ESP_LOGD(TAG, LOG_FMT("serving %s from %s"), ctx->uri, ctx->base_path);
+    return ESP_OK;
+}
+
+esp_err_t httpd_unregister_static_handler(httpd_handle_t handle, const char *uri)
+{
+    if (handle == NULL || uri == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct httpd_data *hd = (struct httpd_data *) handle;
+    struct httpd_static_ctx *ctx;
+    SLIST_FOREACH(ctx, &hd->static_ctxs, next) {
+        if (strcmp(ctx->uri, uri) == 0) {
+            httpd_unregister_uri_handler(handle, uri, HTTP_GET);
+            httpd_unregister_uri_handler(handle, uri, HTTP_HEAD);
+            SLIST_REMOVE(&hd->static_ctxs, ctx, httpd_static_ctx, next);
+            static_ctx_free(ctx);
+            return ESP_OK;
+        }
+    }
+    ESP_LOGW(TAG, LOG_FMT("no static handler found for URI %s"), uri);
+    return ESP_ERR_NOT_FOUND;
+}
+
+void httpd_static_free_all(struct httpd_data *hd)
+{
+    while (!SLIST_EMPTY(&hd->static_ctxs)) {
+        struct httpd_static_ctx *ctx = SLIST_FIRST(&hd->static_ctxs);
+        SLIST_REMOVE_HEAD(&hd->static_ctxs, next);
+        static_ctx_free(ctx);
+    }
+}
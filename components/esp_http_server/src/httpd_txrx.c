@@ -64,7 +64,7 @@ int httpd_send(httpd_req_t *r, const char *buf, size_t buf_len)
     return ret;
 }
 
-static esp_err_t httpd_send_all(httpd_req_t *r, const char *buf, size_t buf_len)
+esp_err_t httpd_send_all(httpd_req_t *r, const char *buf, size_t buf_len)
 {
     struct httpd_req_aux *ra = r->aux;
     int ret;
@@ -225,30 +225,27 @@ esp_err_t httpd_resp_set_type(httpd_req_t *r, const char *type)
     return ESP_OK;
 }
 
-esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len)
+static int httpd_fmt_resp_hdrs(struct httpd_req_aux *ra, size_t content_len, char *buf, size_t buf_size)
 {
-    if (r == NULL) {
-        return ESP_ERR_INVALID_ARG;
-    }
-
-    if (!httpd_valid_req(r)) {
-        return ESP_ERR_HTTPD_INVALID_REQ;
+    if (content_len == HTTPD_RESP_NO_BODY) {
+        /* Responses such as 304 describe no body of their own, so they carry no content headers */
+        return snprintf(buf, buf_size, "HTTP/1.1 %s\r\n", ra->status);
     }
+    return snprintf(buf, buf_size, "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %"NEWLIB_NANO_COMPAT_FORMAT"\r\n",
+                    ra->status, ra->content_type, NEWLIB_NANO_COMPAT_CAST(content_len));
+}
 
+esp_err_t httpd_resp_send_hdrs(httpd_req_t *r, size_t content_len)
+{
     struct httpd_req_aux *ra = r->aux;
-    const char *httpd_hdr_str = "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %d\r\n";
     const char *colon_separator = ": ";
     const char *cr_lf_seperator = "\r\n";
 
-    if (buf_len == HTTPD_RESP_USE_STRLEN) {
-        buf_len = strlen(buf);
-    }
-
     /* Request headers are no longer available */
     ra->req_hdrs_count = 0;
 
     /* Calculate the size of the headers. +1 for the null terminator */
-    size_t required_size = snprintf(NULL, 0, httpd_hdr_str, ra->status, ra->content_type, buf_len) + 1;
+    size_t required_size = httpd_fmt_resp_hdrs(ra, content_len, NULL, 0) + 1;
     if (required_size > ra->max_req_hdr_len) {
         return ESP_ERR_HTTPD_RESP_HDR;
     }
@@ -258,7 +255,7 @@ esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len)
         return ESP_ERR_HTTPD_ALLOC_MEM;
     }
 
-    esp_err_t ret = snprintf(res_buf, required_size, httpd_hdr_str, ra->status, ra->content_type, buf_len);
+    esp_err_t ret = httpd_fmt_resp_hdrs(ra, content_len, res_buf, required_size);
     if (ret < 0 || ret >= required_size) {
         free(res_buf);
         return ESP_ERR_HTTPD_RESP_HDR;
@@ -295,6 +292,29 @@ esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len)
         return ESP_ERR_HTTPD_RESP_SEND;
     }
     esp_http_server_dispatch_event(HTTP_SERVER_EVENT_HEADERS_SENT, &(ra->sd->fd), sizeof(int));
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len)
+{
+    if (r == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!httpd_valid_req(r)) {
+        return ESP_ERR_HTTPD_INVALID_REQ;
+    }
+
+    struct httpd_req_aux *ra = r->aux;
+
+    if (buf_len == HTTPD_RESP_USE_STRLEN) {
+        buf_len = strlen(buf);
+    }
+
+    esp_err_t ret = httpd_resp_send_hdrs(r, buf_len);
+    if (ret != ESP_OK) {
+        return ret;
+    }
 
     /* Sending content */
     if (buf && buf_len) {
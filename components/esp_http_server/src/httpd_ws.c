@@ -35,6 +35,28 @@ typedef struct {
     EventGroupHandle_t transfer_done;
 } async_transfer_t;
 
+/* A frame encoded once for all recipients of a broadcast. It is only
+ * referenced from the server task, so the count needs no locking. */
+struct ws_bcast_frame {
+    unsigned refcount;
+    size_t len;             /*!< Length of header and payload */
+    uint8_t data[];         /*!< Encoded header followed by payload */
+};
+
+/* Entry of a session's queue of partially sent broadcast frames */
+struct ws_tx_entry {
+    struct ws_tx_entry *next;
+    struct ws_bcast_frame *frame;
+    size_t offset;          /*!< Bytes of the frame already sent */
+};
+
+typedef struct {
+    struct ws_bcast_frame *frame;
+    httpd_handle_t handle;
+    httpd_ws_filter_fn_t filter;
+    void *arg;
+} ws_bcast_work_t;
+
 static const char *TAG="httpd_ws";
 
 /*
@@ -47,6 +69,9 @@ static const char *TAG="httpd_ws";
 #define HTTPD_WS_MASK_BIT       0x80U
 #define HTTPD_WS_LENGTH_BITS    0x7fU
 
+/* Longest header of a server frame: 2 bytes header and 8 bytes length */
+#define HTTPD_WS_MAX_HEADER_LEN 10
+
 /*
  * The magic GUID string used for handshake
  * Please refer to RFC6455 Section 1.3 for more details.
@@ -401,16 +426,12 @@ esp_err_t httpd_ws_send_frame(httpd_req_t *req, httpd_ws_frame_t *frame)
     return httpd_ws_send_frame_async(req->handle, httpd_req_to_sockfd(req), frame);
 }
 
-esp_err_t httpd_ws_send_frame_async(httpd_handle_t hd, int fd, httpd_ws_frame_t *frame)
+/* Encodes the header of an unmasked server frame into header_buf, which must
+ * hold HTTPD_WS_MAX_HEADER_LEN bytes. Returns the length of the header. */
+static size_t httpd_ws_encode_header(const httpd_ws_frame_t *frame, uint8_t *header_buf)
 {
-    if (!frame) {
-        ESP_LOGW(TAG, LOG_FMT("Argument is invalid"));
-        return ESP_ERR_INVALID_ARG;
-    }
-
-    /* Prepare Tx buffer - maximum length is 14, which includes 2 bytes header, 8 bytes length, 4 bytes mask key */
     uint8_t tx_len = 0;
-    uint8_t header_buf[10] = {0 };
+    memset(header_buf, 0, HTTPD_WS_MAX_HEADER_LEN);
     /* Set the `FIN` bit by default if message is not fragmented. Else, set it as per the `final` field */
     header_buf[0] |= (!frame->fragmented) ? HTTPD_WS_FIN_BIT : (frame->final? HTTPD_WS_FIN_BIT: HTTPD_WS_CONTINUE);
     header_buf[0] |= frame->type; /* Type (opcode): 4 bits */
@@ -438,12 +459,33 @@ esp_err_t httpd_ws_send_frame_async(httpd_handle_t hd, int fd, httpd_ws_frame_t
 
     /* WebSocket server does not required to mask response payload, so leave the MASK bit as 0. */
     header_buf[1] &= (~HTTPD_WS_MASK_BIT);
+    return tx_len;
+}
+
+esp_err_t httpd_ws_send_frame_async(httpd_handle_t hd, int fd, httpd_ws_frame_t *frame)
+{
+    if (!frame) {
+        ESP_LOGW(TAG, LOG_FMT("Argument is invalid"));
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    /* Prepare Tx buffer - maximum length is 14, which includes 2 bytes header, 8 bytes length, 4 bytes mask key */
+    uint8_t header_buf[HTTPD_WS_MAX_HEADER_LEN];
+    size_t tx_len = httpd_ws_encode_header(frame, header_buf);
 
     struct sock_db *sess = httpd_sess_get(hd, fd);
     if (!sess) {
         return ESP_ERR_INVALID_ARG;
     }
 
+    /* Frames of an earlier broadcast still queued for this client go first.
+     * The queue belongs to the server task, other tasks leave it alone. */
+    struct httpd_data *hd_data = (struct httpd_data *) hd;
+    if (httpd_os_thread_handle() == hd_data->hd_td.handle && httpd_ws_sess_flush(sess, true) != ESP_OK) {
+        ESP_LOGW(TAG, LOG_FMT("Failed to flush queued WS frames"));
+        return ESP_FAIL;
+    }
+
     /* Send off header */
     if (sess->send_fn(hd, fd, (const char *)header_buf, tx_len, 0) < 0) {
         ESP_LOGW(TAG, LOG_FMT("Failed to send WS header"));
@@ -629,4 +671,192 @@ esp_err_t httpd_ws_send_data_async(httpd_handle_t handle, int socket, httpd_ws_f
     return ESP_OK;
 }
 
+static void httpd_ws_bcast_frame_put(struct ws_bcast_frame *frame)
+{
+    if (--frame->refcount == 0) {
+        free(frame);
+    }
+}
+
+static void httpd_ws_tx_pop(struct sock_db *sess)
+{
+    struct ws_tx_entry *entry = sess->ws_tx_head;
+    sess->ws_tx_head = entry->next;
+    if (sess->ws_tx_head == NULL) {
+        sess->ws_tx_tail = NULL;
+    }
+    sess->ws_tx_count--;
+    httpd_ws_bcast_frame_put(entry->frame);
+    free(entry);
+}
+
+esp_err_t httpd_ws_sess_flush(struct sock_db *sess, bool blocking)
+{
+    while (sess->ws_tx_head) {
+        struct ws_tx_entry *entry = sess->ws_tx_head;
+        const char *buf = (const char *)entry->frame->data + entry->offset;
+        size_t len = entry->frame->len - entry->offset;
+
+        int ret = sess->send_fn(sess->handle, sess->fd, buf, len, blocking ? 0 : MSG_DONTWAIT);
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT && !blocking) {
+            /* Socket buffer full, wait for it to become writable */
+            return ESP_OK;
+        }
+        if (ret < 0) {
+            return ESP_FAIL;
+        }
+        entry->offset += ret;
+        if (entry->offset == entry->frame->len) {
+            httpd_ws_tx_pop(sess);
+        } else if (!blocking) {
+            return ESP_OK;
+        }
+    }
+    return ESP_OK;
+}
+
+void httpd_ws_sess_free_tx(struct sock_db *sess)
+{
+    while (sess->ws_tx_head) {
+        httpd_ws_tx_pop(sess);
+    }
+}
+
+void httpd_ws_sess_set_wr_descriptors(struct httpd_data *hd, fd_set *fdset, int *maxfd)
+{
+    for (int i = 0; i < hd->config.max_open_sockets; i++) {
+        struct sock_db *sess = &hd->hd_sd[i];
+        if (sess->fd != -1 && sess->ws_tx_head) {
+            FD_SET(sess->fd, fdset);
+            *maxfd = MAX(*maxfd, sess->fd);
+        }
+    }
+}
+
+void httpd_ws_sess_process_writable(struct httpd_data *hd, fd_set *fdset)
+{
+    for (int i = 0; i < hd->config.max_open_sockets; i++) {
+        struct sock_db *sess = &hd->hd_sd[i];
+        if (sess->fd != -1 && sess->ws_tx_head && FD_ISSET(sess->fd, fdset)) {
+            if (httpd_ws_sess_flush(sess, false) != ESP_OK) {
+                ESP_LOGW(TAG, LOG_FMT("Failed to send queued WS frames to %d"), sess->fd);
+                httpd_sess_delete(hd, sess);
+            }
+        }
+    }
+}
+
+/* Sends a broadcast frame to one client without blocking, queueing
+ * whatever does not fit in the socket's send buffer. Only send functions
+ * honouring MSG_DONTWAIT do not block, overrides may ignore the flag. */
+static esp_err_t httpd_ws_bcast_send(struct sock_db *sess, struct ws_bcast_frame *frame)
+{
+    size_t offset = 0;
+
+    if (sess->ws_tx_head == NULL) {
+        int ret = sess->send_fn(sess->handle, sess->fd, (const char *)frame->data, frame->len, MSG_DONTWAIT);
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+            ret = 0;
+        } else if (ret < 0) {
+            return ESP_FAIL;
+        }
+        if ((size_t)ret == frame->len) {
+            return ESP_OK;
+        }
+        offset = ret;
+    } else if (sess->ws_tx_count >= CONFIG_HTTPD_WS_BROADCAST_QUEUE_LEN) {
+        /* Slow client, apply the overflow policy. A partially sent frame is
+         * always kept so that the stream stays well formed. */
+#if CONFIG_HTTPD_WS_BROADCAST_OVERFLOW_CLOSE
+        return ESP_ERR_NO_MEM;
+#else
+        ESP_LOGD(TAG, LOG_FMT("queue full, dropping frame for %d"), sess->fd);
+        return ESP_OK;
+#endif
+    }
+
+    struct ws_tx_entry *entry = malloc(sizeof(struct ws_tx_entry));
+    if (entry == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    entry->next = NULL;
+    entry->frame = frame;
+    entry->offset = offset;
+    frame->refcount++;
+    if (sess->ws_tx_tail) {
+        sess->ws_tx_tail->next = entry;
+    } else {
+        sess->ws_tx_head = entry;
+    }
+    sess->ws_tx_tail = entry;
+    sess->ws_tx_count++;
+    return ESP_OK;
+}
+
+static void httpd_ws_bcast_cb(void *arg)
+{
+    ws_bcast_work_t *work = arg;
+    struct httpd_data *hd = (struct httpd_data *) work->handle;
+
+    for (int i = 0; i < hd->config.max_open_sockets; i++) {
+        struct sock_db *sess = &hd->hd_sd[i];
+        /* Sessions owned by an async handler are left alone, as its
+         * own writes could interleave with the broadcast */
+        if (sess->fd == -1 || !sess->ws_handshake_done || sess->ws_close || sess->for_async_req) {
+            continue;
+        }
+        if (work->filter && !work->filter(work->handle, sess->fd, work->arg)) {
+            continue;
+        }
+        if (httpd_ws_bcast_send(sess, work->frame) != ESP_OK) {
+            ESP_LOGW(TAG, LOG_FMT("closing WS client %d"), sess->fd);
+            httpd_sess_delete(hd, sess);
+        }
+    }
+
+    httpd_ws_bcast_frame_put(work->frame);
+    free(work);
+}
+
+esp_err_t httpd_ws_broadcast(httpd_handle_t handle, httpd_ws_filter_fn_t filter, void *arg,
+                             const httpd_ws_frame_t *frame)
+{
+    if (handle == NULL || frame == NULL || (frame->len && frame->payload == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ws_bcast_work_t *work = calloc(1, sizeof(ws_bcast_work_t));
+    if (work == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    /* Encode header and copy payload once for all recipients */
+    uint8_t header_buf[HTTPD_WS_MAX_HEADER_LEN];
+    size_t header_len = httpd_ws_encode_header(frame, header_buf);
+    struct ws_bcast_frame *bcast = malloc(sizeof(struct ws_bcast_frame) + header_len + frame->len);
+    if (bcast == NULL) {
+        free(work);
+        return ESP_ERR_NO_MEM;
+    }
+    bcast->refcount = 1;
+    bcast->len = header_len + frame->len;
+    memcpy(bcast->data, header_buf, header_len);
+    if (frame->len) {
+        memcpy(bcast->data + header_len, frame->payload, frame->len);
+    }
+
+    work->frame = bcast;
+    work->handle = handle;
+    work->filter = filter;
+    work->arg = arg;
+
+    esp_err_t err = httpd_queue_work(handle, httpd_ws_bcast_cb, work);
+    if (err != ESP_OK) {
+        free(bcast);
+        free(work);
+        return err;
+    }
+    return ESP_OK;
+}
+
 #endif /* CONFIG_HTTPD_WS_SUPPORT */
@@ -4,10 +4,17 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <errno.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdatomic.h>
+#include <sys/param.h>
+#include <sys/stat.h>
 #include <esp_system.h>
 #include <esp_http_server.h>
+#include <esp_timer.h>
+#include <esp_vfs.h>
+#include <lwip/sockets.h>
 
 #include "unity.h"
 #include "test_utils.h"
@@ -244,6 +251,668 @@ TEST_CASE("Max Allowed Sockets Test", "[HTTP SERVER]")
     TEST_ASSERT(httpd_start(&hd, &config) != ESP_OK);
 }
 
+/********************* Static File Handler *******************/
+
+/* A read-only VFS with a single file of generated content, so that
+ * the static handler can be exercised without a flash file system */
+#define STATIC_TEST_BASE_PATH   "/static_test"
+#define STATIC_TEST_FILE        "/index.html"
+#define STATIC_TEST_FILE_SIZE   (64 * 1024)
+#define STATIC_TEST_MAX_FDS     8
+
+static off_t s_static_test_pos[STATIC_TEST_MAX_FDS];
+static bool s_static_test_used[STATIC_TEST_MAX_FDS];
+/* 0 behaves like a file system that does not track modification times */
+static time_t s_static_test_mtime = 784111777;
+
+static int static_test_open(const char *path, int flags, int mode)
+{
+    if (strcmp(path, STATIC_TEST_FILE) != 0) {
+        errno = ENOENT;
+        return -1;
+    }
+    for (int fd = 0; fd < STATIC_TEST_MAX_FDS; fd++) {
+        if (!s_static_test_used[fd]) {
+            s_static_test_used[fd] = true;
+            s_static_test_pos[fd] = 0;
+            return fd;
+        }
+    }
+    errno = ENFILE;
+    return -1;
+}
+
+static ssize_t static_test_read(int fd, void *dst, size_t size)
+{
+    size_t left = STATIC_TEST_FILE_SIZE - s_static_test_pos[fd];
+    size = MIN(size, left);
+    for (size_t i = 0; i < size; i++) {
+        ((uint8_t *)dst)[i] = (uint8_t)(s_static_test_pos[fd] + i);
+    }
+    s_static_test_pos[fd] += size;
+    return size;
+}
+
+static off_t static_test_lseek(int fd, off_t offset, int mode)
+{
+    if (mode != SEEK_SET || offset > STATIC_TEST_FILE_SIZE) {
+        errno = EINVAL;
+        return -1;
+    }
+    s_static_test_pos[fd] = offset;
+    return offset;
+}
+
+static int static_test_close(int fd)
+{
+    s_static_test_used[fd] = false;
+    return 0;
+}
+
+static int static_test_stat(const char *path, struct stat *st)
+{
+    if (strcmp(path, STATIC_TEST_FILE) != 0) {
+        errno = ENOENT;
+        return -1;
+    }
+    memset(st, 0, sizeof(*st));
+    st->st_mode = S_IFREG | 0444;
+    st->st_size = STATIC_TEST_FILE_SIZE;
+    st->st_mtime = s_static_test_mtime;
+    return 0;
+}
+
+static void static_test_register_vfs(void)
+{
+    const esp_vfs_t vfs = {
+        .flags = ESP_VFS_FLAG_DEFAULT | ESP_VFS_FLAG_READONLY_FS,
+        .open = static_test_open,
+        .read = static_test_read,
+        .lseek = static_test_lseek,
+        .close = static_test_close,
+        .stat = static_test_stat,
+    };
+    TEST_ESP_OK(esp_vfs_register(STATIC_TEST_BASE_PATH, &vfs, NULL));
+}
+
+/* Sends a request to the local server and returns the number of body bytes
+ * received, or -1 if the request failed or the body does not match the
+ * generated file content. Does not use TEST_ASSERT, so that it can be called
+ * from other tasks than the test task. */
+static int static_test_request(uint16_t port, const char *extra_hdrs, int *status, bool *has_content_len,
+                               size_t first_byte)
+{
+    int ret = -1;
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock < 0) {
+        return -1;
+    }
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        goto exit;
+    }
+
+    char req[256];
+    int len = snprintf(req, sizeof(req), "GET /www/index.html HTTP/1.1\r\nHost: localhost\r\n%s\r\n", extra_hdrs);
+    if (send(sock, req, len, 0) != len) {
+        goto exit;
+    }
+
+    /* Read the headers */
+    char hdr[512];
+    size_t hdr_len = 0;
+    char *body = NULL;
+    while (body == NULL && hdr_len < sizeof(hdr) - 1) {
+        int n = recv(sock, hdr + hdr_len, sizeof(hdr) - 1 - hdr_len, 0);
+        if (n <= 0) {
+            goto exit;
+        }
+        hdr_len += n;
+        hdr[hdr_len] = '\0';
+        body = strstr(hdr, "\r\n\r\n");
+    }
+    if (body == NULL) {
+        goto exit;
+    }
+    body += 4;
+    *status = atoi(hdr + strlen("HTTP/1.1 "));
+    char *cl = strstr(hdr, "Content-Length: ");
+    size_t content_len = cl ? atoi(cl + strlen("Content-Length: ")) : 0;
+    if (has_content_len) {
+        *has_content_len = cl != NULL;
+    }
+
+    /* Read and check the body */
+    uint8_t buf[1024];
+    size_t received = hdr + hdr_len - body;
+    memcpy(buf, body, received);
+    size_t checked = 0;
+    while (true) {
+        for (size_t i = 0; i < received; i++, checked++) {
+            if (buf[i] != (uint8_t)(first_byte + checked)) {
+                goto exit;
+            }
+        }
+        if (checked >= content_len) {
+            break;
+        }
+        int n = recv(sock, buf, MIN(sizeof(buf), content_len - checked), 0);
+        if (n <= 0) {
+            goto exit;
+        }
+        received = n;
+    }
+    ret = checked;
+
+exit:
+    close(sock);
+    return ret;
+}
+
+typedef struct {
+    uint16_t port;
+    SemaphoreHandle_t done;
+    atomic_int failures;
+} static_test_client_arg_t;
+
+/* Downloads the file once, failures are counted and checked by the test task */
+static void static_test_client_task(void *arg)
+{
+    static_test_client_arg_t *client = arg;
+    int status = 0;
+    if (static_test_request(client->port, "", &status, NULL, 0) != STATIC_TEST_FILE_SIZE || status != 200) {
+        atomic_fetch_add(&client->failures, 1);
+    }
+    xSemaphoreGive(client->done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("Static File Handler Registration", "[HTTP SERVER]")
+{
+    httpd_handle_t hd;
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.uri_match_fn = httpd_uri_match_wildcard;
+
+    test_case_uses_tcpip();
+
+    TEST_ASSERT(httpd_start(&hd, &config) == ESP_OK);
+
+    httpd_static_config_t static_config = HTTPD_STATIC_DEFAULT_CONFIG();
+    TEST_ASSERT(httpd_register_static_handler(hd, &static_config) == ESP_ERR_INVALID_ARG);
+
+    static_config.uri = "/www/?*";
+    static_config.base_path = STATIC_TEST_BASE_PATH;
+    TEST_ASSERT(httpd_register_static_handler(hd, &static_config) == ESP_OK);
+    /* Same URI cannot be registered twice */
+    TEST_ASSERT(httpd_register_static_handler(hd, &static_config) == ESP_ERR_HTTPD_HANDLER_EXISTS);
+
+    TEST_ASSERT(httpd_unregister_static_handler(hd, "/www/?*") == ESP_OK);
+    TEST_ASSERT(httpd_unregister_static_handler(hd, "/www/?*") == ESP_ERR_NOT_FOUND);
+
+    /* Handlers left registered are freed by httpd_stop */
+    TEST_ASSERT(httpd_register_static_handler(hd, &static_config) == ESP_OK);
+    TEST_ASSERT(httpd_stop(hd) == ESP_OK);
+}
+
+TEST_CASE("Static File Handler Throughput", "[HTTP SERVER]")
+{
+    httpd_handle_t hd;
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.uri_match_fn = httpd_uri_match_wildcard;
+
+    test_case_uses_tcpip();
+    static_test_register_vfs();
+
+    TEST_ASSERT(httpd_start(&hd, &config) == ESP_OK);
+    httpd_static_config_t static_config = HTTPD_STATIC_DEFAULT_CONFIG();
+    static_config.uri = "/www/?*";
+    static_config.base_path = STATIC_TEST_BASE_PATH;
+    TEST_ASSERT(httpd_register_static_handler(hd, &static_config) == ESP_OK);
+
+    /* Range and conditional requests */
+    int status;
+    bool has_content_len;
+    TEST_ASSERT_EQUAL(10, static_test_request(config.server_port, "Range: bytes=10-19\r\n", &status, NULL, 10));
+    TEST_ASSERT_EQUAL(206, status);
+    TEST_ASSERT_EQUAL(0, static_test_request(config.server_port, "Range: bytes=70000-\r\n", &status, NULL, 0));
+    TEST_ASSERT_EQUAL(416, status);
+    /* 304 carries no body, so it must not carry Content-Length either */
+    TEST_ASSERT_EQUAL(0, static_test_request(config.server_port,
+                                             "If-Modified-Since: Sun, 06 Nov 1994 08:49:37 GMT\r\n",
+                                             &status, &has_content_len, 0));
+    TEST_ASSERT_EQUAL(304, status);
+    TEST_ASSERT_FALSE(has_content_len);
+
+    /* Concurrent full downloads, the server handles them one request at a time
+     * so the RAM per download is the socket buffers on top of one shared
+     * transfer buffer */
+    const int clients[] = { 1, 2, 4 };
+    for (int c = 0; c < sizeof(clients) / sizeof(clients[0]); c++) {
+        static_test_client_arg_t arg = {
+            .port = config.server_port,
+            .done = xSemaphoreCreateCounting(clients[c], 0),
+        };
+        TEST_ASSERT_NOT_NULL(arg.done);
+        size_t heap_before = esp_get_free_heap_size();
+        int64_t start = esp_timer_get_time();
+        for (int i = 0; i < clients[c]; i++) {
+            TEST_ASSERT(xTaskCreate(static_test_client_task, "static_client", 4096, &arg, 5, NULL) == pdPASS);
+        }
+        for (int i = 0; i < clients[c]; i++) {
+            TEST_ASSERT(xSemaphoreTake(arg.done, pdMS_TO_TICKS(20000)) == pdTRUE);
+        }
+        TEST_ASSERT_EQUAL(0, atomic_load(&arg.failures));
+        int64_t elapsed_us = esp_timer_get_time() - start;
+        size_t heap_min = esp_get_minimum_free_heap_size();
+        printf("static handler: %d client(s), %d KB/s total, %d bytes of heap in use during downloads\n",
+               clients[c], (int)((int64_t)clients[c] * STATIC_TEST_FILE_SIZE * 1000 / 1024 * 1000 / elapsed_us),
+               (int)(heap_before > heap_min ? heap_before - heap_min : 0));
+        vSemaphoreDelete(arg.done);
+        vTaskDelay(10);
+    }
+
+    TEST_ASSERT(httpd_stop(hd) == ESP_OK);
+    TEST_ESP_OK(esp_vfs_unregister(STATIC_TEST_BASE_PATH));
+}
+
+TEST_CASE("Static File Handler without modification times", "[HTTP SERVER]")
+{
+    httpd_handle_t hd;
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.uri_match_fn = httpd_uri_match_wildcard;
+
+    test_case_uses_tcpip();
+    static_test_register_vfs();
+    s_static_test_mtime = 0;
+
+    TEST_ASSERT(httpd_start(&hd, &config) == ESP_OK);
+    httpd_static_config_t static_config = HTTPD_STATIC_DEFAULT_CONFIG();
+    static_config.uri = "/www/?*";
+    static_config.base_path = STATIC_TEST_BASE_PATH;
+    static_config.cache_max_file_size = STATIC_TEST_FILE_SIZE;
+    static_config.cache_max_total = STATIC_TEST_FILE_SIZE;
+    TEST_ASSERT(httpd_register_static_handler(hd, &static_config) == ESP_OK);
+
+    /* Without validators, a file rewritten with the same size cannot be told
+     * apart from the old one, so conditional requests get the full file */
+    int status;
+    TEST_ASSERT_EQUAL(STATIC_TEST_FILE_SIZE, static_test_request(config.server_port,
+                                                                 "If-None-Match: \"0-10000\"\r\n", &status, NULL, 0));
+    TEST_ASSERT_EQUAL(200, status);
+    TEST_ASSERT_EQUAL(STATIC_TEST_FILE_SIZE, static_test_request(config.server_port,
+                                                                 "If-Modified-Since: Thu, 01 Jan 1970 00:00:00 GMT\r\n",
+                                                                 &status, NULL, 0));
+    TEST_ASSERT_EQUAL(200, status);
+    TEST_ASSERT_EQUAL(STATIC_TEST_FILE_SIZE, static_test_request(config.server_port,
+                                                                 "Range: bytes=10-19\r\nIf-Range: \"0-10000\"\r\n",
+                                                                 &status, NULL, 0));
+    TEST_ASSERT_EQUAL(200, status);
+    /* Ranges without If-Range are still served */
+    TEST_ASSERT_EQUAL(10, static_test_request(config.server_port, "Range: bytes=10-19\r\n", &status, NULL, 10));
+    TEST_ASSERT_EQUAL(206, status);
+
+    s_static_test_mtime = 784111777;
+    TEST_ASSERT(httpd_stop(hd) == ESP_OK);
+    TEST_ESP_OK(esp_vfs_unregister(STATIC_TEST_BASE_PATH));
+}
+
+/********************* Static File Handler End *******************/
+
+/********************* WebSocket Broadcast *******************/
+
+#define WS_BCAST_TEST_FRAMES        100
+#define WS_BCAST_TEST_PAYLOAD_LEN   64
+/* Every client needs a socket on both ends, the server uses 3 more */
+#define WS_BCAST_TEST_MAX_CLIENTS   MIN((CONFIG_LWIP_MAX_SOCKETS - 3) / 2, 100)
+/* Chips with little RAM end the client sweep early */
+#define WS_BCAST_TEST_MIN_FREE_HEAP (32 * 1024)
+/* Frames of the queueing tests, larger than the loopback socket buffers hold
+ * together: CONFIG_LWIP_TCP_SND_BUF_DEFAULT + CONFIG_LWIP_TCP_WND_DEFAULT */
+#define WS_BCAST_TEST_BIG_FRAME_LEN 4000
+#define WS_BCAST_TEST_BIG_FRAMES    (2 * (CONFIG_LWIP_TCP_SND_BUF_DEFAULT + CONFIG_LWIP_TCP_WND_DEFAULT) / \
+                                     WS_BCAST_TEST_BIG_FRAME_LEN + CONFIG_HTTPD_WS_BROADCAST_QUEUE_LEN)
+
+static esp_err_t ws_bcast_test_handler(httpd_req_t *req)
+{
+    if (req->method == HTTP_GET) {
+        /* Handshake done */
+        return ESP_OK;
+    }
+    httpd_ws_frame_t frame = { 0 };
+    return httpd_ws_recv_frame(req, &frame, 0);
+}
+
+static int ws_bcast_test_connect(uint16_t port)
+{
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    TEST_ASSERT(sock >= 0);
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    TEST_ASSERT_EQUAL(0, connect(sock, (struct sockaddr *)&addr, sizeof(addr)));
+
+    const char *req = "GET /ws HTTP/1.1\r\n"
+                      "Host: localhost\r\n"
+                      "Upgrade: websocket\r\n"
+                      "Connection: Upgrade\r\n"
+                      "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                      "Sec-WebSocket-Version: 13\r\n\r\n";
+    TEST_ASSERT_EQUAL(strlen(req), send(sock, req, strlen(req), 0));
+
+    /* The server sends nothing after the handshake response until the
+     * first frame, so reading up to the blank line is enough */
+    char resp[256];
+    size_t len = 0;
+    while (len < 4 || memcmp(&resp[len - 4], "\r\n\r\n", 4) != 0) {
+        TEST_ASSERT(len < sizeof(resp));
+        TEST_ASSERT_EQUAL(1, recv(sock, &resp[len], 1, 0));
+        len++;
+    }
+    TEST_ASSERT_EQUAL(0, strncmp(resp, "HTTP/1.1 101", strlen("HTTP/1.1 101")));
+    return sock;
+}
+
+/* Receives exactly len bytes, returns false on EOF or error */
+static bool ws_bcast_test_recv_all(int sock, uint8_t *buf, size_t len)
+{
+    while (len > 0) {
+        int n = recv(sock, buf, len, 0);
+        if (n <= 0) {
+            return false;
+        }
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+
+/* Receives an unmasked binary frame of up to 65535 bytes and returns the
+ * length of its payload, or -1 if the connection was closed */
+static int ws_bcast_test_read_frame(int sock, uint8_t *payload, size_t max_len)
+{
+    uint8_t hdr[4];
+    if (!ws_bcast_test_recv_all(sock, hdr, 2)) {
+        return -1;
+    }
+    TEST_ASSERT_EQUAL_HEX8(0x80 | HTTPD_WS_TYPE_BINARY, hdr[0]);
+    size_t len = hdr[1];
+    if (len == 126) {
+        if (!ws_bcast_test_recv_all(sock, hdr + 2, 2)) {
+            return -1;
+        }
+        len = (hdr[2] << 8) | hdr[3];
+    }
+    TEST_ASSERT(len <= max_len);
+    if (!ws_bcast_test_recv_all(sock, payload, len)) {
+        return -1;
+    }
+    return len;
+}
+
+static void ws_bcast_test_recv_frame(int sock)
+{
+    uint8_t payload[WS_BCAST_TEST_PAYLOAD_LEN];
+    TEST_ASSERT_EQUAL(WS_BCAST_TEST_PAYLOAD_LEN, ws_bcast_test_read_frame(sock, payload, sizeof(payload)));
+}
+
+TEST_CASE("WebSocket Broadcast Throughput", "[HTTP SERVER]")
+{
+    httpd_handle_t hd;
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.max_open_sockets = CONFIG_LWIP_MAX_SOCKETS - 3;
+
+    test_case_uses_tcpip();
+
+    TEST_ASSERT(httpd_start(&hd, &config) == ESP_OK);
+    httpd_uri_t ws = {
+        .uri = "/ws",
+        .method = HTTP_GET,
+        .handler = ws_bcast_test_handler,
+        .is_websocket = true,
+    };
+    TEST_ASSERT(httpd_register_uri_handler(hd, &ws) == ESP_OK);
+
+    uint8_t payload[WS_BCAST_TEST_PAYLOAD_LEN];
+    memset(payload, 0xa5, sizeof(payload));
+    httpd_ws_frame_t frame = {
+        .type = HTTPD_WS_TYPE_BINARY,
+        .payload = payload,
+        .len = sizeof(payload),
+    };
+
+    int socks[WS_BCAST_TEST_MAX_CLIENTS];
+    int clients = 0;
+    /* The sweep is limited by CONFIG_LWIP_MAX_SOCKETS, raised in sdkconfig.defaults */
+    const int client_counts[] = { 1, 2, 4, 8, 16, 32, 64, 100 };
+    for (int c = 0; c < sizeof(client_counts) / sizeof(client_counts[0]); c++) {
+        int n = MIN(client_counts[c], WS_BCAST_TEST_MAX_CLIENTS);
+        if (n == clients) {
+            break;
+        }
+        if (esp_get_free_heap_size() < WS_BCAST_TEST_MIN_FREE_HEAP) {
+            printf("ws broadcast: stopping at %d client(s), heap is running out\n", clients);
+            break;
+        }
+        while (clients < n) {
+            socks[clients++] = ws_bcast_test_connect(config.server_port);
+        }
+        size_t fds = clients;
+        int client_fds[WS_BCAST_TEST_MAX_CLIENTS];
+        TEST_ESP_OK(httpd_get_client_list(hd, &fds, client_fds));
+
+        /* One work item and one encode per client and frame */
+        int64_t start = esp_timer_get_time();
+        for (int f = 0; f < WS_BCAST_TEST_FRAMES; f++) {
+            for (int i = 0; i < fds; i++) {
+                TEST_ESP_OK(httpd_ws_send_data_async(hd, client_fds[i], &frame, NULL, NULL));
+            }
+            for (int i = 0; i < clients; i++) {
+                ws_bcast_test_recv_frame(socks[i]);
+            }
+        }
+        int64_t per_client_us = esp_timer_get_time() - start;
+
+        /* One work item and one encode per frame */
+        start = esp_timer_get_time();
+        for (int f = 0; f < WS_BCAST_TEST_FRAMES; f++) {
+            TEST_ESP_OK(httpd_ws_broadcast(hd, NULL, NULL, &frame));
+            for (int i = 0; i < clients; i++) {
+                ws_bcast_test_recv_frame(socks[i]);
+            }
+        }
+        int64_t bcast_us = esp_timer_get_time() - start;
+
+        printf("ws broadcast: %d client(s), per-client send %d frames/s, broadcast %d frames/s\n", clients,
+               (int)(WS_BCAST_TEST_FRAMES * 1000000LL / per_client_us), (int)(WS_BCAST_TEST_FRAMES * 1000000LL / bcast_us));
+    }
+
+    for (int i = 0; i < clients; i++) {
+        close(socks[i]);
+    }
+    TEST_ASSERT(httpd_stop(hd) == ESP_OK);
+}
+
+static httpd_handle_t ws_bcast_test_start(void)
+{
+    httpd_handle_t hd;
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    TEST_ASSERT(httpd_start(&hd, &config) == ESP_OK);
+    httpd_uri_t ws = {
+        .uri = "/ws",
+        .method = HTTP_GET,
+        .handler = ws_bcast_test_handler,
+        .is_websocket = true,
+    };
+    TEST_ASSERT(httpd_register_uri_handler(hd, &ws) == ESP_OK);
+    return hd;
+}
+
+/* Broadcasts a frame whose payload is filled with the given marker byte */
+static void ws_bcast_test_send_marker(httpd_handle_t hd, httpd_ws_filter_fn_t filter, void *arg,
+                                      uint8_t *payload, size_t len, uint8_t marker)
+{
+    memset(payload, marker, len);
+    httpd_ws_frame_t frame = {
+        .type = HTTPD_WS_TYPE_BINARY,
+        .payload = payload,
+        .len = len,
+    };
+    TEST_ESP_OK(httpd_ws_broadcast(hd, filter, arg, &frame));
+}
+
+/* Reads a frame and checks that its whole payload is the same marker byte,
+ * returns the marker or -1 if the connection was closed */
+static int ws_bcast_test_read_marker(int sock, uint8_t *payload, size_t len)
+{
+    int ret = ws_bcast_test_read_frame(sock, payload, len);
+    if (ret < 0) {
+        return -1;
+    }
+    TEST_ASSERT_EQUAL(len, ret);
+    for (size_t i = 1; i < len; i++) {
+        TEST_ASSERT_EQUAL_HEX8(payload[0], payload[i]);
+    }
+    return payload[0];
+}
+
+static bool ws_bcast_test_filter_fd(httpd_handle_t hd, int fd, void *arg)
+{
+    return fd == *(int *)arg;
+}
+
+TEST_CASE("WebSocket Broadcast Filter", "[HTTP SERVER]")
+{
+    test_case_uses_tcpip();
+    httpd_handle_t hd = ws_bcast_test_start();
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+
+    int socks[3];
+    for (int i = 0; i < 3; i++) {
+        socks[i] = ws_bcast_test_connect(config.server_port);
+    }
+    int client_fds[3];
+    size_t fds = 3;
+    TEST_ESP_OK(httpd_get_client_list(hd, &fds, client_fds));
+    TEST_ASSERT_EQUAL(3, fds);
+
+    /* Frame 1 goes to a single client, frame 2 to all of them. The order of
+     * the client list is unrelated to the order of connecting, so each
+     * client reports which frames it got. */
+    uint8_t payload[WS_BCAST_TEST_PAYLOAD_LEN];
+    ws_bcast_test_send_marker(hd, ws_bcast_test_filter_fd, &client_fds[1], payload, sizeof(payload), 1);
+    ws_bcast_test_send_marker(hd, NULL, NULL, payload, sizeof(payload), 2);
+
+    int selected = 0;
+    for (int i = 0; i < 3; i++) {
+        int marker = ws_bcast_test_read_marker(socks[i], payload, sizeof(payload));
+        if (marker == 1) {
+            selected++;
+            marker = ws_bcast_test_read_marker(socks[i], payload, sizeof(payload));
+        }
+        TEST_ASSERT_EQUAL(2, marker);
+    }
+    TEST_ASSERT_EQUAL(1, selected);
+
+    for (int i = 0; i < 3; i++) {
+        close(socks[i]);
+    }
+    TEST_ASSERT(httpd_stop(hd) == ESP_OK);
+}
+
+/*
+ * A client that does not read makes the server queue the rest of partially
+ * sent frames. The broadcast must neither block the other clients nor
+ * corrupt the stream of the stalled one.
+ */
+TEST_CASE("WebSocket Broadcast Queues Partial Sends", "[HTTP SERVER]")
+{
+    test_case_uses_tcpip();
+    httpd_handle_t hd = ws_bcast_test_start();
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+
+    int stalled = ws_bcast_test_connect(config.server_port);
+    int reader = ws_bcast_test_connect(config.server_port);
+    uint8_t *payload = malloc(WS_BCAST_TEST_BIG_FRAME_LEN);
+    TEST_ASSERT_NOT_NULL(payload);
+
+    /* More than fits into the socket buffers, but no more than the queue
+     * holds, so some frames are queued and none are dropped */
+    const int frames = CONFIG_HTTPD_WS_BROADCAST_QUEUE_LEN;
+    for (int f = 0; f < frames; f++) {
+        ws_bcast_test_send_marker(hd, NULL, NULL, payload, WS_BCAST_TEST_BIG_FRAME_LEN, f);
+        TEST_ASSERT_EQUAL(f, ws_bcast_test_read_marker(reader, payload, WS_BCAST_TEST_BIG_FRAME_LEN));
+    }
+    for (int f = 0; f < frames; f++) {
+        TEST_ASSERT_EQUAL(f, ws_bcast_test_read_marker(stalled, payload, WS_BCAST_TEST_BIG_FRAME_LEN));
+    }
+
+    free(payload);
+    close(reader);
+    close(stalled);
+    TEST_ASSERT(httpd_stop(hd) == ESP_OK);
+}
+
+/*
+ * A client that does not read for longer than its queue can hold is handled
+ * according to CONFIG_HTTPD_WS_BROADCAST_OVERFLOW.
+ */
+TEST_CASE("WebSocket Broadcast Overflow Policy", "[HTTP SERVER]")
+{
+    test_case_uses_tcpip();
+    httpd_handle_t hd = ws_bcast_test_start();
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+
+    int stalled = ws_bcast_test_connect(config.server_port);
+    int reader = ws_bcast_test_connect(config.server_port);
+    uint8_t *payload = malloc(WS_BCAST_TEST_BIG_FRAME_LEN);
+    TEST_ASSERT_NOT_NULL(payload);
+
+    /* The reader having received a frame means the server has processed it */
+    for (int f = 0; f < WS_BCAST_TEST_BIG_FRAMES; f++) {
+        ws_bcast_test_send_marker(hd, NULL, NULL, payload, WS_BCAST_TEST_BIG_FRAME_LEN, f);
+        TEST_ASSERT_EQUAL(f, ws_bcast_test_read_marker(reader, payload, WS_BCAST_TEST_BIG_FRAME_LEN));
+    }
+
+    /* Drain the stalled client, the server flushes its queue as it reads.
+     * It gets whole frames in order, but not all of them. */
+    struct timeval timeout = { .tv_sec = 2 };
+    TEST_ASSERT_EQUAL(0, setsockopt(stalled, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)));
+    int received = 0;
+    int prev = -1;
+    int marker;
+    errno = 0;
+    while ((marker = ws_bcast_test_read_marker(stalled, payload, WS_BCAST_TEST_BIG_FRAME_LEN)) >= 0) {
+        TEST_ASSERT(marker > prev);
+        prev = marker;
+        received++;
+    }
+    TEST_ASSERT(received < WS_BCAST_TEST_BIG_FRAMES);
+#if CONFIG_HTTPD_WS_BROADCAST_OVERFLOW_CLOSE
+    /* Disconnected on overflow */
+    TEST_ASSERT_NOT_EQUAL(EAGAIN, errno);
+#else
+    /* Frames were dropped, but the connection is still usable */
+    TEST_ASSERT_EQUAL(EAGAIN, errno);
+    timeout.tv_sec = 0;
+    TEST_ASSERT_EQUAL(0, setsockopt(stalled, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)));
+    ws_bcast_test_send_marker(hd, NULL, NULL, payload, WS_BCAST_TEST_BIG_FRAME_LEN, 0xff);
+    TEST_ASSERT_EQUAL(0xff, ws_bcast_test_read_marker(stalled, payload, WS_BCAST_TEST_BIG_FRAME_LEN));
+#endif
+
+    free(payload);
+    close(reader);
+    close(stalled);
+    TEST_ASSERT(httpd_stop(hd) == ESP_OK);
+}
+
+/********************* WebSocket Broadcast End *******************/
+
 void app_main(void)
 {
     unity_run_menu();
@@ -1,13 +1,18 @@
 /*
- * SPDX-FileCopyrightText: 2021-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  *
  * Linux host partition API test
  */
 
+#include <stdio.h>
 #include <string.h>
+#include <inttypes.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
 #include <sys/time.h>
 #include "esp_err.h"
 #include "esp_partition.h"
@@ -86,6 +91,11 @@ TEST(partition_api, test_partition_find_first)
 
     const esp_partition_t *partition_data = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "storage");
     TEST_ASSERT_NOT_NULL(partition_data);
+
+    // a subtype without a type is rejected, like by esp_partition_find()
+    TEST_ASSERT_NULL(esp_partition_find(ESP_PARTITION_TYPE_ANY, partition_data->subtype, "storage"));
+    TEST_ASSERT_NULL(esp_partition_find_first(ESP_PARTITION_TYPE_ANY, partition_data->subtype, "storage"));
+    TEST_ASSERT_NULL(esp_partition_find_first(ESP_PARTITION_TYPE_ANY, partition_data->subtype, NULL));
 }
 
 TEST(partition_api, test_partition_ops)
@@ -722,6 +732,158 @@ TEST(partition_api, test_partition_power_off_emulation)
     free(test_data_ptr);
 }
 
+TEST(partition_api, test_partition_timing_virtual)
+{
+    const esp_partition_t *partition_data = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "storage");
+    TEST_ASSERT_NOT_NULL(partition_data);
+
+    uint8_t buf[ESP_PARTITION_EMULATED_SECTOR_SIZE];
+    memset(buf, 0xa5, sizeof(buf));
+
+    esp_partition_timing_t timing = ESP_PARTITION_TIMING_DEFAULT(ESP_PARTITION_TIMING_VIRTUAL);
+    TEST_ESP_OK(esp_partition_set_timing(&timing));
+    esp_partition_clear_stats();
+
+    TEST_ESP_OK(esp_partition_erase_range(partition_data, 0, 2 * ESP_PARTITION_EMULATED_SECTOR_SIZE));
+    TEST_ESP_OK(esp_partition_write(partition_data, 0, buf, 256));
+    TEST_ESP_OK(esp_partition_read(partition_data, 0, buf, sizeof(buf)));
+
+    uint64_t expected_ns = 2ULL * timing.erase_sector_us * 1000
+                           + timing.program_op_ns + 256ULL * timing.program_byte_ns
+                           + timing.read_op_ns + (uint64_t) sizeof(buf) * timing.read_byte_ns;
+    TEST_ASSERT_EQUAL_UINT64(expected_ns, esp_partition_get_emulated_time_ns());
+    TEST_ASSERT_EQUAL(0, esp_partition_get_suspend_count());
+
+    // virtual time does not delay the caller: 100 sector erases take 4.5 s of emulated time
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < 100; i++) {
+        TEST_ESP_OK(esp_partition_erase_range(partition_data, 0, ESP_PARTITION_EMULATED_SECTOR_SIZE));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    TEST_ASSERT_LESS_THAN(1, end.tv_sec - start.tv_sec);
+    TEST_ASSERT_EQUAL_UINT64(expected_ns + 100ULL * timing.erase_sector_us * 1000, esp_partition_get_emulated_time_ns());
+
+    esp_partition_clear_stats();
+    TEST_ASSERT_EQUAL_UINT64(0, esp_partition_get_emulated_time_ns());
+
+    timing.mode = ESP_PARTITION_TIMING_NONE;
+    TEST_ESP_OK(esp_partition_set_timing(&timing));
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, esp_partition_set_timing(NULL));
+}
+
+static uint64_t timing_monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void *timing_erase_task(void *arg)
+{
+    const esp_partition_t *partition_data = arg;
+    esp_err_t err = esp_partition_erase_range(partition_data, 0, ESP_PARTITION_EMULATED_SECTOR_SIZE);
+    return (void *)(intptr_t) err;
+}
+
+// Issues a read while a sector erase is in progress. The erase is known to be in progress once its time
+// is accounted by the timing model. Returns the monotonic time at which the erase was started at the latest.
+static uint64_t timing_read_during_erase(const esp_partition_t *partition_data, const esp_partition_timing_t *timing,
+                                         uint64_t *read_done_ns)
+{
+    TEST_ESP_OK(esp_partition_set_timing(timing));
+    esp_partition_clear_stats();
+
+    pthread_t eraser;
+    uint64_t erase_start_ns = timing_monotonic_ns();
+    TEST_ASSERT_EQUAL(0, pthread_create(&eraser, NULL, timing_erase_task, (void *) partition_data));
+    while (esp_partition_get_emulated_time_ns() == 0) {
+        sched_yield();
+    }
+
+    uint32_t word;
+    TEST_ESP_OK(esp_partition_read(partition_data, 0, &word, sizeof(word)));
+    *read_done_ns = timing_monotonic_ns();
+
+    void *ret;
+    TEST_ASSERT_EQUAL(0, pthread_join(eraser, &ret));
+    TEST_ESP_OK((esp_err_t)(intptr_t) ret);
+    return erase_start_ns;
+}
+
+TEST(partition_api, test_partition_timing_suspend)
+{
+    const esp_partition_t *partition_data = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "storage");
+    TEST_ASSERT_NOT_NULL(partition_data);
+
+    esp_partition_timing_t timing = ESP_PARTITION_TIMING_DEFAULT(ESP_PARTITION_TIMING_REAL);
+    timing.erase_sector_us = 200000;
+    const uint64_t erase_ns = timing.erase_sector_us * 1000ULL;
+    const uint64_t read_ns = timing.read_op_ns + 4 * timing.read_byte_ns;
+    uint64_t read_done_ns;
+
+    // suspended erase: the read is served right away, the erase takes longer by the suspend overhead
+    timing_read_during_erase(partition_data, &timing, &read_done_ns);
+    TEST_ASSERT_EQUAL(1, esp_partition_get_suspend_count());
+    TEST_ASSERT_EQUAL_UINT64(erase_ns + (timing.suspend_us + timing.resume_us) * 1000ULL + read_ns,
+                             esp_partition_get_emulated_time_ns());
+
+    // no suspend: the read waits for the rest of the erase
+    timing.suspend_enabled = false;
+    uint64_t erase_start_ns = timing_read_during_erase(partition_data, &timing, &read_done_ns);
+    TEST_ASSERT_EQUAL(0, esp_partition_get_suspend_count());
+    TEST_ASSERT_EQUAL_UINT64(erase_ns + read_ns, esp_partition_get_emulated_time_ns());
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT64(erase_start_ns + erase_ns + read_ns, read_done_ns);
+
+    timing.mode = ESP_PARTITION_TIMING_NONE;
+    TEST_ESP_OK(esp_partition_set_timing(&timing));
+}
+
+TEST(partition_api, test_partition_wear_heatmap)
+{
+    const esp_partition_t *partition_data = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "storage");
+    TEST_ASSERT_NOT_NULL(partition_data);
+
+    esp_partition_clear_stats();
+    for (int i = 0; i < 3; i++) {
+        TEST_ESP_OK(esp_partition_erase_range(partition_data, 0, 2 * ESP_PARTITION_EMULATED_SECTOR_SIZE));
+    }
+    TEST_ESP_OK(esp_partition_erase_range(partition_data, ESP_PARTITION_EMULATED_SECTOR_SIZE, ESP_PARTITION_EMULATED_SECTOR_SIZE));
+
+    char filename[64];
+    partition_test_get_unique_filename(filename, sizeof(filename));
+    TEST_ESP_OK(esp_partition_dump_wear_heatmap(filename));
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, esp_partition_dump_wear_heatmap(NULL));
+
+    FILE *f = fopen(filename, "r");
+    TEST_ASSERT_NOT_NULL(f);
+    char line[128];
+    TEST_ASSERT_NOT_NULL(fgets(line, sizeof(line), f));
+    TEST_ASSERT_EQUAL_STRING("sector,address,erase_count,partition\n", line);
+
+    size_t first_sector = partition_data->address / ESP_PARTITION_EMULATED_SECTOR_SIZE;
+    size_t lines = 0;
+    size_t total_erases = 0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        size_t sector, address, count;
+        char label[32] = "";
+        TEST_ASSERT_GREATER_OR_EQUAL(3, sscanf(line, "%zu,%zx,%zu,%31s", &sector, &address, &count, label));
+        TEST_ASSERT_EQUAL(lines, sector);
+        TEST_ASSERT_EQUAL(sector * ESP_PARTITION_EMULATED_SECTOR_SIZE, address);
+        if (sector == first_sector || sector == first_sector + 1) {
+            TEST_ASSERT_EQUAL(sector == first_sector ? 3 : 4, count);
+            TEST_ASSERT_EQUAL_STRING(partition_data->label, label);
+        }
+        total_erases += count;
+        lines++;
+    }
+    fclose(f);
+    remove(filename);
+
+    TEST_ASSERT_EQUAL(esp_partition_get_file_mmap_ctrl_act()->flash_file_size / ESP_PARTITION_EMULATED_SECTOR_SIZE, lines);
+    TEST_ASSERT_EQUAL(esp_partition_get_erase_ops(), total_erases);
+}
+
 TEST(partition_api, test_partition_copy)
 {
     const esp_partition_t *factory_part = esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_FACTORY, NULL);
@@ -764,6 +926,100 @@ TEST(partition_api, test_partition_register_external)
     TEST_ESP_OK(esp_partition_deregister_external(ota1_part));
 }
 
+static uint64_t partition_test_time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+TEST(partition_api, test_partition_find_30_partitions)
+{
+    // Scenario: partition table with 30 partitions, check the lookups and report their duration
+
+    esp_partition_file_munmap();
+
+    esp_partition_file_mmap_ctrl_t *p_file_mmap_ctrl_input = esp_partition_get_file_mmap_ctrl_input();
+    TEST_ASSERT_NOT_NULL(p_file_mmap_ctrl_input);
+    memset(p_file_mmap_ctrl_input, 0, sizeof(*p_file_mmap_ctrl_input));
+    p_file_mmap_ctrl_input->flash_file_size = 0x800000;   // 8MB
+    strlcpy(p_file_mmap_ctrl_input->partition_file_name, BUILD_DIR "/partition_table/partition-table_30.bin", sizeof(p_file_mmap_ctrl_input->partition_file_name));
+
+    // all partitions, in the order of the table
+    const esp_partition_t *parts[30];
+    size_t count = 0;
+    for (esp_partition_iterator_t it = esp_partition_find(ESP_PARTITION_TYPE_ANY, ESP_PARTITION_SUBTYPE_ANY, NULL); it != NULL; it = esp_partition_next(it)) {
+        TEST_ASSERT_LESS_THAN(30, count);
+        parts[count++] = esp_partition_get(it);
+    }
+    TEST_ASSERT_EQUAL(30, count);
+
+    for (size_t i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL_PTR(parts[i], esp_partition_find_first(ESP_PARTITION_TYPE_ANY, ESP_PARTITION_SUBTYPE_ANY, parts[i]->label));
+        TEST_ASSERT_EQUAL_PTR(parts[i], esp_partition_find_first(parts[i]->type, parts[i]->subtype, parts[i]->label));
+        TEST_ASSERT_NULL(esp_partition_find_first(parts[i]->type, parts[i]->subtype + 1, parts[i]->label));
+
+        // the lookups by type and subtype return the partitions in the order of the table
+        size_t matches = 0;
+        const esp_partition_t *first = NULL;
+        esp_partition_iterator_t it = esp_partition_find(parts[i]->type, parts[i]->subtype, NULL);
+        for (size_t j = 0; j < count; j++) {
+            if (parts[j]->type == parts[i]->type && parts[j]->subtype == parts[i]->subtype) {
+                TEST_ASSERT_NOT_NULL(it);
+                TEST_ASSERT_EQUAL_PTR(parts[j], esp_partition_get(it));
+                first = first ? first : parts[j];
+                it = esp_partition_next(it);
+                matches++;
+            }
+        }
+        TEST_ASSERT_NULL(it);
+        TEST_ASSERT_NOT_EQUAL(0, matches);
+        TEST_ASSERT_EQUAL_PTR(first, esp_partition_find_first(parts[i]->type, parts[i]->subtype, NULL));
+    }
+    TEST_ASSERT_NULL(esp_partition_find_first(ESP_PARTITION_TYPE_ANY, ESP_PARTITION_SUBTYPE_ANY, "storage"));
+
+    size_t data_count = 0;
+    for (esp_partition_iterator_t it = esp_partition_find(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, NULL); it != NULL; it = esp_partition_next(it)) {
+        data_count++;
+    }
+    TEST_ASSERT_EQUAL(27, data_count);
+
+    const int rounds = 10000;
+    uint64_t start = partition_test_time_ns();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < count; i++) {
+            TEST_ASSERT_EQUAL_PTR(parts[i], esp_partition_find_first(ESP_PARTITION_TYPE_ANY, ESP_PARTITION_SUBTYPE_ANY, parts[i]->label));
+        }
+    }
+    uint64_t by_label = partition_test_time_ns() - start;
+
+    start = partition_test_time_ns();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < count; i++) {
+            TEST_ASSERT_NOT_NULL(esp_partition_find_first(parts[i]->type, parts[i]->subtype, NULL));
+        }
+    }
+    uint64_t by_subtype = partition_test_time_ns() - start;
+
+    start = partition_test_time_ns();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < count; i++) {
+            esp_partition_iterator_t it = esp_partition_find(parts[i]->type, parts[i]->subtype, NULL);
+            TEST_ASSERT_NOT_NULL(it);
+            esp_partition_iterator_release(it);
+        }
+    }
+    uint64_t find_release = partition_test_time_ns() - start;
+
+    const uint64_t lookups = (uint64_t) rounds * count;
+    ESP_LOGI(TAG, "30 partitions, per lookup: find_first by label %" PRIu64 " ns, by type and subtype %" PRIu64 " ns, find and release %" PRIu64 " ns",
+             by_label / lookups, by_subtype / lookups, find_release / lookups);
+
+    // cleanup after test
+    esp_partition_file_munmap();
+    memset(p_file_mmap_ctrl_input, 0, sizeof(*p_file_mmap_ctrl_input));
+}
+
 TEST_GROUP_RUNNER(partition_api)
 {
     RUN_TEST_CASE(partition_api, test_partition_find_basic);
@@ -783,8 +1039,12 @@ TEST_GROUP_RUNNER(partition_api)
     RUN_TEST_CASE(partition_api, test_partition_mmap_size_too_small);
     RUN_TEST_CASE(partition_api, test_partition_stats);
     RUN_TEST_CASE(partition_api, test_partition_power_off_emulation);
+    RUN_TEST_CASE(partition_api, test_partition_timing_virtual);
+    RUN_TEST_CASE(partition_api, test_partition_timing_suspend);
+    RUN_TEST_CASE(partition_api, test_partition_wear_heatmap);
     RUN_TEST_CASE(partition_api, test_partition_copy);
     RUN_TEST_CASE(partition_api, test_partition_register_external);
+    RUN_TEST_CASE(partition_api, test_partition_find_30_partitions);
 }
 
 static void run_all_tests(void)
@@ -200,6 +200,103 @@ void esp_partition_fail_after(size_t count, uint8_t mode);
 */
 size_t esp_partition_get_sector_erase_count(size_t sector);
 
+/** @brief Accounting of the emulated flash operation times */
+typedef enum {
+    ESP_PARTITION_TIMING_NONE,      /*!< Operations complete instantly and are not accounted (default) */
+    ESP_PARTITION_TIMING_VIRTUAL,   /*!< Operation times are accumulated in a virtual clock, operations complete instantly */
+    ESP_PARTITION_TIMING_REAL,      /*!< Operation times are accumulated and the calling thread is delayed accordingly */
+} esp_partition_timing_mode_t;
+
+/**
+ * @brief Timing model of the emulated SPI FLASH device
+ *
+ * Read and program times are made of a fixed part per operation (command, address and status polling)
+ * and a part proportional to the number of bytes. Erase time is proportional to the number of sectors.
+ *
+ * Suspend and resume only apply in ESP_PARTITION_TIMING_REAL mode, where operations issued by different threads
+ * can overlap: a read issued while a program or erase is in progress suspends it if suspend_enabled is set,
+ * otherwise the read waits until the program or erase completes.
+ */
+typedef struct {
+    esp_partition_timing_mode_t mode;   /*!< Accounting of the operation times */
+    uint32_t read_op_ns;                /*!< Fixed time of a read operation, in nanoseconds */
+    uint32_t read_byte_ns;              /*!< Time to read one byte, in nanoseconds */
+    uint32_t program_op_ns;             /*!< Fixed time of a program operation, in nanoseconds */
+    uint32_t program_byte_ns;           /*!< Time to program one byte, in nanoseconds */
+    uint32_t erase_sector_us;           /*!< Time to erase one ESP_PARTITION_EMULATED_SECTOR_SIZE sector, in microseconds */
+    bool suspend_enabled;               /*!< Reads suspend a program or erase in progress instead of waiting for it */
+    uint32_t suspend_us;                /*!< Time to suspend a program or erase, in microseconds */
+    uint32_t resume_us;                 /*!< Time to resume a suspended program or erase, in microseconds */
+} esp_partition_timing_t;
+
+/**
+ * @brief Typical timing of a quad SPI NOR flash chip, with the given accounting mode
+ */
+#define ESP_PARTITION_TIMING_DEFAULT(timing_mode) (esp_partition_timing_t) { \
+    .mode = (timing_mode), \
+    .read_op_ns = 1000, \
+    .read_byte_ns = 100, \
+    .program_op_ns = 10000, \
+    .program_byte_ns = 2400, \
+    .erase_sector_us = 45000, \
+    .suspend_enabled = true, \
+    .suspend_us = 20, \
+    .resume_us = 20, \
+}
+
+/**
+ * @brief Sets the timing model of the emulated SPI FLASH device
+ *
+ * Requires CONFIG_ESP_PARTITION_ENABLE_STATS. The emulated time is accounted in addition to
+ * the statistics returned by esp_partition_get_total_time, and cleared by esp_partition_clear_stats.
+ *
+ * @param[in] timing Timing model, see ESP_PARTITION_TIMING_DEFAULT
+ *
+ * @return
+ *      - ESP_OK: Timing model set
+ *      - ESP_ERR_INVALID_ARG: timing is NULL or its mode is invalid
+ */
+esp_err_t esp_partition_set_timing(const esp_partition_timing_t *timing);
+
+/**
+ * @brief Returns the time spent in emulated flash operations according to the timing model
+ *
+ * In ESP_PARTITION_TIMING_VIRTUAL mode this is the virtual clock. It includes the suspend and resume overhead
+ * of programs and erases interrupted by reads.
+ * In ESP_PARTITION_TIMING_REAL mode the time of an operation is accounted when it starts, before the calling
+ * thread is delayed.
+ *
+ * @return
+ *      - emulated time in nanoseconds since recent esp_partition_clear_stats
+ */
+uint64_t esp_partition_get_emulated_time_ns(void);
+
+/**
+ * @brief Returns number of program or erase operations suspended by reads
+ *
+ * @return
+ *      - number of suspensions since recent esp_partition_clear_stats
+ */
+size_t esp_partition_get_suspend_count(void);
+
+/**
+ * @brief Exports erase counts of all virtual emulated sectors to a CSV file
+ *
+ * The file contains one line per ESP_PARTITION_EMULATED_SECTOR_SIZE sector with the columns
+ * sector, address, erase_count and partition (label of the partition containing the sector, empty if none).
+ * It can be plotted as a heatmap to evaluate the wear distribution of a storage engine.
+ *
+ * @param[in] path Name of the file to create
+ *
+ * @return
+ *      - ESP_OK: File written
+ *      - ESP_ERR_INVALID_ARG: path is NULL
+ *      - ESP_ERR_INVALID_STATE: flash emulation is not mapped
+ *      - ESP_ERR_NO_MEM: Out of memory
+ *      - ESP_FAIL: Failed to write the file
+ */
+esp_err_t esp_partition_dump_wear_heatmap(const char *path);
+
 typedef struct {
     char flash_file_name[PATH_MAX];      /*!< name of flash dump file, zero-terminated ASCII string */
     size_t flash_file_size;              /*!< size of flash dump file in bytes */
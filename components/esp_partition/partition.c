@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -67,8 +67,34 @@ typedef struct esp_partition_iterator_opaque_ {
     esp_partition_t *info;                          // pointer to info (it is redundant, but makes code more readable)
 } esp_partition_iterator_opaque_t;
 
+/* Entry of an index of the partition table. Entries are sorted by key, then by position in the table.
+ * Iterators returned for lookups which an index covers point to its entries, so they don't need to be allocated.
+ */
+typedef struct partition_index_entry_ {
+    uint32_t key;                                   // depends on the index: type and subtype, type, or label hash
+    const struct partition_index_entry_ *next;      // next entry with the same key, NULL if none
+    partition_list_item_t *item;
+} partition_index_entry_t;
+
+typedef struct {
+    partition_index_entry_t *entries;               // all indexes, PARTITION_INDEX_MAX * count entries
+    size_t count;                                   // number of partitions in the table
+    bool labels_unique;                             // false if labels are repeated, label lookups are not indexed then
+} partition_index_t;
+
+typedef enum {
+    PARTITION_INDEX_BY_SUBTYPE,
+    PARTITION_INDEX_BY_TYPE,
+    PARTITION_INDEX_BY_LABEL,
+    PARTITION_INDEX_MAX,
+} partition_index_kind_t;
+
 static SLIST_HEAD(partition_list_head_, partition_list_item_) s_partition_list = SLIST_HEAD_INITIALIZER(s_partition_list);
 static _lock_t s_partition_list_lock;
+// Index of the partitions loaded from the partition table, built along with s_partition_list
+static partition_index_t s_partition_index;
+// Number of partitions registered with esp_partition_register_external, which are not indexed
+static size_t s_external_partition_count;
 
 static const char *TAG = "partition";
 
@@ -102,6 +128,158 @@ static bool is_partition_encrypted(bool encryption_config, esp_partition_type_t
 #endif
 }
 
+static uint32_t label_hash(const char *label)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(((esp_partition_t *) 0)->label) && label[i] != '\0'; i++) {
+        hash ^= (uint8_t) label[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t index_key(partition_index_kind_t kind, const esp_partition_t *info)
+{
+    switch (kind) {
+    case PARTITION_INDEX_BY_SUBTYPE:
+        return ((uint32_t) info->type << 8) | info->subtype;
+    case PARTITION_INDEX_BY_TYPE:
+        return info->type;
+    default:
+        return label_hash(info->label);
+    }
+}
+
+static partition_index_entry_t *index_entries(partition_index_kind_t kind)
+{
+    return s_partition_index.entries + kind * s_partition_index.count;
+}
+
+// Build the indexes of the partitions in s_partition_list, called with s_partition_list_lock taken.
+// If there is not enough memory, lookups fall back to iterating the list.
+static void build_partition_index(void)
+{
+    size_t count = 0;
+    partition_list_item_t *item;
+    SLIST_FOREACH(item, &s_partition_list, next) {
+        count++;
+    }
+    if (count == 0) {
+        return;
+    }
+    partition_index_entry_t *entries = calloc(PARTITION_INDEX_MAX * count, sizeof(partition_index_entry_t));
+    if (entries == NULL) {
+        ESP_LOGW(TAG, "Not enough memory for the partition index");
+        return;
+    }
+    s_partition_index.entries = entries;
+    s_partition_index.count = count;
+    s_partition_index.labels_unique = true;
+
+    for (partition_index_kind_t kind = 0; kind < PARTITION_INDEX_MAX; kind++) {
+        partition_index_entry_t *index = index_entries(kind);
+        size_t n = 0;
+        // Insertion sort keeps the table order of equal keys. The table is small and this is done once.
+        SLIST_FOREACH(item, &s_partition_list, next) {
+            partition_index_entry_t entry = {
+                .key = index_key(kind, &item->info),
+                .item = item,
+            };
+            size_t pos = n;
+            while (pos > 0 && index[pos - 1].key > entry.key) {
+                index[pos] = index[pos - 1];
+                pos--;
+            }
+            index[pos] = entry;
+            n++;
+        }
+        for (size_t i = 0; i + 1 < count; i++) {
+            if (index[i].key != index[i + 1].key) {
+                continue;
+            }
+            if (kind == PARTITION_INDEX_BY_LABEL) {
+                // Label lookups return at most one partition, checking for equal labels with different hashes isn't needed
+                if (strcmp(index[i].item->info.label, index[i + 1].item->info.label) == 0) {
+                    s_partition_index.labels_unique = false;
+                }
+            } else {
+                index[i].next = &index[i + 1];
+            }
+        }
+    }
+}
+
+static void free_partition_index(void)
+{
+    free(s_partition_index.entries);
+    s_partition_index = (partition_index_t) {};
+}
+
+static bool is_index_iterator(esp_partition_iterator_t it)
+{
+    uintptr_t begin = (uintptr_t) s_partition_index.entries;
+    uintptr_t end = (uintptr_t) (s_partition_index.entries + PARTITION_INDEX_MAX * s_partition_index.count);
+    return (uintptr_t) it >= begin && (uintptr_t) it < end;
+}
+
+// Binary search for the first entry of the index with the key, NULL if there is none
+static const partition_index_entry_t *index_lookup(partition_index_kind_t kind, uint32_t key)
+{
+    const partition_index_entry_t *index = index_entries(kind);
+    size_t lo = 0;
+    size_t hi = s_partition_index.count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (index[mid].key < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return (lo < s_partition_index.count && index[lo].key == key) ? &index[lo] : NULL;
+}
+
+// Look up the first partition of the table matching the constraints in the indexes.
+// Returns false if the lookup is not covered by an index, the list has to be searched then.
+static bool index_find(esp_partition_type_t type, esp_partition_subtype_t subtype, const char *label,
+                       const partition_index_entry_t **out_entry)
+{
+    *out_entry = NULL;
+    if (s_partition_index.entries == NULL || type > ESP_PARTITION_TYPE_ANY || subtype > ESP_PARTITION_SUBTYPE_ANY) {
+        return false;
+    }
+    if (label != NULL) {
+        if (!s_partition_index.labels_unique) {
+            return false;
+        }
+        const uint32_t hash = label_hash(label);
+        const partition_index_entry_t *end = index_entries(PARTITION_INDEX_BY_LABEL) + s_partition_index.count;
+        for (const partition_index_entry_t *entry = index_lookup(PARTITION_INDEX_BY_LABEL, hash);
+                entry != NULL && entry < end && entry->key == hash; entry++) {
+            const esp_partition_t *p = &entry->item->info;
+            if (strcmp(label, p->label) == 0) {
+                if ((type == ESP_PARTITION_TYPE_ANY || type == p->type)
+                        && (subtype == ESP_PARTITION_SUBTYPE_ANY || subtype == p->subtype)) {
+                    *out_entry = entry;
+                }
+                break;
+            }
+        }
+        return true;
+    }
+    if (type == ESP_PARTITION_TYPE_ANY) {
+        // would have to be in table order across all the types, iterating the list is as fast
+        return false;
+    }
+    if (subtype == ESP_PARTITION_SUBTYPE_ANY) {
+        *out_entry = index_lookup(PARTITION_INDEX_BY_TYPE, type);
+    } else {
+        *out_entry = index_lookup(PARTITION_INDEX_BY_SUBTYPE, ((uint32_t) type << 8) | subtype);
+    }
+    return true;
+}
+
 // Create linked list of partition_list_item_t structures.
 // This function is called only once, with s_partition_list_lock taken.
 static esp_err_t load_partitions(void)
@@ -234,6 +412,7 @@ static esp_err_t load_partitions(void)
     if (err == ESP_OK) {
         /* Don't copy the list to the static variable unless it's verified */
         s_partition_list = new_partitions_list;
+        build_partition_index();
     } else {
         /* Otherwise, free all the memory we just allocated */
         partition_list_item_t *it = new_partitions_list.slh_first;
@@ -254,6 +433,8 @@ static esp_err_t load_partitions(void)
 void esp_partition_unload_all(void)
 {
     _lock_acquire(&s_partition_list_lock);
+    free_partition_index();
+    s_external_partition_count = 0;
     partition_list_item_t *it;
     partition_list_item_t *tmp;
     SLIST_FOREACH_SAFE(it, &s_partition_list, next, tmp) {
@@ -311,6 +492,11 @@ esp_partition_iterator_t esp_partition_find(esp_partition_type_t type,
     if (type == ESP_PARTITION_TYPE_ANY && subtype != ESP_PARTITION_SUBTYPE_ANY) {
         return NULL;
     }
+    // Partitions registered externally are only in the list, after the partitions from the table
+    const partition_index_entry_t *entry;
+    if (s_external_partition_count == 0 && index_find(type, subtype, label, &entry)) {
+        return (esp_partition_iterator_t) entry;
+    }
     // create an iterator pointing to the start of the list
     // (next item will be the first one)
     esp_partition_iterator_t it = iterator_create(type, subtype, label);
@@ -326,6 +512,9 @@ esp_partition_iterator_t esp_partition_find(esp_partition_type_t type,
 esp_partition_iterator_t esp_partition_next(esp_partition_iterator_t it)
 {
     assert(it);
+    if (is_index_iterator(it)) {
+        return (esp_partition_iterator_t) ((const partition_index_entry_t *) it)->next;
+    }
     // iterator reached the end of linked list?
     if (it->next_item == NULL) {
         esp_partition_iterator_release(it);
@@ -359,6 +548,18 @@ esp_partition_iterator_t esp_partition_next(esp_partition_iterator_t it)
 const esp_partition_t *esp_partition_find_first(esp_partition_type_t type,
         esp_partition_subtype_t subtype, const char *label)
 {
+    if (ensure_partitions_loaded() != ESP_OK) {
+        return NULL;
+    }
+    // Same usage error as in esp_partition_find(), the index could answer it
+    if (type == ESP_PARTITION_TYPE_ANY && subtype != ESP_PARTITION_SUBTYPE_ANY) {
+        return NULL;
+    }
+    const partition_index_entry_t *entry;
+    if (index_find(type, subtype, label, &entry) && (entry != NULL || s_external_partition_count == 0)) {
+        // a match in the table precedes any partition registered externally
+        return entry ? &entry->item->info : NULL;
+    }
     esp_partition_iterator_t it = esp_partition_find(type, subtype, label);
     if (it == NULL) {
         return NULL;
@@ -371,12 +572,18 @@ const esp_partition_t *esp_partition_find_first(esp_partition_type_t type,
 void esp_partition_iterator_release(esp_partition_iterator_t iterator)
 {
     // iterator == NULL is okay
+    if (is_index_iterator(iterator)) {
+        return;
+    }
     free(iterator);
 }
 
 const esp_partition_t *esp_partition_get(esp_partition_iterator_t iterator)
 {
     assert(iterator != NULL);
+    if (is_index_iterator(iterator)) {
+        return &((const partition_index_entry_t *) iterator)->item->info;
+    }
     return iterator->info;
 }
 
@@ -464,6 +671,7 @@ esp_err_t esp_partition_register_external(esp_flash_t *flash_chip, size_t offset
     } else {
         SLIST_INSERT_AFTER(last, item, next);
     }
+    s_external_partition_count++;
     _lock_release(&s_partition_list_lock);
     if (out_partition != NULL) {
         *out_partition = &item->info;
@@ -485,6 +693,7 @@ esp_err_t esp_partition_deregister_external(const esp_partition_t *partition)
             }
             SLIST_REMOVE(&s_partition_list, it, partition_list_item_, next);
             free(it);
+            s_external_partition_count--;
             result = ESP_OK;
             break;
         }
@@ -14,6 +14,8 @@
 #include <unistd.h>
 #include <limits.h>
 #include <errno.h>
+#include <time.h>
+#include <pthread.h>
 #include "sdkconfig.h"
 #include "esp_partition.h"
 #include "esp_flash_partitions.h"
@@ -46,6 +48,14 @@ static uint8_t s_esp_partition_emulated_power_off_mode = 0;
 // tracking erase count individually for each emulated sector
 static size_t *s_esp_partition_stat_sector_erase_count = NULL;
 
+// flash timing model, see esp_partition_set_timing()
+static esp_partition_timing_t s_esp_partition_timing = { .mode = ESP_PARTITION_TIMING_NONE };
+static pthread_mutex_t s_esp_partition_timing_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t s_esp_partition_timing_time_ns = 0;     // modeled time of all operations (virtual clock)
+static uint64_t s_esp_partition_timing_busy_until = 0;  // end of the program/erase in progress (real time mode)
+static uint32_t s_esp_partition_timing_busy_seq = 0;    // identifies the program/erase in progress
+static size_t s_esp_partition_timing_suspends = 0;
+
 // forward declaration of hooks
 static void esp_partition_hook_read(const void *srcAddr, const size_t size);
 static bool esp_partition_hook_write(const void *dstAddr, size_t *size);
@@ -321,7 +331,7 @@ esp_err_t esp_partition_file_mmap(const uint8_t **part_desc_addr_start)
 
 #ifdef CONFIG_ESP_PARTITION_ENABLE_STATS
     free(s_esp_partition_stat_sector_erase_count);
-    s_esp_partition_stat_sector_erase_count = malloc(sizeof(size_t) * s_esp_partition_file_mmap_ctrl_act.flash_file_size / ESP_PARTITION_EMULATED_SECTOR_SIZE);
+    s_esp_partition_stat_sector_erase_count = calloc(s_esp_partition_file_mmap_ctrl_act.flash_file_size / ESP_PARTITION_EMULATED_SECTOR_SIZE, sizeof(size_t));
 #endif
 
     //return mmapped file starting address
@@ -575,6 +585,96 @@ static size_t s_esp_partition_stat_read_times[] = {7, 5, 6, 7, 11, 18, 32, 60, 1
 static size_t s_esp_partition_stat_write_times[] = {19, 23, 35, 57, 106, 205, 417, 814, 1622, 3200, 6367};
 static size_t s_esp_partition_stat_block_erase_time = 37142;
 
+typedef enum {
+    ESP_PARTITION_TIMING_OP_READ,
+    ESP_PARTITION_TIMING_OP_PROGRAM,
+    ESP_PARTITION_TIMING_OP_ERASE,
+} esp_partition_timing_op_t;
+
+static uint64_t esp_partition_timing_monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void esp_partition_timing_sleep_until(uint64_t deadline_ns)
+{
+    struct timespec ts = {
+        .tv_sec = deadline_ns / 1000000000ULL,
+        .tv_nsec = deadline_ns % 1000000000ULL,
+    };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+// Accounts the duration of the emulated flash operation according to the timing model. The duration is computed
+// from size, the number of bytes read or programmed, or the number of sectors erased.
+// In virtual time mode the duration is only added to the virtual clock.
+// In real time mode the calling thread is delayed and the device executes one operation at a time:
+// a read issued while a program/erase is in progress either suspends it (when enabled), or waits for it to finish.
+// Each suspension delays the completion of the program/erase by the suspend, read and resume times.
+static void esp_partition_timing_account(esp_partition_timing_op_t op, size_t size)
+{
+    pthread_mutex_lock(&s_esp_partition_timing_lock);
+    const esp_partition_timing_t *timing = &s_esp_partition_timing;
+    if (timing->mode == ESP_PARTITION_TIMING_NONE) {
+        pthread_mutex_unlock(&s_esp_partition_timing_lock);
+        return;
+    }
+    uint64_t duration_ns;
+    switch (op) {
+    case ESP_PARTITION_TIMING_OP_READ:
+        duration_ns = timing->read_op_ns + (uint64_t) timing->read_byte_ns * size;
+        break;
+    case ESP_PARTITION_TIMING_OP_PROGRAM:
+        duration_ns = timing->program_op_ns + (uint64_t) timing->program_byte_ns * size;
+        break;
+    default:
+        duration_ns = (uint64_t) timing->erase_sector_us * 1000 * size;
+        break;
+    }
+    s_esp_partition_timing_time_ns += duration_ns;
+    if (timing->mode == ESP_PARTITION_TIMING_VIRTUAL) {
+        pthread_mutex_unlock(&s_esp_partition_timing_lock);
+        return;
+    }
+
+    uint64_t start = esp_partition_timing_monotonic_ns();
+    if (start < s_esp_partition_timing_busy_until) {
+        if (op == ESP_PARTITION_TIMING_OP_READ && timing->suspend_enabled) {
+            uint64_t overhead_ns = (uint64_t)(timing->suspend_us + timing->resume_us) * 1000;
+            start += (uint64_t) timing->suspend_us * 1000;
+            s_esp_partition_timing_busy_until += overhead_ns + duration_ns;
+            s_esp_partition_timing_time_ns += overhead_ns;
+            s_esp_partition_timing_suspends++;
+        } else {
+            start = s_esp_partition_timing_busy_until;
+        }
+    }
+    uint64_t end = start + duration_ns;
+    uint32_t seq = 0;
+    if (op != ESP_PARTITION_TIMING_OP_READ) {
+        s_esp_partition_timing_busy_until = end;
+        seq = ++s_esp_partition_timing_busy_seq;
+    }
+    pthread_mutex_unlock(&s_esp_partition_timing_lock);
+
+    esp_partition_timing_sleep_until(end);
+
+    // reads served in the meantime may have postponed the end of this program/erase
+    while (op != ESP_PARTITION_TIMING_OP_READ) {
+        pthread_mutex_lock(&s_esp_partition_timing_lock);
+        bool postponed = seq == s_esp_partition_timing_busy_seq && s_esp_partition_timing_busy_until > end;
+        end = s_esp_partition_timing_busy_until;
+        pthread_mutex_unlock(&s_esp_partition_timing_lock);
+        if (!postponed) {
+            break;
+        }
+        esp_partition_timing_sleep_until(end);
+    }
+}
+
 static size_t esp_partition_stat_time_interpolate(uint32_t bytes, size_t *lut)
 {
     const int lut_size = sizeof(s_esp_partition_stat_read_times) / sizeof(s_esp_partition_stat_read_times[0]);
@@ -599,6 +699,8 @@ static void esp_partition_hook_read(const void *srcAddr, const size_t size)
     ++s_esp_partition_stat_read_ops;
     s_esp_partition_stat_read_bytes += size;
     s_esp_partition_stat_total_time += esp_partition_stat_time_interpolate((uint32_t) size, s_esp_partition_stat_read_times);
+
+    esp_partition_timing_account(ESP_PARTITION_TIMING_OP_READ, size);
 }
 
 // Registers write access statistics of emulated SPI FLASH device (Linux host)
@@ -644,6 +746,9 @@ static bool esp_partition_hook_write(const void *dstAddr, size_t *size)
         s_esp_partition_stat_total_time += esp_partition_stat_time_interpolate((uint32_t) (*size), s_esp_partition_stat_write_times);
     }
 
+    // the bytes programmed before an emulated power-off took their time too
+    esp_partition_timing_account(ESP_PARTITION_TIMING_OP_PROGRAM, *size);
+
     return ret_val;
 }
 
@@ -697,6 +802,8 @@ static bool esp_partition_hook_erase(const void *dstAddr, size_t *size)
         s_esp_partition_stat_total_time += s_esp_partition_stat_block_erase_time;
     }
 
+    esp_partition_timing_account(ESP_PARTITION_TIMING_OP_ERASE, sector_count);
+
     return ret_val;
 }
 
@@ -709,6 +816,11 @@ void esp_partition_clear_stats(void)
     s_esp_partition_stat_write_ops = 0;
     s_esp_partition_stat_total_time = 0;
 
+    pthread_mutex_lock(&s_esp_partition_timing_lock);
+    s_esp_partition_timing_time_ns = 0;
+    s_esp_partition_timing_suspends = 0;
+    pthread_mutex_unlock(&s_esp_partition_timing_lock);
+
     memset(s_esp_partition_stat_sector_erase_count, 0, sizeof(size_t) * s_esp_partition_file_mmap_ctrl_act.flash_file_size / ESP_PARTITION_EMULATED_SECTOR_SIZE);
 }
 
@@ -752,4 +864,80 @@ size_t esp_partition_get_sector_erase_count(size_t sector)
 {
     return s_esp_partition_stat_sector_erase_count[sector];
 }
+
+esp_err_t esp_partition_set_timing(const esp_partition_timing_t *timing)
+{
+    if (timing == NULL || timing->mode > ESP_PARTITION_TIMING_REAL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&s_esp_partition_timing_lock);
+    s_esp_partition_timing = *timing;
+    s_esp_partition_timing_busy_until = 0;
+    pthread_mutex_unlock(&s_esp_partition_timing_lock);
+    return ESP_OK;
+}
+
+uint64_t esp_partition_get_emulated_time_ns(void)
+{
+    pthread_mutex_lock(&s_esp_partition_timing_lock);
+    uint64_t time_ns = s_esp_partition_timing_time_ns;
+    pthread_mutex_unlock(&s_esp_partition_timing_lock);
+    return time_ns;
+}
+
+size_t esp_partition_get_suspend_count(void)
+{
+    pthread_mutex_lock(&s_esp_partition_timing_lock);
+    size_t suspends = s_esp_partition_timing_suspends;
+    pthread_mutex_unlock(&s_esp_partition_timing_lock);
+    return suspends;
+}
+
+esp_err_t esp_partition_dump_wear_heatmap(const char *path)
+{
+    if (path == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_esp_partition_stat_sector_erase_count == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    size_t sector_count = s_esp_partition_file_mmap_ctrl_act.flash_file_size / ESP_PARTITION_EMULATED_SECTOR_SIZE;
+    const char **labels = calloc(sector_count, sizeof(const char *));
+    if (labels == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    // owner of each sector, partitions registered by the table as well as the external ones
+    esp_partition_iterator_t it = esp_partition_find(ESP_PARTITION_TYPE_ANY, ESP_PARTITION_SUBTYPE_ANY, NULL);
+    for (; it != NULL; it = esp_partition_next(it)) {
+        const esp_partition_t *part = esp_partition_get(it);
+        size_t first = part->address / ESP_PARTITION_EMULATED_SECTOR_SIZE;
+        size_t last = (part->address + part->size + ESP_PARTITION_EMULATED_SECTOR_SIZE - 1) / ESP_PARTITION_EMULATED_SECTOR_SIZE;
+        for (size_t i = first; i < last && i < sector_count; i++) {
+            labels[i] = part->label;
+        }
+    }
+
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        ESP_LOGE(TAG, "Failed to open wear heatmap file %s: %s", path, strerror(errno));
+        free(labels);
+        return ESP_FAIL;
+    }
+
+    fprintf(f, "sector,address,erase_count,partition\n");
+    for (size_t i = 0; i < sector_count; i++) {
+        fprintf(f, "%zu,0x%08zx,%zu,%s\n", i, i * ESP_PARTITION_EMULATED_SECTOR_SIZE,
+                s_esp_partition_stat_sector_erase_count[i], labels[i] ? labels[i] : "");
+    }
+
+    esp_err_t ret = ESP_OK;
+    if (fclose(f) != 0) {
+        ESP_LOGE(TAG, "Failed to write wear heatmap file %s: %s", path, strerror(errno));
+        ret = ESP_FAIL;
+    }
+    free(labels);
+    return ret;
+}
 #endif
@@ -35,8 +35,8 @@ static DRAM_ATTR StaticSemaphore_t s_ipc_ack_buffer[CONFIG_FREERTOS_NUMBER_OF_CO
 static TaskHandle_t s_ipc_task_handle[CONFIG_FREERTOS_NUMBER_OF_CORES];
 static SemaphoreHandle_t s_ipc_mutex[CONFIG_FREERTOS_NUMBER_OF_CORES];    // This mutex is used as a global lock for esp_ipc_* APIs
 static SemaphoreHandle_t s_ipc_ack[CONFIG_FREERTOS_NUMBER_OF_CORES];      // Semaphore used to acknowledge that task was woken up,
-static volatile esp_ipc_func_t s_func[CONFIG_FREERTOS_NUMBER_OF_CORES] = { 0 };   // Function which should be called by high priority task
-static void * volatile s_func_arg[CONFIG_FREERTOS_NUMBER_OF_CORES];       // Argument to pass into s_func
+static const esp_ipc_call_desc_t * volatile s_calls[CONFIG_FREERTOS_NUMBER_OF_CORES] = { 0 };   // Calls which should be made by high priority task
+static volatile size_t s_num_calls[CONFIG_FREERTOS_NUMBER_OF_CORES];     // Number of calls in s_calls
 typedef enum {
     IPC_WAIT_NO = 0,
     IPC_WAIT_FOR_START,
@@ -49,6 +49,40 @@ static volatile esp_ipc_func_t s_no_block_func[portNUM_PROCESSORS] = { 0 };
 static volatile bool s_no_block_func_and_arg_are_ready[portNUM_PROCESSORS] = { 0 };
 static void * volatile s_no_block_func_arg[portNUM_PROCESSORS];
 
+/* Ring of calls made by esp_ipc_call_async(), run in order by the IPC task */
+typedef struct {
+    esp_ipc_call_desc_t calls[CONFIG_ESP_IPC_ASYNC_QUEUE_SIZE];
+    uint32_t head;      // Index of the oldest call
+    uint32_t count;     // Number of calls in the ring
+    portMUX_TYPE lock;
+} ipc_async_queue_t;
+
+static ipc_async_queue_t s_async_queue[CONFIG_FREERTOS_NUMBER_OF_CORES];
+
+static void ESP_SYSTEM_IRAM_ATTR ipc_async_queue_run(ipc_async_queue_t *queue)
+{
+#ifdef CONFIG_ESP_IPC_USES_CALLERS_PRIORITY
+    // Calls queued from an ISR cannot raise the priority of the IPC task before waking it, so the task does it itself.
+    // A call queued concurrently is either seen here or wakes the task again.
+    if (queue->count != 0) {
+        vTaskPrioritySet(NULL, IPC_MAX_PRIORITY);
+    }
+#endif
+    while (true) {
+        portENTER_CRITICAL(&queue->lock);
+        if (queue->count == 0) {
+            portEXIT_CRITICAL(&queue->lock);
+            break;
+        }
+        esp_ipc_call_desc_t call = queue->calls[queue->head];
+        queue->head = (queue->head + 1) % CONFIG_ESP_IPC_ASYNC_QUEUE_SIZE;
+        queue->count--;
+        portEXIT_CRITICAL(&queue->lock);
+
+        (*call.func)(call.arg);
+    }
+}
+
 static void ESP_SYSTEM_IRAM_ATTR ipc_task(void* arg)
 {
     const int cpuid = (int) arg;
@@ -67,21 +101,28 @@ static void ESP_SYSTEM_IRAM_ATTR ipc_task(void* arg)
             s_no_block_func[cpuid] = NULL;
         }
 
+        ipc_async_queue_run(&s_async_queue[cpuid]);
+
 #ifndef CONFIG_FREERTOS_UNICORE
-        if (s_func[cpuid]) {
-            // we need to cache s_func, s_func_arg and ipc_ack variables locally
+        if (s_calls[cpuid]) {
+            // we need to cache s_calls, s_num_calls and ipc_ack variables locally
             // because they can be changed by a subsequent IPC call (after xTaskNotify(caller_task_handle)).
-            esp_ipc_func_t func = s_func[cpuid];
-            void* func_arg = s_func_arg[cpuid];
+            const esp_ipc_call_desc_t *calls = s_calls[cpuid];
+            size_t num_calls = s_num_calls[cpuid];
             esp_ipc_wait_t ipc_wait = s_wait_for[cpuid];
             SemaphoreHandle_t ipc_ack = s_ipc_ack[cpuid];
-            s_func[cpuid] = NULL;
+            s_calls[cpuid] = NULL;
 
             if (ipc_wait == IPC_WAIT_FOR_START) {
+                // the call is on the caller's stack, which can be reused as soon as the caller is acknowledged
+                esp_ipc_func_t func = calls[0].func;
+                void* func_arg = calls[0].arg;
                 xSemaphoreGive(ipc_ack);
                 (*func)(func_arg);
             } else if (ipc_wait == IPC_WAIT_FOR_END) {
-                (*func)(func_arg);
+                for (size_t i = 0; i < num_calls; i++) {
+                    (*calls[i].func)(calls[i].arg);
+                }
                 xSemaphoreGive(ipc_ack);
             } else {
                 abort();
@@ -98,8 +139,8 @@ static void ESP_SYSTEM_IRAM_ATTR ipc_task(void* arg)
  * This function start two tasks, one on each CPU. These tasks are started
  * with high priority. These tasks are normally inactive, waiting until one of
  * the esp_ipc_call_* functions to be used. One of these tasks will be
- * woken up to execute the callback provided to esp_ipc_call_nonblocking or
- * esp_ipc_call_blocking.
+ * woken up to execute the callback provided to esp_ipc_call_nonblocking,
+ * esp_ipc_call_async, esp_ipc_call_batch_blocking or esp_ipc_call_blocking.
  */
 static void esp_ipc_init(void) __attribute__((constructor));
 
@@ -111,6 +152,7 @@ static void esp_ipc_init(void)
         task_name[3] = i + (char)'0';
         s_ipc_mutex[i] = xSemaphoreCreateMutexStatic(&s_ipc_mutex_buffer[i]);
         s_ipc_ack[i] = xSemaphoreCreateBinaryStatic(&s_ipc_ack_buffer[i]);
+        portMUX_INITIALIZE(&s_async_queue[i].lock);
         BaseType_t res = xTaskCreatePinnedToCore(ipc_task, task_name, IPC_STACK_SIZE, (void*) i,
                                                  IPC_MAX_PRIORITY, &s_ipc_task_handle[i], i);
         assert(res == pdTRUE);
@@ -118,7 +160,7 @@ static void esp_ipc_init(void)
     }
 }
 
-static esp_err_t esp_ipc_call_and_wait(uint32_t cpu_id, esp_ipc_func_t func, void* arg, esp_ipc_wait_t wait_for)
+static esp_err_t esp_ipc_call_and_wait(uint32_t cpu_id, const esp_ipc_call_desc_t *calls, size_t num_calls, esp_ipc_wait_t wait_for)
 {
     if (cpu_id >= CONFIG_FREERTOS_NUMBER_OF_CORES) {
         return ESP_ERR_INVALID_ARG;
@@ -144,10 +186,10 @@ static esp_err_t esp_ipc_call_and_wait(uint32_t cpu_id, esp_ipc_func_t func, voi
     xSemaphoreTake(s_ipc_mutex[0], portMAX_DELAY);
 #endif
 
-    s_func_arg[cpu_id] = arg;
+    s_num_calls[cpu_id] = num_calls;
     s_wait_for[cpu_id] = wait_for;
-    // s_func must be set after all other parameters. The ipc_task use this as indicator of the IPC is prepared.
-    s_func[cpu_id] = func;
+    // s_calls must be set after all other parameters. The ipc_task use this as indicator of the IPC is prepared.
+    s_calls[cpu_id] = calls;
     xTaskNotifyGive(s_ipc_task_handle[cpu_id]);
     xSemaphoreTake(s_ipc_ack[cpu_id], portMAX_DELAY);
 
@@ -161,12 +203,70 @@ static esp_err_t esp_ipc_call_and_wait(uint32_t cpu_id, esp_ipc_func_t func, voi
 
 esp_err_t esp_ipc_call(uint32_t cpu_id, esp_ipc_func_t func, void* arg)
 {
-    return esp_ipc_call_and_wait(cpu_id, func, arg, IPC_WAIT_FOR_START);
+    const esp_ipc_call_desc_t call = { .func = func, .arg = arg };
+    return esp_ipc_call_and_wait(cpu_id, &call, 1, IPC_WAIT_FOR_START);
 }
 
 esp_err_t esp_ipc_call_blocking(uint32_t cpu_id, esp_ipc_func_t func, void* arg)
 {
-    return esp_ipc_call_and_wait(cpu_id, func, arg, IPC_WAIT_FOR_END);
+    const esp_ipc_call_desc_t call = { .func = func, .arg = arg };
+    return esp_ipc_call_and_wait(cpu_id, &call, 1, IPC_WAIT_FOR_END);
+}
+
+esp_err_t esp_ipc_call_batch_blocking(uint32_t cpu_id, const esp_ipc_call_desc_t *calls, size_t num_calls)
+{
+    if (calls == NULL || num_calls == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < num_calls; i++) {
+        if (calls[i].func == NULL) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    return esp_ipc_call_and_wait(cpu_id, calls, num_calls, IPC_WAIT_FOR_END);
+}
+
+esp_err_t esp_ipc_call_async(uint32_t cpu_id, esp_ipc_func_t func, void* arg)
+{
+    if (cpu_id >= CONFIG_FREERTOS_NUMBER_OF_CORES || func == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_ipc_task_handle[cpu_id] == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (cpu_id == xPortGetCoreID() && xTaskGetSchedulerState() != taskSCHEDULER_RUNNING) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    ipc_async_queue_t *queue = &s_async_queue[cpu_id];
+    portENTER_CRITICAL_SAFE(&queue->lock);
+    if (queue->count == CONFIG_ESP_IPC_ASYNC_QUEUE_SIZE) {
+        portEXIT_CRITICAL_SAFE(&queue->lock);
+        return ESP_ERR_NO_MEM;
+    }
+    uint32_t tail = (queue->head + queue->count) % CONFIG_ESP_IPC_ASYNC_QUEUE_SIZE;
+    queue->calls[tail].func = func;
+    queue->calls[tail].arg = arg;
+    bool was_empty = (queue->count++ == 0);
+    portEXIT_CRITICAL_SAFE(&queue->lock);
+
+    // The IPC task runs the queued calls until the ring is empty, so it only needs to be woken up by the first one
+    if (!was_empty) {
+        return ESP_OK;
+    }
+    if (xPortInIsrContext()) {
+        BaseType_t higher_prio_woken = pdFALSE;
+        vTaskNotifyGiveFromISR(s_ipc_task_handle[cpu_id], &higher_prio_woken);
+        if (higher_prio_woken) {
+            portYIELD_FROM_ISR();
+        }
+    } else {
+#ifdef CONFIG_ESP_IPC_USES_CALLERS_PRIORITY
+        vTaskPrioritySet(s_ipc_task_handle[cpu_id], IPC_MAX_PRIORITY);
+#endif
+        xTaskNotifyGive(s_ipc_task_handle[cpu_id]);
+    }
+    return ESP_OK;
 }
 
 esp_err_t esp_ipc_call_nonblocking(uint32_t cpu_id, esp_ipc_func_t func, void* arg)
@@ -1,11 +1,12 @@
 /*
- * SPDX-FileCopyrightText: 2015-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
 
 #pragma once
 
+#include <stddef.h>
 #include <esp_err.h>
 
 #ifdef __cplusplus
@@ -29,6 +30,16 @@ extern "C" {
  */
 typedef void (*esp_ipc_func_t)(void* arg);
 
+/**
+ * @brief Description of a single call in a batch of IPC calls
+ *
+ * An array of these is provided as an argument when calling esp_ipc_call_batch_blocking().
+ */
+typedef struct {
+    esp_ipc_func_t func;    /**< Callback to be executed */
+    void *arg;              /**< Arbitrary argument of type void* to be passed into the callback */
+} esp_ipc_call_desc_t;
+
 /**
  * @brief Execute a callback on a given CPU
  *
@@ -71,6 +82,56 @@ esp_err_t esp_ipc_call(uint32_t cpu_id, esp_ipc_func_t func, void* arg);
  */
 esp_err_t esp_ipc_call_blocking(uint32_t cpu_id, esp_ipc_func_t func, void* arg);
 
+/**
+ * @brief Execute a batch of callbacks on a given CPU and block until all of them complete
+ *
+ * The callbacks are executed one after another, in the order of the array, in the context of the target CPU's IPC task.
+ * The target CPU's IPC task is only woken up once for the whole batch, thus this function is considerably faster than
+ * calling esp_ipc_call_blocking() for each callback when many short callbacks have to be executed on the other CPU.
+ *
+ * - The calls are executed while the IPC mutex is held, thus other IPC calls to the target CPU are delayed until the
+ *   whole batch completes
+ * - The array must remain valid until this function returns
+ *
+ * @note    In single-core mode, returns ESP_ERR_INVALID_ARG for cpu_id 1.
+ *
+ * @param[in]   cpu_id      CPU where the given functions should be executed (0 or 1)
+ * @param[in]   calls       Array of callbacks and their arguments
+ * @param[in]   num_calls   Number of elements in the calls array
+ *
+ * @return
+ *      - ESP_ERR_INVALID_ARG if cpu_id is invalid, calls is NULL, num_calls is 0 or any of the callbacks is NULL
+ *      - ESP_ERR_INVALID_STATE if the FreeRTOS scheduler is not running
+ *      - ESP_OK otherwise
+ */
+esp_err_t esp_ipc_call_batch_blocking(uint32_t cpu_id, const esp_ipc_call_desc_t *calls, size_t num_calls);
+
+/**
+ * @brief Queue a callback for execution on a given CPU without waiting for it
+ *
+ * The callback is added to a per-CPU ring of pending calls and the target CPU's IPC task is notified. The callbacks
+ * in the ring are executed in the order they were queued. This function never blocks, and can be called from an
+ * interrupt or when the scheduler of the current CPU is suspended.
+ *
+ * - The length of the ring can be configured via the CONFIG_ESP_IPC_ASYNC_QUEUE_SIZE option
+ * - The caller is not notified of the completion of the callback. If required, the callback has to signal it itself.
+ * - With CONFIG_ESP_IPC_USES_CALLERS_PRIORITY, the callbacks run at the maximum IPC priority. When called from an
+ *   interrupt, the IPC task is woken at the priority of its last caller and raises its priority before running the
+ *   callbacks.
+ *
+ * @param[in]   cpu_id  CPU where the given function should be executed (0 or 1)
+ * @param[in]   func    Pointer to a function of type void func(void* arg) to be executed
+ * @param[in]   arg     Arbitrary argument of type void* to be passed into the function
+ *
+ * @return
+ *      - ESP_ERR_INVALID_ARG if cpu_id or func is invalid
+ *      - ESP_ERR_INVALID_STATE if the IPC tasks have not been initialized yet, or cpu_id is the current CPU and the
+ *        FreeRTOS scheduler is not running on it
+ *      - ESP_ERR_NO_MEM if the ring of the target CPU is full
+ *      - ESP_OK otherwise
+ */
+esp_err_t esp_ipc_call_async(uint32_t cpu_id, esp_ipc_func_t func, void* arg);
+
 #endif // !defined(CONFIG_FREERTOS_UNICORE) || defined(CONFIG_APPTRACE_GCOV_ENABLE)
 
 #ifdef __cplusplus
@@ -1,10 +1,11 @@
 /*
- * SPDX-FileCopyrightText: 2015-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
 
 #include <stdio.h>
+#include <inttypes.h>
 #include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -16,6 +17,7 @@
 #endif
 #include "esp_log.h"
 #include "esp_rom_sys.h"
+#include "esp_timer.h"
 
 #if !CONFIG_FREERTOS_UNICORE
 static void test_func_ipc_cb(void *arg)
@@ -135,6 +137,41 @@ TEST_CASE("Test multiple ipc_calls", "[ipc]")
         vSemaphoreDelete(test_semaphore[i].start);
     }
 }
+
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+static void test_func_ipc_priority_cb(void *arg)
+{
+    *(volatile UBaseType_t *)arg = uxTaskPriorityGet(NULL);
+}
+
+static void IRAM_ATTR test_ipc_async_from_isr_cb(void *arg)
+{
+    esp_ipc_call_async(1, test_func_ipc_priority_cb, arg);
+}
+
+TEST_CASE("Test ipc call async from an ISR runs at the maximum IPC priority", "[ipc]")
+{
+    volatile UBaseType_t func_priority = 0;
+
+    // A blocking call leaves the IPC task at the priority of its caller
+    TEST_ESP_OK(esp_ipc_call_blocking(1, test_func_ipc_priority_cb, (void *)&func_priority));
+    TEST_ASSERT_EQUAL(uxTaskPriorityGet(NULL), func_priority);
+
+    func_priority = 0;
+    esp_timer_handle_t timer;
+    const esp_timer_create_args_t timer_args = {
+        .callback = test_ipc_async_from_isr_cb,
+        .arg = (void *)&func_priority,
+        .dispatch_method = ESP_TIMER_ISR,
+        .name = "ipc_async_isr",
+    };
+    TEST_ESP_OK(esp_timer_create(&timer_args, &timer));
+    TEST_ESP_OK(esp_timer_start_once(timer, 1000));
+    vTaskDelay(50 / portTICK_PERIOD_MS);
+    TEST_ESP_OK(esp_timer_delete(timer));
+    TEST_ASSERT_EQUAL(configMAX_PRIORITIES - 1, func_priority);
+}
+#endif /* CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD */
 #endif /* CONFIG_ESP_IPC_USES_CALLERS_PRIORITY */
 
 static void test_func_ipc_cb2(void *arg)
@@ -209,4 +246,184 @@ TEST_CASE("Test ipc call nonblocking when FreeRTOS Scheduler is suspended", "[ip
     xTaskResumeAll();
 #endif
 }
+
+#define TEST_BATCH_MAX_CALLS 100
+
+typedef struct {
+    int cpu_id;
+    int order;
+    volatile int *counter;
+} test_batch_call_arg_t;
+
+static void test_func_ipc_batch_cb(void *arg)
+{
+    test_batch_call_arg_t *call_arg = (test_batch_call_arg_t *)arg;
+    call_arg->cpu_id = xPortGetCoreID();
+    call_arg->order = (*call_arg->counter)++;
+}
+
+TEST_CASE("Test ipc call batch blocking", "[ipc]")
+{
+    esp_ipc_call_desc_t calls[TEST_BATCH_MAX_CALLS];
+    test_batch_call_arg_t args[TEST_BATCH_MAX_CALLS];
+    volatile int counter = 0;
+    const int other_cpu = !xPortGetCoreID();
+
+    for (int i = 0; i < TEST_BATCH_MAX_CALLS; i++) {
+        args[i] = (test_batch_call_arg_t) {
+            .cpu_id = -1, .order = -1, .counter = &counter
+        };
+        calls[i] = (esp_ipc_call_desc_t) {
+            .func = test_func_ipc_batch_cb, .arg = &args[i]
+        };
+    }
+    TEST_ESP_OK(esp_ipc_call_batch_blocking(other_cpu, calls, TEST_BATCH_MAX_CALLS));
+
+    // All the calls have completed in order on the other CPU when the function returns
+    TEST_ASSERT_EQUAL(TEST_BATCH_MAX_CALLS, counter);
+    for (int i = 0; i < TEST_BATCH_MAX_CALLS; i++) {
+        TEST_ASSERT_EQUAL(other_cpu, args[i].cpu_id);
+        TEST_ASSERT_EQUAL(i, args[i].order);
+    }
+
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, esp_ipc_call_batch_blocking(other_cpu, calls, 0));
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, esp_ipc_call_batch_blocking(other_cpu, NULL, 1));
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, esp_ipc_call_batch_blocking(CONFIG_FREERTOS_NUMBER_OF_CORES, calls, 1));
+    calls[1].func = NULL;
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, esp_ipc_call_batch_blocking(other_cpu, calls, 2));
+    TEST_ASSERT_EQUAL(TEST_BATCH_MAX_CALLS, counter);
+}
+
+TEST_CASE("Test ipc call async", "[ipc]")
+{
+    test_batch_call_arg_t args[CONFIG_ESP_IPC_ASYNC_QUEUE_SIZE];
+    volatile int counter = 0;
+    int val = 20;
+
+    // Keep the IPC task busy so that the queued calls stay pending
+    TEST_ESP_OK(esp_ipc_call_async(1, test_func_ipc_cb2, &val));
+    vTaskDelay(10 / portTICK_PERIOD_MS);
+    for (int i = 0; i < CONFIG_ESP_IPC_ASYNC_QUEUE_SIZE; i++) {
+        args[i] = (test_batch_call_arg_t) {
+            .cpu_id = -1, .order = -1, .counter = &counter
+        };
+        TEST_ESP_OK(esp_ipc_call_async(1, test_func_ipc_batch_cb, &args[i]));
+    }
+    TEST_ESP_ERR(ESP_ERR_NO_MEM, esp_ipc_call_async(1, test_func_ipc_batch_cb, &args[0]));
+    TEST_ASSERT_EQUAL(20, val);
+    TEST_ASSERT_EQUAL(0, counter);
+
+    vTaskDelay(150 / portTICK_PERIOD_MS);
+    TEST_ASSERT_EQUAL(21, val);
+    TEST_ASSERT_EQUAL(CONFIG_ESP_IPC_ASYNC_QUEUE_SIZE, counter);
+    for (int i = 0; i < CONFIG_ESP_IPC_ASYNC_QUEUE_SIZE; i++) {
+        TEST_ASSERT_EQUAL(1, args[i].cpu_id);
+        TEST_ASSERT_EQUAL(i, args[i].order);
+    }
+
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, esp_ipc_call_async(CONFIG_FREERTOS_NUMBER_OF_CORES, test_func_ipc_cb4, &val));
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, esp_ipc_call_async(1, NULL, &val));
+}
+
+TEST_CASE("Test ipc call async when FreeRTOS Scheduler is suspended", "[ipc]")
+{
+#ifdef CONFIG_FREERTOS_SMP
+    //Note: Scheduler suspension behavior changed in FreeRTOS SMP
+    vTaskPreemptionDisable(NULL);
+#else
+    // Disable scheduler on the current CPU
+    vTaskSuspendAll();
+#endif // CONFIG_FREERTOS_SMP
+
+    volatile int value = 20;
+    TEST_ESP_OK(esp_ipc_call_async(1, test_func_ipc_cb4, (void*)&value));
+    TEST_ESP_OK(esp_ipc_call_async(1, test_func_ipc_cb4, (void*)&value));
+    while (value != 22) { };
+
+#ifdef CONFIG_FREERTOS_SMP
+    //Note: Scheduler suspension behavior changed in FreeRTOS SMP
+    vTaskPreemptionEnable(NULL);
+#else
+    xTaskResumeAll();
+#endif
+    TEST_ASSERT_EQUAL(22, value);
+}
+
+#define TEST_PERF_ROUNDS 20
+
+static void test_func_ipc_count_cb(void *arg)
+{
+    (*(volatile uint32_t *)arg)++;
+}
+
+static void print_ipc_perf(const char *mode, int num_calls, int64_t elapsed_us)
+{
+    uint32_t calls = TEST_PERF_ROUNDS * num_calls;
+    printf("%-12s %3d call(s): latency %5"PRIi64" us per batch, throughput %7"PRIi64" calls/s\n",
+           mode, num_calls, elapsed_us / TEST_PERF_ROUNDS, (int64_t)calls * 1000000 / (elapsed_us ? elapsed_us : 1));
+}
+
+/*
+Benchmark the IPC modes with batches of short callbacks
+
+Procedure:
+    - Run batches of 1, 10 and 100 calls on the other CPU, each batch TEST_PERF_ROUNDS times:
+        - one esp_ipc_call_blocking() per call
+        - one esp_ipc_call_batch_blocking() per batch
+        - one esp_ipc_call_async() per call, then wait for the calls to complete
+
+Expected:
+    - All the calls are executed, the latency of a batch and the throughput of each mode are printed
+*/
+TEST_CASE("Test ipc call latency and throughput of batches", "[ipc]")
+{
+    const int batch_sizes[] = { 1, 10, TEST_BATCH_MAX_CALLS };
+    esp_ipc_call_desc_t calls[TEST_BATCH_MAX_CALLS];
+    volatile uint32_t counter;
+    const int other_cpu = !xPortGetCoreID();
+
+    for (int i = 0; i < TEST_BATCH_MAX_CALLS; i++) {
+        calls[i] = (esp_ipc_call_desc_t) {
+            .func = test_func_ipc_count_cb, .arg = (void *)&counter
+        };
+    }
+
+    for (size_t b = 0; b < sizeof(batch_sizes) / sizeof(batch_sizes[0]); b++) {
+        const int num_calls = batch_sizes[b];
+        const uint32_t expected = TEST_PERF_ROUNDS * num_calls;
+
+        counter = 0;
+        int64_t start = esp_timer_get_time();
+        for (int r = 0; r < TEST_PERF_ROUNDS; r++) {
+            for (int i = 0; i < num_calls; i++) {
+                TEST_ESP_OK(esp_ipc_call_blocking(other_cpu, test_func_ipc_count_cb, (void *)&counter));
+            }
+        }
+        print_ipc_perf("blocking", num_calls, esp_timer_get_time() - start);
+        TEST_ASSERT_EQUAL(expected, counter);
+
+        counter = 0;
+        start = esp_timer_get_time();
+        for (int r = 0; r < TEST_PERF_ROUNDS; r++) {
+            TEST_ESP_OK(esp_ipc_call_batch_blocking(other_cpu, calls, num_calls));
+        }
+        print_ipc_perf("batch", num_calls, esp_timer_get_time() - start);
+        TEST_ASSERT_EQUAL(expected, counter);
+
+        counter = 0;
+        start = esp_timer_get_time();
+        for (int r = 0; r < TEST_PERF_ROUNDS; r++) {
+            const uint32_t done = (r + 1) * num_calls;
+            for (int i = 0; i < num_calls; i++) {
+                // The IPC task of the other CPU drains the queue in parallel, retry until there is room
+                while (esp_ipc_call_async(other_cpu, test_func_ipc_count_cb, (void *)&counter) == ESP_ERR_NO_MEM) {
+                }
+            }
+            while (counter != done) {
+            }
+        }
+        print_ipc_perf("async", num_calls, esp_timer_get_time() - start);
+        TEST_ASSERT_EQUAL(expected, counter);
+    }
+}
 #endif /* !CONFIG_FREERTOS_UNICORE */
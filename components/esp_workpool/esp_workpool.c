@@ -0,0 +1,516 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include <stdatomic.h>
+#include "sdkconfig.h"
+#include "esp_check.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_workpool.h"
+
+static const char *TAG = "workpool";
+
+/* Notes on the implementation:
+ *
+ * - Each worker has a bounded double-ended queue of jobs, protected by a spinlock. The worker
+ *   takes the newest job from its own queue, so that jobs submitted by a job run while their
+ *   data is still in cache. Other workers steal the oldest job from the queue.
+ * - Idle workers block on a counting semaphore. Submitting a job only gives the semaphore when
+ *   a worker is idle, so that keeping busy workers fed does not call into FreeRTOS.
+ * - Waiting for a job or for a parallel_for uses a completion, which creates a semaphore on the
+ *   stack of the waiting task only when it actually has to block.
+ */
+
+/* Values of completion_t::state, other than the handle of the semaphore of the waiting task */
+#define COMPLETION_PENDING  ((uintptr_t) 0)
+#define COMPLETION_DONE     ((uintptr_t) 1)
+
+typedef struct {
+    _Atomic uintptr_t state;
+} completion_t;
+
+struct esp_workpool_job {
+    esp_workpool_func_t func;
+    void *arg;
+    struct esp_workpool *pool;
+    completion_t done;
+    _Atomic uint32_t refs;      /* The worker which runs the job, and the future, if any */
+    bool embedded;              /* Job is part of a parallel_for, and is not reference counted */
+};
+
+typedef struct esp_workpool_job esp_workpool_job_t;
+
+typedef struct {
+    esp_workpool_job_t **jobs;  /* Ring buffer of queue_size pending jobs */
+    uint32_t head;              /* Index of the oldest pending job */
+    uint32_t count;             /* Number of pending jobs */
+    portMUX_TYPE lock;
+    TaskHandle_t task;
+    struct esp_workpool *pool;
+    uint32_t index;
+} worker_t;
+
+struct esp_workpool {
+    uint32_t num_workers;
+    uint32_t queue_size;
+    SemaphoreHandle_t work_sem;         /* Given to wake up idle workers */
+    SemaphoreHandle_t exit_sem;         /* Given by each worker when it exits */
+    _Atomic uint32_t idle_workers;
+    _Atomic uint32_t next_worker;       /* Queue for the next job submitted by another task */
+    _Atomic bool stopping;
+    worker_t workers[];
+};
+
+/* Shared state of an esp_workpool_parallel_for() call, followed by the jobs of the helping workers */
+typedef struct {
+    esp_workpool_range_func_t func;
+    void *arg;
+    size_t start;
+    size_t end;
+    size_t chunk_size;
+    size_t num_chunks;
+    _Atomic size_t next_chunk;
+    _Atomic size_t chunks_done;
+    completion_t done;
+    _Atomic uint32_t refs;      /* The calling task, and each helper job which was queued */
+    esp_workpool_job_t helpers[];
+} parallel_for_t;
+
+static void completion_init(completion_t *completion)
+{
+    atomic_init(&completion->state, COMPLETION_PENDING);
+}
+
+static bool completion_is_done(completion_t *completion)
+{
+    return atomic_load_explicit(&completion->state, memory_order_acquire) == COMPLETION_DONE;
+}
+
+static void completion_complete(completion_t *completion)
+{
+    uintptr_t state = atomic_exchange_explicit(&completion->state, COMPLETION_DONE, memory_order_acq_rel);
+    if (state != COMPLETION_PENDING) {
+        xSemaphoreGive((SemaphoreHandle_t) state);
+    }
+}
+
+/* Only one task may wait for a completion at a time */
+static bool completion_wait(completion_t *completion, TickType_t timeout)
+{
+    if (completion_is_done(completion)) {
+        return true;
+    }
+    if (timeout == 0) {
+        return false;
+    }
+
+    StaticSemaphore_t sem_buffer;
+    SemaphoreHandle_t sem = xSemaphoreCreateBinaryStatic(&sem_buffer);
+    uintptr_t expected = COMPLETION_PENDING;
+    bool done = true;
+    if (atomic_compare_exchange_strong_explicit(&completion->state, &expected, (uintptr_t) sem,
+                                                memory_order_acq_rel, memory_order_acquire)) {
+        done = (xSemaphoreTake(sem, timeout) == pdTRUE);
+        if (!done) {
+            expected = (uintptr_t) sem;
+            if (!atomic_compare_exchange_strong_explicit(&completion->state, &expected, COMPLETION_PENDING,
+                                                         memory_order_acq_rel, memory_order_acquire)) {
+                /* Completed after the timeout, wait until the semaphore is given so that it can be deleted */
+                xSemaphoreTake(sem, portMAX_DELAY);
+                done = true;
+            }
+        }
+    } else {
+        assert(expected == COMPLETION_DONE && "another task is already waiting");
+    }
+    vSemaphoreDelete(sem);
+    return done;
+}
+
+static void job_release(esp_workpool_job_t *job)
+{
+    if (atomic_fetch_sub_explicit(&job->refs, 1, memory_order_acq_rel) == 1) {
+        free(job);
+    }
+}
+
+static void run_job(esp_workpool_job_t *job)
+{
+    /* An embedded job may be freed by its function */
+    if (job->embedded) {
+        job->func(job->arg);
+        return;
+    }
+    job->func(job->arg);
+    completion_complete(&job->done);
+    job_release(job);
+}
+
+static bool worker_push(worker_t *worker, esp_workpool_job_t *job)
+{
+    uint32_t queue_size = worker->pool->queue_size;
+    bool pushed = false;
+
+    portENTER_CRITICAL(&worker->lock);
+    if (worker->count < queue_size) {
+        worker->jobs[(worker->head + worker->count) % queue_size] = job;
+        worker->count++;
+        pushed = true;
+    }
+    portEXIT_CRITICAL(&worker->lock);
+    return pushed;
+}
+
+/* Take the newest job, called by the worker itself */
+static esp_workpool_job_t *worker_pop(worker_t *worker)
+{
+    esp_workpool_job_t *job = NULL;
+
+    portENTER_CRITICAL(&worker->lock);
+    if (worker->count > 0) {
+        worker->count--;
+        job = worker->jobs[(worker->head + worker->count) % worker->pool->queue_size];
+    }
+    portEXIT_CRITICAL(&worker->lock);
+    return job;
+}
+
+/* Take the oldest job, called by other workers */
+static esp_workpool_job_t *worker_steal(worker_t *worker)
+{
+    esp_workpool_job_t *job = NULL;
+
+    portENTER_CRITICAL(&worker->lock);
+    if (worker->count > 0) {
+        job = worker->jobs[worker->head];
+        worker->head = (worker->head + 1) % worker->pool->queue_size;
+        worker->count--;
+    }
+    portEXIT_CRITICAL(&worker->lock);
+    return job;
+}
+
+/* Returns the index of the worker running the current task, or -1 if it is not a worker of the pool */
+static int current_worker_index(esp_workpool_handle_t pool)
+{
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    for (uint32_t i = 0; i < pool->num_workers; i++) {
+        if (pool->workers[i].task == task) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static esp_workpool_job_t *find_job(esp_workpool_handle_t pool, int self)
+{
+    esp_workpool_job_t *job = NULL;
+    uint32_t first = 0;
+
+    if (self >= 0) {
+        job = worker_pop(&pool->workers[self]);
+        first = self + 1;
+    }
+    for (uint32_t i = 0; job == NULL && i < pool->num_workers; i++) {
+        uint32_t victim = (first + i) % pool->num_workers;
+        if ((int) victim != self) {
+            job = worker_steal(&pool->workers[victim]);
+        }
+    }
+    return job;
+}
+
+/* Queue a job on the queue of the current worker, or on the queues of the workers in turn, and wake up a worker */
+static bool push_job(esp_workpool_handle_t pool, esp_workpool_job_t *job, int self)
+{
+    uint32_t first = (self >= 0) ? (uint32_t) self : atomic_fetch_add(&pool->next_worker, 1);
+
+    for (uint32_t i = 0; i < pool->num_workers; i++) {
+        if (worker_push(&pool->workers[(first + i) % pool->num_workers], job)) {
+            /* Checking idle_workers after queueing the job pairs with the workers checking the queues again
+               after incrementing idle_workers, so that the job is never missed by all idle workers */
+            if (atomic_load(&pool->idle_workers) > 0) {
+                xSemaphoreGive(pool->work_sem);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+static void worker_task(void *arg)
+{
+    worker_t *worker = (worker_t *) arg;
+    esp_workpool_handle_t pool = worker->pool;
+
+    while (1) {
+        esp_workpool_job_t *job = find_job(pool, worker->index);
+        if (job == NULL) {
+            if (atomic_load(&pool->stopping)) {
+                break;
+            }
+            atomic_fetch_add(&pool->idle_workers, 1);
+            job = find_job(pool, worker->index);
+            if (job == NULL && !atomic_load(&pool->stopping)) {
+                xSemaphoreTake(pool->work_sem, portMAX_DELAY);
+            }
+            atomic_fetch_sub(&pool->idle_workers, 1);
+        }
+        if (job != NULL) {
+            run_job(job);
+        }
+    }
+
+    xSemaphoreGive(pool->exit_sem);
+    vTaskDelete(NULL);
+}
+
+/* Stop the first num_started workers after they have run all pending jobs, and free the pool */
+static void workpool_destroy(esp_workpool_handle_t pool, uint32_t num_started)
+{
+    atomic_store(&pool->stopping, true);
+    for (uint32_t i = 0; i < num_started; i++) {
+        xSemaphoreGive(pool->work_sem);
+    }
+    for (uint32_t i = 0; i < num_started; i++) {
+        xSemaphoreTake(pool->exit_sem, portMAX_DELAY);
+    }
+
+    if (pool->work_sem) {
+        vSemaphoreDelete(pool->work_sem);
+    }
+    if (pool->exit_sem) {
+        vSemaphoreDelete(pool->exit_sem);
+    }
+    free(pool->workers[0].jobs);
+    free(pool);
+}
+
+esp_err_t esp_workpool_create(const esp_workpool_config_t *config, esp_workpool_handle_t *ret_pool)
+{
+    ESP_RETURN_ON_FALSE(config && ret_pool, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(config->queue_size > 0, ESP_ERR_INVALID_ARG, TAG, "queue size must not be 0");
+
+    uint32_t num_workers = config->num_workers ? config->num_workers : portNUM_PROCESSORS;
+    esp_workpool_handle_t pool = calloc(1, sizeof(struct esp_workpool) + num_workers * sizeof(worker_t));
+    ESP_RETURN_ON_FALSE(pool, ESP_ERR_NO_MEM, TAG, "no memory for work pool");
+
+    pool->num_workers = num_workers;
+    pool->queue_size = config->queue_size;
+    atomic_init(&pool->idle_workers, 0);
+    atomic_init(&pool->next_worker, 0);
+    atomic_init(&pool->stopping, false);
+
+    esp_workpool_job_t **jobs = calloc(num_workers * config->queue_size, sizeof(esp_workpool_job_t *));
+    pool->work_sem = xSemaphoreCreateCounting(num_workers, 0);
+    pool->exit_sem = xSemaphoreCreateCounting(num_workers, 0);
+    for (uint32_t i = 0; i < num_workers; i++) {
+        worker_t *worker = &pool->workers[i];
+        worker->jobs = jobs ? &jobs[i * config->queue_size] : NULL;
+        portMUX_INITIALIZE(&worker->lock);
+        worker->pool = pool;
+        worker->index = i;
+    }
+    if (!jobs || !pool->work_sem || !pool->exit_sem) {
+        workpool_destroy(pool, 0);
+        ESP_LOGE(TAG, "no memory for work pool");
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (uint32_t i = 0; i < num_workers; i++) {
+        worker_t *worker = &pool->workers[i];
+        BaseType_t core_id = config->pin_to_core ? (BaseType_t)(i % portNUM_PROCESSORS) : tskNO_AFFINITY;
+        if (xTaskCreatePinnedToCore(worker_task, "workpool", config->task_stack_size, worker, config->task_priority,
+                                    &worker->task, core_id) != pdPASS) {
+            workpool_destroy(pool, i);
+            ESP_LOGE(TAG, "failed to create worker task");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    *ret_pool = pool;
+    return ESP_OK;
+}
+
+esp_err_t esp_workpool_delete(esp_workpool_handle_t pool)
+{
+    ESP_RETURN_ON_FALSE(pool, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(current_worker_index(pool) < 0, ESP_ERR_INVALID_STATE, TAG, "called from a worker");
+
+    workpool_destroy(pool, pool->num_workers);
+    return ESP_OK;
+}
+
+uint32_t esp_workpool_get_num_workers(esp_workpool_handle_t pool)
+{
+    return pool ? pool->num_workers : 0;
+}
+
+esp_err_t esp_workpool_submit(esp_workpool_handle_t pool, esp_workpool_func_t func, void *arg,
+                              esp_workpool_future_t *ret_future)
+{
+    ESP_RETURN_ON_FALSE(pool && func, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    esp_workpool_job_t *job = malloc(sizeof(esp_workpool_job_t));
+    ESP_RETURN_ON_FALSE(job, ESP_ERR_NO_MEM, TAG, "no memory for job");
+    job->func = func;
+    job->arg = arg;
+    job->pool = pool;
+    job->embedded = false;
+    completion_init(&job->done);
+    atomic_init(&job->refs, ret_future ? 2 : 1);
+
+    if (!push_job(pool, job, current_worker_index(pool))) {
+        free(job);
+        return ESP_FAIL;
+    }
+    if (ret_future) {
+        *ret_future = job;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_workpool_future_wait(esp_workpool_future_t future, TickType_t timeout)
+{
+    ESP_RETURN_ON_FALSE(future, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    /* The pool may have been deleted since the job has completed */
+    if (completion_is_done(&future->done)) {
+        return ESP_OK;
+    }
+
+    esp_workpool_handle_t pool = future->pool;
+    int self = current_worker_index(pool);
+    if (self >= 0) {
+        /* The job may be pending in the queue of this worker, run jobs until it has completed, or until there
+           are no pending jobs anymore, which means that the job is running on another worker */
+        TickType_t start = xTaskGetTickCount();
+        while (!completion_is_done(&future->done)) {
+            TickType_t elapsed = xTaskGetTickCount() - start;
+            if (timeout != portMAX_DELAY && elapsed >= timeout) {
+                return ESP_ERR_TIMEOUT;
+            }
+            esp_workpool_job_t *job = find_job(pool, self);
+            if (job == NULL) {
+                if (timeout != portMAX_DELAY) {
+                    timeout -= elapsed;
+                }
+                break;
+            }
+            run_job(job);
+        }
+    }
+
+    return completion_wait(&future->done, timeout) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+bool esp_workpool_future_is_done(esp_workpool_future_t future)
+{
+    return future && completion_is_done(&future->done);
+}
+
+esp_err_t esp_workpool_future_delete(esp_workpool_future_t future)
+{
+    ESP_RETURN_ON_FALSE(future, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    job_release(future);
+    return ESP_OK;
+}
+
+static void parallel_for_release(parallel_for_t *pfor)
+{
+    if (atomic_fetch_sub_explicit(&pfor->refs, 1, memory_order_acq_rel) == 1) {
+        free(pfor);
+    }
+}
+
+static void parallel_for_run_chunks(parallel_for_t *pfor)
+{
+    size_t chunk;
+    while ((chunk = atomic_fetch_add(&pfor->next_chunk, 1)) < pfor->num_chunks) {
+        size_t start = pfor->start + chunk * pfor->chunk_size;
+        size_t end = (pfor->end - start > pfor->chunk_size) ? start + pfor->chunk_size : pfor->end;
+        pfor->func(start, end, pfor->arg);
+        if (atomic_fetch_add_explicit(&pfor->chunks_done, 1, memory_order_acq_rel) + 1 == pfor->num_chunks) {
+            completion_complete(&pfor->done);
+        }
+    }
+}
+
+static void parallel_for_helper(void *arg)
+{
+    parallel_for_t *pfor = (parallel_for_t *) arg;
+
+    parallel_for_run_chunks(pfor);
+    parallel_for_release(pfor);
+}
+
+esp_err_t esp_workpool_parallel_for(esp_workpool_handle_t pool, size_t start, size_t end, size_t chunk_size,
+                                    esp_workpool_range_func_t func, void *arg)
+{
+    ESP_RETURN_ON_FALSE(pool && func && start <= end, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    if (start == end) {
+        return ESP_OK;
+    }
+
+    int self = current_worker_index(pool);
+    /* Workers other than the calling task */
+    uint32_t num_helpers = (self >= 0) ? pool->num_workers - 1 : pool->num_workers;
+    size_t count = end - start;
+    if (chunk_size == 0) {
+        chunk_size = (count + num_helpers) / (num_helpers + 1);
+    }
+    size_t num_chunks = count / chunk_size + (count % chunk_size ? 1 : 0);
+    if (num_helpers > num_chunks - 1) {
+        num_helpers = num_chunks - 1;
+    }
+
+    if (num_helpers == 0) {
+        for (size_t chunk_start = start; chunk_start < end; chunk_start += chunk_size) {
+            func(chunk_start, (end - chunk_start > chunk_size) ? chunk_start + chunk_size : end, arg);
+        }
+        return ESP_OK;
+    }
+
+    parallel_for_t *pfor = malloc(sizeof(parallel_for_t) + num_helpers * sizeof(esp_workpool_job_t));
+    ESP_RETURN_ON_FALSE(pfor, ESP_ERR_NO_MEM, TAG, "no memory for parallel_for");
+    pfor->func = func;
+    pfor->arg = arg;
+    pfor->start = start;
+    pfor->end = end;
+    pfor->chunk_size = chunk_size;
+    pfor->num_chunks = num_chunks;
+    atomic_init(&pfor->next_chunk, 0);
+    atomic_init(&pfor->chunks_done, 0);
+    completion_init(&pfor->done);
+    atomic_init(&pfor->refs, num_helpers + 1);
+
+    /* Queue one helper job per worker, starting with the worker following the current one */
+    uint32_t first = (self >= 0) ? self + 1 : 0;
+    for (uint32_t i = 0; i < num_helpers; i++) {
+        esp_workpool_job_t *job = &pfor->helpers[i];
+        job->func = parallel_for_helper;
+        job->arg = pfor;
+        job->pool = pool;
+        job->embedded = true;
+        if (!worker_push(&pool->workers[(first + i) % pool->num_workers], job)) {
+            /* The other chunks will be run by the calling task and the other helpers */
+            atomic_fetch_sub(&pfor->refs, 1);
+        }
+    }
+    uint32_t idle_workers = atomic_load(&pool->idle_workers);
+    for (uint32_t i = 0; i < num_helpers && i < idle_workers; i++) {
+        xSemaphoreGive(pool->work_sem);
+    }
+
+    parallel_for_run_chunks(pfor);
+    completion_wait(&pfor->done, portMAX_DELAY);
+    parallel_for_release(pfor);
+    return ESP_OK;
+}
@@ -0,0 +1,204 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+/**
+ * @file esp_workpool.h
+ * @brief Work-stealing task pool for data-parallel computations
+ *
+ * A work pool runs jobs on a fixed set of worker tasks, by default one worker
+ * pinned to each core. Each worker has its own queue of jobs. Jobs submitted by
+ * a worker are added to its own queue, other jobs are distributed over the queues
+ * of all workers. A worker whose queue is empty steals jobs from the queues of
+ * the other workers, so that all cores are kept busy.
+ *
+ * Jobs are short functions which run to completion. They can submit further jobs,
+ * and wait for them. While a worker waits for a job, it runs other jobs of the pool.
+ *
+ * esp_workpool_parallel_for() splits a range of indices into chunks, and processes
+ * them on all workers and on the calling task.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Opaque type representing a work pool
+ */
+typedef struct esp_workpool *esp_workpool_handle_t;
+
+/**
+ * @brief Opaque type representing the result of a job submitted with esp_workpool_submit()
+ */
+typedef struct esp_workpool_job *esp_workpool_future_t;
+
+/**
+ * @brief Job function type
+ *
+ * @param arg Argument passed to esp_workpool_submit()
+ */
+typedef void (*esp_workpool_func_t)(void *arg);
+
+/**
+ * @brief Range function type, see esp_workpool_parallel_for()
+ *
+ * @param start First index of the chunk to process
+ * @param end Index following the last index of the chunk to process
+ * @param arg Argument passed to esp_workpool_parallel_for()
+ */
+typedef void (*esp_workpool_range_func_t)(size_t start, size_t end, void *arg);
+
+/**
+ * @brief Work pool configuration passed to esp_workpool_create()
+ */
+typedef struct {
+    uint32_t num_workers;       //!< Number of worker tasks, 0 to create one worker per core
+    uint32_t queue_size;        //!< Maximum number of pending jobs in the queue of each worker
+    uint32_t task_priority;     //!< Priority of the worker tasks
+    uint32_t task_stack_size;   //!< Stack size of the worker tasks, in bytes
+    bool pin_to_core;           //!< Pin worker N to core (N % number of cores), otherwise workers have no affinity
+} esp_workpool_config_t;
+
+/**
+ * @brief Default work pool configuration
+ */
+#define ESP_WORKPOOL_DEFAULT_CONFIG() { \
+    .num_workers = 0,                   \
+    .queue_size = 32,                   \
+    .task_priority = 5,                 \
+    .task_stack_size = 4096,            \
+    .pin_to_core = true,                \
+}
+
+/**
+ * @brief Create a work pool and start its worker tasks
+ *
+ * @param config Configuration of the work pool. Not saved by the library, can be allocated on the stack.
+ * @param[out] ret_pool Handle of the created work pool
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if config or ret_pool is NULL, or the queue size is 0
+ *      - ESP_ERR_NO_MEM if the work pool or its worker tasks could not be allocated
+ */
+esp_err_t esp_workpool_create(const esp_workpool_config_t *config, esp_workpool_handle_t *ret_pool);
+
+/**
+ * @brief Delete a work pool
+ *
+ * The jobs which are still pending are run before the worker tasks exit. This function
+ * blocks until all worker tasks have exited.
+ *
+ * @note Must not be called from a job of the work pool.
+ *
+ * @param pool Work pool to delete
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if pool is NULL
+ *      - ESP_ERR_INVALID_STATE if called from a worker task of the work pool
+ */
+esp_err_t esp_workpool_delete(esp_workpool_handle_t pool);
+
+/**
+ * @brief Get the number of worker tasks of a work pool
+ *
+ * @param pool Work pool
+ *
+ * @return Number of worker tasks, 0 if pool is NULL
+ */
+uint32_t esp_workpool_get_num_workers(esp_workpool_handle_t pool);
+
+/**
+ * @brief Submit a job to a work pool
+ *
+ * @param pool Work pool
+ * @param func Job function
+ * @param arg Argument to pass to func
+ * @param[out] ret_future If not NULL, returns a future to wait for the job with esp_workpool_future_wait().
+ *                        The future must be deleted with esp_workpool_future_delete().
+ *                        If NULL, the job cannot be waited for.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if pool or func is NULL
+ *      - ESP_ERR_NO_MEM if the job could not be allocated
+ *      - ESP_FAIL if the queues of all workers are full
+ */
+esp_err_t esp_workpool_submit(esp_workpool_handle_t pool, esp_workpool_func_t func, void *arg,
+                              esp_workpool_future_t *ret_future);
+
+/**
+ * @brief Wait until a job has completed
+ *
+ * If called from a worker task of the work pool, the worker runs other jobs while waiting.
+ * Once the job has completed, its future can be waited for even if the work pool was deleted.
+ *
+ * @param future Future returned by esp_workpool_submit()
+ * @param timeout Maximum time to wait, in ticks
+ *
+ * @return
+ *      - ESP_OK if the job has completed
+ *      - ESP_ERR_INVALID_ARG if future is NULL
+ *      - ESP_ERR_TIMEOUT if the job has not completed within the timeout
+ */
+esp_err_t esp_workpool_future_wait(esp_workpool_future_t future, TickType_t timeout);
+
+/**
+ * @brief Check whether a job has completed, without blocking
+ *
+ * @param future Future returned by esp_workpool_submit()
+ *
+ * @return true if the job has completed, false otherwise
+ */
+bool esp_workpool_future_is_done(esp_workpool_future_t future);
+
+/**
+ * @brief Delete a future
+ *
+ * The job still runs if it has not completed yet.
+ *
+ * @param future Future returned by esp_workpool_submit()
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if future is NULL
+ */
+esp_err_t esp_workpool_future_delete(esp_workpool_future_t future);
+
+/**
+ * @brief Process a range of indices in parallel
+ *
+ * The range [start, end) is split into chunks of chunk_size indices (the last chunk may be smaller).
+ * func is called once for each chunk. The chunks are processed by the workers of the pool and by
+ * the calling task, in no particular order. This function returns once all chunks are processed.
+ *
+ * @param pool Work pool
+ * @param start First index of the range
+ * @param end Index following the last index of the range
+ * @param chunk_size Number of indices per chunk, 0 to split the range into one chunk per worker and calling task
+ * @param func Function to call for each chunk
+ * @param arg Argument to pass to func
+ *
+ * @return
+ *      - ESP_OK on success, including for an empty range
+ *      - ESP_ERR_INVALID_ARG if pool or func is NULL, or if start > end
+ *      - ESP_ERR_NO_MEM if the shared state of the chunks could not be allocated
+ */
+esp_err_t esp_workpool_parallel_for(esp_workpool_handle_t pool, size_t start, size_t end, size_t chunk_size,
+                                    esp_workpool_range_func_t func, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
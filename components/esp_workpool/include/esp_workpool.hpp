@@ -0,0 +1,268 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "esp_workpool.h"
+
+namespace workpool {
+
+namespace detail {
+
+/**
+ * State of a job submitted with WorkPool::submit(), holding the callable and its result.
+ */
+template<typename T>
+struct JobState {
+    std::function<T()> func;
+    std::optional<T> result;
+
+    void run()
+    {
+        result.emplace(func());
+    }
+
+    T take()
+    {
+        return std::move(*result);
+    }
+};
+
+template<>
+struct JobState<void> {
+    std::function<void()> func;
+
+    void run()
+    {
+        func();
+    }
+
+    void take() { }
+};
+
+} // namespace detail
+
+/**
+ * @brief Result of a job submitted with WorkPool::submit().
+ *
+ * @note Destroying a valid future waits until the job has completed, as the job stores its result in the future.
+ */
+template<typename T>
+class Future {
+public:
+    Future() = default;
+
+    Future(Future &&other) noexcept : future(std::exchange(other.future, nullptr)), state(std::move(other.state)) { }
+
+    Future &operator=(Future &&other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            future = std::exchange(other.future, nullptr);
+            state = std::move(other.state);
+        }
+        return *this;
+    }
+
+    Future(const Future &) = delete;
+    Future &operator=(const Future &) = delete;
+
+    ~Future()
+    {
+        reset();
+    }
+
+    /**
+     * @brief Check whether the future refers to a job
+     */
+    bool valid() const
+    {
+        return future != nullptr;
+    }
+
+    /**
+     * @brief Check whether the job has completed, without blocking
+     */
+    bool is_done() const
+    {
+        return esp_workpool_future_is_done(future);
+    }
+
+    /**
+     * @brief Wait until the job has completed, see esp_workpool_future_wait()
+     *
+     * @param timeout Maximum time to wait, in ticks
+     *
+     * @return
+     *      - ESP_OK if the job has completed
+     *      - ESP_ERR_INVALID_ARG if the future is not valid
+     *      - ESP_ERR_TIMEOUT if the job has not completed within the timeout
+     */
+    esp_err_t wait(TickType_t timeout = portMAX_DELAY) const
+    {
+        return esp_workpool_future_wait(future, timeout);
+    }
+
+    /**
+     * @brief Wait until the job has completed and return its result
+     *
+     * The future is not valid anymore afterwards. Must only be called on a valid future.
+     */
+    T get()
+    {
+        wait();
+        esp_workpool_future_delete(std::exchange(future, nullptr));
+        std::unique_ptr<detail::JobState<T>> job_state = std::move(state);
+        return job_state->take();
+    }
+
+private:
+    Future(esp_workpool_future_t future, std::unique_ptr<detail::JobState<T>> state)
+        : future(future), state(std::move(state)) { }
+
+    void reset()
+    {
+        if (future) {
+            esp_workpool_future_wait(future, portMAX_DELAY);
+            esp_workpool_future_delete(future);
+            future = nullptr;
+        }
+        state.reset();
+    }
+
+    esp_workpool_future_t future = nullptr;
+    std::unique_ptr<detail::JobState<T>> state;
+
+    friend class WorkPool;
+};
+
+/**
+ * @brief Work-stealing task pool, see esp_workpool.h
+ *
+ * The work pool is deleted when this object is destroyed. Callables passed to this class must not throw.
+ */
+class WorkPool {
+public:
+    explicit WorkPool(esp_workpool_handle_t pool) : pool(pool) { }
+
+    WorkPool(const WorkPool &) = delete;
+    WorkPool &operator=(const WorkPool &) = delete;
+
+    ~WorkPool()
+    {
+        esp_workpool_delete(pool);
+    }
+
+    /**
+     * @brief Get the handle of the work pool, to use it with the C API
+     */
+    esp_workpool_handle_t get_handle() const
+    {
+        return pool;
+    }
+
+    /**
+     * @brief Get the number of worker tasks
+     */
+    uint32_t get_num_workers() const
+    {
+        return esp_workpool_get_num_workers(pool);
+    }
+
+    /**
+     * @brief Submit a job
+     *
+     * @param func Callable without parameters, its result is returned by Future::get()
+     * @param[out] err If not nullptr, the error returned by esp_workpool_submit(), or ESP_ERR_NO_MEM
+     *
+     * @return Future of the job, which is not valid if the job could not be submitted
+     */
+    template<typename F>
+    Future<std::invoke_result_t<std::decay_t<F>>> submit(F &&func, esp_err_t *err = nullptr)
+    {
+        using T = std::invoke_result_t<std::decay_t<F>>;
+        esp_err_t ret = ESP_ERR_NO_MEM;
+        Future<T> result;
+
+        std::unique_ptr<detail::JobState<T>> state(new (std::nothrow) detail::JobState<T>);
+        if (state) {
+            state->func = std::forward<F>(func);
+            esp_workpool_future_t future;
+            ret = esp_workpool_submit(pool, &run_job<T>, state.get(), &future);
+            if (ret == ESP_OK) {
+                result = Future<T>(future, std::move(state));
+            }
+        }
+        if (err) {
+            *err = ret;
+        }
+        return result;
+    }
+
+    /**
+     * @brief Process a range of indices in parallel, see esp_workpool_parallel_for()
+     *
+     * @param start First index of the range
+     * @param end Index following the last index of the range
+     * @param chunk_size Number of indices per chunk, 0 to split the range into one chunk per worker and calling task
+     * @param func Callable taking the start and end index of a chunk, called once for each chunk
+     *
+     * @return Error returned by esp_workpool_parallel_for()
+     */
+    template<typename F>
+    esp_err_t parallel_for(size_t start, size_t end, size_t chunk_size, F &&func)
+    {
+        using Func = std::remove_reference_t<F>;
+        return esp_workpool_parallel_for(pool, start, end, chunk_size, [](size_t chunk_start, size_t chunk_end, void *arg) {
+            (*static_cast<Func *>(arg))(chunk_start, chunk_end);
+        }, const_cast<std::remove_const_t<Func> *>(&func));
+    }
+
+private:
+    template<typename T>
+    static void run_job(void *arg)
+    {
+        static_cast<detail::JobState<T> *>(arg)->run();
+    }
+
+    esp_workpool_handle_t pool;
+};
+
+/**
+ * @brief Create a work pool, see esp_workpool_create()
+ *
+ * @param config Configuration of the work pool
+ * @param[out] err If not nullptr, the error returned by esp_workpool_create(), or ESP_ERR_NO_MEM
+ *
+ * @return The work pool, or nullptr if it could not be created
+ */
+inline std::unique_ptr<WorkPool> create_workpool(const esp_workpool_config_t &config = ESP_WORKPOOL_DEFAULT_CONFIG(),
+                                                 esp_err_t *err = nullptr)
+{
+    esp_workpool_handle_t handle;
+    esp_err_t ret = esp_workpool_create(&config, &handle);
+    std::unique_ptr<WorkPool> pool;
+    if (ret == ESP_OK) {
+        pool.reset(new (std::nothrow) WorkPool(handle));
+        if (!pool) {
+            esp_workpool_delete(handle);
+            ret = ESP_ERR_NO_MEM;
+        }
+    }
+    if (err) {
+        *err = ret;
+    }
+    return pool;
+}
+
+} // namespace workpool
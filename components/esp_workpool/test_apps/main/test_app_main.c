@@ -0,0 +1,37 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "unity.h"
+#include "unity_test_runner.h"
+#include "unity_test_utils_memory.h"
+
+// Worker tasks are deleted by the idle task after the work pool is deleted, the threshold is left for that case
+#define TEST_MEMORY_LEAK_THRESHOLD (-200)
+
+void setUp(void)
+{
+    unity_utils_set_leak_level(TEST_MEMORY_LEAK_THRESHOLD);
+    unity_utils_record_free_mem();
+}
+
+void tearDown(void)
+{
+#ifndef CONFIG_IDF_TARGET_LINUX // on Linux, we don't check for memory leaks with memory utils
+    // Add a short delay of 100ms to allow the idle task to free the memory of deleted worker tasks
+    vTaskDelay(pdMS_TO_TICKS(100));
+#endif // CONFIG_IDF_TARGET_LINUX
+
+    unity_utils_evaluate_leaks();
+}
+
+void app_main(void)
+{
+    printf("Running esp_workpool component tests\n");
+    unity_run_menu();
+}
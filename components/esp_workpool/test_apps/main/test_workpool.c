@@ -0,0 +1,305 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_rom_sys.h"
+#include "unity.h"
+#include "esp_workpool.h"
+
+static esp_workpool_handle_t create_pool(uint32_t num_workers, uint32_t queue_size)
+{
+    esp_workpool_config_t config = ESP_WORKPOOL_DEFAULT_CONFIG();
+    config.num_workers = num_workers;
+    config.queue_size = queue_size;
+    esp_workpool_handle_t pool = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_create(&config, &pool));
+    TEST_ASSERT_NOT_NULL(pool);
+    return pool;
+}
+
+TEST_CASE("work pool can be created and deleted", "[workpool]")
+{
+    esp_workpool_config_t config = ESP_WORKPOOL_DEFAULT_CONFIG();
+    esp_workpool_handle_t pool = NULL;
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_workpool_create(NULL, &pool));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_workpool_create(&config, NULL));
+    config.queue_size = 0;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_workpool_create(&config, &pool));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_workpool_delete(NULL));
+
+    pool = create_pool(0, 8);
+    TEST_ASSERT_EQUAL(CONFIG_FREERTOS_NUMBER_OF_CORES, esp_workpool_get_num_workers(pool));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_delete(pool));
+
+    pool = create_pool(3, 8);
+    TEST_ASSERT_EQUAL(3, esp_workpool_get_num_workers(pool));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_delete(pool));
+}
+
+#define TEST_NUM_JOBS 64
+
+typedef struct {
+    atomic_int *counter;
+    TaskHandle_t task;
+} count_job_t;
+
+static void count_job(void *arg)
+{
+    count_job_t *job = (count_job_t *) arg;
+    job->task = xTaskGetCurrentTaskHandle();
+    atomic_fetch_add(job->counter, 1);
+}
+
+TEST_CASE("submitted jobs run on the worker tasks", "[workpool]")
+{
+    esp_workpool_handle_t pool = create_pool(0, TEST_NUM_JOBS);
+    atomic_int counter = 0;
+    count_job_t jobs[TEST_NUM_JOBS];
+    esp_workpool_future_t futures[TEST_NUM_JOBS];
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_workpool_submit(pool, NULL, NULL, NULL));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_workpool_future_wait(NULL, 0));
+
+    for (int i = 0; i < TEST_NUM_JOBS; i++) {
+        jobs[i] = (count_job_t) {
+            .counter = &counter,
+        };
+        TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_submit(pool, count_job, &jobs[i], &futures[i]));
+    }
+    for (int i = 0; i < TEST_NUM_JOBS; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_future_wait(futures[i], pdMS_TO_TICKS(1000)));
+        TEST_ASSERT_TRUE(esp_workpool_future_is_done(futures[i]));
+        TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_future_delete(futures[i]));
+        TEST_ASSERT_NOT_NULL(jobs[i].task);
+        TEST_ASSERT_NOT_EQUAL(xTaskGetCurrentTaskHandle(), jobs[i].task);
+    }
+    TEST_ASSERT_EQUAL(TEST_NUM_JOBS, atomic_load(&counter));
+
+    // Jobs without future
+    for (int i = 0; i < TEST_NUM_JOBS; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_submit(pool, count_job, &jobs[i], NULL));
+    }
+    // Pending jobs are run before the work pool is deleted
+    TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_delete(pool));
+    TEST_ASSERT_EQUAL(2 * TEST_NUM_JOBS, atomic_load(&counter));
+}
+
+TEST_CASE("futures of completed jobs can be waited for after the work pool is deleted", "[workpool]")
+{
+    esp_workpool_handle_t pool = create_pool(1, 8);
+    atomic_int counter = 0;
+    count_job_t job = {
+        .counter = &counter,
+    };
+    esp_workpool_future_t future;
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_submit(pool, count_job, &job, &future));
+    // Pending jobs are run before the work pool is deleted
+    TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_delete(pool));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_future_wait(future, 0));
+    TEST_ASSERT_TRUE(esp_workpool_future_is_done(future));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_future_delete(future));
+    TEST_ASSERT_EQUAL(1, atomic_load(&counter));
+}
+
+static void blocking_job(void *arg)
+{
+    xSemaphoreTake((SemaphoreHandle_t) arg, portMAX_DELAY);
+}
+
+TEST_CASE("future wait times out and submit fails when the queues are full", "[workpool]")
+{
+    esp_workpool_handle_t pool = create_pool(1, 2);
+    SemaphoreHandle_t sem = xSemaphoreCreateCounting(3, 0);
+    TEST_ASSERT_NOT_NULL(sem);
+    esp_workpool_future_t future;
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_submit(pool, blocking_job, sem, &future));
+    TEST_ASSERT_EQUAL(ESP_ERR_TIMEOUT, esp_workpool_future_wait(future, 0));
+    TEST_ASSERT_EQUAL(ESP_ERR_TIMEOUT, esp_workpool_future_wait(future, pdMS_TO_TICKS(50)));
+    TEST_ASSERT_FALSE(esp_workpool_future_is_done(future));
+
+    // Let the worker pick up the first job, then fill its queue
+    vTaskDelay(pdMS_TO_TICKS(10));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_submit(pool, blocking_job, sem, NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_submit(pool, blocking_job, sem, NULL));
+    TEST_ASSERT_EQUAL(ESP_FAIL, esp_workpool_submit(pool, blocking_job, sem, NULL));
+
+    for (int i = 0; i < 3; i++) {
+        xSemaphoreGive(sem);
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_future_wait(future, pdMS_TO_TICKS(1000)));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_future_delete(future));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_delete(pool));
+    vSemaphoreDelete(sem);
+}
+
+typedef struct {
+    esp_workpool_handle_t pool;
+    atomic_int *counter;
+    count_job_t children[TEST_NUM_JOBS];
+    int steals;
+} parent_job_t;
+
+static void busy_count_job(void *arg)
+{
+    count_job(arg);
+    esp_rom_delay_us(500);
+}
+
+static void parent_job(void *arg)
+{
+    parent_job_t *parent = (parent_job_t *) arg;
+    esp_workpool_future_t futures[TEST_NUM_JOBS];
+
+    // The jobs are queued on the queue of this worker, and stolen by the other workers
+    for (int i = 0; i < TEST_NUM_JOBS; i++) {
+        parent->children[i] = (count_job_t) {
+            .counter = parent->counter,
+        };
+        TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_submit(parent->pool, busy_count_job, &parent->children[i], &futures[i]));
+    }
+    // While waiting, this worker runs the jobs of its queue
+    for (int i = 0; i < TEST_NUM_JOBS; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_future_wait(futures[i], portMAX_DELAY));
+        TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_future_delete(futures[i]));
+        if (parent->children[i].task != xTaskGetCurrentTaskHandle()) {
+            parent->steals++;
+        }
+    }
+}
+
+TEST_CASE("jobs can wait for the jobs they submit, which are stolen by idle workers", "[workpool]")
+{
+    for (uint32_t num_workers = 1; num_workers <= 2; num_workers++) {
+        esp_workpool_handle_t pool = create_pool(num_workers, TEST_NUM_JOBS);
+        atomic_int counter = 0;
+        parent_job_t parent = {
+            .pool = pool,
+            .counter = &counter,
+        };
+        esp_workpool_future_t future;
+
+        TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_submit(pool, parent_job, &parent, &future));
+        TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_future_wait(future, pdMS_TO_TICKS(5000)));
+        TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_future_delete(future));
+        TEST_ASSERT_EQUAL(TEST_NUM_JOBS, atomic_load(&counter));
+        if (num_workers == 1) {
+            TEST_ASSERT_EQUAL(0, parent.steals);
+        } else {
+            TEST_ASSERT_GREATER_THAN(0, parent.steals);
+        }
+        TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_delete(pool));
+    }
+}
+
+#define TEST_RANGE_SIZE 1000
+
+typedef struct {
+    uint8_t *visits;
+    size_t start;
+    atomic_int calls;
+} range_args_t;
+
+static void visit_range(size_t start, size_t end, void *arg)
+{
+    range_args_t *args = (range_args_t *) arg;
+    TEST_ASSERT_LESS_THAN(end, start);
+    for (size_t i = start; i < end; i++) {
+        args->visits[i - args->start]++;
+    }
+    atomic_fetch_add(&args->calls, 1);
+}
+
+static void test_parallel_for(esp_workpool_handle_t pool, size_t start, size_t count, size_t chunk_size,
+                              int expected_calls)
+{
+    range_args_t args = {
+        .visits = calloc(count + 1, 1),
+        .start = start,
+    };
+    TEST_ASSERT_NOT_NULL(args.visits);
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_parallel_for(pool, start, start + count, chunk_size, visit_range, &args));
+    for (size_t i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL(1, args.visits[i]);
+    }
+    TEST_ASSERT_EQUAL(0, args.visits[count]);
+    if (expected_calls >= 0) {
+        TEST_ASSERT_EQUAL(expected_calls, atomic_load(&args.calls));
+    }
+    free(args.visits);
+}
+
+TEST_CASE("parallel_for processes each index exactly once", "[workpool]")
+{
+    esp_workpool_handle_t pool = create_pool(0, 8);
+    range_args_t args = { 0 };
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_workpool_parallel_for(NULL, 0, 1, 1, visit_range, &args));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_workpool_parallel_for(pool, 0, 1, 1, NULL, &args));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_workpool_parallel_for(pool, 2, 1, 1, visit_range, &args));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_parallel_for(pool, 5, 5, 1, visit_range, &args));
+    TEST_ASSERT_EQUAL(0, atomic_load(&args.calls));
+
+    test_parallel_for(pool, 0, TEST_RANGE_SIZE, 1, TEST_RANGE_SIZE);
+    test_parallel_for(pool, 0, TEST_RANGE_SIZE, 7, (TEST_RANGE_SIZE + 6) / 7);
+    test_parallel_for(pool, 100, TEST_RANGE_SIZE, 100, TEST_RANGE_SIZE / 100);
+    test_parallel_for(pool, 0, TEST_RANGE_SIZE, 2 * TEST_RANGE_SIZE, 1);
+    test_parallel_for(pool, 3, 1, 0, 1);
+    // One chunk per worker and the calling task
+    test_parallel_for(pool, 0, TEST_RANGE_SIZE, 0, esp_workpool_get_num_workers(pool) + 1);
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_delete(pool));
+}
+
+static void nested_parallel_for_job(void *arg)
+{
+    esp_workpool_handle_t pool = (esp_workpool_handle_t) arg;
+
+    test_parallel_for(pool, 0, TEST_RANGE_SIZE, 10, TEST_RANGE_SIZE / 10);
+    // One chunk per worker, including the calling worker
+    test_parallel_for(pool, 0, TEST_RANGE_SIZE, 0, esp_workpool_get_num_workers(pool));
+}
+
+TEST_CASE("parallel_for can be called from jobs", "[workpool]")
+{
+    esp_workpool_handle_t pool = create_pool(0, 8);
+    esp_workpool_future_t futures[4];
+
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_submit(pool, nested_parallel_for_job, pool, &futures[i]));
+    }
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_future_wait(futures[i], pdMS_TO_TICKS(5000)));
+        TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_future_delete(futures[i]));
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_delete(pool));
+}
+
+static void delete_from_job(void *arg)
+{
+    esp_workpool_handle_t pool = (esp_workpool_handle_t) arg;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, esp_workpool_delete(pool));
+}
+
+TEST_CASE("work pool cannot be deleted from its jobs", "[workpool]")
+{
+    esp_workpool_handle_t pool = create_pool(1, 8);
+    esp_workpool_future_t future;
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_submit(pool, delete_from_job, pool, &future));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_future_wait(future, pdMS_TO_TICKS(1000)));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_future_delete(future));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_delete(pool));
+}
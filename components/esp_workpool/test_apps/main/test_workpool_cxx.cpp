@@ -0,0 +1,64 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#include <atomic>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+#include "unity.h"
+#include "esp_workpool.hpp"
+
+TEST_CASE("C++ work pool runs callables and returns their results", "[workpool][cxx]")
+{
+    esp_err_t err;
+    std::unique_ptr<workpool::WorkPool> pool = workpool::create_workpool(ESP_WORKPOOL_DEFAULT_CONFIG(), &err);
+    TEST_ASSERT_EQUAL(ESP_OK, err);
+    TEST_ASSERT_NOT_NULL(pool.get());
+
+    std::vector<workpool::Future<int>> futures;
+    for (int i = 0; i < 16; i++) {
+        futures.push_back(pool->submit([i] { return i * i; }, &err));
+        TEST_ASSERT_EQUAL(ESP_OK, err);
+        TEST_ASSERT_TRUE(futures.back().valid());
+    }
+    for (int i = 0; i < 16; i++) {
+        TEST_ASSERT_EQUAL(i * i, futures[i].get());
+        TEST_ASSERT_FALSE(futures[i].valid());
+    }
+
+    workpool::Future<std::string> str = pool->submit([] { return std::string("workpool"); });
+    TEST_ASSERT_EQUAL(ESP_OK, str.wait());
+    TEST_ASSERT_TRUE(str.is_done());
+    TEST_ASSERT_EQUAL_STRING("workpool", str.get().c_str());
+
+    std::atomic<int> counter = 0;
+    {
+        // Destroying a future waits for its job
+        workpool::Future<void> done = pool->submit([&counter] { counter++; });
+        TEST_ASSERT_TRUE(done.valid());
+    }
+    TEST_ASSERT_EQUAL(1, counter.load());
+}
+
+TEST_CASE("C++ work pool parallel_for sums a vector", "[workpool][cxx]")
+{
+    std::unique_ptr<workpool::WorkPool> pool = workpool::create_workpool();
+    TEST_ASSERT_NOT_NULL(pool.get());
+
+    std::vector<uint32_t> values(10000);
+    std::iota(values.begin(), values.end(), 1);
+    std::atomic<uint64_t> sum = 0;
+
+    TEST_ASSERT_EQUAL(ESP_OK, pool->parallel_for(0, values.size(), 256, [&](size_t start, size_t end) {
+        uint64_t partial = 0;
+        for (size_t i = start; i < end; i++) {
+            partial += values[i];
+        }
+        sum += partial;
+    }));
+    TEST_ASSERT_EQUAL(10000ULL * 10001 / 2, sum.load());
+}
@@ -0,0 +1,149 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/*
+ * Benchmarks of data-parallel kernels with 1 and 2 workers. The kernels are run from a job, so that the worker
+ * running it takes part in the parallel_for, and 1 worker is equivalent to running the kernel serially.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_rom_crc.h"
+#include "unity.h"
+#include "esp_workpool.h"
+
+#define PERF_BUFFER_SIZE        (32 * 1024)
+#define PERF_BLOCK_SIZE         512
+#define PERF_NUM_BLOCKS         (PERF_BUFFER_SIZE / PERF_BLOCK_SIZE)
+#define PERF_BLOCKS_PER_CHUNK   4
+#define PERF_ITERATIONS         20
+#define PERF_MAX_WORKERS        2
+
+typedef struct {
+    esp_workpool_handle_t pool;
+    uint8_t *src;
+    uint8_t *dst;
+    uint32_t *crcs;
+    esp_workpool_range_func_t kernel;
+    uint64_t elapsed_us;
+} perf_args_t;
+
+/* Checksum of each block of the buffer, as used e.g. for per-sector integrity checks */
+static void crc32_blocks(size_t start, size_t end, void *arg)
+{
+    perf_args_t *args = (perf_args_t *) arg;
+    for (size_t i = start; i < end; i++) {
+        args->crcs[i] = esp_rom_crc32_le(0, args->src + i * PERF_BLOCK_SIZE, PERF_BLOCK_SIZE);
+    }
+}
+
+/* Copy each block of the buffer, then sum the copied block to make sure the copy is used */
+static void memcpy_blocks(size_t start, size_t end, void *arg)
+{
+    perf_args_t *args = (perf_args_t *) arg;
+    for (size_t i = start; i < end; i++) {
+        memcpy(args->dst + i * PERF_BLOCK_SIZE, args->src + i * PERF_BLOCK_SIZE, PERF_BLOCK_SIZE);
+        memcpy(args->src + i * PERF_BLOCK_SIZE, args->dst + i * PERF_BLOCK_SIZE, PERF_BLOCK_SIZE);
+    }
+}
+
+static uint64_t perf_time_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void perf_job(void *arg)
+{
+    perf_args_t *args = (perf_args_t *) arg;
+
+    uint64_t start_us = perf_time_us();
+    for (int i = 0; i < PERF_ITERATIONS; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_parallel_for(args->pool, 0, PERF_NUM_BLOCKS, PERF_BLOCKS_PER_CHUNK,
+                                                            args->kernel, args));
+    }
+    args->elapsed_us = perf_time_us() - start_us;
+}
+
+/* Run the kernel with 1 to PERF_MAX_WORKERS workers, returns the elapsed time for each number of workers */
+static void run_benchmark(const char *name, perf_args_t *args, uint64_t elapsed_us[PERF_MAX_WORKERS])
+{
+    for (uint32_t num_workers = 1; num_workers <= PERF_MAX_WORKERS; num_workers++) {
+        esp_workpool_config_t config = ESP_WORKPOOL_DEFAULT_CONFIG();
+        config.num_workers = num_workers;
+        TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_create(&config, &args->pool));
+
+        esp_workpool_future_t future;
+        TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_submit(args->pool, perf_job, args, &future));
+        TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_future_wait(future, portMAX_DELAY));
+        TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_future_delete(future));
+        TEST_ASSERT_EQUAL(ESP_OK, esp_workpool_delete(args->pool));
+
+        elapsed_us[num_workers - 1] = args->elapsed_us;
+        uint64_t bytes = (uint64_t) PERF_BUFFER_SIZE * PERF_ITERATIONS;
+        printf("%s, %"PRIu32" worker(s): %llu us, %llu KiB/s\n", name, num_workers,
+               (unsigned long long) args->elapsed_us,
+               (unsigned long long) (bytes * 1000000 / 1024 / (args->elapsed_us ? args->elapsed_us : 1)));
+    }
+    printf("%s, speedup with %d workers: %llu%%\n", name, PERF_MAX_WORKERS,
+           (unsigned long long) (elapsed_us[0] * 100 / (elapsed_us[PERF_MAX_WORKERS - 1] ? elapsed_us[PERF_MAX_WORKERS - 1] : 1)));
+}
+
+/*
+Benchmark data-parallel kernels
+
+Procedure:
+    - Compute the CRC32 of each block of a buffer, with parallel_for over the blocks
+    - Copy each block of a buffer back and forth, with parallel_for over the blocks
+    - Run both kernels with 1 and 2 workers
+
+Expected:
+    - The results are the same as computed serially, the throughput and the speedup with 2 workers are printed
+*/
+TEST_CASE("work pool speedup of CRC32 and memcpy kernels", "[workpool][perf]")
+{
+    perf_args_t args = {
+        .src = malloc(PERF_BUFFER_SIZE),
+        .dst = malloc(PERF_BUFFER_SIZE),
+        .crcs = calloc(PERF_NUM_BLOCKS, sizeof(uint32_t)),
+    };
+    uint32_t *expected_crcs = calloc(PERF_NUM_BLOCKS, sizeof(uint32_t));
+    TEST_ASSERT_NOT_NULL(args.src);
+    TEST_ASSERT_NOT_NULL(args.dst);
+    TEST_ASSERT_NOT_NULL(args.crcs);
+    TEST_ASSERT_NOT_NULL(expected_crcs);
+
+    for (size_t i = 0; i < PERF_BUFFER_SIZE; i++) {
+        args.src[i] = (uint8_t)(i * 7 + (i >> 8));
+    }
+    for (size_t i = 0; i < PERF_NUM_BLOCKS; i++) {
+        expected_crcs[i] = esp_rom_crc32_le(0, args.src + i * PERF_BLOCK_SIZE, PERF_BLOCK_SIZE);
+    }
+
+    uint64_t elapsed_us[PERF_MAX_WORKERS];
+    args.kernel = crc32_blocks;
+    run_benchmark("crc32", &args, elapsed_us);
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(expected_crcs, args.crcs, PERF_NUM_BLOCKS);
+
+    args.kernel = memcpy_blocks;
+    run_benchmark("memcpy", &args, elapsed_us);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(args.src, args.dst, PERF_BUFFER_SIZE);
+    for (size_t i = 0; i < PERF_NUM_BLOCKS; i++) {
+        TEST_ASSERT_EQUAL_UINT32(expected_crcs[i], esp_rom_crc32_le(0, args.src + i * PERF_BLOCK_SIZE, PERF_BLOCK_SIZE));
+    }
+
+    free(expected_crcs);
+    free(args.crcs);
+    free(args.dst);
+    free(args.src);
+}
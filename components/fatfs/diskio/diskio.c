@@ -11,13 +11,62 @@
 #include <string.h>
 #include <time.h>
 #include <stdlib.h>
+#include <stdbool.h>
 #include <sys/time.h>
 #include "diskio_impl.h"
 #include "ffconf.h"
 #include "ff.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+
+static const char* TAG = "diskio";
 
 static ff_diskio_impl_t * s_impls[FF_VOLUMES] = { NULL };
 
+#ifndef CONFIG_FATFS_DISKIO_CACHE_SECTORS
+#define CONFIG_FATFS_DISKIO_CACHE_SECTORS 0
+#endif
+#ifndef CONFIG_FATFS_DISKIO_CACHE_READ_AHEAD
+#define CONFIG_FATFS_DISKIO_CACHE_READ_AHEAD 0
+#endif
+
+/* One cached sector */
+typedef struct {
+    LBA_t sector;
+    uint32_t last_use;  /* value of use_counter when the sector was last accessed, for LRU replacement */
+    bool valid;
+    bool dirty;         /* modified in the cache, not yet written to the drive */
+} ff_cache_line_t;
+
+/* Write-back sector cache of a drive, sitting between FatFs and the diskio driver */
+typedef struct {
+    size_t line_count;
+    size_t sector_size;
+    LBA_t sector_count;
+    size_t staging_count;   /* size of staging buffer in sectors, used to read ahead and to write runs of sectors */
+    uint32_t use_counter;
+    LBA_t last_read;        /* last sector read, to detect sequential access */
+    ff_cache_line_t* lines;
+    BYTE* data;             /* line_count sectors, data of lines[i] is at data + i * sector_size */
+    BYTE* staging;
+} ff_diskio_cache_t;
+
+static ff_diskio_cache_t* s_caches[FF_VOLUMES] = { NULL };
+static size_t s_cache_sectors[FF_VOLUMES] = {
+    [0 ... FF_VOLUMES - 1] = CONFIG_FATFS_DISKIO_CACHE_SECTORS
+};
+/* set when FatFs initializes the drive, the cache size can't be changed from then until the drive is registered again */
+static bool s_initialized[FF_VOLUMES];
+
+/* Read-only memory mapping of a drive, see ff_diskio_set_mmap() */
+typedef struct {
+    const BYTE* base;
+    size_t sector_size;
+    LBA_t sector_count;
+} ff_diskio_mmap_t;
+
+static ff_diskio_mmap_t s_mmaps[FF_VOLUMES];
+
 #if FF_MULTI_PARTITION		/* Multiple partition configuration */
 PARTITION VolToPart[FF_VOLUMES] = {
     {0, 0},    /* Logical drive 0 ==> Physical drive 0, auto detection */
@@ -63,10 +112,25 @@ esp_err_t ff_diskio_get_drive(BYTE* out_pdrv)
     return ESP_ERR_NOT_FOUND;
 }
 
+static DRESULT cache_flush(BYTE pdrv, ff_diskio_cache_t* cache);
+static DRESULT cache_free(BYTE pdrv);
+static void cache_drop(BYTE pdrv);
+
 void ff_diskio_register(BYTE pdrv, const ff_diskio_impl_t* discio_impl)
 {
     assert(pdrv < FF_VOLUMES);
 
+    // write back cached sectors while the previous driver is still registered
+    if (cache_free(pdrv) != RES_OK) {
+        ESP_LOGE(TAG, "drive %d: failed to write back cached sectors, changes are lost", (int) pdrv);
+        cache_drop(pdrv);
+    }
+    memset(&s_mmaps[pdrv], 0, sizeof(s_mmaps[pdrv]));
+    s_initialized[pdrv] = false;
+    if (!discio_impl) {
+        s_cache_sectors[pdrv] = CONFIG_FATFS_DISKIO_CACHE_SECTORS;
+    }
+
     if (s_impls[pdrv]) {
         ff_diskio_impl_t* im = s_impls[pdrv];
         s_impls[pdrv] = NULL;
@@ -83,9 +147,274 @@ void ff_diskio_register(BYTE pdrv, const ff_diskio_impl_t* discio_impl)
     s_impls[pdrv] = impl;
 }
 
+esp_err_t ff_diskio_set_cache_size(BYTE pdrv, size_t sectors)
+{
+    if (pdrv >= FF_VOLUMES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_initialized[pdrv]) {
+        // the cache is in use by a mounted volume
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_cache_sectors[pdrv] = sectors;
+    return ESP_OK;
+}
+
+esp_err_t ff_diskio_set_mmap(BYTE pdrv, const void* base, size_t sector_size, DWORD sector_count)
+{
+    if (pdrv >= FF_VOLUMES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_mmaps[pdrv] = (ff_diskio_mmap_t) {
+        .base = base,
+        .sector_size = sector_size,
+        .sector_count = base ? sector_count : 0,
+    };
+    return ESP_OK;
+}
+
+/* Reads sectors from the memory mapping of the drive if they are mapped, from the driver otherwise */
+static DRESULT drive_read(BYTE pdrv, BYTE* buff, LBA_t sector, UINT count)
+{
+    const ff_diskio_mmap_t* map = &s_mmaps[pdrv];
+    if (map->base && sector < map->sector_count && count <= map->sector_count - sector) {
+        memcpy(buff, map->base + sector * map->sector_size, count * map->sector_size);
+        return RES_OK;
+    }
+    return s_impls[pdrv]->read(pdrv, buff, sector, count);
+}
+
+static inline BYTE* cache_line_data(ff_diskio_cache_t* cache, size_t line)
+{
+    return cache->data + line * cache->sector_size;
+}
+
+/* Frees the cache of a drive without writing back modified sectors */
+static void cache_drop(BYTE pdrv)
+{
+    ff_diskio_cache_t* cache = s_caches[pdrv];
+    if (!cache) {
+        return;
+    }
+    s_caches[pdrv] = NULL;
+    ff_memfree(cache->staging);
+    ff_memfree(cache->data);
+    ff_memfree(cache->lines);
+    ff_memfree(cache);
+}
+
+/* Writes back modified sectors and frees the cache of a drive, the cache is kept if the write back fails */
+static DRESULT cache_free(BYTE pdrv)
+{
+    ff_diskio_cache_t* cache = s_caches[pdrv];
+    if (!cache) {
+        return RES_OK;
+    }
+    if (s_impls[pdrv]) {
+        DRESULT res = cache_flush(pdrv, cache);
+        if (res != RES_OK) {
+            return res;
+        }
+    }
+    cache_drop(pdrv);
+    return RES_OK;
+}
+
+static ff_diskio_cache_t* cache_create(BYTE pdrv, size_t line_count)
+{
+    WORD sector_size = FF_MIN_SS;
+#if FF_MAX_SS != FF_MIN_SS
+    if (s_impls[pdrv]->ioctl(pdrv, GET_SECTOR_SIZE, &sector_size) != RES_OK) {
+        return NULL;
+    }
+#endif
+    LBA_t sector_count = 0;
+    if (s_impls[pdrv]->ioctl(pdrv, GET_SECTOR_COUNT, &sector_count) != RES_OK) {
+        return NULL;
+    }
+    // stage at least one flash sector worth of FAT sectors, so that flushes can write whole flash sectors
+    size_t staging_count = 1 + CONFIG_FATFS_DISKIO_CACHE_READ_AHEAD;
+    if (staging_count * sector_size < 4096) {
+        staging_count = 4096 / sector_size;
+    }
+    if (staging_count > line_count) {
+        staging_count = line_count;
+    }
+
+    ff_diskio_cache_t* cache = ff_memalloc(sizeof(ff_diskio_cache_t));
+    if (!cache) {
+        return NULL;
+    }
+    memset(cache, 0, sizeof(*cache));
+    cache->lines = ff_memalloc(line_count * sizeof(ff_cache_line_t));
+    cache->data = ff_memalloc(line_count * sector_size);
+    cache->staging = ff_memalloc(staging_count * sector_size);
+    if (!cache->lines || !cache->data || !cache->staging) {
+        ff_memfree(cache->staging);
+        ff_memfree(cache->data);
+        ff_memfree(cache->lines);
+        ff_memfree(cache);
+        return NULL;
+    }
+    memset(cache->lines, 0, line_count * sizeof(ff_cache_line_t));
+    cache->line_count = line_count;
+    cache->sector_size = sector_size;
+    cache->sector_count = sector_count;
+    cache->staging_count = staging_count;
+    cache->last_read = (LBA_t) -1;
+    return cache;
+}
+
+static int cache_find(ff_diskio_cache_t* cache, LBA_t sector)
+{
+    for (size_t i = 0; i < cache->line_count; i++) {
+        if (cache->lines[i].valid && cache->lines[i].sector == sector) {
+            return (int) i;
+        }
+    }
+    return -1;
+}
+
+static inline void cache_touch(ff_diskio_cache_t* cache, size_t line)
+{
+    cache->lines[line].last_use = ++cache->use_counter;
+}
+
+/* Write all dirty sectors, in ascending order and in runs of consecutive sectors */
+static DRESULT cache_flush(BYTE pdrv, ff_diskio_cache_t* cache)
+{
+    while (true) {
+        int first = -1;
+        for (size_t i = 0; i < cache->line_count; i++) {
+            if (cache->lines[i].dirty && (first < 0 || cache->lines[i].sector < cache->lines[first].sector)) {
+                first = (int) i;
+            }
+        }
+        if (first < 0) {
+            return RES_OK;
+        }
+
+        LBA_t start = cache->lines[first].sector;
+        int run_lines[cache->staging_count];
+        size_t run = 0;
+        int line = first;
+        do {
+            memcpy(cache->staging + run * cache->sector_size, cache_line_data(cache, line), cache->sector_size);
+            run_lines[run++] = line;
+            line = run < cache->staging_count ? cache_find(cache, start + run) : -1;
+        } while (line >= 0 && cache->lines[line].dirty);
+
+        const BYTE* buff = cache->staging;
+        if (run == 1) {
+            buff = cache_line_data(cache, first);
+        }
+        DRESULT res = s_impls[pdrv]->write(pdrv, buff, start, run);
+        if (res != RES_OK) {
+            return res;
+        }
+        for (size_t i = 0; i < run; i++) {
+            cache->lines[run_lines[i]].dirty = false;
+        }
+    }
+}
+
+/* Get a line to store a new sector, writing back dirty sectors if the least recently used line is dirty */
+static int cache_alloc(BYTE pdrv, ff_diskio_cache_t* cache)
+{
+    int victim = 0;
+    for (size_t i = 0; i < cache->line_count; i++) {
+        if (!cache->lines[i].valid) {
+            victim = (int) i;
+            break;
+        }
+        if (cache->lines[i].last_use < cache->lines[victim].last_use) {
+            victim = (int) i;
+        }
+    }
+    if (cache->lines[victim].dirty && cache_flush(pdrv, cache) != RES_OK) {
+        return -1;
+    }
+    cache->lines[victim].valid = false;
+    return victim;
+}
+
+static void cache_invalidate(ff_diskio_cache_t* cache, LBA_t start, LBA_t end)
+{
+    for (size_t i = 0; i < cache->line_count; i++) {
+        if (cache->lines[i].valid && cache->lines[i].sector >= start && cache->lines[i].sector <= end) {
+            cache->lines[i].valid = false;
+            cache->lines[i].dirty = false;
+        }
+    }
+}
+
+static DRESULT cache_read_sector(BYTE pdrv, ff_diskio_cache_t* cache, BYTE* buff, LBA_t sector)
+{
+    const bool sequential = (sector == cache->last_read + 1);
+    cache->last_read = sector;
+
+    int line = cache_find(cache, sector);
+    if (line >= 0) {
+        cache_touch(cache, line);
+        memcpy(buff, cache_line_data(cache, line), cache->sector_size);
+        return RES_OK;
+    }
+
+    // on sequential access, also read the following sectors which are not cached yet
+    size_t count = 1;
+    if (sequential) {
+        while (count < cache->staging_count && count <= CONFIG_FATFS_DISKIO_CACHE_READ_AHEAD &&
+                sector + count < cache->sector_count && cache_find(cache, sector + count) < 0) {
+            count++;
+        }
+    }
+    // take the lines first: making room may write back dirty sectors through the staging buffer
+    int lines[count];
+    for (size_t i = 0; i < count; i++) {
+        lines[i] = cache_alloc(pdrv, cache);
+        if (lines[i] < 0) {
+            if (i > 0) {
+                cache_invalidate(cache, sector, sector + i - 1);
+            }
+            return RES_ERROR;
+        }
+        cache->lines[lines[i]].sector = sector + i;
+        cache->lines[lines[i]].valid = true;
+        cache->lines[lines[i]].dirty = false;
+        cache_touch(cache, lines[i]);
+    }
+    BYTE* dst = count == 1 ? cache_line_data(cache, lines[0]) : cache->staging;
+    DRESULT res = drive_read(pdrv, dst, sector, count);
+    if (res != RES_OK) {
+        cache_invalidate(cache, sector, sector + count - 1);
+        return res;
+    }
+    if (count > 1) {
+        for (size_t i = 0; i < count; i++) {
+            memcpy(cache_line_data(cache, lines[i]), cache->staging + i * cache->sector_size, cache->sector_size);
+        }
+    }
+    memcpy(buff, cache_line_data(cache, lines[0]), cache->sector_size);
+    return RES_OK;
+}
+
 DSTATUS ff_disk_initialize (BYTE pdrv)
 {
-    return s_impls[pdrv]->init(pdrv);
+    DSTATUS status = s_impls[pdrv]->init(pdrv);
+    if (status & STA_NOINIT) {
+        return status;
+    }
+    // the drive may have been changed, drop the cached sectors (after writing them back)
+    if (cache_free(pdrv) != RES_OK) {
+        // keep the modified sectors, mounting again retries writing them back
+        ESP_LOGE(TAG, "drive %d: failed to write back cached sectors", (int) pdrv);
+        return STA_NOINIT;
+    }
+    if (s_cache_sectors[pdrv] > 0) {
+        s_caches[pdrv] = cache_create(pdrv, s_cache_sectors[pdrv]);
+    }
+    s_initialized[pdrv] = true;
+    return status;
 }
 DSTATUS ff_disk_status (BYTE pdrv)
 {
@@ -93,14 +422,68 @@ DSTATUS ff_disk_status (BYTE pdrv)
 }
 DRESULT ff_disk_read (BYTE pdrv, BYTE* buff, LBA_t sector, UINT count)
 {
-    return s_impls[pdrv]->read(pdrv, buff, sector, count);
+    ff_diskio_cache_t* cache = s_caches[pdrv];
+    if (!cache) {
+        return drive_read(pdrv, buff, sector, count);
+    }
+    if (count == 1) {
+        return cache_read_sector(pdrv, cache, buff, sector);
+    }
+    // multi-sector reads are file data: read directly, without replacing the cached metadata
+    DRESULT res = drive_read(pdrv, buff, sector, count);
+    if (res != RES_OK) {
+        return res;
+    }
+    for (size_t i = 0; i < cache->line_count; i++) {
+        ff_cache_line_t* l = &cache->lines[i];
+        if (l->dirty && l->sector >= sector && l->sector < sector + count) {
+            memcpy(buff + (l->sector - sector) * cache->sector_size, cache_line_data(cache, i), cache->sector_size);
+        }
+    }
+    return RES_OK;
 }
 DRESULT ff_disk_write (BYTE pdrv, const BYTE* buff, LBA_t sector, UINT count)
 {
-    return s_impls[pdrv]->write(pdrv, buff, sector, count);
+    ff_diskio_cache_t* cache = s_caches[pdrv];
+    if (!cache) {
+        return s_impls[pdrv]->write(pdrv, buff, sector, count);
+    }
+    if (count == 1) {
+        int line = cache_find(cache, sector);
+        if (line < 0) {
+            line = cache_alloc(pdrv, cache);
+            if (line < 0) {
+                return RES_ERROR;
+            }
+            cache->lines[line].sector = sector;
+            cache->lines[line].valid = true;
+        }
+        memcpy(cache_line_data(cache, line), buff, cache->sector_size);
+        cache->lines[line].dirty = true;
+        cache_touch(cache, line);
+        return RES_OK;
+    }
+    // multi-sector writes go straight to the drive, cached copies of these sectors are now stale
+    DRESULT res = s_impls[pdrv]->write(pdrv, buff, sector, count);
+    if (res == RES_OK) {
+        cache_invalidate(cache, sector, sector + count - 1);
+    }
+    return res;
 }
 DRESULT ff_disk_ioctl (BYTE pdrv, BYTE cmd, void* buff)
 {
+    ff_diskio_cache_t* cache = s_caches[pdrv];
+    if (cache) {
+        if (cmd == CTRL_SYNC) {
+            DRESULT res = cache_flush(pdrv, cache);
+            if (res != RES_OK) {
+                return res;
+            }
+        } else if (cmd == CTRL_TRIM) {
+            LBA_t* range = (LBA_t*) buff;
+            cache_invalidate(cache, range[0], range[1]);
+        }
+    }
     return s_impls[pdrv]->ioctl(pdrv, cmd, buff);
 }
 
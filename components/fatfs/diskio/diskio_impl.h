@@ -19,6 +19,7 @@ extern "C" {
 #endif
 
 #include <stdint.h>
+#include <stddef.h>
 typedef unsigned int UINT;
 typedef unsigned char BYTE;
 typedef uint32_t DWORD;
@@ -67,6 +68,46 @@ void ff_diskio_register(BYTE pdrv, const ff_diskio_impl_t* discio_impl);
 esp_err_t ff_diskio_get_drive(BYTE* out_pdrv);
 
 
+/**
+ * Set the number of sectors kept in the write-back cache of a drive
+ *
+ * Single sector reads and writes, which FatFs uses for the FAT, directories and partial
+ * file sectors, are served from the cache. Modified sectors are written back in runs of
+ * consecutive sectors when FatFs syncs the volume (f_sync, f_close...), when they have to
+ * be replaced, or when the drive is unregistered. The default is CONFIG_FATFS_DISKIO_CACHE_SECTORS.
+ *
+ * The size takes effect when the drive is initialized, i.e. when the volume is mounted, so it has
+ * to be set after the drive is registered and before the volume is mounted. Registering the drive
+ * again allows changing it, unregistering the drive restores the default.
+ *
+ * @param pdrv      drive number
+ * @param sectors   number of sectors to cache, 0 to disable the cache
+ *
+ * @return  ESP_OK                  on success
+ *          ESP_ERR_INVALID_ARG     if pdrv is out of range
+ *          ESP_ERR_INVALID_STATE   if the drive has been initialized since it was registered
+ */
+esp_err_t ff_diskio_set_cache_size(BYTE pdrv, size_t sectors);
+
+/**
+ * Set a read-only memory mapping of a drive
+ *
+ * Sectors within the mapping are read by copying them from memory instead of calling the read
+ * function of the driver. The mapping must reflect writes made through the driver, e.g. a flash
+ * partition mapped through the cache, written without wear levelling.
+ * The mapping is removed when the drive is registered or unregistered.
+ *
+ * @param pdrv          drive number
+ * @param base          address of sector 0, or NULL to remove the mapping
+ * @param sector_size   size of a sector in bytes
+ * @param sector_count  number of sectors in the mapping
+ *
+ * @return  ESP_OK              on success
+ *          ESP_ERR_INVALID_ARG if pdrv is out of range
+ */
+esp_err_t ff_diskio_set_mmap(BYTE pdrv, const void* base, size_t sector_size, DWORD sector_count);
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -11,6 +11,7 @@
 #include "esp_log.h"
 #include "diskio_rawflash.h"
 #include "esp_compiler.h"
+#include "sdkconfig.h"
 
 static const char* TAG = "diskio_rawflash";
 
@@ -19,12 +20,46 @@ static const esp_partition_t* s_ff_raw_handles[FF_VOLUMES];
 static size_t s_sector_size[FF_VOLUMES];
 static size_t s_sectors_count[FF_VOLUMES];
 static uint8_t s_initialized[FF_VOLUMES];
+#if CONFIG_FATFS_RAW_FLASH_MMAP
+static esp_partition_mmap_handle_t s_mmap_handles[FF_VOLUMES];
+static bool s_mapped[FF_VOLUMES];
+#endif
 
 #define BPB_BytsPerSec 11
 #define BPB_TotSec16 19
 #define BPB_TotSec32 32
 
 
+#if CONFIG_FATFS_RAW_FLASH_MMAP
+static void ff_raw_munmap(BYTE pdrv)
+{
+    if (s_mapped[pdrv]) {
+        ff_diskio_set_mmap(pdrv, NULL, 0, 0);
+        esp_partition_munmap(s_mmap_handles[pdrv]);
+        s_mapped[pdrv] = false;
+    }
+}
+
+// Map the partition so that FatFs reads sectors through the flash cache, this is optional
+static void ff_raw_mmap(BYTE pdrv)
+{
+    const esp_partition_t* part = s_ff_raw_handles[pdrv];
+    const void* ptr;
+    ff_raw_munmap(pdrv);
+    esp_err_t err = esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA, &ptr, &s_mmap_handles[pdrv]);
+    if (err != ESP_OK) {
+        ESP_LOGD(TAG, "esp_partition_mmap failed (0x%x), reading through esp_partition_read", err);
+        return;
+    }
+    DWORD mapped_sectors = part->size / s_sector_size[pdrv];
+    if (mapped_sectors > s_sectors_count[pdrv]) {
+        mapped_sectors = s_sectors_count[pdrv];
+    }
+    ff_diskio_set_mmap(pdrv, ptr, s_sector_size[pdrv], mapped_sectors);
+    s_mapped[pdrv] = true;
+}
+#endif
+
 static DSTATUS ff_raw_initialize (BYTE pdrv)
 {
 
@@ -58,6 +93,9 @@ static DSTATUS ff_raw_initialize (BYTE pdrv)
     }
 
     s_initialized[pdrv] = true;
+#if CONFIG_FATFS_RAW_FLASH_MMAP
+    ff_raw_mmap(pdrv);
+#endif
     return STA_PROTECT;
 }
 
@@ -122,6 +160,9 @@ esp_err_t ff_diskio_register_raw_partition(BYTE pdrv, const esp_partition_t* par
         .write = &ff_raw_write,
         .ioctl = &ff_raw_ioctl
     };
+#if CONFIG_FATFS_RAW_FLASH_MMAP
+    ff_raw_munmap(pdrv);
+#endif
     ff_diskio_register(pdrv, &raw_impl);
     s_ff_raw_handles[pdrv] = part_handle;
     return ESP_OK;
@@ -138,3 +179,16 @@ BYTE ff_diskio_get_pdrv_raw(const esp_partition_t* part_handle)
     }
     return 0xff;
 }
+
+void ff_diskio_clear_pdrv_raw(const esp_partition_t* part_handle)
+{
+    for (int i = 0; i < FF_VOLUMES; i++) {
+        if (part_handle == s_ff_raw_handles[i]) {
+#if CONFIG_FATFS_RAW_FLASH_MMAP
+            ff_raw_munmap(i);
+#endif
+            s_ff_raw_handles[i] = NULL;
+            s_initialized[i] = false;
+        }
+    }
+}
@@ -30,6 +30,15 @@ extern "C" {
 esp_err_t ff_diskio_register_raw_partition(unsigned char pdrv, const esp_partition_t* part_handle);
 unsigned char ff_diskio_get_pdrv_raw(const esp_partition_t* part_handle);
 
+/**
+ * Release the drive number used by a raw flash partition, after unregistering the drive
+ *
+ * If CONFIG_FATFS_RAW_FLASH_MMAP is enabled, this also releases the memory mapping of the partition.
+ *
+ * @param part_handle  pointer to raw flash partition.
+ */
+void ff_diskio_clear_pdrv_raw(const esp_partition_t* part_handle);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,9 +1,9 @@
-# SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+# SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
 # SPDX-License-Identifier: Apache-2.0
 
 import os
 from datetime import datetime
-from typing import List, Optional, Tuple, Union
+from typing import Dict, List, Optional, Tuple, Union
 
 from .entry import Entry
 from .exceptions import FatalError, WriteDirectoryException
@@ -99,6 +99,10 @@ class Directory:
         # entries will be initialized after the cluster allocation
         self.entries: List[Entry] = []
         self.entities: List[Union[File, Directory]] = []  # type: ignore
+        # entities by their full name, so the lookup does not have to go through all of them
+        self._entities_by_name: Dict[str, Union[File, Directory]] = {}  # type: ignore
+        # entries are never freed while the image is being generated, the ones before the hint are used
+        self._free_entry_hint: int = 0
         self._entry = entry  # currently not in use (will use later for e.g. modification time, etc.)
 
     @property
@@ -143,10 +147,11 @@ class Directory:
                                     entity_type=dir_id.ENTITY_TYPE)
 
     def lookup_entity(self, object_name: str, extension: str):  # type: ignore
-        for entity in self.entities:
-            if build_name(entity.name, entity.extension) == build_name(object_name, extension):
-                return entity
-        return None
+        return self._entities_by_name.get(build_name(object_name, extension))
+
+    def add_entity(self, entity):  # type: (Union[File, Directory]) -> None
+        self.entities.append(entity)
+        self._entities_by_name.setdefault(build_name(entity.name, entity.extension), entity)
 
     @staticmethod
     def _is_end_of_path(path_as_list: List[str]) -> bool:
@@ -169,9 +174,11 @@ class Directory:
         return self.recursive_search(path_as_list[1:], next_obj)
 
     def find_free_entry(self) -> Optional[Entry]:
-        for entry in self.entries:
-            if entry.is_empty:
-                return entry
+        for i in range(self._free_entry_hint, len(self.entries)):
+            if self.entries[i].is_empty:
+                self._free_entry_hint = i
+                return self.entries[i]
+        self._free_entry_hint = len(self.entries)
         return None
 
     def _extend_directory(self) -> None:
@@ -306,7 +313,7 @@ class Directory:
                           fatfs_state=self.fatfs_state,
                           entry=free_entry)
         file.first_cluster = free_cluster
-        target_dir.entities.append(file)
+        target_dir.add_entity(file)
 
     def new_directory(self, name, parent, path_from_root, object_timestamp_):
         # type: (str, Directory, Optional[List[str]], datetime) -> None
@@ -322,7 +329,7 @@ class Directory:
                                          entry=free_entry)
         directory.first_cluster = free_cluster
         directory.init_directory()
-        target_dir.entities.append(directory)
+        target_dir.add_entity(directory)
 
     def write_to_file(self, path: List[str], content: bytes) -> None:
         """
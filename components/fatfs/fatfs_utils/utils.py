@@ -1,4 +1,4 @@
-# SPDX-FileCopyrightText: 2021-2024 Espressif Systems (Shanghai) CO LTD
+# SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
 # SPDX-License-Identifier: Apache-2.0
 import argparse
 import binascii
@@ -214,6 +214,23 @@ def get_args_for_partition_generator(desc: str, wl: bool) -> argparse.Namespace:
                         type=int,
                         choices=[1, 2],
                         help='Number of file allocation tables (FATs) in the filesystem.')
+    if not wl:
+        parser.add_argument('--batch',
+                            default=None,
+                            help='CSV file with per-device files (columns: device, path in the image, '
+                                 'source file). One image is generated for each device, containing the '
+                                 'input directory with the files of the device added or replaced.')
+        parser.add_argument('--batch_output_dir',
+                            default='.',
+                            help='Directory for the images generated with --batch, named <device>.img')
+        parser.add_argument('--jobs',
+                            default=1,
+                            type=int,
+                            help='Number of processes generating the images in --batch mode')
+        parser.add_argument('--cache_dir',
+                            default=None,
+                            help='Directory for caching the image of the input directory between runs. '
+                                 'The cache is keyed by the contents of the files and the image parameters.')
     parser.add_argument('--wl_mode',
                         default=None,
                         type=str,
@@ -228,6 +245,8 @@ def get_args_for_partition_generator(desc: str, wl: bool) -> argparse.Namespace:
     args.partition_size = int(str(args.partition_size), 0)
     if not os.path.isdir(args.input_directory):
         raise NotADirectoryError(f'The target directory `{args.input_directory}` does not exist!')
+    if not wl and args.batch is not None and args.partition_size == -1:
+        raise ValueError('The partition size must be given explicitly in batch mode')
     if args.wl_mode is not None:
         if args.sector_size != 512:
             raise ValueError('Wear levelling mode can be set only for sector size 512')
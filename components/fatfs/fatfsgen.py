@@ -1,11 +1,19 @@
 #!/usr/bin/env python
-# SPDX-FileCopyrightText: 2021-2024 Espressif Systems (Shanghai) CO LTD
+# SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
 # SPDX-License-Identifier: Apache-2.0
+import csv
+import hashlib
 import os
+import pickle
+import stat
+import sys
+from concurrent.futures import ProcessPoolExecutor
 from datetime import datetime
 from typing import Any
+from typing import Dict
 from typing import List
 from typing import Optional
+from typing import Set
 
 from fatfs_utils.boot_sector import BootSector
 from fatfs_utils.exceptions import NoFreeClusterException
@@ -27,12 +35,24 @@ from fatfs_utils.utils import RESERVED_CLUSTERS_COUNT
 
 def duplicate_fat_decorator(func):  # type: ignore
     def wrapper(self, *args, **kwargs) -> None:  # type: ignore
-        func(self, *args, **kwargs)
-        if isinstance(self, FATFS):
+        # nested calls (e.g. generating the image from a folder) duplicate the FAT once, when the outermost returns
+        self._fat_update_depth += 1
+        try:
+            func(self, *args, **kwargs)
+        finally:
+            self._fat_update_depth -= 1
+        if isinstance(self, FATFS) and self._fat_update_depth == 0:
             self.duplicate_fat()
     return wrapper
 
 
+def image_path(path: str) -> List[str]:
+    """
+    Splits the path of a file in the image (separated by '/') into the upper case names used by the generator.
+    """
+    return [part.upper() for part in path.replace(os.sep, '/').strip('/').split('/')]
+
+
 class FATFS:
     """
     The class FATFS provides API for generating FAT file system.
@@ -64,6 +84,7 @@ class FATFS:
             assert ((int(root_entry_count) * BYTES_PER_DIRECTORY_ENTRY) // sector_size) % 2 == 0
 
         root_dir_sectors_cnt: int = (int(root_entry_count) * BYTES_PER_DIRECTORY_ENTRY) // sector_size
+        self._fat_update_depth: int = 0
 
         self.state: FATFSState = FATFSState(sector_size=sector_size,
                                             explicit_fat_type=explicit_fat_type,
@@ -169,15 +190,49 @@ class FATFS:
                 self.state.binary_image[fat_start: fat_end]
             )
 
+    @duplicate_fat_decorator
+    def add_file(self, path: str, content: bytes, object_timestamp_: datetime = FATFS_INCEPTION) -> None:
+        """
+        Creates the file with the given content, including the missing parent directories.
+
+        :param path: path of the file from the root directory, the names are separated by '/'
+        :param content: content of the file
+        :param object_timestamp_: timestamp of the file and of the directories created
+        """
+        split_path = image_path(path)
+        for depth in range(1, len(split_path)):
+            try:
+                self.root_directory.recursive_search(split_path[:depth], self.root_directory)
+            except FileNotFoundError:
+                self.create_directory(name=split_path[depth - 1],
+                                      path_from_root=split_path[:depth - 1],
+                                      object_timestamp_=object_timestamp_)
+        file_name, extension = os.path.splitext(split_path[-1])
+        self.create_file(name=file_name,
+                         extension=extension[1:],
+                         path_from_root=split_path[:-1] or None,
+                         object_timestamp_=object_timestamp_,
+                         is_empty=len(content) == 0)
+        self.write_content(split_path, content)
+
     def write_filesystem(self, output_path: str) -> None:
+        """
+        Writes the image to the file, or streams it to the standard output if the path is '-'
+        (e.g. to pipe it into a flashing tool without a temporary file).
+        """
+        if output_path == '-':
+            sys.stdout.buffer.write(self.state.binary_image)
+            sys.stdout.buffer.flush()
+            return
         with open(output_path, 'wb') as output:
-            output.write(bytearray(self.state.binary_image))
+            output.write(self.state.binary_image)
 
     @duplicate_fat_decorator
     def _generate_partition_from_folder(self,
                                         folder_relative_path: str,
                                         folder_path: str = '',
-                                        is_dir: bool = False) -> None:
+                                        is_dir: bool = False,
+                                        exclude: Optional[Set[str]] = None) -> None:
         """
         Given path to folder and folder name recursively encodes folder into binary image.
         Used by method generate.
@@ -192,6 +247,8 @@ class FATFS:
         object_timestamp = datetime.fromtimestamp(os.path.getctime(real_path))
 
         if os.path.isfile(real_path):
+            if exclude and '/'.join(split_path[1:]) in exclude:
+                return
             with open(real_path, 'rb') as file:
                 content = file.read()
             file_name, extension = os.path.splitext(split_path[-1])
@@ -211,14 +268,19 @@ class FATFS:
             # sorting files for better testability
             dir_content = list(sorted(os.listdir(real_path)))
             for path in dir_content:
-                self._generate_partition_from_folder(os.path.join(lower_path, path), folder_path=folder_path)
+                self._generate_partition_from_folder(os.path.join(lower_path, path),
+                                                     folder_path=folder_path,
+                                                     exclude=exclude)
 
-    def generate(self, input_directory: str) -> None:
+    def generate(self, input_directory: str, exclude: Optional[Set[str]] = None) -> None:
         """
         Normalize path to folder and recursively encode folder to binary image
+
+        :param input_directory: the folder to encode
+        :param exclude: paths of the files to leave out, as returned by `image_path` joined by '/'
         """
         path_to_folder, folder_name = os.path.split(input_directory)
-        self._generate_partition_from_folder(folder_name, folder_path=path_to_folder, is_dir=True)
+        self._generate_partition_from_folder(folder_name, folder_path=path_to_folder, is_dir=True, exclude=exclude)
 
 
 def calculate_min_space(path: List[str],
@@ -248,6 +310,167 @@ def calculate_min_space(path: List[str],
     return buff
 
 
+def read_batch_overrides(csv_path: str) -> Dict[str, Dict[str, str]]:
+    """
+    Reads the per-device files for the batch mode. Each row contains the name of the device, the path of the file
+    in the image and the path of the source file (relative to the CSV file). Rows starting with '#' are ignored.
+
+    :returns: source files by the path in the image (see `image_path`) for each device, in the order of the CSV
+    """
+    overrides: Dict[str, Dict[str, str]] = {}
+    base_dir = os.path.dirname(os.path.abspath(csv_path))
+    with open(csv_path, newline='') as csv_file:
+        for row in csv.reader(csv_file):
+            if not row or row[0].strip().startswith('#'):
+                continue
+            if len(row) != 3:
+                raise ValueError(f'Invalid batch row {row}, expected: device, path, source')
+            device, path, source = (column.strip() for column in row)
+            overrides.setdefault(device, {})['/'.join(image_path(path))] = os.path.join(base_dir, source)
+    return overrides
+
+
+def _template_cache_key(input_directory: str, exclude: Set[str], fatfs_args: Dict[str, Any]) -> str:
+    """
+    The key covers the parameters of the image and the names, contents and (unless the default timestamp is used)
+    the timestamps of the files and directories.
+    """
+    key = hashlib.sha256(repr((sorted(fatfs_args.items()), sorted(exclude))).encode())
+    with_timestamps = not fatfs_args.get('use_default_datetime', True)
+    for root, dirs, files in os.walk(input_directory):
+        dirs.sort()
+        for name in dirs + sorted(files):
+            path = os.path.join(root, name)
+            key.update(os.path.relpath(path, input_directory).encode() + b'\0')
+            if with_timestamps:
+                key.update(repr(os.path.getctime(path)).encode())
+            if os.path.isfile(path):
+                with open(path, 'rb') as file:
+                    key.update(hashlib.sha256(file.read()).digest())
+    return key.hexdigest()
+
+
+def _is_private(path: str) -> bool:
+    """
+    Tells whether the file or directory is owned by the current user and cannot be modified by other users.
+    Where ownership is not available (Windows), nothing is considered private.
+    """
+    if not hasattr(os, 'getuid'):
+        return False
+    path_stat = os.stat(path)
+    return path_stat.st_uid == os.getuid() and not path_stat.st_mode & (stat.S_IWGRP | stat.S_IWOTH)
+
+
+def _read_cached_template(cache_dir: str, cache_path: str) -> Optional[bytes]:
+    """
+    Returns the cached template, or None if there is none. Templates are unpickled, which can execute code,
+    so a cache file is only used if it and the cache directory can only be modified by the current user.
+    """
+    if not os.path.isfile(cache_path):
+        return None
+    if not (_is_private(cache_dir) and _is_private(cache_path)):
+        print(f'Ignoring {cache_path}: the cache directory and its files must be owned by the current user '
+              'and must not be writable by other users', file=sys.stderr)
+        return None
+    with open(cache_path, 'rb') as cache_file:
+        return cache_file.read()
+
+
+def _write_cached_template(cache_dir: str, cache_path: str, template: bytes) -> None:
+    os.makedirs(cache_dir, mode=0o700, exist_ok=True)
+    tmp_path = cache_path + '.tmp'
+    with open(os.open(tmp_path, os.O_WRONLY | os.O_CREAT | os.O_TRUNC, 0o600), 'wb') as cache_file:
+        cache_file.write(template)
+    os.replace(tmp_path, cache_path)
+
+
+def generate_template(input_directory: str,
+                      fatfs_args: Dict[str, Any],
+                      exclude: Optional[Set[str]] = None,
+                      cache_dir: Optional[str] = None) -> bytes:
+    """
+    Generates the image of the folder and returns the serialized FATFS, to which files can be added afterwards.
+    With a cache directory, the result is reused as long as the files and the parameters do not change.
+    The cache directory has to be private to the current user, see `_read_cached_template`.
+    """
+    exclude = exclude or set()
+    cache_path = None
+    if cache_dir is not None:
+        key = _template_cache_key(input_directory, exclude, fatfs_args)
+        cache_path = os.path.join(cache_dir, f'fatfs-{key}.pickle')
+        cached = _read_cached_template(cache_dir, cache_path)
+        if cached is not None:
+            return cached
+
+    fatfs = FATFS(**fatfs_args)
+    fatfs.generate(input_directory, exclude=exclude)
+    template = pickle.dumps(fatfs, protocol=pickle.HIGHEST_PROTOCOL)
+
+    if cache_path is not None:
+        _write_cached_template(cache_dir, cache_path, template)  # type: ignore
+    return template
+
+
+_batch_template: bytes = b''
+
+
+def _init_batch_worker(template: bytes) -> None:
+    global _batch_template
+    _batch_template = template
+
+
+def _generate_device_image(files: Dict[str, str], output_path: str) -> str:
+    fatfs: FATFS = pickle.loads(_batch_template)
+    for path, source in files.items():
+        with open(source, 'rb') as file:
+            content = file.read()
+        fatfs.add_file(path, content, datetime.fromtimestamp(os.path.getctime(source)))
+    fatfs.write_filesystem(output_path)
+    return output_path
+
+
+def generate_batch(input_directory: str,
+                   overrides: Dict[str, Dict[str, str]],
+                   output_dir: str,
+                   fatfs_args: Dict[str, Any],
+                   jobs: int = 1,
+                   cache_dir: Optional[str] = None) -> List[str]:
+    """
+    Generates an image for each device, containing the files of the input directory with the per-device files
+    added or replaced. The input directory is encoded only once, the per-device files are added to a copy of it.
+
+    :param input_directory: folder with the files common to all devices
+    :param overrides: per-device files, see `read_batch_overrides`
+    :param output_dir: folder for the images, named <device>.img
+    :param fatfs_args: keyword arguments of FATFS
+    :param jobs: number of processes generating the images
+    :param cache_dir: folder for caching the image of the input directory between runs
+    :returns: paths of the generated images
+    """
+    template_files: Dict[str, str] = {}
+    for root, _, files in os.walk(input_directory):
+        for name in files:
+            path = os.path.join(root, name)
+            template_files['/'.join(image_path(os.path.relpath(path, input_directory)))] = path
+
+    # files replaced on any device are left out of the template and added to each image
+    exclude = {path for files in overrides.values() for path in files if path in template_files}
+    template = generate_template(input_directory, fatfs_args, exclude=exclude, cache_dir=cache_dir)
+
+    os.makedirs(output_dir, exist_ok=True)
+    tasks = []
+    for device, files in overrides.items():
+        device_files = {path: template_files[path] for path in sorted(exclude) if path not in files}
+        device_files.update(files)
+        tasks.append((device_files, os.path.join(output_dir, f'{device}.img')))
+
+    if jobs <= 1:
+        _init_batch_worker(template)
+        return [_generate_device_image(*task) for task in tasks]
+    with ProcessPoolExecutor(max_workers=jobs, initializer=_init_batch_worker, initargs=(template,)) as executor:
+        return list(executor.map(_generate_device_image, *zip(*tasks)))
+
+
 def main() -> None:
     args = get_args_for_partition_generator('Create a FAT filesystem and populate it with directory content', wl=False)
 
@@ -263,16 +486,29 @@ def main() -> None:
                                    ) * args.sector_size
                                   )
 
-    fatfs = FATFS(size=args.partition_size,
-                  fat_tables_cnt=args.fat_count,
-                  sectors_per_cluster=args.sectors_per_cluster,
-                  sector_size=args.sector_size,
-                  long_names_enabled=args.long_name_support,
-                  use_default_datetime=args.use_default_datetime,
-                  root_entry_count=args.root_entry_count,
-                  explicit_fat_type=args.fat_type)
-
-    fatfs.generate(args.input_directory)
+    fatfs_args = dict(size=args.partition_size,
+                      fat_tables_cnt=args.fat_count,
+                      sectors_per_cluster=args.sectors_per_cluster,
+                      sector_size=args.sector_size,
+                      long_names_enabled=args.long_name_support,
+                      use_default_datetime=args.use_default_datetime,
+                      root_entry_count=args.root_entry_count,
+                      explicit_fat_type=args.fat_type)
+
+    if args.batch is not None:
+        generate_batch(args.input_directory,
+                       read_batch_overrides(args.batch),
+                       args.batch_output_dir,
+                       fatfs_args,
+                       jobs=args.jobs,
+                       cache_dir=args.cache_dir)
+        return
+
+    if args.cache_dir is not None:
+        fatfs = pickle.loads(generate_template(args.input_directory, fatfs_args, cache_dir=args.cache_dir))
+    else:
+        fatfs = FATFS(**fatfs_args)
+        fatfs.generate(args.input_directory)
     fatfs.write_filesystem(args.output_file)
 
 
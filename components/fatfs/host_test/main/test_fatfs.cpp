@@ -1,16 +1,19 @@
 /*
- * SPDX-FileCopyrightText: 2023-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2023-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 #include "ff.h"
 #include "esp_partition.h"
+#include "esp_private/partition_linux.h"
 #include "wear_levelling.h"
 #include "diskio_impl.h"
 #include "diskio_wl.h"
+#include "diskio_rawflash.h"
 
 #include <catch2/catch_test_macros.hpp>
 
@@ -285,3 +288,218 @@ TEST_CASE("Test mounting 2 volumes, writing data and formatting the 2nd one, rea
     esp_result = wl_unmount(wl_handle1);
     REQUIRE(esp_result == ESP_OK);
 }
+
+typedef struct {
+    size_t read_ops;
+    size_t write_ops;
+    size_t erase_ops;
+} flash_ops_t;
+
+/*
+ * Appends small records to a log file, closing it each time, and lists the directory,
+ * i.e. mostly single sector FAT, directory and partial data sector accesses.
+ */
+static flash_ops_t run_metadata_workload(size_t cache_sectors)
+{
+    const esp_partition_t *partition = NULL;
+    wl_handle_t wl_handle = WL_INVALID_HANDLE;
+    BYTE pdrv = UINT8_MAX;
+    FATFS fs;
+    FIL file;
+    UINT bw;
+
+    prepare_fatfs("storage", &partition, &wl_handle, &pdrv);
+    REQUIRE(ff_diskio_set_cache_size(pdrv, cache_sectors) == ESP_OK);
+    char drv[3] = {(char)('0' + pdrv), ':', 0};
+    char path[16];
+    snprintf(path, sizeof(path), "%s/log.txt", drv);
+    REQUIRE(f_mount(&fs, drv, 1) == FR_OK);
+    // the cache size can't be changed while the volume is mounted
+    REQUIRE(ff_diskio_set_cache_size(pdrv, cache_sectors + 1) == ESP_ERR_INVALID_STATE);
+
+    esp_partition_clear_stats();
+    const char record[] = "0123456789abcdef0123456789abcde\n";
+    for (int i = 0; i < 20; i++) {
+        REQUIRE(f_open(&file, path, FA_OPEN_APPEND | FA_WRITE) == FR_OK);
+        REQUIRE(f_write(&file, record, sizeof(record) - 1, &bw) == FR_OK);
+        REQUIRE(bw == sizeof(record) - 1);
+        REQUIRE(f_close(&file) == FR_OK);
+
+        FF_DIR dir;
+        FILINFO info;
+        REQUIRE(f_opendir(&dir, drv) == FR_OK);
+        while (f_readdir(&dir, &info) == FR_OK && info.fname[0] != 0) {
+            REQUIRE(f_stat(path, &info) == FR_OK);
+        }
+        REQUIRE(f_closedir(&dir) == FR_OK);
+    }
+
+    REQUIRE(f_open(&file, path, FA_READ) == FR_OK);
+    REQUIRE(f_size(&file) == 20 * (sizeof(record) - 1));
+    REQUIRE(f_close(&file) == FR_OK);
+
+    // unregistering the drive writes back the cache
+    REQUIRE(f_mount(0, drv, 0) == FR_OK);
+    ff_diskio_unregister(pdrv);
+    flash_ops_t ops = {
+        .read_ops = esp_partition_get_read_ops(),
+        .write_ops = esp_partition_get_write_ops(),
+        .erase_ops = esp_partition_get_erase_ops(),
+    };
+
+    ff_diskio_clear_pdrv_wl(wl_handle);
+    REQUIRE(wl_unmount(wl_handle) == ESP_OK);
+    return ops;
+}
+
+TEST_CASE("Disk I/O cache reduces flash operations of metadata updates", "[fatfs]")
+{
+    flash_ops_t uncached = run_metadata_workload(0);
+    flash_ops_t cached = run_metadata_workload(16);
+
+    printf("flash operations without cache: read %zu, write %zu, erase %zu\n",
+           uncached.read_ops, uncached.write_ops, uncached.erase_ops);
+    printf("flash operations with 16 sector cache: read %zu, write %zu, erase %zu\n",
+           cached.read_ops, cached.write_ops, cached.erase_ops);
+
+    REQUIRE(cached.read_ops < uncached.read_ops);
+    REQUIRE(cached.write_ops <= uncached.write_ops);
+    REQUIRE(cached.erase_ops <= uncached.erase_ops);
+}
+
+static const esp_partition_t* s_rw_raw_partition;
+
+/* Writable raw flash driver, used to create the FAT image read through diskio_rawflash */
+static DSTATUS rw_raw_initialize(BYTE pdrv)
+{
+    return 0;
+}
+
+static DSTATUS rw_raw_status(BYTE pdrv)
+{
+    return 0;
+}
+
+static DRESULT rw_raw_read(BYTE pdrv, BYTE* buff, DWORD sector, UINT count)
+{
+    esp_err_t err = esp_partition_read(s_rw_raw_partition, sector * ESP_PARTITION_EMULATED_SECTOR_SIZE, buff, count * ESP_PARTITION_EMULATED_SECTOR_SIZE);
+    return err == ESP_OK ? RES_OK : RES_ERROR;
+}
+
+static DRESULT rw_raw_write(BYTE pdrv, const BYTE* buff, DWORD sector, UINT count)
+{
+    size_t offset = sector * ESP_PARTITION_EMULATED_SECTOR_SIZE;
+    size_t size = count * ESP_PARTITION_EMULATED_SECTOR_SIZE;
+    if (esp_partition_erase_range(s_rw_raw_partition, offset, size) != ESP_OK ||
+        esp_partition_write(s_rw_raw_partition, offset, buff, size) != ESP_OK) {
+        return RES_ERROR;
+    }
+    return RES_OK;
+}
+
+static DRESULT rw_raw_ioctl(BYTE pdrv, BYTE cmd, void* buff)
+{
+    switch (cmd) {
+    case CTRL_SYNC:
+        return RES_OK;
+    case GET_SECTOR_COUNT:
+        *((DWORD*) buff) = s_rw_raw_partition->size / ESP_PARTITION_EMULATED_SECTOR_SIZE;
+        return RES_OK;
+    case GET_SECTOR_SIZE:
+        *((WORD*) buff) = ESP_PARTITION_EMULATED_SECTOR_SIZE;
+        return RES_OK;
+    }
+    return RES_ERROR;
+}
+
+static double read_file_mbps(const char* path, char* buf, size_t size, size_t* read_ops)
+{
+    const int rounds = 50;
+    FIL file;
+    UINT br;
+    struct timespec start, end;
+
+    esp_partition_clear_stats();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < rounds; i++) {
+        REQUIRE(f_open(&file, path, FA_READ) == FR_OK);
+        REQUIRE(f_read(&file, buf, size, &br) == FR_OK);
+        REQUIRE(br == size);
+        REQUIRE(f_close(&file) == FR_OK);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    *read_ops = esp_partition_get_read_ops();
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    return rounds * size / seconds / 1e6;
+}
+
+TEST_CASE("Read-only raw flash partition is read through the partition mapping", "[fatfs]")
+{
+    s_rw_raw_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_FAT, "assets");
+    REQUIRE(s_rw_raw_partition != NULL);
+
+    // create the image through a writable driver
+    BYTE pdrv;
+    REQUIRE(ff_diskio_get_drive(&pdrv) == ESP_OK);
+    char drv[3] = {(char)('0' + pdrv), ':', 0};
+    char path[16];
+    snprintf(path, sizeof(path), "%s/asset.bin", drv);
+    static const ff_diskio_impl_t rw_raw_impl = {
+        .init = &rw_raw_initialize,
+        .status = &rw_raw_status,
+        .read = &rw_raw_read,
+        .write = &rw_raw_write,
+        .ioctl = &rw_raw_ioctl,
+    };
+    ff_diskio_register(pdrv, &rw_raw_impl);
+
+    BYTE work_area[FF_MAX_SS];
+    const MKFS_PARM opt = {(BYTE)(FM_ANY | FM_SFD), 0, 0, 128, 0};
+    REQUIRE(f_mkfs(drv, &opt, work_area, sizeof(work_area)) == FR_OK);
+
+    const size_t data_size = 256 * 1024;
+    char* data = (char*) malloc(data_size);
+    char* buf = (char*) malloc(data_size);
+    REQUIRE(data != NULL);
+    REQUIRE(buf != NULL);
+    for (size_t i = 0; i < data_size; i++) {
+        data[i] = (char)(i * 13);
+    }
+
+    FATFS fs;
+    FIL file;
+    UINT bw;
+    REQUIRE(f_mount(&fs, drv, 1) == FR_OK);
+    REQUIRE(f_open(&file, path, FA_CREATE_ALWAYS | FA_WRITE) == FR_OK);
+    REQUIRE(f_write(&file, data, data_size, &bw) == FR_OK);
+    REQUIRE(bw == data_size);
+    REQUIRE(f_close(&file) == FR_OK);
+    REQUIRE(f_mount(0, drv, 0) == FR_OK);
+    ff_diskio_unregister(pdrv);
+
+    // mount it the way esp_vfs_fat_spiflash_mount_ro does, the partition is mapped on mount
+    REQUIRE(ff_diskio_register_raw_partition(pdrv, s_rw_raw_partition) == ESP_OK);
+    REQUIRE(f_mount(&fs, drv, 1) == FR_OK);
+
+    size_t mmap_read_ops;
+    double mmap_mbps = read_file_mbps(path, buf, data_size, &mmap_read_ops);
+    REQUIRE(memcmp(data, buf, data_size) == 0);
+
+    REQUIRE(ff_diskio_set_mmap(pdrv, NULL, 0, 0) == ESP_OK);
+    memset(buf, 0, data_size);
+    size_t copy_read_ops;
+    double copy_mbps = read_file_mbps(path, buf, data_size, &copy_read_ops);
+    REQUIRE(memcmp(data, buf, data_size) == 0);
+
+    printf("file read throughput: %.1f MB/s through esp_partition_read (%zu reads), %.1f MB/s through the partition mapping\n",
+           copy_mbps, copy_read_ops, mmap_mbps);
+    REQUIRE(mmap_read_ops == 0);
+    REQUIRE(copy_read_ops > 0);
+
+    REQUIRE(f_mount(0, drv, 0) == FR_OK);
+    ff_diskio_unregister(pdrv);
+    ff_diskio_clear_pdrv_raw(s_rw_raw_partition);
+    REQUIRE(ff_diskio_get_pdrv_raw(s_rw_raw_partition) == 0xff);
+    free(buf);
+    free(data);
+}
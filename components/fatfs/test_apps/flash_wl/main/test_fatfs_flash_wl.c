@@ -295,6 +295,13 @@ TEST_CASE("(WL) multiple tasks can use same volume", "[fatfs][wear_levelling]")
     test_teardown();
 }
 
+TEST_CASE("(WL) multiple tasks reading different files", "[fatfs][wear_levelling][timeout=60]")
+{
+    test_setup();
+    test_fatfs_concurrent_read_speed("/spiflash/r", 64 * 1024, 4);
+    test_teardown();
+}
+
 TEST_CASE("(WL) fatfs does not ignore leading spaces", "[fatfs][wear_levelling]")
 {
     // the functionality of ignoring leading and trailing whitespaces is not implemented yet
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -1091,6 +1091,88 @@ void test_fatfs_concurrent(const char* filename_prefix)
     vSemaphoreDelete(args4.done);
 }
 
+typedef struct {
+    const char* filename;
+    size_t file_size;
+    size_t block_size;
+    SemaphoreHandle_t done;
+    esp_err_t result;
+} read_speed_task_arg_t;
+
+static void read_speed_task(void* param)
+{
+    read_speed_task_arg_t* args = (read_speed_task_arg_t*) param;
+    args->result = ESP_FAIL;
+    void* buf = malloc(args->block_size);
+    int fd = open(args->filename, O_RDONLY);
+    if (buf != NULL && fd >= 0) {
+        size_t total = 0;
+        ssize_t n;
+        while ((n = read(fd, buf, args->block_size)) > 0) {
+            total += n;
+        }
+        if (n == 0 && total == args->file_size) {
+            args->result = ESP_OK;
+        }
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    free(buf);
+    xSemaphoreGive(args->done);
+    vTaskDelete(NULL);
+}
+
+void test_fatfs_concurrent_read_speed(const char* filename_prefix, size_t file_size, size_t max_tasks)
+{
+    const size_t block_size = 4096;
+    char (*names)[64] = calloc(max_tasks, sizeof(*names));
+    read_speed_task_arg_t* args = calloc(max_tasks, sizeof(*args));
+    void* buf = malloc(block_size);
+    TEST_ASSERT_NOT_NULL(names);
+    TEST_ASSERT_NOT_NULL(args);
+    TEST_ASSERT_NOT_NULL(buf);
+    memset(buf, 0x5a, block_size);
+
+    for (size_t i = 0; i < max_tasks; ++i) {
+        snprintf(names[i], sizeof(names[i]), "%s%d", filename_prefix, i + 1);
+        int fd = open(names[i], O_WRONLY | O_CREAT | O_TRUNC);
+        TEST_ASSERT_GREATER_OR_EQUAL(0, fd);
+        for (size_t written = 0; written < file_size; written += block_size) {
+            TEST_ASSERT_EQUAL(block_size, write(fd, buf, block_size));
+        }
+        TEST_ASSERT_EQUAL(0, close(fd));
+        args[i].done = xSemaphoreCreateBinary();
+        TEST_ASSERT_NOT_NULL(args[i].done);
+    }
+
+    for (size_t task_count = 1; task_count <= max_tasks; task_count *= 2) {
+        int64_t start = esp_timer_get_time();
+        for (size_t i = 0; i < task_count; ++i) {
+            args[i].filename = names[i];
+            args[i].file_size = file_size;
+            args[i].block_size = block_size;
+            TEST_ASSERT_EQUAL(pdPASS, xTaskCreatePinnedToCore(&read_speed_task, "rs", 4096, &args[i], 3, NULL,
+                                                              i % CONFIG_FREERTOS_NUMBER_OF_CORES));
+        }
+        for (size_t i = 0; i < task_count; ++i) {
+            xSemaphoreTake(args[i].done, portMAX_DELAY);
+            TEST_ASSERT_EQUAL(ESP_OK, args[i].result);
+        }
+        float t_s = (esp_timer_get_time() - start) * 1e-6f;
+        printf("%d tasks read %d bytes each in %.3fms (%.3f MB/s total)\n",
+                task_count, file_size, t_s * 1e3, task_count * file_size / (1024.0f * 1024.0f * t_s));
+    }
+
+    for (size_t i = 0; i < max_tasks; ++i) {
+        vSemaphoreDelete(args[i].done);
+        unlink(names[i]);
+    }
+    free(buf);
+    free(args);
+    free(names);
+}
+
 void test_leading_spaces(void){
     // fatfs should ignore leading and trailing whitespaces
     // and files "/spiflash/        thelongfile.txt    " and "/spiflash/thelongfile.txt" should be equivalent
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2022 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -63,6 +63,11 @@ void test_fatfs_link_rename(const char* filename_prefix);
 
 void test_fatfs_concurrent(const char* filename_prefix);
 
+/**
+ * @brief Read files of file_size bytes from 1, 2, 4... up to max_tasks tasks at once and print the total throughput
+ */
+void test_fatfs_concurrent_read_speed(const char* filename_prefix, size_t file_size, size_t max_tasks);
+
 void test_fatfs_mkdir_rmdir(const char* filename_prefix);
 
 void test_fatfs_can_opendir(const char* path);
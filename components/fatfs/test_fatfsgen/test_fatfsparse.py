@@ -1,10 +1,11 @@
 #!/usr/bin/env python
-# SPDX-FileCopyrightText: 2021-2024 Espressif Systems (Shanghai) CO LTD
+# SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
 # SPDX-License-Identifier: Apache-2.0
 
 import os
 import shutil
 import sys
+import time
 import unittest
 from subprocess import STDOUT, run
 
@@ -349,6 +350,72 @@ class FatFSGen(unittest.TestCase):
             {}
         )
 
+    @staticmethod
+    def _write_batch_csv(devices: int) -> None:
+        os.makedirs('output_data/devices')
+        with open('output_data/batch.csv', 'w') as csv_file:
+            csv_file.write('# device, path in the image, source\n')
+            for i in range(devices):
+                with open(f'output_data/devices/id{i}', 'w') as id_file:
+                    id_file.write(f'device {i}\n')
+                csv_file.write(f'dev{i},test/testfil2,devices/id{i}\n')
+                csv_file.write(f'dev{i},id/device.bin,devices/id{i}\n')
+
+    def test_batch_gen_parse(self) -> None:
+        self._write_batch_csv(3)
+        for _ in range(2):  # the second run uses the cached template
+            run([sys.executable, '../fatfsgen.py', 'output_data/tst_str',
+                 '--batch', 'output_data/batch.csv',
+                 '--batch_output_dir', 'output_data/images',
+                 '--cache_dir', 'output_data/cache',
+                 '--jobs', '2'], stderr=STDOUT, check=True)
+        self.assertEqual(len(os.listdir('output_data/cache')), 1)
+        self.assertEqual(set(os.listdir('output_data/images')), {'dev0.img', 'dev1.img', 'dev2.img'})
+
+        run([sys.executable, '../fatfsparse.py', 'output_data/images/dev1.img'], stderr=STDOUT, check=True)
+        self.assertEqual(set(os.listdir('Espressif')), {'TEST', 'TESTFILE', 'ID'})
+        with open('Espressif/TESTFILE', 'rb') as in_:
+            self.assertEqual(in_.read(), b'ahoj\n')
+        with open('Espressif/TEST/TESTFIL2', 'rb') as in_:
+            self.assertEqual(in_.read(), b'device 1\n')
+        with open('Espressif/TEST/TEST/LASTFILE.TXT', 'rb') as in_:
+            self.assertEqual(in_.read(), b'deeptest\n')
+        with open('Espressif/ID/DEVICE.BIN', 'rb') as in_:
+            self.assertEqual(in_.read(), b'device 1\n')
+
+    @unittest.skipUnless(hasattr(os, 'getuid'), 'requires POSIX file ownership')
+    def test_batch_cache_permissions(self) -> None:
+        self._write_batch_csv(1)
+        batch_args = [sys.executable, '../fatfsgen.py', 'output_data/tst_str',
+                      '--batch', 'output_data/batch.csv',
+                      '--batch_output_dir', 'output_data/images',
+                      '--cache_dir', 'output_data/cache']
+        run(batch_args, stderr=STDOUT, check=True)
+        cache_path = os.path.join('output_data/cache', os.listdir('output_data/cache')[0])
+        self.assertEqual(os.stat('output_data/cache').st_mode & 0o777, 0o700)
+        self.assertEqual(os.stat(cache_path).st_mode & 0o777, 0o600)
+
+        # a cache file other users can modify is not unpickled
+        with open(cache_path, 'wb') as cache_file:
+            cache_file.write(b'not a pickle')
+        os.chmod(cache_path, 0o666)
+        run(batch_args, stderr=STDOUT, check=True)
+        run([sys.executable, '../fatfsparse.py', 'output_data/images/dev0.img'], stderr=STDOUT, check=True)
+        with open('Espressif/TEST/TESTFIL2', 'rb') as in_:
+            self.assertEqual(in_.read(), b'device 0\n')
+
+    def test_batch_benchmark(self) -> None:
+        devices = 100
+        self._write_batch_csv(devices)
+        start = time.perf_counter()
+        images = fatfsgen.generate_batch('output_data/tst_str',
+                                         fatfsgen.read_batch_overrides('output_data/batch.csv'),
+                                         'output_data/images',
+                                         dict(size=1024 * 1024, use_default_datetime=True))
+        elapsed = time.perf_counter() - start
+        self.assertEqual(len(images), devices)
+        print(f'\nfatfsgen batch: {devices} images in {elapsed:.2f} s, {devices * 60 / elapsed:.0f} images/min')
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -40,11 +40,12 @@ typedef struct {
     char fat_drive[8];  /* FAT drive name */
     char base_path[ESP_VFS_PATH_MAX];   /* base path in VFS where partition is registered */
     size_t max_files;   /* max number of simultaneously open files; size of files[] array */
-    _lock_t lock;       /* guard for access to this structure */
+    _lock_t lock;       /* guard for the volume: file descriptor allocation, path buffers and directory operations */
     FATFS fs;           /* fatfs library FS structure */
     char tmp_path_buf[FILENAME_MAX+3];  /* temporary buffer used to prepend drive name to the path */
     char tmp_path_buf2[FILENAME_MAX+3]; /* as above; used in functions which take two path arguments */
     uint32_t *flags; /* file descriptor flags, array of max_files size */
+    _lock_t *file_locks; /* per file descriptor guards, array of max_files size */
 #ifdef CONFIG_VFS_SUPPORT_DIR
     char dir_path[FILENAME_MAX]; /* variable to store path of opened directory*/
     struct cached_data cached_fileinfo;
@@ -212,18 +213,28 @@ esp_err_t esp_vfs_fat_register_cfg(const esp_vfs_fat_conf_t* conf, FATFS** out_f
         return ESP_ERR_NO_MEM;
     }
     memset(fat_ctx->flags, 0, max_files * sizeof(*fat_ctx->flags));
+    fat_ctx->file_locks = ff_memalloc(max_files * sizeof(*fat_ctx->file_locks));
+    if (fat_ctx->file_locks == NULL) {
+        free(fat_ctx->flags);
+        free(fat_ctx);
+        return ESP_ERR_NO_MEM;
+    }
     fat_ctx->max_files = max_files;
     strlcpy(fat_ctx->fat_drive, conf->fat_drive, sizeof(fat_ctx->fat_drive) - 1);
     strlcpy(fat_ctx->base_path, conf->base_path, sizeof(fat_ctx->base_path) - 1);
 
     esp_err_t err = esp_vfs_register_fs(conf->base_path, &s_vfs_fat, ESP_VFS_FLAG_CONTEXT_PTR | ESP_VFS_FLAG_STATIC, fat_ctx);
     if (err != ESP_OK) {
+        free(fat_ctx->file_locks);
         free(fat_ctx->flags);
         free(fat_ctx);
         return err;
     }
 
     _lock_init(&fat_ctx->lock);
+    for (size_t i = 0; i < max_files; ++i) {
+        _lock_init(&fat_ctx->file_locks[i]);
+    }
     s_fat_ctxs[ctx] = fat_ctx;
 
     //compatibility
@@ -246,6 +257,10 @@ esp_err_t esp_vfs_fat_unregister_path(const char* base_path)
         return err;
     }
     _lock_close(&fat_ctx->lock);
+    for (size_t i = 0; i < fat_ctx->max_files; ++i) {
+        _lock_close(&fat_ctx->file_locks[i]);
+    }
+    free(fat_ctx->file_locks);
     free(fat_ctx->flags);
     free(fat_ctx);
     s_fat_ctxs[ctx] = NULL;
@@ -353,6 +368,22 @@ static void file_cleanup(vfs_fat_ctx_t* ctx, int fd)
     memset(&ctx->files[fd], 0, sizeof(FIL));
 }
 
+/*
+ * Operations on an open file only take the lock of that file descriptor, so that tasks
+ * working on different files don't wait for each other in this layer. Access to the
+ * FATFS volume itself is serialized inside FatFs (FF_FS_REENTRANT), per f_xxx call.
+ * Lock order: file lock first, then fat_ctx->lock (see vfs_fat_close).
+ */
+static inline void file_lock(vfs_fat_ctx_t* ctx, int fd)
+{
+    _lock_acquire(&ctx->file_locks[fd]);
+}
+
+static inline void file_unlock(vfs_fat_ctx_t* ctx, int fd)
+{
+    _lock_release(&ctx->file_locks[fd]);
+}
+
 /**
  * @brief Prepend drive letters to path names
  * This function returns new path path pointers, pointing to a temporary buffer
@@ -444,12 +475,12 @@ static ssize_t vfs_fat_write(void* ctx, int fd, const void * data, size_t size)
     vfs_fat_ctx_t* fat_ctx = (vfs_fat_ctx_t*) ctx;
     FIL* file = &fat_ctx->files[fd];
     FRESULT res;
-    _lock_acquire(&fat_ctx->lock);
+    file_lock(fat_ctx, fd);
     if (fat_ctx->flags[fd] & O_APPEND) {
         if ((res = f_lseek(file, f_size(file))) != FR_OK) {
             ESP_LOGD(TAG, "%s: fresult=%d", __func__, res);
             errno = fresult_to_errno(res);
-            _lock_release(&fat_ctx->lock);
+            file_unlock(fat_ctx, fd);
             return -1;
         }
     }
@@ -457,14 +488,14 @@ static ssize_t vfs_fat_write(void* ctx, int fd, const void * data, size_t size)
     res = f_write(file, data, size, &written);
     if (((written == 0) && (size != 0)) && (res == 0)) {
         errno = ENOSPC;
-        _lock_release(&fat_ctx->lock);
+        file_unlock(fat_ctx, fd);
         return -1;
     }
     if (res != FR_OK) {
         ESP_LOGD(TAG, "%s: fresult=%d", __func__, res);
         errno = fresult_to_errno(res);
         if (written == 0) {
-            _lock_release(&fat_ctx->lock);
+            file_unlock(fat_ctx, fd);
             return -1;
         }
     }
@@ -475,12 +506,12 @@ static ssize_t vfs_fat_write(void* ctx, int fd, const void * data, size_t size)
         if (res != FR_OK) {
             ESP_LOGD(TAG, "%s: fresult=%d", __func__, res);
             errno = fresult_to_errno(res);
-            _lock_release(&fat_ctx->lock);
+            file_unlock(fat_ctx, fd);
             return -1;
         }
      }
 #endif
-    _lock_release(&fat_ctx->lock);
+    file_unlock(fat_ctx, fd);
     return written;
 }
 
@@ -489,7 +520,9 @@ static ssize_t vfs_fat_read(void* ctx, int fd, void * dst, size_t size)
     vfs_fat_ctx_t* fat_ctx = (vfs_fat_ctx_t*) ctx;
     FIL* file = &fat_ctx->files[fd];
     unsigned read = 0;
+    file_lock(fat_ctx, fd);
     FRESULT res = f_read(file, dst, size, &read);
+    file_unlock(fat_ctx, fd);
     if (res != FR_OK) {
         ESP_LOGD(TAG, "%s: fresult=%d", __func__, res);
         errno = fresult_to_errno(res);
@@ -504,7 +537,7 @@ static ssize_t vfs_fat_pread(void *ctx, int fd, void *dst, size_t size, off_t of
 {
     ssize_t ret = -1;
     vfs_fat_ctx_t *fat_ctx = (vfs_fat_ctx_t *) ctx;
-    _lock_acquire(&fat_ctx->lock);
+    file_lock(fat_ctx, fd);
     FIL *file = &fat_ctx->files[fd];
     const off_t prev_pos = f_tell(file);
 
@@ -536,7 +569,7 @@ static ssize_t vfs_fat_pread(void *ctx, int fd, void *dst, size_t size, off_t of
     }
 
 pread_release:
-    _lock_release(&fat_ctx->lock);
+    file_unlock(fat_ctx, fd);
     return ret;
 }
 
@@ -544,7 +577,7 @@ static ssize_t vfs_fat_pwrite(void *ctx, int fd, const void *src, size_t size, o
 {
     ssize_t ret = -1;
     vfs_fat_ctx_t *fat_ctx = (vfs_fat_ctx_t *) ctx;
-    _lock_acquire(&fat_ctx->lock);
+    file_lock(fat_ctx, fd);
     FIL *file = &fat_ctx->files[fd];
     const off_t prev_pos = f_tell(file);
 
@@ -560,7 +593,7 @@ static ssize_t vfs_fat_pwrite(void *ctx, int fd, const void *src, size_t size, o
     f_res = f_write(file, src, size, &wr);
     if (((wr == 0) && (size != 0)) && (f_res == 0)) {
         errno = ENOSPC;
-        return -1;
+        goto pwrite_release;
     }
     if (f_res == FR_OK) {
         ret = wr;
@@ -592,7 +625,7 @@ static ssize_t vfs_fat_pwrite(void *ctx, int fd, const void *src, size_t size, o
 #endif
 
 pwrite_release:
-    _lock_release(&fat_ctx->lock);
+    file_unlock(fat_ctx, fd);
     return ret;
 }
 
@@ -600,7 +633,9 @@ static int vfs_fat_fsync(void* ctx, int fd)
 {
     vfs_fat_ctx_t* fat_ctx = (vfs_fat_ctx_t*) ctx;
     FIL* file = &fat_ctx->files[fd];
+    file_lock(fat_ctx, fd);
     FRESULT res = f_sync(file);
+    file_unlock(fat_ctx, fd);
     int rc = 0;
     if (res != FR_OK) {
         ESP_LOGD(TAG, "%s: fresult=%d", __func__, res);
@@ -613,6 +648,8 @@ static int vfs_fat_fsync(void* ctx, int fd)
 static int vfs_fat_close(void* ctx, int fd)
 {
     vfs_fat_ctx_t* fat_ctx = (vfs_fat_ctx_t*) ctx;
+    // wait for the operations in progress on this file, then free the descriptor
+    file_lock(fat_ctx, fd);
     _lock_acquire(&fat_ctx->lock);
     FIL* file = &fat_ctx->files[fd];
 
@@ -624,6 +661,7 @@ static int vfs_fat_close(void* ctx, int fd)
     FRESULT res = f_close(file);
     file_cleanup(fat_ctx, fd);
     _lock_release(&fat_ctx->lock);
+    file_unlock(fat_ctx, fd);
     int rc = 0;
     if (res != FR_OK) {
         ESP_LOGD(TAG, "%s: fresult=%d", __func__, res);
@@ -638,6 +676,7 @@ static off_t vfs_fat_lseek(void* ctx, int fd, off_t offset, int mode)
     vfs_fat_ctx_t* fat_ctx = (vfs_fat_ctx_t*) ctx;
     FIL* file = &fat_ctx->files[fd];
     off_t new_pos;
+    file_lock(fat_ctx, fd);
     if (mode == SEEK_SET) {
         new_pos = offset;
     } else if (mode == SEEK_CUR) {
@@ -647,6 +686,7 @@ static off_t vfs_fat_lseek(void* ctx, int fd, off_t offset, int mode)
         off_t size = f_size(file);
         new_pos = size + offset;
     } else {
+        file_unlock(fat_ctx, fd);
         errno = EINVAL;
         return -1;
     }
@@ -657,6 +697,7 @@ static off_t vfs_fat_lseek(void* ctx, int fd, off_t offset, int mode)
     ESP_LOGD(TAG, "%s: offset=%ld, filesize:=%" PRIu32, __func__, new_pos, f_size(file));
 #endif
     FRESULT res = f_lseek(file, new_pos);
+    file_unlock(fat_ctx, fd);
     if (res != FR_OK) {
         ESP_LOGD(TAG, "%s: fresult=%d", __func__, res);
         errno = fresult_to_errno(res);
@@ -670,7 +711,9 @@ static int vfs_fat_fstat(void* ctx, int fd, struct stat * st)
     vfs_fat_ctx_t* fat_ctx = (vfs_fat_ctx_t*) ctx;
     FIL* file = &fat_ctx->files[fd];
     memset(st, 0, sizeof(*st));
+    file_lock(fat_ctx, fd);
     st->st_size = f_size(file);
+    file_unlock(fat_ctx, fd);
     st->st_mode = S_IRWXU | S_IRWXG | S_IRWXO | S_IFREG;
     st->st_mtime = 0;
     st->st_atime = 0;
@@ -686,7 +729,9 @@ static int vfs_fat_fcntl(void* ctx, int fd, int cmd, int arg)
         case F_GETFL:
             return fat_ctx->flags[fd];
         case F_SETFL:
+            file_lock(fat_ctx, fd);
             fat_ctx->flags[fd] = arg;
+            file_unlock(fat_ctx, fd);
             return 0;
         // no-ops:
         case F_SETLK:
@@ -1263,7 +1308,7 @@ static int vfs_fat_ftruncate(void* ctx, int fd, off_t length)
         return ret;
     }
 
-    _lock_acquire(&fat_ctx->lock);
+    file_lock(fat_ctx, fd);
     file = &fat_ctx->files[fd];
     if (file == NULL) {
         ESP_LOGD(TAG, "ftruncate NULL file pointer");
@@ -1328,7 +1373,7 @@ static int vfs_fat_ftruncate(void* ctx, int fd, off_t length)
 #endif
 
 out:
-    _lock_release(&fat_ctx->lock);
+    file_unlock(fat_ctx, fd);
     return ret;
 
 fail:
@@ -392,6 +392,7 @@ esp_err_t esp_vfs_fat_spiflash_mount_ro(const char* base_path,
 fail:
     esp_vfs_fat_unregister_path(base_path);
     ff_diskio_unregister(pdrv);
+    ff_diskio_clear_pdrv_raw(data_partition);
     return ret;
 }
 
@@ -407,6 +408,7 @@ esp_err_t esp_vfs_fat_spiflash_unmount_ro(const char* base_path, const char* par
     char drv[3] = {(char)('0' + pdrv), ':', 0};
     f_mount(0, drv, 0);
     ff_diskio_unregister(pdrv);
+    ff_diskio_clear_pdrv_raw(data_partition);
     esp_err_t err = esp_vfs_fat_unregister_path(base_path);
     return err;
 }
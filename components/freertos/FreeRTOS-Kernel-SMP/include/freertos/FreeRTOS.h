@@ -707,6 +707,10 @@
     #define configINCLUDE_FREERTOS_TASK_C_ADDITIONS_H    0
 #endif
 
+#ifndef configINCLUDE_FREERTOS_QUEUE_C_ADDITIONS_H
+    #define configINCLUDE_FREERTOS_QUEUE_C_ADDITIONS_H    0
+#endif
+
 /* The following event macros are embedded in the kernel API calls. */
 
 #ifndef traceMOVED_TASK_TO_READY_STATE
@@ -125,6 +125,9 @@ void vPortReleaseLock( portMUX_TYPE *lock );
 
 void vPortYield( void );
 extern void vPortYieldFromISR( void );
+#if ( configNUMBER_OF_CORES > 1 )
+void vPortYieldCore( BaseType_t xCoreID );
+#endif /* configNUMBER_OF_CORES > 1 */
 
 #define portYIELD_FROM_ISR_CHECK(x)     ({ \
     if ( (x) == pdTRUE ) { \
@@ -169,6 +172,18 @@ void vPortCleanUpTCB ( void *pxTCB );
 extern BaseType_t xPortSetInterruptMask( void );
 extern void vPortClearInterruptMask( BaseType_t xMask );
 
+#if ( configNUMBER_OF_CORES > 1 )
+#define portSET_INTERRUPT_MASK()                    xPortSetInterruptMask()
+#define portCLEAR_INTERRUPT_MASK(x)                 vPortClearInterruptMask(x)
+#define portSET_INTERRUPT_MASK_FROM_ISR()           xPortSetInterruptMask()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(x)        vPortClearInterruptMask(x)
+#define portENTER_CRITICAL_FROM_ISR()               vTaskEnterCriticalFromISR()
+#define portEXIT_CRITICAL_FROM_ISR(x)               vTaskExitCriticalFromISR(x)
+#define portGET_TASK_LOCK()                         vPortTakeLock(&port_xTaskLock)
+#define portRELEASE_TASK_LOCK()                     vPortReleaseLock(&port_xTaskLock)
+#define portGET_ISR_LOCK()                          vPortTakeLock(&port_xISRLock)
+#define portRELEASE_ISR_LOCK()                      vPortReleaseLock(&port_xISRLock)
+#else
 #define portSET_INTERRUPT_MASK_FROM_ISR() ({ \
     BaseType_t cur_level; \
     cur_level = xPortSetInterruptMask(); \
@@ -179,6 +194,7 @@ extern void vPortClearInterruptMask( BaseType_t xMask );
     vTaskExitCritical(); \
     vPortClearInterruptMask(x); \
 })
+#endif /* configNUMBER_OF_CORES > 1 */
 
 // ---------------------- Yielding -------------------------
 
@@ -188,7 +204,9 @@ extern void vPortClearInterruptMask( BaseType_t xMask );
 #else
 #define portYIELD_FROM_ISR(...)                     CHOOSE_MACRO_VA_ARG(portYIELD_FROM_ISR_CHECK, portYIELD_FROM_ISR_NO_CHECK, ##__VA_ARGS__)(__VA_ARGS__)
 #endif
-// Note that the Linux port does not provide portYIELD_CORE(x) because purely single core for now.
+#if ( configNUMBER_OF_CORES > 1 )
+#define portYIELD_CORE(x)                           vPortYieldCore(x)
+#endif /* configNUMBER_OF_CORES > 1 */
 
 // ----------------------- System --------------------------
 
@@ -218,18 +236,20 @@ extern unsigned long ulPortGetRunTime( void );
 
 // ---------------------- Yielding -------------------------
 
-// NOTE: vPortYieldCore( BaseType_t xCoreID ) is currently not implemented as the simulator is single core
-
 // ----------------------- System --------------------------
 /**
  * @brief Get the current core's ID
  *
- * @note dummy function for freertos simulator, always returns 0.
- @ return BaseType_t 0
+ * @note With several simulated cores, this is the core on which the calling thread currently runs a task.
+ * @return BaseType_t Core ID, always 0 with a single simulated core
  */
 static inline BaseType_t xPortGetCoreID(void)
 {
-    return (BaseType_t) 0; // POSIX simulator is only single-core at the moment
+#if ( configNUMBER_OF_CORES > 1 )
+    return (BaseType_t) port_uxCoreID;
+#else
+    return (BaseType_t) 0;
+#endif
 }
 
 /* ------------------------------------------------ IDF Compatibility --------------------------------------------------
@@ -265,22 +285,28 @@ static inline void vPortAssertIfInISR(void)
 
 // ------------------ Critical Sections --------------------
 
-void vPortEnterCriticalIDF(void);
-void vPortExitCriticalIDF(void);
+BaseType_t xPortEnterCriticalTimeout(portMUX_TYPE *lock, BaseType_t timeout);
+
+static inline void vPortEnterCriticalIDF(portMUX_TYPE *lock)
+{
+    xPortEnterCriticalTimeout(lock, portMUX_NO_TIMEOUT);
+}
 
-// We ignore the lock and timeout argument on POSIX simulator since it is single core
+void vPortExitCriticalIDF(portMUX_TYPE *lock);
+
+// The lock is only taken with several simulated cores, otherwise the spinlock functions are stubs
 
 //IDF task critical sections
-#define portTRY_ENTER_CRITICAL(lock, timeout)       ({(void) lock; (void) timeout; vPortEnterCriticalIDF(); pdPASS;})
-#define portENTER_CRITICAL_IDF(lock)                ({(void) lock; vPortEnterCriticalIDF();})
-#define portEXIT_CRITICAL_IDF(lock)                 ({(void) lock; vPortExitCriticalIDF();})
+#define portTRY_ENTER_CRITICAL(lock, timeout)       xPortEnterCriticalTimeout(lock, timeout)
+#define portENTER_CRITICAL_IDF(lock)                vPortEnterCriticalIDF(lock)
+#define portEXIT_CRITICAL_IDF(lock)                 vPortExitCriticalIDF(lock)
 //IDF ISR critical sections
-#define portTRY_ENTER_CRITICAL_ISR(lock, timeout)   ({(void) lock; (void) timeout; vPortEnterCriticalIDF(); pdPASS;})
-#define portENTER_CRITICAL_ISR(lock)                ({(void) lock; vPortEnterCriticalIDF();})
-#define portEXIT_CRITICAL_ISR(lock)                 ({(void) lock; vPortExitCriticalIDF();})
+#define portTRY_ENTER_CRITICAL_ISR(lock, timeout)   xPortEnterCriticalTimeout(lock, timeout)
+#define portENTER_CRITICAL_ISR(lock)                vPortEnterCriticalIDF(lock)
+#define portEXIT_CRITICAL_ISR(lock)                 vPortExitCriticalIDF(lock)
 //IDF safe critical sections (they're the same)
-#define portENTER_CRITICAL_SAFE(lock)               ({(void) lock; vPortEnterCriticalIDF();})
-#define portEXIT_CRITICAL_SAFE(lock)                ({(void) lock; vPortExitCriticalIDF();})
+#define portENTER_CRITICAL_SAFE(lock)               vPortEnterCriticalIDF(lock)
+#define portEXIT_CRITICAL_SAFE(lock)                vPortExitCriticalIDF(lock)
 
 // ---------------------- Yielding -------------------------
 
@@ -307,10 +333,15 @@ extern void vPortCancelThread( void *pxTaskToDelete );
  * are always a full memory barrier. ISRs are emulated as signals
  * which also imply a full memory barrier.
  *
- * Thus, only a compiler barrier is needed to prevent the compiler
- * reordering.
+ * Thus, with a single simulated core, only a compiler barrier is needed
+ * to prevent the compiler reordering. With several simulated cores, tasks
+ * run in parallel on different host CPUs and a full barrier is required.
  */
+#if ( configNUMBER_OF_CORES > 1 )
+#define portMEMORY_BARRIER() __atomic_thread_fence( __ATOMIC_SEQ_CST )
+#else
 #define portMEMORY_BARRIER() __asm volatile( "" ::: "memory" )
+#endif
 
 #ifdef __cplusplus
 }
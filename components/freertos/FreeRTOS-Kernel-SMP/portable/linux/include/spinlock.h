@@ -1,16 +1,23 @@
 /*
- * SPDX-FileCopyrightText: 2015-2022 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
 
 /*
- * This file provides only very simple stubs to build IDF-based FreeRTOSes which use spinlocks on Linux.
+ * Spinlocks of the Linux simulator.
+ *
+ * With a single simulated core, only one task runs at a time and the spinlocks are simple stubs. With several
+ * simulated cores, tasks run in parallel on their host threads and the spinlocks are real recursive spinlocks owned
+ * by the simulated core that acquired them, just like on the chips.
  */
 #pragma once
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <assert.h>
+#include <sched.h>
+#include "sdkconfig.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -27,13 +34,13 @@ extern "C" {
  * Owner:
  *  - Set to 0 if uninitialized
  *  - Set to portMUX_FREE_VAL when free
- *  - Set to CORE_ID_REGVAL_PRO or CORE_ID_REGVAL_AP when locked
+ *  - Set to SPINLOCK_OWNER_ID() of the owning simulated core when locked
  *  - Any other value indicates corruption
  * Count:
  *  - 0 if unlocked
  *  - Recursive count if locked
  *
- * @note The simulator is single-core, hence, it doesn't have a proper spinlock implementation.
+ * @note With a single simulated core, the spinlock is a stub and the fields are not updated.
  * @note Keep portMUX_INITIALIZER_UNLOCKED in sync with this struct
  */
 typedef struct {
@@ -41,6 +48,73 @@ typedef struct {
     uint32_t count;
 }spinlock_t;
 
+#if CONFIG_FREERTOS_NUMBER_OF_CORES > 1
+
+/**
+ * @brief ID of the simulated core the calling thread runs on
+ *
+ * Maintained by the port whenever a task's thread is resumed on a core. Threads which do not run tasks (e.g., the
+ * main thread) are on core 0.
+ */
+extern __thread volatile uint32_t port_uxCoreID;
+
+/* Owner value of a spinlock held by a simulated core. Core IDs start at 0, which marks an uninitialized spinlock, so
+ * they are offset by one. */
+#define SPINLOCK_OWNER_ID(core_id) ((uint32_t)(core_id) + 1)
+
+/* Number of failed attempts after which a waiting core gives the host CPU away, in case the owner was preempted by the
+ * host scheduler. */
+#define SPINLOCK_SPINS_BEFORE_YIELD 64
+
+static inline void __attribute__((always_inline)) spinlock_initialize(spinlock_t *lock)
+{
+    lock->owner = SPINLOCK_FREE;
+    lock->count = 0;
+}
+
+/**
+ * @brief Acquire the spinlock, recursively if it is already owned by the calling core
+ *
+ * @param lock    spinlock
+ * @param timeout number of attempts, SPINLOCK_WAIT_FOREVER or SPINLOCK_NO_WAIT
+ * @return true if the spinlock was acquired
+ */
+static inline bool __attribute__((always_inline)) spinlock_acquire(spinlock_t *lock, int32_t timeout)
+{
+    const uint32_t owner_id = SPINLOCK_OWNER_ID(port_uxCoreID);
+    const uint32_t owner = __atomic_load_n(&lock->owner, __ATOMIC_RELAXED);
+
+    assert(owner != 0); // The spinlock was not initialized
+    if (owner == owner_id) {
+        lock->count++;
+        return true;
+    }
+
+    for (int32_t attempts = 1; ; attempts++) {
+        uint32_t expected = SPINLOCK_FREE;
+        if (__atomic_compare_exchange_n(&lock->owner, &expected, owner_id, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            break;
+        }
+        if (timeout != SPINLOCK_WAIT_FOREVER && attempts >= timeout) {
+            return false;
+        }
+        if (attempts % SPINLOCK_SPINS_BEFORE_YIELD == 0) {
+            sched_yield();
+        }
+    }
+    lock->count = 1;
+    return true;
+}
+
+static inline void __attribute__((always_inline)) spinlock_release(spinlock_t *lock)
+{
+    if (--lock->count == 0) {
+        __atomic_store_n(&lock->owner, SPINLOCK_FREE, __ATOMIC_RELEASE);
+    }
+}
+
+#else /* CONFIG_FREERTOS_NUMBER_OF_CORES > 1 */
+
 static inline void __attribute__((always_inline)) spinlock_initialize(spinlock_t *lock)
 {
 }
@@ -54,6 +128,8 @@ static inline void __attribute__((always_inline)) spinlock_release(spinlock_t *l
 {
 }
 
+#endif /* CONFIG_FREERTOS_NUMBER_OF_CORES > 1 */
+
 #ifdef __cplusplus
 }
 #endif
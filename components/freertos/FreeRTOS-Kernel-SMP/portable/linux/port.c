@@ -43,6 +43,13 @@
  * The timer interrupt uses SIGALRM and care is taken to ensure that
  * the signal handler runs only on the thread for the current task.
  *
+ * With configNUMBER_OF_CORES > 1, one thread per simulated core runs
+ * a task at any time, so tasks on different cores run truly in parallel
+ * on the host. Each thread knows which core it currently runs on, and the
+ * interrupt mask and nesting counts are thread-local as they are part of
+ * the context of the task. A core is requested to yield by sending
+ * SIG_YIELD_CORE to the thread of the task it is running.
+ *
  * Use of part of the standard C library requires care as some
  * functions can take pthread mutexes internally which can result in
  * deadlocks as the FreeRTOS kernel can switch tasks while they're
@@ -73,17 +80,27 @@
 #include "timers.h"
 #include "utils/wait_for_event.h"
 #include "esp_log.h"
+#if ( configNUMBER_OF_CORES > 1 )
+#include "esp_private/freertos_idf_additions_priv.h"
+#endif
 /*-----------------------------------------------------------*/
 
 #define SIG_RESUME SIGUSR1
+#define SIG_YIELD_CORE SIGUSR2
 
 typedef struct THREAD
 {
     pthread_t pthread;
     TaskFunction_t pxCode;
     void *pvParams;
-    BaseType_t xDying;
+    volatile BaseType_t xDying;
+    TaskHandle_t xTask;                 /* Task of the thread, set once it is dying */
+    volatile BaseType_t xSuspended;     /* Set while the thread waits in prvSuspendSelf() */
+    volatile BaseType_t xExiting;       /* Set once the thread exits on its own */
     struct event *ev;
+#if ( configNUMBER_OF_CORES > 1 )
+    volatile BaseType_t xCoreID;    /* Core to run on, set by the thread which resumes this one */
+#endif
 } Thread_t;
 
 /*
@@ -104,10 +121,23 @@ static sigset_t xAllSignals;
 static sigset_t xSchedulerOriginalSignalMask;
 static pthread_t hMainThread = ( pthread_t )NULL;
 
-// These are saved as part of a thread's state in prvSwitchThread()
-static volatile BaseType_t uxCriticalNestingIDF = 0;    /* Track nesting calls for IDF style critical sections. FreeRTOS critical section nesting is maintained in the TCB. */
-static volatile UBaseType_t uxInterruptNesting = 0;     /* Tracks if we are currently in an interrupt. */
-static volatile BaseType_t uxInterruptLevel = 0;        /* Tracks the current level (i.e., interrupt mask) */
+// These are part of a thread's state, they are kept by the thread while it is suspended in prvSwitchThread()
+static __thread volatile BaseType_t uxCriticalNestingIDF = 0;   /* Track nesting calls for IDF style critical sections. FreeRTOS critical section nesting is maintained in the TCB. */
+static __thread volatile UBaseType_t uxInterruptNesting = 0;    /* Tracks if we are currently in an interrupt. */
+static __thread volatile BaseType_t uxInterruptLevel = 0;       /* Tracks the current level (i.e., interrupt mask) */
+
+#if ( configNUMBER_OF_CORES > 1 )
+__thread volatile uint32_t port_uxCoreID = 0;
+
+/* Number of times each core went through the scheduler, and the counts seen when this thread signaled the other
+ * cores with SIG_YIELD_CORE (bit N of uxYieldCoreWaitMask is set while core N has not yet been waited for). */
+static volatile uint32_t uxCoreSwitchCount[ configNUMBER_OF_CORES ];
+static __thread uint32_t uxYieldCoreSwitchCount[ configNUMBER_OF_CORES ];
+static __thread UBaseType_t uxYieldCoreWaitMask = 0;
+
+/* Upper bound of the time to wait for a signaled core, in host scheduler yields */
+#define portYIELD_CORE_WAIT_ATTEMPTS    1000
+#endif
 /*-----------------------------------------------------------*/
 
 static BaseType_t xSchedulerEnd = pdFALSE;
@@ -121,6 +151,9 @@ static void prvSwitchThread( Thread_t * xThreadToResume,
 static void prvSuspendSelf( Thread_t * thread);
 static void prvResumeThread( Thread_t * xThreadId );
 static void vPortSystemTickHandler( int sig );
+#if ( configNUMBER_OF_CORES > 1 )
+static void vPortYieldCoreHandler( int sig );
+#endif
 static void vPortStartFirstTask( void );
 /*-----------------------------------------------------------*/
 
@@ -155,6 +188,8 @@ StackType_t *pxPortInitialiseStack( StackType_t *pxTopOfStack,
     thread->pxCode = pxCode;
     thread->pvParams = pvParameters;
     thread->xDying = pdFALSE;
+    thread->xSuspended = pdFALSE;
+    thread->xExiting = pdFALSE;
 
     pthread_attr_init( &xThreadAttributes );
     pthread_attr_setstack( &xThreadAttributes, pxEndOfStack, ulStackSize );
@@ -178,10 +213,21 @@ StackType_t *pxPortInitialiseStack( StackType_t *pxTopOfStack,
 
 void vPortStartFirstTask( void )
 {
+#if ( configNUMBER_OF_CORES > 1 )
+    /* Start the first task of each core. */
+    for ( BaseType_t xCoreID = 0; xCoreID < configNUMBER_OF_CORES; xCoreID++ )
+    {
+        Thread_t *pxFirstThread = prvGetThreadFromTask( xTaskGetCurrentTaskHandleForCore( xCoreID ) );
+
+        pxFirstThread->xCoreID = xCoreID;
+        prvResumeThread( pxFirstThread );
+    }
+#else
     Thread_t *pxFirstThread = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
 
     /* Start the first task. */
     prvResumeThread( pxFirstThread );
+#endif
 }
 /*-----------------------------------------------------------*/
 
@@ -211,9 +257,12 @@ BaseType_t xPortStartScheduler( void )
         sigwait( &xSignals, &iSignal );
     }
 
-    /* Cancel the Idle task and free its resources */
+    /* Cancel the Idle task(s) and free their resources */
 #if ( INCLUDE_xTaskGetIdleTaskHandle == 1 )
-    vPortCancelThread( xTaskGetIdleTaskHandle() );
+    for ( BaseType_t xCoreID = 0; xCoreID < configNUMBER_OF_CORES; xCoreID++ )
+    {
+        vPortCancelThread( xTaskGetIdleTaskHandleForCore( xCoreID ) );
+    }
 #endif
 
 #if ( configUSE_TIMERS == 1 )
@@ -269,22 +318,34 @@ static void vPortEnableInterrupts( void )
 }
 /*-----------------------------------------------------------*/
 
-void vPortEnterCriticalIDF( void )
+BaseType_t xPortEnterCriticalTimeout( portMUX_TYPE *lock, BaseType_t timeout )
 {
-    if ( uxCriticalNestingIDF == 0 && uxInterruptLevel == 0)
+    if ( uxCriticalNestingIDF == 0 && uxInterruptLevel == 0 && uxInterruptNesting == 0 )
     {
         vPortDisableInterrupts();
     }
+
+    /* The spinlock is only contended with several simulated cores. */
+    if ( !spinlock_acquire( lock, timeout ) )
+    {
+        if ( uxCriticalNestingIDF == 0 && uxInterruptLevel == 0 && uxInterruptNesting == 0 )
+        {
+            vPortEnableInterrupts();
+        }
+        return pdFAIL;
+    }
     uxCriticalNestingIDF++;
+    return pdPASS;
 }
 /*-----------------------------------------------------------*/
 
-void vPortExitCriticalIDF( void )
+void vPortExitCriticalIDF( portMUX_TYPE *lock )
 {
+    spinlock_release( lock );
     uxCriticalNestingIDF--;
 
     /* If we have reached 0 then re-enable the interrupts. */
-    if( uxCriticalNestingIDF == 0 && uxInterruptLevel == 0)
+    if( uxCriticalNestingIDF == 0 && uxInterruptLevel == 0 && uxInterruptNesting == 0 )
     {
         vPortEnableInterrupts();
     }
@@ -298,7 +359,12 @@ void vPortYieldFromISR( void )
 
     xThreadToSuspend = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
 
+#if ( configNUMBER_OF_CORES > 1 )
+    vTaskSwitchContext( xPortGetCoreID() );
+    __atomic_add_fetch( &uxCoreSwitchCount[ xPortGetCoreID() ], 1, __ATOMIC_RELEASE );
+#else
     vTaskSwitchContext();
+#endif
 
     xThreadToResume = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
 
@@ -306,6 +372,57 @@ void vPortYieldFromISR( void )
 }
 /*-----------------------------------------------------------*/
 
+#if ( configNUMBER_OF_CORES > 1 )
+void vPortYieldCore( BaseType_t xCoreID )
+{
+    /* Called by the kernel with the task and ISR locks held, so the task of the other core cannot change in the
+     * meantime. If that core is busy switching to this task, its thread still has all signals blocked and takes the
+     * interrupt as soon as it has resumed. */
+    Thread_t *pxThread = prvGetThreadFromTask( xTaskGetCurrentTaskHandleForCore( xCoreID ) );
+
+    uxYieldCoreSwitchCount[ xCoreID ] = __atomic_load_n( &uxCoreSwitchCount[ xCoreID ], __ATOMIC_ACQUIRE );
+    uxYieldCoreWaitMask |= ( 1U << xCoreID );
+    (void)pthread_kill( pxThread->pthread, SIG_YIELD_CORE );
+}
+/*-----------------------------------------------------------*/
+
+static void prvWaitForYieldedCores( void )
+{
+    /* Host threads may wait a long time for a CPU, while the interrupt takes effect right away on the chips. Let the
+     * signaled cores run their scheduler before going on, so that the kernel state seen afterwards (e.g., by
+     * eTaskGetState()) is the same as on the chips. The wait is bounded, as a signaled core may be busy in a critical
+     * section for a while. */
+    for ( BaseType_t xCoreID = 0; xCoreID < configNUMBER_OF_CORES; xCoreID++ )
+    {
+        if ( ( uxYieldCoreWaitMask & ( 1U << xCoreID ) ) == 0 )
+        {
+            continue;
+        }
+        for ( int i = 0; i < portYIELD_CORE_WAIT_ATTEMPTS; i++ )
+        {
+            if ( __atomic_load_n( &uxCoreSwitchCount[ xCoreID ], __ATOMIC_ACQUIRE ) != uxYieldCoreSwitchCount[ xCoreID ] )
+            {
+                break;
+            }
+            sched_yield();
+        }
+    }
+    uxYieldCoreWaitMask = 0;
+}
+/*-----------------------------------------------------------*/
+
+static void vPortYieldCoreHandler( int sig )
+{
+    uxInterruptNesting++;
+
+    /* The thread may have moved to another core since the signal was sent, then the switch is merely spurious. */
+    vPortYieldFromISR();
+
+    uxInterruptNesting--;
+}
+/*-----------------------------------------------------------*/
+#endif /* configNUMBER_OF_CORES > 1 */
+
 void vPortYield( void )
 {
     BaseType_t prev_intr_level = xPortSetInterruptMask();
@@ -318,11 +435,12 @@ void vPortYield( void )
 
 /* In SMP code, the disable/enable interrupt macros are calling the set/get interrupt mask functions below.
    Hence, we need to call vPortDisableInterrupts() and vPortEnableInterrupts(), otherwise interrupts
-   are never disabled/enabled. */
+   are never disabled/enabled. Signal handlers run with all signals blocked, and the signal mask is
+   restored when they return, so it is left alone inside an ISR. */
 
 BaseType_t xPortSetInterruptMask( void )
 {
-    if (uxInterruptLevel == 0 && uxCriticalNestingIDF == 0) {
+    if (uxInterruptLevel == 0 && uxCriticalNestingIDF == 0 && uxInterruptNesting == 0) {
         vPortDisableInterrupts();
     }
     BaseType_t prev_intr_level = uxInterruptLevel;
@@ -335,7 +453,7 @@ void vPortClearInterruptMask( BaseType_t xMask )
 {
     // Only re-enable interrupts if xMask is 0
     uxInterruptLevel = xMask;
-    if (uxInterruptLevel == 0 && uxCriticalNestingIDF == 0) {
+    if (uxInterruptLevel == 0 && uxCriticalNestingIDF == 0 && uxInterruptNesting == 0) {
         vPortEnableInterrupts();
     }
 }
@@ -395,6 +513,9 @@ static void vPortSystemTickHandler( int sig )
     Thread_t *pxThreadToSuspend;
     Thread_t *pxThreadToResume;
     BaseType_t xSwitchRequired;
+#if ( configNUMBER_OF_CORES > 1 )
+    UBaseType_t uxSavedInterruptStatus;
+#endif
     /* uint64_t xExpectedTicks; */
 
     // Handling a timer signal, so we are currently in an interrupt.
@@ -411,7 +532,15 @@ static void vPortSystemTickHandler( int sig )
  *      xExpectedTicks = (prvGetTimeNs() - prvStartTimeNs)
  *        / (portTICK_RATE_MICROSECONDS * 1000);
  * do { */
+#if ( configNUMBER_OF_CORES > 1 )
+    /* The tick is handled by whichever core takes the signal, other cores may be accessing the kernel
+     * at the same time */
+    uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+    xSwitchRequired = xTaskIncrementTick();
+    taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
+#else
     xSwitchRequired = xTaskIncrementTick();
+#endif
 /*        prvTickCount++;
  *    } while (prvTickCount < xExpectedTicks);
 */
@@ -419,7 +548,12 @@ static void vPortSystemTickHandler( int sig )
 #if ( configUSE_PREEMPTION == 1 )
     if (xSwitchRequired == pdTRUE) {
         /* Select Next Task. */
+#if ( configNUMBER_OF_CORES > 1 )
+        vTaskSwitchContext( xPortGetCoreID() );
+        __atomic_add_fetch( &uxCoreSwitchCount[ xPortGetCoreID() ], 1, __ATOMIC_RELEASE );
+#else
         vTaskSwitchContext();
+#endif
 
         pxThreadToResume = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
 
@@ -438,6 +572,7 @@ void vPortThreadDying( void *pxTaskToDelete, volatile BaseType_t *pxPendYield )
 {
     Thread_t *pxThread = prvGetThreadFromTask( pxTaskToDelete );
 
+    pxThread->xTask = pxTaskToDelete;
     pxThread->xDying = pdTRUE;
 }
 
@@ -446,9 +581,21 @@ void vPortCancelThread( void *pxTaskToDelete )
     Thread_t *pxThreadToCancel = prvGetThreadFromTask( pxTaskToDelete );
 
     /*
-     * The thread has already been suspended so it can be safely cancelled.
+     * The task is not running anymore, but its thread may still be resuming
+     * the next task (e.g., on another core). If it was interrupted in a
+     * cancellation point such as nanosleep(), it is cancelled asynchronously,
+     * so only cancel it once it has been suspended. A dying thread may also
+     * exit by itself once the next task is resumed.
      */
-    pthread_cancel( pxThreadToCancel->pthread );
+    while ( !__atomic_load_n( &pxThreadToCancel->xSuspended, __ATOMIC_ACQUIRE ) &&
+            !__atomic_load_n( &pxThreadToCancel->xExiting, __ATOMIC_ACQUIRE ) )
+    {
+        sched_yield();
+    }
+    if ( !pxThreadToCancel->xExiting )
+    {
+        pthread_cancel( pxThreadToCancel->pthread );
+    }
     pthread_join( pxThreadToCancel->pthread, NULL );
     event_delete( pxThreadToCancel->ev );
 }
@@ -461,11 +608,14 @@ static void *prvWaitForStart( void * pvParams )
     prvSuspendSelf(pxThread);
 
     /* Resumed for the first time, thus this thread didn't previously call
-     * prvSwitchThread(). So we need to initialise the state variables for this
-     * thread. */
-    uxCriticalNestingIDF = 0;
-    uxInterruptNesting = 0;
-    uxInterruptLevel = 0;
+     * prvSwitchThread(). The thread-local state variables are still at their
+     * initial values. */
+#if ( configNUMBER_OF_CORES > 1 )
+    port_uxCoreID = pxThread->xCoreID;
+
+    /* This may be the first task to run on this core */
+    prvStartSchedulerOtherCores();
+#endif
     vPortEnableInterrupts();
 
     /* Call the task's entry point. */
@@ -482,35 +632,51 @@ static void *prvWaitForStart( void * pvParams )
 }
 /*-----------------------------------------------------------*/
 
+static BaseType_t prvIsTaskRunning( TaskHandle_t xTask )
+{
+#if ( configNUMBER_OF_CORES > 1 )
+    /* The task may have been deleted after this thread switched away from it, while another core had already
+     * selected it again. Its thread must then keep running, the task switches away on that core as it is deleted.
+     * A deleted task is never selected again, so it cannot start running after this check. */
+    for ( BaseType_t xCoreID = 0; xCoreID < configNUMBER_OF_CORES; xCoreID++ )
+    {
+        if ( xTaskGetCurrentTaskHandleForCore( xCoreID ) == xTask )
+        {
+            return pdTRUE;
+        }
+    }
+#else
+    (void)xTask;
+#endif
+    return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
 static void prvSwitchThread( Thread_t *pxThreadToResume,
                              Thread_t *pxThreadToSuspend )
 {
-    BaseType_t uxSavedCriticalNestingIDF;
-    BaseType_t uxSavedInterruptNesting;
-    BaseType_t uxSavedInterruptLevel;
-
     if ( pxThreadToSuspend != pxThreadToResume )
     {
         /* It is possible for prvSwitchThread() to be called...
          * - while inside an ISR (i.e., via vPortSystemTickHandler() or vPortYieldFromISR())
          * - while interrupts are disabled or in a critical section (i.e., via vPortYield())
          *
-         * So we need to save the various count variables as part of the thread's context.
-         * They are restored when the pthread switches back. */
-        uxSavedCriticalNestingIDF = uxCriticalNestingIDF;
-        uxSavedInterruptNesting = uxInterruptNesting;
-        uxSavedInterruptLevel = uxInterruptLevel;
-
+         * The various count variables are thread-local, so they stay with the thread's
+         * context until the pthread switches back. */
+#if ( configNUMBER_OF_CORES > 1 )
+        /* The next task takes over this core. This thread may be resumed on another core. */
+        pxThreadToResume->xCoreID = port_uxCoreID;
+#endif
         prvResumeThread( pxThreadToResume );
-        if ( pxThreadToSuspend->xDying )
+        if ( pxThreadToSuspend->xDying && !prvIsTaskRunning( pxThreadToSuspend->xTask ) )
         {
+            __atomic_store_n( &pxThreadToSuspend->xExiting, pdTRUE, __ATOMIC_RELEASE );
             pthread_exit( NULL );
         }
         prvSuspendSelf( pxThreadToSuspend );
-
-        uxCriticalNestingIDF = uxSavedCriticalNestingIDF;
-        uxInterruptNesting = uxSavedInterruptNesting;
-        uxInterruptLevel = uxSavedInterruptLevel;
+#if ( configNUMBER_OF_CORES > 1 )
+        port_uxCoreID = pxThreadToSuspend->xCoreID;
+#endif
     }
 }
 /*-----------------------------------------------------------*/
@@ -530,7 +696,9 @@ static void prvSuspendSelf( Thread_t *thread )
      *
      * - A thread with all signals blocked with pthread_sigmask().
         */
+    __atomic_store_n( &thread->xSuspended, pdTRUE, __ATOMIC_RELEASE );
     event_wait(thread->ev);
+    thread->xSuspended = pdFALSE;
 }
 
 /*-----------------------------------------------------------*/
@@ -547,6 +715,9 @@ static void prvResumeThread( Thread_t *xThreadId )
 static void prvSetupSignalsAndSchedulerPolicy( void )
 {
     struct sigaction sigresume, sigtick;
+#if ( configNUMBER_OF_CORES > 1 )
+    struct sigaction sigyield;
+#endif
     int iRet;
 
     hMainThread = pthread_self();
@@ -588,6 +759,18 @@ static void prvSetupSignalsAndSchedulerPolicy( void )
     {
         prvFatalError( "sigaction", errno );
     }
+
+#if ( configNUMBER_OF_CORES > 1 )
+    sigyield.sa_flags = 0;
+    sigyield.sa_handler = vPortYieldCoreHandler;
+    sigfillset( &sigyield.sa_mask );
+
+    iRet = sigaction( SIG_YIELD_CORE, &sigyield, NULL );
+    if ( iRet )
+    {
+        prvFatalError( "sigaction", errno );
+    }
+#endif
 }
 /*-----------------------------------------------------------*/
 
@@ -645,9 +828,9 @@ int main(int argc, const char **argv)
     BaseType_t res;
 
 #if ( configNUM_CORES > 1 )
-    res = xTaskCreateAffinitySet(&main_task, "main",
-                                 ESP_TASK_MAIN_STACK, NULL,
-                                 ESP_TASK_MAIN_PRIO, ESP_TASK_MAIN_CORE, NULL);
+    res = xTaskCreatePinnedToCore(&main_task, "main",
+                                  ESP_TASK_MAIN_STACK, NULL,
+                                  ESP_TASK_MAIN_PRIO, NULL, ESP_TASK_MAIN_CORE);
 #else
     res = xTaskCreate(&main_task, "main",
                       ESP_TASK_MAIN_STACK, NULL,
@@ -715,6 +898,22 @@ void vApplicationGetIdleTaskMemory( StaticTask_t ** ppxIdleTaskTCBBuffer,
      * configMINIMAL_STACK_SIZE is specified in bytes. */
     *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
 }
+
+#if ( configNUMBER_OF_CORES > 1 )
+/* The passive idle tasks of the other cores need their memory as well. */
+void vApplicationGetPassiveIdleTaskMemory( StaticTask_t ** ppxIdleTaskTCBBuffer,
+                                           StackType_t ** ppxIdleTaskStackBuffer,
+                                           uint32_t * pulIdleTaskStackSize,
+                                           BaseType_t xPassiveIdleTaskIndex )
+{
+    static StaticTask_t xPassiveIdleTaskTCBs[ configNUMBER_OF_CORES - 1 ];
+    static StackType_t uxPassiveIdleTaskStacks[ configNUMBER_OF_CORES - 1 ][ configMINIMAL_STACK_SIZE ];
+
+    *ppxIdleTaskTCBBuffer = &xPassiveIdleTaskTCBs[ xPassiveIdleTaskIndex ];
+    *ppxIdleTaskStackBuffer = uxPassiveIdleTaskStacks[ xPassiveIdleTaskIndex ];
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+#endif // configNUMBER_OF_CORES > 1
 #endif // configSUPPORT_STATIC_ALLOCATION == 1
 /*-----------------------------------------------------------*/
 
@@ -762,6 +961,17 @@ void vPortTakeLock( portMUX_TYPE *lock )
 void vPortReleaseLock( portMUX_TYPE *lock )
 {
     spinlock_release( lock );
+
+#if ( configNUMBER_OF_CORES > 1 )
+    /* A core signaled with SIG_YIELD_CORE can only switch tasks once the kernel locks are free. It may also wait for an
+     * IDF spinlock held by this thread, so do not wait for it while holding one. */
+    if ( uxYieldCoreWaitMask != 0 && uxCriticalNestingIDF == 0 &&
+         port_xTaskLock.owner != SPINLOCK_OWNER_ID( port_uxCoreID ) &&
+         port_xISRLock.owner != SPINLOCK_OWNER_ID( port_uxCoreID ) )
+    {
+        prvWaitForYieldedCores();
+    }
+#endif
 }
 
 #define FREERTOS_SMP_MALLOC_CAPS    (MALLOC_CAP_INTERNAL|MALLOC_CAP_8BIT)
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2022-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2022-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -19,6 +19,10 @@
 #include "esp_task.h"
 #include "spinlock.h"
 
+#if CONFIG_FREERTOS_NUMBER_OF_CORES > 1
+#error "The ESP-IDF FreeRTOS Linux simulator only runs on a single core, enable CONFIG_FREERTOS_SMP to simulate several cores"
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -25,6 +25,7 @@
 #include "task.h"
 #include "utils/wait_for_event.h"
 #include "esp_log.h"
+#include "esp_private/freertos_idf_additions_priv.h"
 
 #define BACKTRACE_PC_ARRAY_SIZE 20
 #define ON_SEGFAULT_MESSAGE "ERROR: Segmentation Fault, here's your backtrace:\n"
@@ -151,6 +152,12 @@ void esp_vApplicationIdleHook(void)
      * because it is the responsibility of the idle task to clean up memory
      * allocated by the kernel to any task that has since deleted itself. */
 
+#if CONFIG_FREERTOS_LINUX_VIRTUAL_TIME
+    if (xTaskVirtualTimeFastForward() == pdTRUE) {
+        // The next delayed task is ready now, no need to wait for the tick
+        return;
+    }
+#endif
 
     usleep( 15000 );
 }
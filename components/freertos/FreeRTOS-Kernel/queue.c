@@ -3419,3 +3419,12 @@ BaseType_t xQueueIsQueueFullFromISR( const QueueHandle_t xQueue )
     }
 
 #endif /* configUSE_QUEUE_SETS */
+/*-----------------------------------------------------------*/
+
+#if ( configINCLUDE_FREERTOS_QUEUE_C_ADDITIONS_H == 1 )
+
+/* ESP-IDF additions to the queue API, which need access to the queue
+ * structure (see `esp_additions/freertos_queue_c_additions.h`). */
+    #include "freertos_queue_c_additions.h"
+
+#endif /* configINCLUDE_FREERTOS_QUEUE_C_ADDITIONS_H == 1 */
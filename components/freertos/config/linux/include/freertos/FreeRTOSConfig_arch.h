@@ -40,6 +40,7 @@
 #define configUSE_NEWLIB_REENTRANT                   0
 
 #define configINCLUDE_FREERTOS_TASK_C_ADDITIONS_H    1
+#define configINCLUDE_FREERTOS_QUEUE_C_ADDITIONS_H   1
 
 /* ----------------------- Memory  ------------------------- */
 
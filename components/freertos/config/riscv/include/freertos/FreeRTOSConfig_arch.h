@@ -54,6 +54,7 @@
 #define configDEINIT_TLS_BLOCK( xTLSBlock )                    _reclaim_reent( &( xTLSBlock ) )
 
 #define configINCLUDE_FREERTOS_TASK_C_ADDITIONS_H    1
+#define configINCLUDE_FREERTOS_QUEUE_C_ADDITIONS_H   1
 
 /* ----------------------- Memory  ------------------------- */
 
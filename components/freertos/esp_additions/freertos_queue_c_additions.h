@@ -0,0 +1,229 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "sdkconfig.h"
+#include "freertos/idf_additions.h"
+
+/**
+ * This file will be included in `queue.c` file, thus, it is treated as a source
+ * file instead of a header file, and must NOT be included by any (other) file.
+ * This file is used to add additional functions to `queue.c`. See the
+ * `esp_additions/include` directory of the headers that expose these `queue.c`
+ * additional API.
+ */
+
+/* ------------------------------------------------- Critical Sections ---------------------------------------------- */
+
+/*
+ * Amazon SMP FreeRTOS uses global critical sections, while IDF FreeRTOS takes
+ * each queue's spinlock.
+ */
+#if CONFIG_FREERTOS_SMP
+    #define queueADDITIONS_ENTER_CRITICAL( pxQueue )    taskENTER_CRITICAL()
+    #define queueADDITIONS_EXIT_CRITICAL( pxQueue )     taskEXIT_CRITICAL()
+#else
+    #define queueADDITIONS_ENTER_CRITICAL( pxQueue )    taskENTER_CRITICAL( &( ( pxQueue )->xQueueLock ) )
+    #define queueADDITIONS_EXIT_CRITICAL( pxQueue )     taskEXIT_CRITICAL( &( ( pxQueue )->xQueueLock ) )
+#endif /* CONFIG_FREERTOS_SMP */
+
+/* -------------------------------------------------- Queue Utilities ----------------------------------------------- */
+
+/*
+ * Copy as many items as there are spaces in the queue, then unblock at most
+ * one waiting receiver per item copied. Must be called in a critical section.
+ *
+ * Returns the number of items copied.
+ */
+static size_t prvSendMultipleToQueue( Queue_t * const pxQueue,
+                                      const int8_t * pcItems,
+                                      size_t xItemCount )
+{
+    size_t xCopied = 0;
+    BaseType_t xYieldRequired = pdFALSE;
+
+    while( ( xCopied < xItemCount ) && ( pxQueue->uxMessagesWaiting < pxQueue->uxLength ) )
+    {
+        traceQUEUE_SEND( pxQueue );
+        ( void ) prvCopyDataToQueue( pxQueue, pcItems, queueSEND_TO_BACK );
+        pcItems += pxQueue->uxItemSize;
+        xCopied++;
+
+        #if ( configUSE_QUEUE_SETS == 1 )
+        {
+            /* A queue set holds one handle per item available in its member
+             * queues, so it is notified for each item. */
+            if( ( pxQueue->pxQueueSetContainer != NULL ) && ( prvNotifyQueueSetContainer( pxQueue ) != pdFALSE ) )
+            {
+                xYieldRequired = pdTRUE;
+            }
+        }
+        #endif /* configUSE_QUEUE_SETS */
+    }
+
+    #if ( configUSE_QUEUE_SETS == 1 )
+        if( pxQueue->pxQueueSetContainer == NULL )
+    #endif /* configUSE_QUEUE_SETS */
+    {
+        for( size_t x = 0; ( x < xCopied ) && ( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToReceive ) ) == pdFALSE ); x++ )
+        {
+            if( xTaskRemoveFromEventList( &( pxQueue->xTasksWaitingToReceive ) ) != pdFALSE )
+            {
+                xYieldRequired = pdTRUE;
+            }
+        }
+    }
+
+    if( xYieldRequired != pdFALSE )
+    {
+        /* Yielding from within the critical section is fine, the kernel takes
+         * care of that. */
+        queueYIELD_IF_USING_PREEMPTION();
+    }
+
+    return xCopied;
+}
+/*----------------------------------------------------------*/
+
+/*
+ * Copy out as many items as are available in the queue, up to xMaxItems, then
+ * unblock at most one waiting sender per item removed. Must be called in a
+ * critical section.
+ *
+ * Returns the number of items copied.
+ */
+static size_t prvReceiveMultipleFromQueue( Queue_t * const pxQueue,
+                                           int8_t * pcBuffer,
+                                           size_t xMaxItems )
+{
+    size_t xCopied = 0;
+    BaseType_t xYieldRequired = pdFALSE;
+
+    while( ( xCopied < xMaxItems ) && ( xCopied < ( size_t ) pxQueue->uxMessagesWaiting ) )
+    {
+        prvCopyDataFromQueue( pxQueue, pcBuffer );
+        traceQUEUE_RECEIVE( pxQueue );
+        pcBuffer += pxQueue->uxItemSize;
+        xCopied++;
+    }
+
+    pxQueue->uxMessagesWaiting -= ( UBaseType_t ) xCopied;
+
+    for( size_t x = 0; ( x < xCopied ) && ( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToSend ) ) == pdFALSE ); x++ )
+    {
+        if( xTaskRemoveFromEventList( &( pxQueue->xTasksWaitingToSend ) ) != pdFALSE )
+        {
+            xYieldRequired = pdTRUE;
+        }
+    }
+
+    if( xYieldRequired != pdFALSE )
+    {
+        queueYIELD_IF_USING_PREEMPTION();
+    }
+
+    return xCopied;
+}
+/*----------------------------------------------------------*/
+
+size_t xQueueSendMultiple( QueueHandle_t xQueue,
+                           const void * pvItems,
+                           size_t xItemCount,
+                           TickType_t xTicksToWait )
+{
+    Queue_t * const pxQueue = xQueue;
+    const int8_t * pcItems = pvItems;
+    size_t xSent = 0;
+    TimeOut_t xTimeOut;
+
+    configASSERT( pxQueue );
+    configASSERT( !( ( pvItems == NULL ) && ( xItemCount != 0 ) ) );
+    /* Semaphores and mutexes have no items to copy */
+    configASSERT( pxQueue->uxItemSize != ( UBaseType_t ) 0U );
+
+    vTaskSetTimeOutState( &xTimeOut );
+
+    for( ; ; )
+    {
+        size_t xCopied;
+
+        queueADDITIONS_ENTER_CRITICAL( pxQueue );
+        {
+            xCopied = prvSendMultipleToQueue( pxQueue, pcItems, xItemCount - xSent );
+        }
+        queueADDITIONS_EXIT_CRITICAL( pxQueue );
+
+        xSent += xCopied;
+        pcItems += xCopied * pxQueue->uxItemSize;
+
+        if( ( xSent == xItemCount ) || ( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) != pdFALSE ) )
+        {
+            break;
+        }
+
+        /* The queue is full. Block until there is space for the next item, the
+         * rest is then copied in a single critical section again. */
+        if( xQueueGenericSend( xQueue, pcItems, xTicksToWait, queueSEND_TO_BACK ) != pdPASS )
+        {
+            break;
+        }
+
+        xSent++;
+        pcItems += pxQueue->uxItemSize;
+
+        if( xSent == xItemCount )
+        {
+            break;
+        }
+    }
+
+    return xSent;
+}
+/*----------------------------------------------------------*/
+
+size_t xQueueReceiveMultiple( QueueHandle_t xQueue,
+                              void * pvBuffer,
+                              size_t xMaxItems,
+                              TickType_t xTicksToWait )
+{
+    Queue_t * const pxQueue = xQueue;
+    int8_t * pcBuffer = pvBuffer;
+    size_t xReceived;
+
+    configASSERT( pxQueue );
+    configASSERT( !( ( pvBuffer == NULL ) && ( xMaxItems != 0 ) ) );
+    /* Semaphores and mutexes have no items to copy */
+    configASSERT( pxQueue->uxItemSize != ( UBaseType_t ) 0U );
+
+    if( xMaxItems == 0 )
+    {
+        return 0;
+    }
+
+    queueADDITIONS_ENTER_CRITICAL( pxQueue );
+    {
+        xReceived = prvReceiveMultipleFromQueue( pxQueue, pcBuffer, xMaxItems );
+    }
+    queueADDITIONS_EXIT_CRITICAL( pxQueue );
+
+    if( ( xReceived == 0 ) && ( xTicksToWait != ( TickType_t ) 0 ) )
+    {
+        /* The queue is empty. Block until an item arrives, then take whatever
+         * else has been sent in the meantime. */
+        if( xQueueReceive( xQueue, pcBuffer, xTicksToWait ) == pdPASS )
+        {
+            xReceived = 1;
+
+            queueADDITIONS_ENTER_CRITICAL( pxQueue );
+            {
+                xReceived += prvReceiveMultipleFromQueue( pxQueue, pcBuffer + pxQueue->uxItemSize, xMaxItems - 1 );
+            }
+            queueADDITIONS_EXIT_CRITICAL( pxQueue );
+        }
+    }
+
+    return xReceived;
+}
+/*----------------------------------------------------------*/
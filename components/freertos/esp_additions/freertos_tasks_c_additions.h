@@ -146,6 +146,52 @@ _Static_assert( tskNO_AFFINITY == ( BaseType_t ) CONFIG_FREERTOS_NO_AFFINITY, "C
 #endif /* ( !CONFIG_FREERTOS_SMP && ( configNUM_CORES > 1 ) ) */
 /*----------------------------------------------------------*/
 
+#if CONFIG_FREERTOS_LINUX_VIRTUAL_TIME
+
+    BaseType_t xTaskVirtualTimeFastForward( void )
+    {
+        BaseType_t xJumped = pdFALSE;
+        UBaseType_t uxPriority;
+
+        vTaskSuspendAll();
+        taskENTER_CRITICAL( &xKernelLock );
+        {
+            /* Only the idle task may be ready, i.e., every other task is
+             * either blocked with a timeout, or blocked/suspended indefinitely. */
+            BaseType_t xOnlyIdleReady = ( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ tskIDLE_PRIORITY ] ) ) <= ( UBaseType_t ) configNUMBER_OF_CORES ) &&
+                                        ( listLIST_IS_EMPTY( &( xPendingReadyList[ portGET_CORE_ID() ] ) ) != pdFALSE ) &&
+                                        ( xPendedTicks == ( TickType_t ) 0U );
+
+            for( uxPriority = tskIDLE_PRIORITY + 1; ( uxPriority <= uxTopReadyPriority ) && ( xOnlyIdleReady != pdFALSE ); uxPriority++ )
+            {
+                xOnlyIdleReady = listLIST_IS_EMPTY( &( pxReadyTasksLists[ uxPriority ] ) );
+            }
+
+            /* Time is not advanced past a tick count overflow, in which case the
+             * next unblock time is only known once the delayed lists are switched
+             * (see taskSWITCH_DELAYED_LISTS()). Real ticks take over in that case. */
+            if( ( xOnlyIdleReady != pdFALSE ) &&
+                ( xNextTaskUnblockTime != portMAX_DELAY ) &&
+                ( xNextTaskUnblockTime > xTickCount ) )
+            {
+                /* Same as vTaskStepTick(): Leave the last tick pending so that
+                 * xTaskIncrementTick() unblocks the delayed tasks when the
+                 * scheduler is resumed. */
+                traceINCREASE_TICK_COUNT( xNextTaskUnblockTime - xTickCount - 1 );
+                xTickCount = xNextTaskUnblockTime - 1;
+                xPendedTicks++;
+                xJumped = pdTRUE;
+            }
+        }
+        taskEXIT_CRITICAL( &xKernelLock );
+        ( void ) xTaskResumeAll();
+
+        return xJumped;
+    }
+
+#endif /* CONFIG_FREERTOS_LINUX_VIRTUAL_TIME */
+/*----------------------------------------------------------*/
+
 /* -------------------------------------------------- Task Creation ------------------------------------------------- */
 
 #if ( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
@@ -189,6 +189,24 @@
 
 #endif /* ( !CONFIG_FREERTOS_SMP && ( configNUM_CORES > 1 ) ) */
 
+/*
+ * Virtual time of the Linux port (CONFIG_FREERTOS_LINUX_VIRTUAL_TIME).
+ *
+ * Called by the idle task. If no task other than the idle task is ready to run,
+ * the tick count is advanced straight to the time at which the next delayed
+ * task unblocks (i.e., the next vTaskDelay() or block time expiry, including
+ * the one of the timer task). The delayed tasks are unblocked in the same
+ * order as they would be by the periodic tick.
+ *
+ * Returns pdTRUE if the tick count has been advanced, in which case the idle
+ * task should not sleep.
+ */
+#if CONFIG_FREERTOS_LINUX_VIRTUAL_TIME
+
+    BaseType_t xTaskVirtualTimeFastForward( void );
+
+#endif /* CONFIG_FREERTOS_LINUX_VIRTUAL_TIME */
+
 /*------------------------------------------------------------------------------
  * TASK UTILITIES (PRIVATE)
  *----------------------------------------------------------------------------*/
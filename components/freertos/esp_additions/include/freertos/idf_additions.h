@@ -246,6 +246,61 @@ uint8_t * pxTaskGetStackStart( TaskHandle_t xTask );
 
 #endif /* CONFIG_FREERTOS_TLSP_DELETION_CALLBACKS */
 
+/* ------------------------------------------------- Queue Utilities ------------------------------------------------ */
+
+/**
+ * @brief Send several items to the back of a queue
+ *
+ * This function is similar to calling xQueueSend() once per item, but copies
+ * as many items as the queue has space for in a single critical section, and
+ * unblocks at most one waiting receiver per item sent (i.e., usually once).
+ * When the queue is full, the calling task blocks until there is space again,
+ * until all items are sent or xTicksToWait expires.
+ *
+ * @note The items are sent in order, but items sent by other tasks or ISRs can
+ * be interleaved with them while the calling task is blocked.
+ * @note This function must not be called from an ISR, and must not be used
+ * with semaphores or mutexes.
+ * @param xQueue The handle to the queue on which the items are to be posted.
+ * @param pvItems Pointer to an array of xItemCount items, each of the item
+ * size the queue was created with.
+ * @param xItemCount The number of items to send.
+ * @param xTicksToWait The maximum amount of time the task should block waiting
+ * for space to become available on the queue.
+ * @return The number of items sent, which is less than xItemCount if the
+ * queue stayed full until xTicksToWait expired.
+ */
+size_t xQueueSendMultiple( QueueHandle_t xQueue,
+                           const void * pvItems,
+                           size_t xItemCount,
+                           TickType_t xTicksToWait );
+
+/**
+ * @brief Receive several items from a queue
+ *
+ * This function is similar to calling xQueueReceive() once per item, but
+ * copies all available items (up to xMaxItems) in a single critical section,
+ * and unblocks at most one waiting sender per item received. If the queue is
+ * empty, the calling task blocks until at least one item is available or
+ * xTicksToWait expires, it does not wait for xMaxItems items.
+ *
+ * @note This function must not be called from an ISR, and must not be used
+ * with semaphores or mutexes.
+ * @param xQueue The handle to the queue from which the items are to be
+ * received.
+ * @param pvBuffer Pointer to the buffer into which the received items are
+ * copied, large enough to hold xMaxItems items.
+ * @param xMaxItems The maximum number of items to receive.
+ * @param xTicksToWait The maximum amount of time the task should block waiting
+ * for an item to receive should the queue be empty.
+ * @return The number of items received, 0 if the queue stayed empty until
+ * xTicksToWait expired.
+ */
+size_t xQueueReceiveMultiple( QueueHandle_t xQueue,
+                              void * pvBuffer,
+                              size_t xMaxItems,
+                              TickType_t xTicksToWait );
+
 /* -------------------------------------------- Creation With Memory Caps ----------------------------------------------
  * Helper functions to create various FreeRTOS objects (e.g., queues, semaphores) with specific memory capabilities
  * (e.g., MALLOC_CAP_INTERNAL).
@@ -0,0 +1,155 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "sdkconfig.h"
+#include <stdio.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/idf_additions.h"
+#include "unity.h"
+
+#define QUEUE_LEN       8
+
+/*
+Test xQueueSendMultiple()/xQueueReceiveMultiple() without blocking
+
+Purpose:
+    - Test that items are sent and received in order, including when the queue storage wraps around
+    - Test that no more items than the queue can hold are sent, and no more than available are received
+
+Procedure:
+    - Send 5 items, then 5 more items without blocking
+    - Receive 3 items, then send 3 more items so that the queue storage wraps around
+    - Receive all items, then try again without blocking
+
+Expected:
+    - Only 3 of the second batch of 5 items are sent as the queue is then full
+    - All items are received in the order they were sent
+    - Nothing is received from the empty queue
+*/
+TEST_CASE("Test xQueueSendMultiple/xQueueReceiveMultiple no blocking", "[freertos]")
+{
+    QueueHandle_t queue = xQueueCreate(QUEUE_LEN, sizeof(uint32_t));
+    TEST_ASSERT_NOT_EQUAL(NULL, queue);
+    uint32_t items[2 * QUEUE_LEN];
+    uint32_t next_expected = 0;
+
+    for (int i = 0; i < 2 * QUEUE_LEN; i++) {
+        items[i] = i;
+    }
+    TEST_ASSERT_EQUAL(5, xQueueSendMultiple(queue, &items[0], 5, 0));
+    TEST_ASSERT_EQUAL(3, xQueueSendMultiple(queue, &items[5], 5, 0));
+    TEST_ASSERT_EQUAL(0, uxQueueSpacesAvailable(queue));
+
+    uint32_t received[2 * QUEUE_LEN];
+    TEST_ASSERT_EQUAL(3, xQueueReceiveMultiple(queue, received, 3, 0));
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL(next_expected++, received[i]);
+    }
+
+    // Items 8 and 9 were not sent, the queue storage now wraps around
+    TEST_ASSERT_EQUAL(3, xQueueSendMultiple(queue, &items[8], 3, 0));
+    TEST_ASSERT_EQUAL(QUEUE_LEN, uxQueueMessagesWaiting(queue));
+
+    TEST_ASSERT_EQUAL(QUEUE_LEN, xQueueReceiveMultiple(queue, received, 2 * QUEUE_LEN, 0));
+    for (int i = 0; i < QUEUE_LEN; i++) {
+        TEST_ASSERT_EQUAL(next_expected++, received[i]);
+    }
+    TEST_ASSERT_EQUAL(0, xQueueReceiveMultiple(queue, received, 2 * QUEUE_LEN, 0));
+
+    vQueueDelete(queue);
+}
+
+typedef struct {
+    QueueHandle_t queue;
+    SemaphoreHandle_t done;
+    size_t count;
+    uint32_t items[2 * QUEUE_LEN];
+} test_multiple_args_t;
+
+static void receiver_task(void *arg)
+{
+    test_multiple_args_t *args = (test_multiple_args_t *)arg;
+
+    args->count = xQueueReceiveMultiple(args->queue, args->items, 2 * QUEUE_LEN, portMAX_DELAY);
+    xSemaphoreGive(args->done);
+    vTaskSuspend(NULL);
+}
+
+static void sender_task(void *arg)
+{
+    test_multiple_args_t *args = (test_multiple_args_t *)arg;
+
+    args->count = xQueueSendMultiple(args->queue, args->items, 2 * QUEUE_LEN, portMAX_DELAY);
+    xSemaphoreGive(args->done);
+    vTaskSuspend(NULL);
+}
+
+/*
+Test xQueueSendMultiple()/xQueueReceiveMultiple() with blocking
+
+Purpose:
+    - Test that a blocked receiver is woken up once and receives the whole batch
+    - Test that a sender blocks on a full queue until all of its items are sent
+
+Procedure:
+    - Create a higher priority task that blocks in xQueueReceiveMultiple(), then send it 4 items at once
+    - Create a higher priority task that sends 2 * QUEUE_LEN items at once, then receive them in several calls
+
+Expected:
+    - The receiving task receives the 4 items in one call
+    - The sending task sends all items, and they are received in order
+*/
+TEST_CASE("Test xQueueSendMultiple/xQueueReceiveMultiple blocking", "[freertos]")
+{
+    test_multiple_args_t args = {
+        .queue = xQueueCreate(QUEUE_LEN, sizeof(uint32_t)),
+        .done = xSemaphoreCreateBinary(),
+    };
+    TEST_ASSERT_NOT_EQUAL(NULL, args.queue);
+    TEST_ASSERT_NOT_EQUAL(NULL, args.done);
+    TaskHandle_t task;
+    uint32_t items[2 * QUEUE_LEN];
+
+    for (int i = 0; i < 2 * QUEUE_LEN; i++) {
+        items[i] = i;
+    }
+
+    // Blocked receiver
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreatePinnedToCore(receiver_task, "rcv", 4096, &args, CONFIG_UNITY_FREERTOS_PRIORITY + 1, &task, 0));
+    vTaskDelay(2);  // Let the receiver block on the empty queue
+    TEST_ASSERT_EQUAL(4, xQueueSendMultiple(args.queue, items, 4, 0));
+    TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(args.done, portMAX_DELAY));
+    TEST_ASSERT_EQUAL(4, args.count);
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL(i, args.items[i]);
+    }
+    vTaskDelete(task);
+
+    // Blocked sender
+    for (int i = 0; i < 2 * QUEUE_LEN; i++) {
+        args.items[i] = i;
+    }
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreatePinnedToCore(sender_task, "snd", 4096, &args, CONFIG_UNITY_FREERTOS_PRIORITY + 1, &task, 0));
+    size_t received = 0;
+    while (received < 2 * QUEUE_LEN) {
+        size_t count = xQueueReceiveMultiple(args.queue, &items[received], 3, pdMS_TO_TICKS(1000));
+        TEST_ASSERT_NOT_EQUAL(0, count);
+        received += count;
+    }
+    TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(args.done, portMAX_DELAY));
+    TEST_ASSERT_EQUAL(2 * QUEUE_LEN, args.count);
+    for (int i = 0; i < 2 * QUEUE_LEN; i++) {
+        TEST_ASSERT_EQUAL(i, items[i]);
+    }
+    vTaskDelete(task);
+
+    vSemaphoreDelete(args.done);
+    vQueueDelete(args.queue);
+}
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2018-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2018-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -32,6 +32,23 @@ int sched_get_priority_min(int policy);
 
 int sched_get_priority_max(int policy);
 
+#if defined(_POSIX_READER_WRITER_LOCKS)
+
+/* Read-write lock kinds (non-portable, compatible with glibc) */
+enum {
+    PTHREAD_RWLOCK_PREFER_READER_NP,                /* Readers get the lock whenever no writer holds it, writers may starve */
+    PTHREAD_RWLOCK_PREFER_WRITER_NP,                /* Same as PTHREAD_RWLOCK_PREFER_READER_NP, as in glibc */
+    PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP,   /* Readers wait while writers are waiting, a recursive read lock can deadlock */
+    PTHREAD_RWLOCK_DEFAULT_NP = PTHREAD_RWLOCK_PREFER_READER_NP
+};
+
+/* Get or set the kind of the read-write locks initialized with the attributes */
+int pthread_rwlockattr_getkind_np(const pthread_rwlockattr_t *attr, int *pref);
+
+int pthread_rwlockattr_setkind_np(pthread_rwlockattr_t *attr, int pref);
+
+#endif // _POSIX_READER_WRITER_LOCKS
+
 #ifdef __cplusplus
 }
 #endif
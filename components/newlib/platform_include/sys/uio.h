@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2018-2021 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2018-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -7,18 +7,33 @@
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
 #include <sys/types.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* lwip/sockets.h skips its own definition of struct iovec when the iovec macro is defined,
+ * and this one is skipped if lwip/sockets.h has already been included */
+#if !defined(iovec) && !defined(LWIP_HDR_SOCKETS_H)
+struct iovec {
+    void  *iov_base;
+    size_t iov_len;
+};
+#define iovec iovec
+#else
 struct iovec;
+#endif
 
-int writev(int s, const struct iovec *iov, int iovcnt);
+ssize_t writev(int fd, const struct iovec *iov, int iovcnt);
 
 ssize_t readv(int fd, const struct iovec *iov, int iovcnt);
 
+ssize_t pwritev(int fd, const struct iovec *iov, int iovcnt, off_t offset);
+
+ssize_t preadv(int fd, const struct iovec *iov, int iovcnt, off_t offset);
+
 #ifdef __cplusplus
 }
 #endif
@@ -6,6 +6,9 @@
 
 #include <sys/lock.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
 #include <sys/reent.h>
 #include "esp_attr.h"
 #include "freertos/FreeRTOS.h"
@@ -36,6 +39,10 @@
  *   is holding the lock at this time.
  * - Race conditions between lock_close & lock_init (for the same lock)
  *   are the responsibility of the caller.
+ * - With CONFIG_LIBC_LOCKS_ADAPTIVE, locks created by lock_init_generic
+ *   are adaptive locks instead, see below. Locks which are FreeRTOS
+ *   mutexes created elsewhere (e.g. the common static locks) keep
+ *   working as before.
  */
 
 #if CONFIG_LIBC_PICOLIBC
@@ -44,6 +51,314 @@ struct __lock __lock___libc_recursive_mutex;
 
 static portMUX_TYPE lock_init_spinlock = portMUX_INITIALIZER_UNLOCKED;
 
+#if CONFIG_LIBC_LOCKS_ADAPTIVE
+/* Notes on adaptive locks:
+ *
+ * - Most libc locks (e.g. FILE locks) are held for a few instructions only, and are rarely contended.
+ *   An adaptive lock is a small descriptor whose owner is set with a compare-and-swap, so acquiring and
+ *   releasing it while it is not contended neither allocates nor calls into FreeRTOS.
+ * - On multi-core targets, a task which finds the lock held spins for a short while before blocking,
+ *   as the owner is likely running on the other core.
+ * - The first time a task has to block, the lock is inflated: a FreeRTOS mutex is created and taken by
+ *   that task, and the current owner hands the lock over to it when releasing the lock. From then on
+ *   the lock is only acquired through that mutex, and behaves exactly like a non-adaptive lock.
+ * - The owner did not take the mutex, so while the lock is being inflated, waiting tasks raise the
+ *   priority of the owner with xTaskPriorityInherit() themselves. The owner drops the inherited
+ *   priority when handing the lock over, the same way as when giving a mutex.
+ * - The _lock_t value of an adaptive lock is the address of its descriptor with bit 0 set, so it can
+ *   be told apart from a FreeRTOS mutex handle.
+ */
+
+#define ADAPTIVE_LOCK_TAG           ((uintptr_t) 1)
+#define LOCK_IS_ADAPTIVE(lock)      (((uintptr_t)(lock) & ADAPTIVE_LOCK_TAG) != 0)
+#define ADAPTIVE_LOCK_FROM(lock)    ((adaptive_lock_t *)((uintptr_t)(lock) & ~ADAPTIVE_LOCK_TAG))
+
+/* Values of adaptive_lock_t::state, other than the handle of the owner task */
+#define ADAPTIVE_LOCK_FREE          ((uintptr_t) 0)
+#define ADAPTIVE_LOCK_PENDING       ((uintptr_t) 1) /* Flag: hand the lock over to the mutex holder when the owner releases it */
+#define ADAPTIVE_LOCK_INFLATED      ((uintptr_t) 2) /* The lock is acquired through its FreeRTOS mutex */
+#define ADAPTIVE_LOCK_OWNER_ISR     ((uintptr_t) 4) /* The lock was acquired from an ISR */
+
+/* Number of times a task checks whether the lock was released before blocking */
+#define ADAPTIVE_LOCK_SPIN_COUNT    200
+
+typedef struct {
+    _Atomic uintptr_t state;            /* ADAPTIVE_LOCK_FREE/INFLATED, or owner (task handle or ADAPTIVE_LOCK_OWNER_ISR) with optional ADAPTIVE_LOCK_PENDING */
+    _Atomic(SemaphoreHandle_t) mutex;   /* Created when the lock is inflated */
+    _Atomic(SemaphoreHandle_t) handover;/* Given by the owner when handing the lock over to the mutex holder, created before the mutex */
+    uint32_t count;                     /* Recursion count, only accessed by the owner */
+    uint8_t mutex_type;                 /* queueQUEUE_TYPE_MUTEX or queueQUEUE_TYPE_RECURSIVE_MUTEX */
+} adaptive_lock_t;
+
+/* Held while raising the priority of the owner of a lock being inflated, so that the owner can't hand the lock
+   over and drop its inherited priority in the meantime */
+static portMUX_TYPE adaptive_lock_inherit_spinlock = portMUX_INITIALIZER_UNLOCKED;
+
+static _lock_t NEWLIB_LOCKS_IRAM_ATTR adaptive_lock_create(uint8_t mutex_type)
+{
+    adaptive_lock_t *alock = pvPortMalloc(sizeof(adaptive_lock_t));
+    if (!alock) {
+        abort(); /* OOM */
+    }
+    atomic_init(&alock->state, ADAPTIVE_LOCK_FREE);
+    atomic_init(&alock->mutex, NULL);
+    atomic_init(&alock->handover, NULL);
+    alock->count = 0;
+    alock->mutex_type = mutex_type;
+    return (_lock_t)((uintptr_t) alock | ADAPTIVE_LOCK_TAG);
+}
+
+static void NEWLIB_LOCKS_IRAM_ATTR adaptive_lock_delete(_lock_t lock)
+{
+    adaptive_lock_t *alock = ADAPTIVE_LOCK_FROM(lock);
+    SemaphoreHandle_t h = atomic_load(&alock->mutex);
+    SemaphoreHandle_t handover = atomic_load(&alock->handover);
+    uintptr_t state = atomic_load(&alock->state);
+
+    configASSERT(state == ADAPTIVE_LOCK_FREE || state == ADAPTIVE_LOCK_INFLATED); /* lock should not be held */
+    if (h) {
+#if (INCLUDE_xSemaphoreGetMutexHolder == 1)
+        configASSERT(xSemaphoreGetMutexHolder(h) == NULL); /* mutex should not be held */
+#endif
+        vSemaphoreDelete(h);
+    }
+    if (handover) {
+        vSemaphoreDelete(handover);
+    }
+    vPortFree(alock);
+}
+
+static inline bool NEWLIB_LOCKS_IRAM_ATTR adaptive_lock_try_set_owner(adaptive_lock_t *alock, uintptr_t owner)
+{
+    uintptr_t expected = ADAPTIVE_LOCK_FREE;
+    return atomic_compare_exchange_strong_explicit(&alock->state, &expected, owner,
+                                                   memory_order_acquire, memory_order_relaxed);
+}
+
+/* Return the mutex of the lock, creating it and the handover semaphore if needed */
+static SemaphoreHandle_t NEWLIB_LOCKS_IRAM_ATTR adaptive_lock_get_mutex(adaptive_lock_t *alock)
+{
+    SemaphoreHandle_t h = atomic_load(&alock->mutex);
+    if (h != NULL) {
+        return h;
+    }
+
+    /* The handover semaphore is published first, so that it exists whenever the mutex does */
+    SemaphoreHandle_t handover = atomic_load(&alock->handover);
+    if (handover == NULL) {
+        SemaphoreHandle_t new_sem = xSemaphoreCreateBinary();
+        if (!new_sem) {
+            abort(); /* No more semaphores available or OOM */
+        }
+        if (!atomic_compare_exchange_strong(&alock->handover, &handover, new_sem)) {
+            vSemaphoreDelete(new_sem); /* another task inflated the lock in the meantime */
+        }
+    }
+
+    SemaphoreHandle_t new_sem = xQueueCreateMutex(alock->mutex_type);
+    if (!new_sem) {
+        abort(); /* No more semaphores available or OOM */
+    }
+    if (atomic_compare_exchange_strong(&alock->mutex, &h, new_sem)) {
+        h = new_sem;
+    } else {
+        vSemaphoreDelete(new_sem); /* another task inflated the lock in the meantime */
+    }
+    return h;
+}
+
+/* If the lock is being handed over to the mutex holder, raise the priority of its current owner to the priority
+   of the calling task, as if the owner held the mutex */
+static void NEWLIB_LOCKS_IRAM_ATTR adaptive_lock_inherit_priority(adaptive_lock_t *alock)
+{
+    portENTER_CRITICAL(&adaptive_lock_inherit_spinlock);
+    uintptr_t state = atomic_load_explicit(&alock->state, memory_order_relaxed);
+    uintptr_t owner = state & ~ADAPTIVE_LOCK_PENDING;
+    /* The owner waits for adaptive_lock_inherit_spinlock when handing the lock over, so it is still valid here */
+    if ((state & ADAPTIVE_LOCK_PENDING) && owner != ADAPTIVE_LOCK_OWNER_ISR) {
+        xTaskPriorityInherit((TaskHandle_t) owner);
+    }
+    portEXIT_CRITICAL(&adaptive_lock_inherit_spinlock);
+}
+
+/* Acquire the lock through its mutex, inflating the lock first if needed. Only called from task context, with an
+   infinite timeout. */
+static void NEWLIB_LOCKS_IRAM_ATTR adaptive_lock_inflate(adaptive_lock_t *alock)
+{
+    SemaphoreHandle_t h = adaptive_lock_get_mutex(alock);
+
+    adaptive_lock_inherit_priority(alock);
+    if (alock->mutex_type == queueQUEUE_TYPE_RECURSIVE_MUTEX) {
+        xSemaphoreTakeRecursive(h, portMAX_DELAY);
+    } else {
+        xSemaphoreTake(h, portMAX_DELAY);
+    }
+
+    /* Only the mutex holder inflates the lock, so the lock is now inflated (and acquired), or free, or held by a
+       task which acquired it without the mutex */
+    while (1) {
+        uintptr_t state = atomic_load_explicit(&alock->state, memory_order_acquire);
+        if (state == ADAPTIVE_LOCK_INFLATED) {
+            return;
+        }
+        if (state == ADAPTIVE_LOCK_FREE) {
+            if (atomic_compare_exchange_strong_explicit(&alock->state, &state, ADAPTIVE_LOCK_INFLATED,
+                                                        memory_order_acquire, memory_order_relaxed)) {
+                return;
+            }
+            continue;
+        }
+        /* Ask the owner to hand the lock over when releasing it, and wait for it */
+        if (atomic_compare_exchange_strong(&alock->state, &state, state | ADAPTIVE_LOCK_PENDING)) {
+            adaptive_lock_inherit_priority(alock);
+            xSemaphoreTake(atomic_load(&alock->handover), portMAX_DELAY);
+        }
+    }
+}
+
+/* Called by the owner after passing the lock to the mutex holder, see adaptive_lock_inflate() */
+static void NEWLIB_LOCKS_IRAM_ATTR adaptive_lock_hand_over(adaptive_lock_t *alock, bool in_isr)
+{
+    SemaphoreHandle_t handover = atomic_load(&alock->handover);
+
+    if (in_isr) {
+        BaseType_t higher_task_woken = false;
+        xSemaphoreGiveFromISR(handover, &higher_task_woken);
+        if (higher_task_woken) {
+            portYIELD_FROM_ISR();
+        }
+        return;
+    }
+
+    /* Wait until the tasks raising our priority are done, then drop the inherited priority. The lock counts as a
+       mutex held until now, so that the priority is kept while other mutexes are held. */
+    portENTER_CRITICAL(&adaptive_lock_inherit_spinlock);
+    portEXIT_CRITICAL(&adaptive_lock_inherit_spinlock);
+    xSemaphoreGive(handover);
+    pvTaskIncrementMutexHeldCount();
+    if (xTaskPriorityDisinherit(xTaskGetCurrentTaskHandle())) {
+        taskYIELD();
+    }
+}
+
+static int NEWLIB_LOCKS_IRAM_ATTR adaptive_lock_acquire(_lock_t lock, uint32_t delay)
+{
+    adaptive_lock_t *alock = ADAPTIVE_LOCK_FROM(lock);
+    BaseType_t success;
+
+    if (!xPortCanYield()) {
+        /* In ISR Context */
+        if (alock->mutex_type == queueQUEUE_TYPE_RECURSIVE_MUTEX) {
+            abort(); /* recursive mutexes make no sense in ISR context */
+        }
+        if (adaptive_lock_try_set_owner(alock, ADAPTIVE_LOCK_OWNER_ISR)) {
+            return 0;
+        }
+        success = pdFALSE;
+        if (atomic_load_explicit(&alock->state, memory_order_acquire) == ADAPTIVE_LOCK_INFLATED) {
+            BaseType_t higher_task_woken = false;
+            success = xSemaphoreTakeFromISR(atomic_load(&alock->mutex), &higher_task_woken);
+            if (higher_task_woken) {
+                portYIELD_FROM_ISR();
+            }
+        }
+        if (!success && delay > 0) {
+            abort(); /* Tried to block on mutex from ISR, couldn't... rewrite your program to avoid libc interactions in ISRs! */
+        }
+        return (success == pdTRUE) ? 0 : -1;
+    }
+
+    /* In task context */
+    uintptr_t self = (uintptr_t) xTaskGetCurrentTaskHandle();
+    uintptr_t state = atomic_load_explicit(&alock->state, memory_order_acquire);
+    if (state != ADAPTIVE_LOCK_INFLATED) {
+        if (alock->mutex_type == queueQUEUE_TYPE_RECURSIVE_MUTEX && (state & ~ADAPTIVE_LOCK_PENDING) == self) {
+            alock->count++;
+            return 0;
+        }
+        if (adaptive_lock_try_set_owner(alock, self)) {
+            alock->count = 1;
+            return 0;
+        }
+        if (delay == 0) {
+            if (atomic_load_explicit(&alock->state, memory_order_acquire) != ADAPTIVE_LOCK_INFLATED) {
+                return -1;
+            }
+        } else {
+#if !CONFIG_FREERTOS_UNICORE
+            /* The owner may be running on another core, give it a chance to release the lock */
+            for (int i = 0; i < ADAPTIVE_LOCK_SPIN_COUNT; i++) {
+                state = atomic_load_explicit(&alock->state, memory_order_relaxed);
+                if (state == ADAPTIVE_LOCK_INFLATED) {
+                    break;
+                }
+                if (state == ADAPTIVE_LOCK_FREE && adaptive_lock_try_set_owner(alock, self)) {
+                    alock->count = 1;
+                    return 0;
+                }
+            }
+#endif
+            adaptive_lock_inflate(alock);
+            return 0;
+        }
+    }
+
+    /* The lock is inflated */
+    if (alock->mutex_type == queueQUEUE_TYPE_RECURSIVE_MUTEX) {
+        success = xSemaphoreTakeRecursive(atomic_load(&alock->mutex), delay);
+    } else {
+        success = xSemaphoreTake(atomic_load(&alock->mutex), delay);
+    }
+    return (success == pdTRUE) ? 0 : -1;
+}
+
+static void NEWLIB_LOCKS_IRAM_ATTR adaptive_lock_release(_lock_t lock)
+{
+    adaptive_lock_t *alock = ADAPTIVE_LOCK_FROM(lock);
+    bool in_isr = !xPortCanYield();
+
+    if (in_isr && alock->mutex_type == queueQUEUE_TYPE_RECURSIVE_MUTEX) {
+        abort(); /* indicates logic bug, it shouldn't be possible to lock recursively in ISR */
+    }
+
+    uintptr_t state = atomic_load_explicit(&alock->state, memory_order_acquire);
+    if (state == ADAPTIVE_LOCK_INFLATED) {
+        SemaphoreHandle_t h = atomic_load(&alock->mutex);
+        if (in_isr) {
+            BaseType_t higher_task_woken = false;
+            xSemaphoreGiveFromISR(h, &higher_task_woken);
+            if (higher_task_woken) {
+                portYIELD_FROM_ISR();
+            }
+        } else if (alock->mutex_type == queueQUEUE_TYPE_RECURSIVE_MUTEX) {
+            xSemaphoreGiveRecursive(h);
+        } else {
+            xSemaphoreGive(h);
+        }
+        return;
+    }
+
+    uintptr_t self = in_isr ? ADAPTIVE_LOCK_OWNER_ISR : (uintptr_t) xTaskGetCurrentTaskHandle();
+    if ((state & ~ADAPTIVE_LOCK_PENDING) != self) {
+        return; /* not the owner, same as giving a mutex which is not held */
+    }
+    if (!in_isr && --alock->count > 0) {
+        return;
+    }
+    /* Only the PENDING flag can be set concurrently, by the task holding the mutex. If it is set, the lock is passed
+       to that task. */
+    while (!atomic_compare_exchange_weak_explicit(&alock->state, &state,
+                                                  (state & ADAPTIVE_LOCK_PENDING) ? ADAPTIVE_LOCK_INFLATED : ADAPTIVE_LOCK_FREE,
+                                                  memory_order_release, memory_order_relaxed)) {
+    }
+    if (state & ADAPTIVE_LOCK_PENDING) {
+        adaptive_lock_hand_over(alock, in_isr);
+    }
+}
+#else
+#define LOCK_IS_ADAPTIVE(lock)      false
+#endif // CONFIG_LIBC_LOCKS_ADAPTIVE
+
 /* Initialize the given lock by allocating a new mutex semaphore
    as the _lock_t value.
 
@@ -72,11 +387,15 @@ static void NEWLIB_LOCKS_IRAM_ATTR lock_init_generic(_lock_t *lock, uint8_t mute
            without writing wrappers. Doing it this way seems much less
            spaghetti-like.
         */
+#if CONFIG_LIBC_LOCKS_ADAPTIVE
+        *lock = adaptive_lock_create(mutex_type);
+#else
         SemaphoreHandle_t new_sem = xQueueCreateMutex(mutex_type);
         if (!new_sem) {
             abort(); /* No more semaphores available or OOM */
         }
         *lock = (_lock_t)new_sem;
+#endif
     }
     portEXIT_CRITICAL(&lock_init_spinlock);
 }
@@ -106,6 +425,12 @@ void NEWLIB_LOCKS_IRAM_ATTR _lock_init_recursive(_lock_t *lock)
 void NEWLIB_LOCKS_IRAM_ATTR _lock_close(_lock_t *lock)
 {
     portENTER_CRITICAL(&lock_init_spinlock);
+#if CONFIG_LIBC_LOCKS_ADAPTIVE
+    if (*lock && LOCK_IS_ADAPTIVE(*lock)) {
+        adaptive_lock_delete(*lock);
+        *lock = 0;
+    }
+#endif
     if (*lock) {
         SemaphoreHandle_t h = (SemaphoreHandle_t)(*lock);
 #if (INCLUDE_xSemaphoreGetMutexHolder == 1)
@@ -138,6 +463,11 @@ static int NEWLIB_LOCKS_IRAM_ATTR lock_acquire_generic(_lock_t *lock, uint32_t d
     if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) {
         return 0; /* locking is a no-op before scheduler is up, so this "succeeds" */
     }
+#if CONFIG_LIBC_LOCKS_ADAPTIVE
+    if (LOCK_IS_ADAPTIVE(h)) {
+        return adaptive_lock_acquire(*lock, delay);
+    }
+#endif
     BaseType_t success;
     if (!xPortCanYield()) {
         /* In ISR Context */
@@ -195,6 +525,12 @@ static void NEWLIB_LOCKS_IRAM_ATTR lock_release_generic(_lock_t *lock, uint8_t m
     SemaphoreHandle_t h = (SemaphoreHandle_t)(*lock);
     assert(h);
 
+#if CONFIG_LIBC_LOCKS_ADAPTIVE
+    if (LOCK_IS_ADAPTIVE(h)) {
+        adaptive_lock_release(*lock);
+        return;
+    }
+#endif
     if (!xPortCanYield()) {
         if (mutex_type == queueQUEUE_TYPE_RECURSIVE_MUTEX) {
             abort(); /* indicates logic bug, it shouldn't be possible to lock recursively in ISR */
@@ -282,9 +618,16 @@ static StaticSemaphore_t s_common_recursive_mutex;
 
 #ifdef ROM_NEEDS_MUTEX_OVERRIDE
 #define ROM_MUTEX_MAGIC  0xbb10c433
+/* The _LOCK_T value is the lock handle itself. An adaptive lock handle is a tagged pointer which is not aligned,
+   so it is told apart before the magic value is read from the lock. */
+static inline bool NEWLIB_LOCKS_IRAM_ATTR lock_is_rom_mutex(_LOCK_T lock)
+{
+    return !LOCK_IS_ADAPTIVE((_lock_t) lock) && *(int *) lock == ROM_MUTEX_MAGIC;
+}
+
 /* This is a macro, since we are overwriting the argument  */
 #define MAYBE_OVERRIDE_LOCK(_lock, _lock_to_use_instead) \
-    if (*(int*)_lock == ROM_MUTEX_MAGIC) { \
+    if (lock_is_rom_mutex(_lock)) { \
         (_lock) = (_LOCK_T) (_lock_to_use_instead); \
     }
 #else  // ROM_NEEDS_MUTEX_OVERRIDE
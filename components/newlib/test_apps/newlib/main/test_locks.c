@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2022-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Unlicense OR CC0-1.0
  */
@@ -13,6 +13,7 @@
 #include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "esp_timer.h"
 
 #if defined(_RETARGETABLE_LOCKING)
 
@@ -112,3 +113,149 @@ TEST_CASE("Retargetable dynamic recursive locks", "[newlib_locks]")
 }
 
 #endif // _RETARGETABLE_LOCKING
+
+#if CONFIG_LIBC_LOCKS_ADAPTIVE
+
+static void adaptive_locking_task(void* arg)
+{
+    _lock_t *lock = (_lock_t *) arg;
+    _lock_acquire(lock);
+    _lock_release(lock);
+    vTaskSuspend(NULL);
+}
+
+TEST_CASE("Adaptive locks inherit priority from the first contention", "[newlib_locks]")
+{
+    _lock_t lock;
+    TaskHandle_t task_hdl;
+    _lock_init(&lock);
+
+    /* Not contended */
+    _lock_acquire(&lock);
+    TEST_ASSERT_EQUAL(-1, _lock_try_acquire(&lock));
+    _lock_release(&lock);
+
+    /* First contention, the waiting task raises the priority of the owner, and gets the lock once it is released */
+    _lock_acquire(&lock);
+    TEST_ASSERT(xTaskCreate(&adaptive_locking_task, "locking_task", 2048, &lock, UNITY_FREERTOS_PRIORITY + 1, &task_hdl));
+    vTaskDelay(2);
+    TEST_ASSERT_EQUAL(eBlocked, eTaskGetState(task_hdl));
+    TEST_ASSERT_EQUAL(UNITY_FREERTOS_PRIORITY + 1, uxTaskPriorityGet(NULL));
+    _lock_release(&lock);
+    TEST_ASSERT_EQUAL(UNITY_FREERTOS_PRIORITY, uxTaskPriorityGet(NULL));
+    vTaskDelay(2);
+    TEST_ASSERT_EQUAL(eSuspended, eTaskGetState(task_hdl));
+    vTaskDelete(task_hdl);
+
+    /* The lock is now inflated, a higher priority task waiting for it still raises the priority of the owner */
+    _lock_acquire(&lock);
+    TEST_ASSERT(xTaskCreate(&adaptive_locking_task, "locking_task", 2048, &lock, UNITY_FREERTOS_PRIORITY + 1, &task_hdl));
+    vTaskDelay(2);
+    TEST_ASSERT_EQUAL(eBlocked, eTaskGetState(task_hdl));
+    TEST_ASSERT_EQUAL(UNITY_FREERTOS_PRIORITY + 1, uxTaskPriorityGet(NULL));
+    _lock_release(&lock);
+    TEST_ASSERT_EQUAL(UNITY_FREERTOS_PRIORITY, uxTaskPriorityGet(NULL));
+    vTaskDelay(2);
+    TEST_ASSERT_EQUAL(eSuspended, eTaskGetState(task_hdl));
+    vTaskDelete(task_hdl);
+
+    _lock_close(&lock);
+}
+
+TEST_CASE("Adaptive recursive locks", "[newlib_locks]")
+{
+    _lock_t lock;
+    _lock_init_recursive(&lock);
+
+    TEST_ASSERT_EQUAL(0, _lock_try_acquire_recursive(&lock));
+    TEST_ASSERT_EQUAL(0, _lock_try_acquire_recursive(&lock));
+    _lock_release_recursive(&lock);
+    _lock_release_recursive(&lock);
+
+    _lock_close_recursive(&lock);
+}
+
+#endif // CONFIG_LIBC_LOCKS_ADAPTIVE
+
+#define STDIO_PERF_MAX_TASKS    4
+#define STDIO_PERF_ITERATIONS   10000
+
+typedef struct {
+    FILE *stream;
+    SemaphoreHandle_t done;
+} stdio_perf_args_t;
+
+static void stdio_perf_task(void *arg)
+{
+    stdio_perf_args_t *args = (stdio_perf_args_t *) arg;
+
+    for (int i = 0; i < STDIO_PERF_ITERATIONS; i++) {
+        fputc('x', args->stream);
+        if (i % 256 == 255) {
+            fseek(args->stream, 0, SEEK_SET); /* don't let the stream grow */
+        }
+    }
+    xSemaphoreGive(args->done);
+    vTaskSuspend(NULL);
+}
+
+static void stdio_perf_run(int task_num, bool shared_stream)
+{
+    FILE *streams[STDIO_PERF_MAX_TASKS];
+    char *bufs[STDIO_PERF_MAX_TASKS];
+    size_t lens[STDIO_PERF_MAX_TASKS];
+    stdio_perf_args_t args[STDIO_PERF_MAX_TASKS];
+    TaskHandle_t tasks[STDIO_PERF_MAX_TASKS];
+    SemaphoreHandle_t done = xSemaphoreCreateCounting(STDIO_PERF_MAX_TASKS, 0);
+    TEST_ASSERT_NOT_NULL(done);
+
+    int stream_num = shared_stream ? 1 : task_num;
+    for (int i = 0; i < stream_num; i++) {
+        streams[i] = open_memstream(&bufs[i], &lens[i]);
+        TEST_ASSERT_NOT_NULL(streams[i]);
+    }
+
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < task_num; i++) {
+        args[i].stream = streams[shared_stream ? 0 : i];
+        args[i].done = done;
+        TEST_ASSERT(xTaskCreate(&stdio_perf_task, "stdio_perf", 3072, &args[i], UNITY_FREERTOS_PRIORITY - 1, &tasks[i]));
+    }
+    for (int i = 0; i < task_num; i++) {
+        TEST_ASSERT(xSemaphoreTake(done, portMAX_DELAY));
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start;
+
+    for (int i = 0; i < task_num; i++) {
+        vTaskDelete(tasks[i]);
+    }
+    for (int i = 0; i < stream_num; i++) {
+        fclose(streams[i]);
+        free(bufs[i]);
+    }
+    vSemaphoreDelete(done);
+
+    int64_t ops = (int64_t) task_num * STDIO_PERF_ITERATIONS;
+    printf("%d task(s), %s stream: %lld fputc() calls in %lld us (%lld calls/s)\n", task_num,
+           shared_stream ? "shared" : "own", ops, elapsed_us, ops * 1000000 / (elapsed_us ? elapsed_us : 1));
+}
+
+/*
+Benchmark stdio under contention
+
+Procedure:
+    - 1, 2 and 4 tasks call fputc() STDIO_PERF_ITERATIONS times each, on one stream shared by all tasks, then on
+      one stream per task
+
+Expected:
+    - All tasks finish, the number of fputc() calls per second is printed for each workload
+*/
+TEST_CASE("Lock contention of stdio streams", "[newlib_locks]")
+{
+    for (int task_num = 1; task_num <= STDIO_PERF_MAX_TASKS; task_num *= 2) {
+        stdio_perf_run(task_num, true);
+        if (task_num > 1) {
+            stdio_perf_run(task_num, false);
+        }
+    }
+}
@@ -33,6 +33,14 @@ public:
 
     esp_err_t write(size_t dst_offset, const void* src, size_t size) override;
 
+    /**
+     * The mapped content is encrypted, data has to be read by read().
+     */
+    const uint8_t *get_mmap_ptr() override
+    {
+        return nullptr;
+    }
+
 protected:
     mbedtls_aes_xts_context mEctxt;
     mbedtls_aes_xts_context mDctxt;
@@ -263,9 +263,14 @@ esp_err_t Page::readVariableLengthItemData(const Item& item, const size_t index,
     }
 
     esp_err_t rc;
+    const uint8_t* mapped = mappedItemData(item, index);
+    if (mapped != nullptr) {
+        // data entries of the item are contiguous, copy them at once
+        memcpy(data, mapped, item.varLength.dataSize);
+    }
     uint8_t* dst = reinterpret_cast<uint8_t*>(data);
-    size_t left = item.varLength.dataSize;
-    for (size_t i = index + 1; i < index + item.span; ++i) {
+    size_t left = mapped ? 0 : item.varLength.dataSize;
+    for (size_t i = index + 1; left > 0 && i < index + item.span; ++i) {
         Item ditem;
         rc = readEntry(i, ditem);
         if (rc != ESP_OK) {
@@ -287,6 +292,20 @@ esp_err_t Page::readVariableLengthItemData(const Item& item, const size_t index,
     return ESP_OK;
 }
 
+const uint8_t* Page::mappedItemData(const Item& item, const size_t index) const
+{
+    const uint8_t* mapped = mPartition->get_mmap_ptr();
+    if (mapped == nullptr || item.span < 2 || index + item.span > ENTRY_COUNT
+            || item.varLength.dataSize > (item.span - 1) * ENTRY_SIZE) {
+        return nullptr;
+    }
+    uint32_t phyAddr;
+    if (getEntryAddress(index + 1, &phyAddr) != ESP_OK) {
+        return nullptr;
+    }
+    return mapped + phyAddr;
+}
+
 esp_err_t Page::readItem(uint8_t nsIndex, ItemType datatype, const char* key, void* data, size_t dataSize, uint8_t chunkIdx, VerOffset chunkStart)
 {
     size_t index = 0;
@@ -357,6 +376,17 @@ esp_err_t Page::cmpItem(uint8_t nsIndex, ItemType datatype, const char* key, con
         return ESP_ERR_NVS_CONTENT_DIFFERS;
     }
 
+    const uint8_t* mapped = mappedItemData(item, index);
+    if (mapped != nullptr) {
+        if (memcmp(data, mapped, item.varLength.dataSize)) {
+            return ESP_ERR_NVS_CONTENT_DIFFERS;
+        }
+        if (Item::calculateCrc32(mapped, item.varLength.dataSize) != item.varLength.dataCrc32) {
+            return ESP_ERR_NVS_CONTENT_DIFFERS;
+        }
+        return ESP_OK;
+    }
+
     const uint8_t* dst = reinterpret_cast<const uint8_t*>(data);
     size_t left = item.varLength.dataSize;
     uint32_t accumulatedCRC32;
@@ -188,6 +188,9 @@ protected:
 
     esp_err_t readEntry(size_t index, Item& dst) const;
 
+    // data of the variable length item at index in the partition mapping, nullptr if not mapped
+    const uint8_t* mappedItemData(const Item& item, const size_t index) const;
+
     esp_err_t writeEntry(const Item& item);
 
     esp_err_t writeEntryData(const uint8_t* data, size_t size);
@@ -5,6 +5,8 @@
  */
 
 #include <cstdlib>
+#include <cstring>
+#include "sdkconfig.h"
 #include "nvs_partition.hpp"
 
 namespace nvs {
@@ -16,6 +18,15 @@ NVSPartition::NVSPartition(const esp_partition_t* partition)
     if (partition == nullptr) {
         std::abort();
     }
+#if CONFIG_NVS_MMAP_READ
+    // not fatal, reads fall back to esp_partition_read
+    mmap_read_only();
+#endif
+}
+
+NVSPartition::~NVSPartition()
+{
+    munmap();
 }
 
 const char *NVSPartition::get_partition_name()
@@ -25,6 +36,13 @@ const char *NVSPartition::get_partition_name()
 
 esp_err_t NVSPartition::read_raw(size_t src_offset, void* dst, size_t size)
 {
+    if (mMmapPtr != nullptr) {
+        if (src_offset > mESPPartition->size || size > mESPPartition->size - src_offset) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        memcpy(dst, mMmapPtr + src_offset, size);
+        return ESP_OK;
+    }
     return esp_partition_read_raw(mESPPartition, src_offset, dst, size);
 }
 
@@ -34,6 +52,9 @@ esp_err_t NVSPartition::read(size_t src_offset, void* dst, size_t size)
         return ESP_ERR_INVALID_ARG;
     }
 
+    if (mMmapPtr != nullptr) {
+        return read_raw(src_offset, dst, size);
+    }
     return esp_partition_read(mESPPartition, src_offset, dst, size);
 }
 
@@ -71,4 +92,35 @@ bool NVSPartition::get_readonly()
     return mESPPartition->readonly;
 }
 
+esp_err_t NVSPartition::mmap_read_only()
+{
+    if (mMmapPtr != nullptr) {
+        return ESP_OK;
+    }
+    // the mapping would return decrypted data, while esp_partition_read_raw must not decrypt
+    if (mESPPartition->encrypted) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    const void *ptr;
+    esp_err_t err = esp_partition_mmap(mESPPartition, 0, mESPPartition->size, ESP_PARTITION_MMAP_DATA, &ptr, &mMmapHandle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    mMmapPtr = static_cast<const uint8_t *>(ptr);
+    return ESP_OK;
+}
+
+void NVSPartition::munmap()
+{
+    if (mMmapPtr != nullptr) {
+        esp_partition_munmap(mMmapHandle);
+        mMmapPtr = nullptr;
+    }
+}
+
+const uint8_t *NVSPartition::get_mmap_ptr()
+{
+    return mMmapPtr;
+}
+
 } // nvs
@@ -38,7 +38,7 @@ public:
      * No need to de-initialize mESPPartition here, if you used esp_partition_find_first.
      * Otherwise, the user is responsible for de-initializing it.
      */
-    virtual ~NVSPartition() { }
+    virtual ~NVSPartition();
 
     const char *get_partition_name() override;
 
@@ -104,8 +104,30 @@ public:
      */
     bool get_readonly() override;
 
+    /**
+     * Map the whole partition into the data address space, read-only.
+     *
+     * Reads are then served from the mapping instead of calling \c esp_partition_read, and
+     * variable length items are copied at once. Called by the constructor if CONFIG_NVS_MMAP_READ is enabled.
+     *
+     * @return
+     *      - ESP_OK on success, or if the partition is already mapped
+     *      - ESP_ERR_NOT_SUPPORTED if the partition is encrypted by flash encryption
+     *      - other error codes from \c esp_partition_mmap, e.g. if there are not enough free MMU pages
+     */
+    esp_err_t mmap_read_only();
+
+    /**
+     * Release the mapping made by \c mmap_read_only, reads are then served by \c esp_partition_read.
+     */
+    void munmap();
+
+    const uint8_t *get_mmap_ptr() override;
+
 protected:
     const esp_partition_t* mESPPartition;
+    const uint8_t *mMmapPtr = nullptr;
+    esp_partition_mmap_handle_t mMmapHandle = 0;
 };
 
 } // nvs
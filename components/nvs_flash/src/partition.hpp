@@ -49,6 +49,16 @@ public:
      * Return true if the partition is read-only.
      */
     virtual bool get_readonly() = 0;
+
+    /**
+     * Return a read-only memory mapping of the whole partition content, or nullptr if the partition isn't mapped.
+     *
+     * If the content is mapped, data returned by read() can be accessed directly at the same offset.
+     */
+    virtual const uint8_t *get_mmap_ptr()
+    {
+        return nullptr;
+    }
 };
 
 } // nvs
@@ -0,0 +1,90 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+/*
+ * Read-write lock behind pthread_rwlock_t. It only relies on pthread mutexes and condition variables, so that it is
+ * also built on the Linux target, where pthread_rwlock_t is the host's, to benchmark it against the host rwlock.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    /**
+     * Lock state: writer bit, waiting bits and number of readers holding the lock
+     */
+    _Atomic uint32_t state;
+
+    /**
+     * New readers wait while a writer is waiting
+     */
+    bool prefer_writer;
+
+    /**
+     * Protects the wait counts, held while setting or clearing the waiting bits and while waking up waiters
+     */
+    pthread_mutex_t resource_mutex;
+
+    pthread_cond_t readers_cv;
+    pthread_cond_t writers_cv;
+
+    uint32_t waiting_readers;
+    uint32_t waiting_writers;
+} esp_pthread_rwlock_t;
+
+/**
+ * @brief Initialize a read-write lock
+ *
+ * @param rwlock        lock to initialize
+ * @param prefer_writer if true, readers wait while a writer is waiting, so that writers cannot starve. Otherwise
+ *                      readers get the lock whenever no writer holds it, so that recursive read locks cannot deadlock.
+ *
+ * @return 0 on success, ENOMEM if the mutex or the condition variables could not be created
+ */
+int esp_pthread_rwlock_init(esp_pthread_rwlock_t *rwlock, bool prefer_writer);
+
+/**
+ * @brief Deinitialize a read-write lock
+ *
+ * @return 0 on success, EBUSY if the lock is held or waited for
+ */
+int esp_pthread_rwlock_destroy(esp_pthread_rwlock_t *rwlock);
+
+/**
+ * @brief Take a read lock, same as pthread_rwlock_rdlock()
+ */
+int esp_pthread_rwlock_rdlock(esp_pthread_rwlock_t *rwlock);
+
+/**
+ * @brief Take a read lock without waiting, same as pthread_rwlock_tryrdlock()
+ */
+int esp_pthread_rwlock_tryrdlock(esp_pthread_rwlock_t *rwlock);
+
+/**
+ * @brief Take the write lock, same as pthread_rwlock_wrlock()
+ */
+int esp_pthread_rwlock_wrlock(esp_pthread_rwlock_t *rwlock);
+
+/**
+ * @brief Take the write lock without waiting, same as pthread_rwlock_trywrlock()
+ */
+int esp_pthread_rwlock_trywrlock(esp_pthread_rwlock_t *rwlock);
+
+/**
+ * @brief Release a read lock or the write lock held by the calling thread, same as pthread_rwlock_unlock()
+ */
+int esp_pthread_rwlock_unlock(esp_pthread_rwlock_t *rwlock);
+
+#ifdef __cplusplus
+}
+#endif
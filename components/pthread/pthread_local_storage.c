@@ -1,17 +1,17 @@
 /*
- * SPDX-FileCopyrightText: 2017-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2017-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
 #include <errno.h>
 #include <pthread.h>
 #include <string.h>
+#include <stdbool.h>
 #include "esp_err.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "sys/lock.h"
-#include "sys/queue.h"
 
 #include "pthread_internal.h"
 
@@ -24,62 +24,109 @@
 
 typedef void (*pthread_destructor_t)(void*);
 
-/* This is a very naive implementation of key-indexed thread local storage, using two linked lists
-   (one is a global list of registered keys, one per thread for thread local storage values).
+/* Key-indexed thread local storage, using a global table of registered keys and a table of values per thread.
 
-   It won't work well if lots of keys & thread-local values are stored (O(n) lookup for both),
-   but it should work for small amounts of data.
+   A key encodes the index of its slot in both tables, so pthread_getspecific() and pthread_setspecific() are O(1).
+   Both tables grow in chunks of PTHREAD_TLS_CHUNK_SIZE entries. A key also encodes the generation of its slot, which
+   is incremented when the key is deleted. Thus, if a slot is reused by a new key, values which threads still hold for
+   the deleted key are not seen through the new key.
 */
-typedef struct key_entry_t_ {
-    pthread_key_t key;
+#define PTHREAD_TLS_CHUNK_SIZE      8
+#define PTHREAD_TLS_INDEX_BITS      16
+#define PTHREAD_TLS_INDEX_MASK      ((1UL << PTHREAD_TLS_INDEX_BITS) - 1)
+#define PTHREAD_TLS_MAX_KEYS        (PTHREAD_TLS_INDEX_MASK + 1)
+
+#define KEY_INDEX(key)              ((key) & PTHREAD_TLS_INDEX_MASK)
+#define KEY_MAKE(index, generation) (((pthread_key_t)(generation) << PTHREAD_TLS_INDEX_BITS) | (index))
+
+typedef struct {
     pthread_destructor_t destructor;
-    SLIST_ENTRY(key_entry_t_) next;
+    uint16_t generation; // never 0, so that a valid key is never 0
+    bool in_use;
 } key_entry_t;
 
-// List of all keys created with pthread_key_create()
-SLIST_HEAD(key_list_t, key_entry_t_) s_keys = SLIST_HEAD_INITIALIZER(s_keys);
+// Table of all keys created with pthread_key_create(), indexed by KEY_INDEX(key)
+static key_entry_t *s_keys = NULL;
+static size_t s_keys_capacity = 0;
 
 static portMUX_TYPE s_keys_lock = portMUX_INITIALIZER_UNLOCKED;
 
-// List of all value entries associated with a thread via pthread_setspecific()
-typedef struct value_entry_t_ {
+// Value associated with a thread via pthread_setspecific(). Unused entries have key 0.
+typedef struct {
     pthread_key_t key;
     void *value;
-    SLIST_ENTRY(value_entry_t_) next;
 } value_entry_t;
 
-// Type for the head of the list, as saved as a FreeRTOS thread local storage pointer
-SLIST_HEAD(values_list_t_, value_entry_t_);
-typedef struct values_list_t_ values_list_t;
+// Table of the values of a thread, as saved as a FreeRTOS thread local storage pointer. The values array is
+// reallocated when it grows, the table itself is not.
+typedef struct {
+    size_t capacity;
+    value_entry_t *values;
+} values_table_t;
 
-int pthread_key_create(pthread_key_t *key, pthread_destructor_t destructor)
+/* Must be called with s_keys_lock held */
+static bool key_is_valid(pthread_key_t key)
 {
-    key_entry_t *new_key = malloc(sizeof(key_entry_t));
-    if (new_key == NULL) {
-        return ENOMEM;
-    }
+    size_t index = KEY_INDEX(key);
+    return index < s_keys_capacity && s_keys[index].in_use && KEY_MAKE(index, s_keys[index].generation) == key;
+}
 
+int pthread_key_create(pthread_key_t *key, pthread_destructor_t destructor)
+{
     portENTER_CRITICAL(&s_keys_lock);
 
-    const key_entry_t *head = SLIST_FIRST(&s_keys);
-    new_key->key = (head == NULL) ? 1 : (head->key + 1);
-    new_key->destructor = destructor;
-    *key = new_key->key;
+    while (1) {
+        for (size_t i = 0; i < s_keys_capacity; i++) {
+            key_entry_t *entry = &s_keys[i];
+            if (!entry->in_use) {
+                if (entry->generation == 0) {
+                    entry->generation = 1;
+                }
+                entry->in_use = true;
+                entry->destructor = destructor;
+                *key = KEY_MAKE(i, entry->generation);
+                portEXIT_CRITICAL(&s_keys_lock);
+                return 0;
+            }
+        }
+
+        size_t capacity = s_keys_capacity;
+        if (capacity >= PTHREAD_TLS_MAX_KEYS) {
+            portEXIT_CRITICAL(&s_keys_lock);
+            return EAGAIN;
+        }
 
-    SLIST_INSERT_HEAD(&s_keys, new_key, next);
+        // Grow the table by a chunk. Memory can't be allocated or freed inside the critical section, so the table
+        // is only replaced if no other task grew it in the meantime.
+        portEXIT_CRITICAL(&s_keys_lock);
+        key_entry_t *new_keys = calloc(capacity + PTHREAD_TLS_CHUNK_SIZE, sizeof(key_entry_t));
+        if (new_keys == NULL) {
+            return ENOMEM;
+        }
+        portENTER_CRITICAL(&s_keys_lock);
+
+        key_entry_t *old_keys = new_keys;
+        if (s_keys_capacity == capacity) {
+            if (capacity > 0) {
+                memcpy(new_keys, s_keys, capacity * sizeof(key_entry_t));
+            }
+            old_keys = s_keys;
+            s_keys = new_keys;
+            s_keys_capacity = capacity + PTHREAD_TLS_CHUNK_SIZE;
+        }
 
-    portEXIT_CRITICAL(&s_keys_lock);
-    return 0;
+        portEXIT_CRITICAL(&s_keys_lock);
+        free(old_keys);
+        portENTER_CRITICAL(&s_keys_lock);
+    }
 }
 
-static key_entry_t *find_key(pthread_key_t key)
+static bool find_key(pthread_key_t key, pthread_destructor_t *destructor)
 {
     portENTER_CRITICAL(&s_keys_lock);
-    key_entry_t *result = NULL;;
-    SLIST_FOREACH(result, &s_keys, next) {
-        if (result->key == key) {
-            break;
-        }
+    bool result = key_is_valid(key);
+    if (result && destructor != NULL) {
+        *destructor = s_keys[KEY_INDEX(key)].destructor;
     }
     portEXIT_CRITICAL(&s_keys_lock);
     return result;
@@ -90,14 +137,17 @@ int pthread_key_delete(pthread_key_t key)
 
     portENTER_CRITICAL(&s_keys_lock);
 
-    /* Ideally, we would also walk all tasks' thread local storage value_list here
-       and delete any values associated with this key. We do not do this...
+    /* Values which tasks hold for this key are not deleted, but incrementing the generation makes sure that they are
+       neither returned for a new key reusing the slot, nor passed to its destructor.
     */
 
-    key_entry_t *entry = find_key(key);
-    if (entry != NULL) {
-        SLIST_REMOVE(&s_keys, entry, key_entry_t_, next);
-        free(entry);
+    if (key_is_valid(key)) {
+        key_entry_t *entry = &s_keys[KEY_INDEX(key)];
+        entry->in_use = false;
+        entry->destructor = NULL;
+        if (++entry->generation == 0) {
+            entry->generation = 1;
+        }
     }
 
     portEXIT_CRITICAL(&s_keys_lock);
@@ -124,26 +174,33 @@ int pthread_key_delete(pthread_key_t key)
 */
 static void pthread_cleanup_thread_specific_data_callback(int index, void *v_tls)
 {
-    values_list_t *tls = (values_list_t *)v_tls;
+    values_table_t *tls = (values_table_t *)v_tls;
     assert(tls != NULL);
 
-    /* Walk the list, freeing all entries and calling destructors if they are registered */
-    while (1) {
-        value_entry_t *entry = SLIST_FIRST(tls);
-        if (entry == NULL) {
-            break;
-        }
-        SLIST_REMOVE_HEAD(tls, next);
-
-        // This is a little slow, walking the linked list of keys once per value,
-        // but assumes that the thread's value list will have less entries
-        // than the keys list
-        key_entry_t *key = find_key(entry->key);
-        if (key != NULL && key->destructor != NULL) {
-            key->destructor(entry->value);
+    /* Walk the table, clearing all entries and calling destructors if they are registered. A destructor may set new
+       non-NULL values, so walk it again until no values are left. The values array may be reallocated by a destructor,
+       so it must not be cached.
+    */
+    bool found;
+    do {
+        found = false;
+        for (size_t i = 0; i < tls->capacity; i++) {
+            value_entry_t entry = tls->values[i];
+            if (entry.key == 0) {
+                continue;
+            }
+            tls->values[i].key = 0;
+            tls->values[i].value = NULL;
+            found = true;
+
+            pthread_destructor_t destructor;
+            if (find_key(entry.key, &destructor) && destructor != NULL) {
+                destructor(entry.value);
+            }
         }
-        free(entry);
-    }
+    } while (found);
+
+    free(tls->values);
     free(tls);
 }
 
@@ -169,41 +226,33 @@ void pthread_internal_local_storage_destructor_callback(TaskHandle_t handle)
     }
 }
 
-static value_entry_t *find_value(const values_list_t *list, pthread_key_t key)
-{
-    value_entry_t *result = NULL;;
-    SLIST_FOREACH(result, list, next) {
-        if (result->key == key) {
-            break;
-        }
-    }
-    return result;
-}
-
 void *pthread_getspecific(pthread_key_t key)
 {
-    values_list_t *tls = (values_list_t *) pvTaskGetThreadLocalStoragePointer(NULL, PTHREAD_TLS_INDEX);
+    values_table_t *tls = (values_table_t *) pvTaskGetThreadLocalStoragePointer(NULL, PTHREAD_TLS_INDEX);
     if (tls == NULL) {
         return NULL;
     }
 
-    value_entry_t *entry = find_value(tls, key);
-    if (entry != NULL) {
-        return entry->value;
+    size_t index = KEY_INDEX(key);
+    if (index < tls->capacity && tls->values[index].key == key) {
+        return tls->values[index].value;
     }
     return NULL;
 }
 
 int pthread_setspecific(pthread_key_t key, const void *value)
 {
-    key_entry_t *key_entry = find_key(key);
-    if (key_entry == NULL) {
+    if (!find_key(key, NULL)) {
         return ENOENT; // this situation is undefined by pthreads standard
     }
 
-    values_list_t *tls = pvTaskGetThreadLocalStoragePointer(NULL, PTHREAD_TLS_INDEX);
+    size_t index = KEY_INDEX(key);
+    values_table_t *tls = pvTaskGetThreadLocalStoragePointer(NULL, PTHREAD_TLS_INDEX);
     if (tls == NULL) {
-        tls = calloc(1, sizeof(values_list_t));
+        if (value == NULL) {
+            return 0; // nothing to remove
+        }
+        tls = calloc(1, sizeof(values_table_t));
         if (tls == NULL) {
             return ENOMEM;
         }
@@ -217,41 +266,25 @@ int pthread_setspecific(pthread_key_t key, const void *value)
 #endif /* CONFIG_FREERTOS_TLSP_DELETION_CALLBACKS */
     }
 
-    value_entry_t *entry = find_value(tls, key);
-    if (entry != NULL) {
-        if (value != NULL) {
-            // cast on next line is necessary as pthreads API uses
-            // 'const void *' here but elsewhere uses 'void *'
-            entry->value = (void *) value;
-        } else { // value == NULL, remove the entry
-            SLIST_REMOVE(tls, entry, value_entry_t_, next);
-            free(entry);
+    if (index >= tls->capacity) {
+        if (value == NULL) {
+            return 0; // nothing to remove
         }
-    } else if (value != NULL) {
-        entry = malloc(sizeof(value_entry_t));
-        if (entry == NULL) {
+        size_t capacity = (index / PTHREAD_TLS_CHUNK_SIZE + 1) * PTHREAD_TLS_CHUNK_SIZE;
+        value_entry_t *values = realloc(tls->values, capacity * sizeof(value_entry_t));
+        if (values == NULL) {
             return ENOMEM;
         }
-        entry->key = key;
-        entry->value = (void *) value; // see note above about cast
-
-        // insert the new entry at the end of the list. this is important because
-        // a destructor may call pthread_setspecific() to add a new non-NULL value
-        // to the list, and this should be processed after all other entries.
-        //
-        // See pthread_cleanup_thread_specific_data_callback()
-        value_entry_t *last_entry = NULL;
-        value_entry_t *it;
-        SLIST_FOREACH(it, tls, next) {
-            last_entry = it;
-        }
-        if (last_entry == NULL) {
-            SLIST_INSERT_HEAD(tls, entry, next);
-        } else {
-            SLIST_INSERT_AFTER(last_entry, entry, next);
-        }
+        memset(&values[tls->capacity], 0, (capacity - tls->capacity) * sizeof(value_entry_t));
+        tls->values = values;
+        tls->capacity = capacity;
     }
 
+    // cast on next line is necessary as pthreads API uses
+    // 'const void *' here but elsewhere uses 'void *'
+    tls->values[index].key = (value != NULL) ? key : 0;
+    tls->values[index].value = (void *) value;
+
     return 0;
 }
 
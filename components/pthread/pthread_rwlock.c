@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2021-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -8,7 +8,7 @@
 #include <errno.h>
 #include <pthread.h>
 #include <string.h>
-#include <stdatomic.h>
+#include <stdbool.h>
 #include "esp_err.h"
 #include "esp_attr.h"
 #include "sys/queue.h"
@@ -19,43 +19,39 @@
 
 #include "pthread_internal.h"
 #include "esp_pthread.h"
+#include "esp_private/pthread_rwlock_core.h"
 
 #include "esp_log.h"
 const static char *TAG = "pthread_rw_lock";
 
-/** pthread rw_mutex FreeRTOS wrapper */
-typedef struct {
-    /**
-     *
-     */
-    pthread_cond_t cv;
-
-    pthread_mutex_t resource_mutex;
-
-    /**
-     * Number of current readers holding this lock, negative number means waiting readers
-     */
-    int8_t active_readers;
-
-    uint8_t active_writers;
-    uint8_t waiting_writers;
-
-} esp_pthread_rwlock_t;
+/*
+ * newlib's pthread_rwlockattr_t has no field for the lock kind, so it is stored in the upper bits of is_initialized.
+ */
+#define RWLOCKATTR_INITIALIZED  0x1
+#define RWLOCKATTR_KIND_SHIFT   8
 
-#define WRITER_QUEUE_SIZE 4
-#define READER_QUEUE_SIZE 4
+static bool rwlockattr_kind_is_valid(int kind)
+{
+    return kind == PTHREAD_RWLOCK_PREFER_READER_NP ||
+           kind == PTHREAD_RWLOCK_PREFER_WRITER_NP ||
+           kind == PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP;
+}
 
 int pthread_rwlock_init(pthread_rwlock_t *rwlock,
                         const pthread_rwlockattr_t *attr)
 {
     int result;
+    int kind = PTHREAD_RWLOCK_DEFAULT_NP;
+
     if (!rwlock) {
         return EINVAL;
     }
 
     if (attr) {
-        // TODO: implement attributes in IDF-4284
-        return ENOSYS;
+        if (!(attr->is_initialized & RWLOCKATTR_INITIALIZED)) {
+            return EINVAL;
+        }
+        kind = attr->is_initialized >> RWLOCKATTR_KIND_SHIFT;
     }
 
     esp_pthread_rwlock_t *esp_rwlock = (esp_pthread_rwlock_t*) calloc(1, sizeof(esp_pthread_rwlock_t));
@@ -63,23 +59,14 @@ int pthread_rwlock_init(pthread_rwlock_t *rwlock,
         return ENOMEM;
     }
 
-    result = pthread_mutex_init(&esp_rwlock->resource_mutex, NULL);
+    // Like in glibc, PTHREAD_RWLOCK_PREFER_WRITER_NP behaves as PTHREAD_RWLOCK_PREFER_READER_NP, so that recursive
+    // read locks keep working. Only PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP makes readers wait for writers.
+    result = esp_pthread_rwlock_init(esp_rwlock, kind == PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
     if (result != 0) {
         free(esp_rwlock);
-        return ENOMEM;
+        return result;
     }
 
-    result = pthread_cond_init(&esp_rwlock->cv, NULL);
-    if (result != 0) {
-        pthread_mutex_destroy(&esp_rwlock->resource_mutex);
-        free(esp_rwlock);
-        return ENOMEM;
-    }
-
-    esp_rwlock->active_readers = 0;
-    esp_rwlock->active_writers = 0;
-    esp_rwlock->waiting_writers = 0;
-
     *rwlock = (pthread_rwlock_t) esp_rwlock;
 
     return 0;
@@ -101,6 +88,7 @@ static int pthread_rwlock_init_if_static(pthread_rwlock_t *rwlock)
 int pthread_rwlock_destroy(pthread_rwlock_t *rwlock)
 {
     esp_pthread_rwlock_t *esp_rwlock;
+    int result;
 
     ESP_LOGV(TAG, "%s %p", __FUNCTION__, rwlock);
 
@@ -117,19 +105,11 @@ int pthread_rwlock_destroy(pthread_rwlock_t *rwlock)
         return EINVAL;
     }
 
-    // TODO: necessary?
-    pthread_mutex_lock(&esp_rwlock->resource_mutex);
-
-    if (esp_rwlock->active_readers != 0 || esp_rwlock->active_writers > 0 || esp_rwlock->waiting_writers > 0) {
-        pthread_mutex_unlock(&esp_rwlock->resource_mutex);
-        return EBUSY;
+    result = esp_pthread_rwlock_destroy(esp_rwlock);
+    if (result != 0) {
+        return result;
     }
 
-    // delete whole lock
-    pthread_cond_destroy(&esp_rwlock->cv);
-    pthread_mutex_unlock(&esp_rwlock->resource_mutex);
-    pthread_mutex_destroy(&esp_rwlock->resource_mutex);
-
     free(esp_rwlock);
 
     return 0;
@@ -159,7 +139,6 @@ static int checkrw_lock(pthread_rwlock_t *rwlock)
 
 int pthread_rwlock_rdlock(pthread_rwlock_t *rwlock)
 {
-    esp_pthread_rwlock_t *esp_rwlock;
     int res;
 
     res = checkrw_lock(rwlock);
@@ -167,32 +146,11 @@ int pthread_rwlock_rdlock(pthread_rwlock_t *rwlock)
         return res;
     }
 
-    esp_rwlock = (esp_pthread_rwlock_t *)*rwlock;
-    res = pthread_mutex_lock(&esp_rwlock->resource_mutex);
-    if (res != 0) {
-        return res;
-    }
-
-    if (esp_rwlock->active_writers == 0) {
-        esp_rwlock->active_readers++;
-    } else {
-        while (true) {
-            pthread_cond_wait(&esp_rwlock->cv, &esp_rwlock->resource_mutex);
-            if (esp_rwlock->active_writers == 0 && esp_rwlock->waiting_writers == 0) {
-                esp_rwlock->active_readers++;
-                break;
-            }
-        }
-    }
-
-    pthread_mutex_unlock(&esp_rwlock->resource_mutex);
-
-    return 0;
+    return esp_pthread_rwlock_rdlock((esp_pthread_rwlock_t *)*rwlock);
 }
 
 int pthread_rwlock_tryrdlock(pthread_rwlock_t *rwlock)
 {
-    esp_pthread_rwlock_t *esp_rwlock;
     int res;
 
     res = checkrw_lock(rwlock);
@@ -200,27 +158,11 @@ int pthread_rwlock_tryrdlock(pthread_rwlock_t *rwlock)
         return res;
     }
 
-    esp_rwlock = (esp_pthread_rwlock_t *)*rwlock;
-    res = pthread_mutex_trylock(&esp_rwlock->resource_mutex);
-    if (res != 0) {
-        return res;
-    }
-
-    if (esp_rwlock->active_writers == 0) {
-        esp_rwlock->active_readers++;
-        res = 0;
-    } else {
-        res = EBUSY;
-    }
-
-    pthread_mutex_unlock(&esp_rwlock->resource_mutex);
-
-    return res;
+    return esp_pthread_rwlock_tryrdlock((esp_pthread_rwlock_t *)*rwlock);
 }
 
 int pthread_rwlock_wrlock(pthread_rwlock_t *rwlock)
 {
-    esp_pthread_rwlock_t *esp_rwlock;
     int res;
 
     res = checkrw_lock(rwlock);
@@ -228,27 +170,11 @@ int pthread_rwlock_wrlock(pthread_rwlock_t *rwlock)
         return res;
     }
 
-    esp_rwlock = (esp_pthread_rwlock_t *)*rwlock;
-    res = pthread_mutex_lock(&esp_rwlock->resource_mutex);
-    if (res != 0) {
-        return res;
-    }
-
-    esp_rwlock->waiting_writers++;
-    while (esp_rwlock->active_readers > 0 || esp_rwlock->active_writers > 0) {
-        pthread_cond_wait(&esp_rwlock->cv, &esp_rwlock->resource_mutex);
-    }
-    esp_rwlock->waiting_writers--;
-    esp_rwlock->active_writers++;
-
-    pthread_mutex_unlock(&esp_rwlock->resource_mutex);
-
-    return 0;
+    return esp_pthread_rwlock_wrlock((esp_pthread_rwlock_t *)*rwlock);
 }
 
 int pthread_rwlock_trywrlock(pthread_rwlock_t *rwlock)
 {
-    esp_pthread_rwlock_t *esp_rwlock;
     int res;
 
     res = checkrw_lock(rwlock);
@@ -256,29 +182,11 @@ int pthread_rwlock_trywrlock(pthread_rwlock_t *rwlock)
         return res;
     }
 
-    esp_rwlock = (esp_pthread_rwlock_t *)*rwlock;
-    res = pthread_mutex_trylock(&esp_rwlock->resource_mutex);
-    if (res != 0) {
-        return res;
-    }
-
-    if (esp_rwlock->active_readers > 0 ||
-            esp_rwlock->active_writers > 0 ||
-            esp_rwlock->waiting_writers > 0) { // the last check for waiting_writers is to avoid skipping the queue
-        res = EBUSY;
-    } else {
-        esp_rwlock->active_writers++;
-        res = 0;
-    }
-
-    pthread_mutex_unlock(&esp_rwlock->resource_mutex);
-
-    return res;
+    return esp_pthread_rwlock_trywrlock((esp_pthread_rwlock_t *)*rwlock);
 }
 
 int pthread_rwlock_unlock(pthread_rwlock_t *rwlock)
 {
-    esp_pthread_rwlock_t *esp_rwlock;
     int res;
 
     res = checkrw_lock(rwlock);
@@ -286,28 +194,67 @@ int pthread_rwlock_unlock(pthread_rwlock_t *rwlock)
         return res;
     }
 
-    esp_rwlock = (esp_pthread_rwlock_t *)*rwlock;
-    res = pthread_mutex_lock(&esp_rwlock->resource_mutex);
-    if (res != 0) {
-        return res;
+    return esp_pthread_rwlock_unlock((esp_pthread_rwlock_t *)*rwlock);
+}
+
+/***************** ATTRIBUTES ******************/
+int pthread_rwlockattr_init(pthread_rwlockattr_t *attr)
+{
+    if (!attr) {
+        return EINVAL;
     }
+    memset(attr, 0, sizeof(*attr));
+    attr->is_initialized = RWLOCKATTR_INITIALIZED | (PTHREAD_RWLOCK_DEFAULT_NP << RWLOCKATTR_KIND_SHIFT);
+    return 0;
+}
 
-    assert(!(esp_rwlock->active_readers > 0 && esp_rwlock->active_writers > 0));
+int pthread_rwlockattr_destroy(pthread_rwlockattr_t *attr)
+{
+    if (!attr) {
+        return EINVAL;
+    }
+    attr->is_initialized = 0;
+    return 0;
+}
 
-    if (esp_rwlock->active_readers > 0) {
-        // we are a reader
-        esp_rwlock->active_readers--;
-        if (esp_rwlock->active_readers == 0) {
-            pthread_cond_broadcast(&esp_rwlock->cv);
-        }
-    } else {
-        // we are a writer
-        esp_rwlock->active_writers = 0;
-        pthread_cond_broadcast(&esp_rwlock->cv);
+int pthread_rwlockattr_getpshared(const pthread_rwlockattr_t *attr, int *pshared)
+{
+    if (!attr || !pshared) {
+        return EINVAL;
+    }
+    *pshared = PTHREAD_PROCESS_PRIVATE;
+    return 0;
+}
+
+int pthread_rwlockattr_setpshared(pthread_rwlockattr_t *attr, int pshared)
+{
+    if (!attr) {
+        return EINVAL;
+    }
+    if (pshared == PTHREAD_PROCESS_SHARED) {
+        return ENOTSUP; // There is only one process
     }
+    if (pshared != PTHREAD_PROCESS_PRIVATE) {
+        return EINVAL;
+    }
+    return 0;
+}
 
-    pthread_mutex_unlock(&esp_rwlock->resource_mutex);
+int pthread_rwlockattr_getkind_np(const pthread_rwlockattr_t *attr, int *pref)
+{
+    if (!attr || !pref || !(attr->is_initialized & RWLOCKATTR_INITIALIZED)) {
+        return EINVAL;
+    }
+    *pref = attr->is_initialized >> RWLOCKATTR_KIND_SHIFT;
+    return 0;
+}
 
+int pthread_rwlockattr_setkind_np(pthread_rwlockattr_t *attr, int pref)
+{
+    if (!attr || !(attr->is_initialized & RWLOCKATTR_INITIALIZED) || !rwlockattr_kind_is_valid(pref)) {
+        return EINVAL;
+    }
+    attr->is_initialized = RWLOCKATTR_INITIALIZED | (pref << RWLOCKATTR_KIND_SHIFT);
     return 0;
 }
 
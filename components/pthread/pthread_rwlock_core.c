@@ -0,0 +1,219 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "esp_private/pthread_rwlock_core.h"
+
+/*
+ * The lock state is a single atomic word, so that uncontended read locks and unlocks (the common case for read-mostly
+ * data) are a single compare-and-swap or atomic decrement. The mutex and condition variables are only used by threads
+ * which have to wait, and to wake them up.
+ */
+#define RWLOCK_WRITER           (1UL << 31) // A writer holds the lock
+#define RWLOCK_WRITERS_WAITING  (1UL << 30) // At least one writer is waiting for the lock
+#define RWLOCK_READERS_WAITING  (1UL << 29) // At least one reader is waiting for the lock
+#define RWLOCK_READERS_MASK     (RWLOCK_READERS_WAITING - 1) // Number of readers holding the lock
+#define RWLOCK_WAITING          (RWLOCK_WRITERS_WAITING | RWLOCK_READERS_WAITING)
+
+int esp_pthread_rwlock_init(esp_pthread_rwlock_t *rwlock, bool prefer_writer)
+{
+    if (pthread_mutex_init(&rwlock->resource_mutex, NULL) != 0) {
+        return ENOMEM;
+    }
+
+    if (pthread_cond_init(&rwlock->readers_cv, NULL) != 0) {
+        pthread_mutex_destroy(&rwlock->resource_mutex);
+        return ENOMEM;
+    }
+
+    if (pthread_cond_init(&rwlock->writers_cv, NULL) != 0) {
+        pthread_cond_destroy(&rwlock->readers_cv);
+        pthread_mutex_destroy(&rwlock->resource_mutex);
+        return ENOMEM;
+    }
+
+    atomic_init(&rwlock->state, 0);
+    rwlock->prefer_writer = prefer_writer;
+    rwlock->waiting_readers = 0;
+    rwlock->waiting_writers = 0;
+
+    return 0;
+}
+
+int esp_pthread_rwlock_destroy(esp_pthread_rwlock_t *rwlock)
+{
+    // The lock must neither be held nor be waited for
+    if (atomic_load(&rwlock->state) != 0) {
+        return EBUSY;
+    }
+
+    pthread_cond_destroy(&rwlock->writers_cv);
+    pthread_cond_destroy(&rwlock->readers_cv);
+    pthread_mutex_destroy(&rwlock->resource_mutex);
+
+    return 0;
+}
+
+/**
+ * Try to take a read lock without waiting.
+ *
+ * Readers are refused while a writer holds the lock, and also while writers are waiting if writers are preferred.
+ */
+static int rwlock_try_read(esp_pthread_rwlock_t *rwlock)
+{
+    uint32_t blocking = RWLOCK_WRITER;
+    if (rwlock->prefer_writer) {
+        blocking |= RWLOCK_WRITERS_WAITING;
+    }
+
+    uint32_t state = atomic_load_explicit(&rwlock->state, memory_order_relaxed);
+    while ((state & blocking) == 0) {
+        if ((state & RWLOCK_READERS_MASK) == RWLOCK_READERS_MASK) {
+            return EAGAIN; // Maximum number of read locks reached
+        }
+        if (atomic_compare_exchange_weak_explicit(&rwlock->state, &state, state + 1,
+                                                  memory_order_acquire, memory_order_relaxed)) {
+            return 0;
+        }
+    }
+
+    return EBUSY;
+}
+
+/**
+ * Try to take the write lock without waiting.
+ *
+ * Unless called by a waiting writer, writers are refused while other writers are waiting, so that they do not skip
+ * the queue.
+ */
+static int rwlock_try_write(esp_pthread_rwlock_t *rwlock, bool waiting)
+{
+    uint32_t blocking = RWLOCK_WRITER | RWLOCK_READERS_MASK;
+    if (!waiting) {
+        blocking |= RWLOCK_WRITERS_WAITING;
+    }
+
+    uint32_t state = atomic_load_explicit(&rwlock->state, memory_order_relaxed);
+    while ((state & blocking) == 0) {
+        if (atomic_compare_exchange_weak_explicit(&rwlock->state, &state, state | RWLOCK_WRITER,
+                                                  memory_order_acquire, memory_order_relaxed)) {
+            return 0;
+        }
+    }
+
+    return EBUSY;
+}
+
+/**
+ * Wake up the threads waiting for the lock, they compete for it again.
+ *
+ * The waiting bits are set with the mutex held before a waiter checks the lock state a last time, and the lock is
+ * released before this function takes the mutex, so a waiter either sees the lock released or gets woken up.
+ */
+static void rwlock_wake_waiters(esp_pthread_rwlock_t *rwlock)
+{
+    pthread_mutex_lock(&rwlock->resource_mutex);
+    if (rwlock->waiting_writers > 0) {
+        pthread_cond_signal(&rwlock->writers_cv);
+    }
+    if (rwlock->waiting_readers > 0) {
+        pthread_cond_broadcast(&rwlock->readers_cv);
+    }
+    pthread_mutex_unlock(&rwlock->resource_mutex);
+}
+
+int esp_pthread_rwlock_rdlock(esp_pthread_rwlock_t *rwlock)
+{
+    int res;
+
+    res = rwlock_try_read(rwlock);
+    if (res != EBUSY) {
+        return res;
+    }
+
+    res = pthread_mutex_lock(&rwlock->resource_mutex);
+    if (res != 0) {
+        return res;
+    }
+
+    rwlock->waiting_readers++;
+    atomic_fetch_or(&rwlock->state, RWLOCK_READERS_WAITING);
+    while ((res = rwlock_try_read(rwlock)) == EBUSY) {
+        pthread_cond_wait(&rwlock->readers_cv, &rwlock->resource_mutex);
+    }
+    if (--rwlock->waiting_readers == 0) {
+        atomic_fetch_and(&rwlock->state, ~RWLOCK_READERS_WAITING);
+    }
+
+    pthread_mutex_unlock(&rwlock->resource_mutex);
+
+    return res;
+}
+
+int esp_pthread_rwlock_tryrdlock(esp_pthread_rwlock_t *rwlock)
+{
+    return rwlock_try_read(rwlock);
+}
+
+int esp_pthread_rwlock_wrlock(esp_pthread_rwlock_t *rwlock)
+{
+    int res;
+
+    if (rwlock_try_write(rwlock, false) == 0) {
+        return 0;
+    }
+
+    res = pthread_mutex_lock(&rwlock->resource_mutex);
+    if (res != 0) {
+        return res;
+    }
+
+    rwlock->waiting_writers++;
+    atomic_fetch_or(&rwlock->state, RWLOCK_WRITERS_WAITING);
+    while (rwlock_try_write(rwlock, true) != 0) {
+        pthread_cond_wait(&rwlock->writers_cv, &rwlock->resource_mutex);
+    }
+    if (--rwlock->waiting_writers == 0) {
+        atomic_fetch_and(&rwlock->state, ~RWLOCK_WRITERS_WAITING);
+    }
+
+    pthread_mutex_unlock(&rwlock->resource_mutex);
+
+    return 0;
+}
+
+int esp_pthread_rwlock_trywrlock(esp_pthread_rwlock_t *rwlock)
+{
+    return rwlock_try_write(rwlock, false);
+}
+
+int esp_pthread_rwlock_unlock(esp_pthread_rwlock_t *rwlock)
+{
+    uint32_t state;
+
+    // The calling thread holds the lock, so whether it is a reader or the writer cannot change under our feet
+    state = atomic_load_explicit(&rwlock->state, memory_order_relaxed);
+    if (state & RWLOCK_WRITER) {
+        // we are a writer
+        state = atomic_fetch_and_explicit(&rwlock->state, ~RWLOCK_WRITER, memory_order_release);
+        if (state & RWLOCK_WAITING) {
+            rwlock_wake_waiters(rwlock);
+        }
+    } else if (state & RWLOCK_READERS_MASK) {
+        // we are a reader, only the last one can let waiters in
+        state = atomic_fetch_sub_explicit(&rwlock->state, 1, memory_order_release);
+        if ((state & RWLOCK_READERS_MASK) == 1 && (state & RWLOCK_WAITING)) {
+            rwlock_wake_waiters(rwlock);
+        }
+    } else {
+        return EPERM;
+    }
+
+    return 0;
+}
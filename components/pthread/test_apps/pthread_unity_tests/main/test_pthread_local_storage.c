@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2022-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2022-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Unlicense OR CC0-1.0
  */
@@ -11,6 +11,7 @@
 #include "freertos/task.h"
 #include "test_utils.h"
 #include "esp_random.h"
+#include "esp_timer.h"
 
 TEST_CASE("pthread local storage basics", "[thread-specific]")
 {
@@ -253,3 +254,86 @@ static void *s_test_repeat_destructor_thread(void *vp_state)
     }
     pthread_exit(NULL);
 }
+
+TEST_CASE("pthread local storage deleted key value not seen by new key", "[thread-specific]")
+{
+    pthread_key_t old_key;
+    pthread_key_t new_key;
+    int val = 3;
+
+    TEST_ASSERT_EQUAL(0, pthread_key_create(&old_key, NULL));
+    TEST_ASSERT_EQUAL(0, pthread_setspecific(old_key, &val));
+    TEST_ASSERT_EQUAL(0, pthread_key_delete(old_key));
+    TEST_ASSERT_NOT_EQUAL(0, pthread_setspecific(old_key, &val));
+
+    // The new key may reuse the storage of the deleted key, but must start without a value
+    TEST_ASSERT_EQUAL(0, pthread_key_create(&new_key, NULL));
+    TEST_ASSERT_NOT_EQUAL(old_key, new_key);
+    TEST_ASSERT_NULL(pthread_getspecific(new_key));
+
+    TEST_ASSERT_EQUAL(0, pthread_key_delete(new_key));
+}
+
+#define MANY_KEYS_NUM 64
+
+TEST_CASE("pthread local storage many keys", "[thread-specific]")
+{
+    pthread_key_t keys[MANY_KEYS_NUM];
+    int values[MANY_KEYS_NUM];
+
+    for (int i = 0; i < MANY_KEYS_NUM; i++) {
+        TEST_ASSERT_EQUAL(0, pthread_key_create(&keys[i], NULL));
+    }
+    // Set the values in reverse order, so that the values of the thread grow to the full size at once
+    for (int i = MANY_KEYS_NUM - 1; i >= 0; i--) {
+        TEST_ASSERT_EQUAL(0, pthread_setspecific(keys[i], &values[i]));
+    }
+    for (int i = 0; i < MANY_KEYS_NUM; i++) {
+        TEST_ASSERT_EQUAL_PTR(&values[i], pthread_getspecific(keys[i]));
+    }
+
+    for (int i = 0; i < MANY_KEYS_NUM; i++) {
+        TEST_ASSERT_EQUAL(0, pthread_setspecific(keys[i], NULL));
+        TEST_ASSERT_EQUAL(0, pthread_key_delete(keys[i]));
+    }
+}
+
+#define GETSPECIFIC_PERF_ITERATIONS 10000
+
+/*
+Benchmark the cost of pthread_getspecific()
+
+Procedure:
+    - For 1, 16 and 64 keys with a value set, look up the values of all keys in turn GETSPECIFIC_PERF_ITERATIONS times
+
+Expected:
+    - All values are found, the average time per pthread_getspecific() call is printed for each number of keys
+*/
+TEST_CASE("pthread local storage getspecific performance", "[thread-specific][perf]")
+{
+    static const int key_nums[] = { 1, 16, MANY_KEYS_NUM };
+    pthread_key_t keys[MANY_KEYS_NUM];
+
+    for (int k = 0; k < sizeof(key_nums) / sizeof(key_nums[0]); k++) {
+        int key_num = key_nums[k];
+
+        for (int i = 0; i < key_num; i++) {
+            TEST_ASSERT_EQUAL(0, pthread_key_create(&keys[i], NULL));
+            TEST_ASSERT_EQUAL(0, pthread_setspecific(keys[i], &keys[i]));
+        }
+
+        int64_t start = esp_timer_get_time();
+        for (int i = 0; i < GETSPECIFIC_PERF_ITERATIONS; i++) {
+            TEST_ASSERT_EQUAL_PTR(&keys[i % key_num], pthread_getspecific(keys[i % key_num]));
+        }
+        int64_t elapsed_us = esp_timer_get_time() - start;
+
+        printf("%d key(s): %d pthread_getspecific() calls in %lld us (%lld ns per call)\n", key_num,
+               GETSPECIFIC_PERF_ITERATIONS, elapsed_us, elapsed_us * 1000 / GETSPECIFIC_PERF_ITERATIONS);
+
+        for (int i = 0; i < key_num; i++) {
+            TEST_ASSERT_EQUAL(0, pthread_setspecific(keys[i], NULL));
+            TEST_ASSERT_EQUAL(0, pthread_key_delete(keys[i]));
+        }
+    }
+}
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2021-2022 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Unlicense OR CC0-1.0
  */
@@ -382,3 +382,138 @@ TEST_CASE("trywrlock lock statically initialized lock", "[pthread][rwlock]")
     TEST_ASSERT_EQUAL_INT(pthread_rwlock_unlock(&rwlock), 0);
     TEST_ASSERT_EQUAL_INT(pthread_rwlock_destroy(&rwlock), 0);
 }
+
+TEST_CASE("unlock fails on unlocked rwlock", "[pthread][rwlock]")
+{
+    pthread_rwlock_t rwlock;
+    TEST_ASSERT_EQUAL_INT(pthread_rwlock_init(&rwlock, NULL), 0);
+
+    TEST_ASSERT_EQUAL_INT(pthread_rwlock_unlock(&rwlock), EPERM);
+
+    TEST_ASSERT_EQUAL_INT(pthread_rwlock_destroy(&rwlock), 0);
+}
+
+TEST_CASE("destroy fails on locked rwlock", "[pthread][rwlock]")
+{
+    pthread_rwlock_t rwlock;
+    TEST_ASSERT_EQUAL_INT(pthread_rwlock_init(&rwlock, NULL), 0);
+    TEST_ASSERT_EQUAL_INT(pthread_rwlock_rdlock(&rwlock), 0);
+
+    TEST_ASSERT_EQUAL_INT(pthread_rwlock_destroy(&rwlock), EBUSY);
+
+    TEST_ASSERT_EQUAL_INT(pthread_rwlock_unlock(&rwlock), 0);
+    TEST_ASSERT_EQUAL_INT(pthread_rwlock_destroy(&rwlock), 0);
+}
+
+TEST_CASE("more than 127 read locks", "[pthread][rwlock]")
+{
+    static const size_t READ_LOCK_NUM = 1000;
+    pthread_rwlock_t rwlock;
+    TEST_ASSERT_EQUAL_INT(pthread_rwlock_init(&rwlock, NULL), 0);
+
+    for (size_t i = 0; i < READ_LOCK_NUM; i++) {
+        TEST_ASSERT_EQUAL_INT(pthread_rwlock_rdlock(&rwlock), 0);
+    }
+    TEST_ASSERT_EQUAL_INT(pthread_rwlock_trywrlock(&rwlock), EBUSY);
+    for (size_t i = 0; i < READ_LOCK_NUM; i++) {
+        TEST_ASSERT_EQUAL_INT(pthread_rwlock_unlock(&rwlock), 0);
+    }
+
+    TEST_ASSERT_EQUAL_INT(pthread_rwlock_trywrlock(&rwlock), 0);
+    TEST_ASSERT_EQUAL_INT(pthread_rwlock_unlock(&rwlock), 0);
+    TEST_ASSERT_EQUAL_INT(pthread_rwlock_destroy(&rwlock), 0);
+}
+
+TEST_CASE("rwlockattr invalid param", "[pthread][rwlock]")
+{
+    pthread_rwlockattr_t attr;
+    pthread_rwlock_t rwlock;
+    int kind;
+
+    TEST_ASSERT_EQUAL_INT(pthread_rwlockattr_init(NULL), EINVAL);
+    TEST_ASSERT_EQUAL_INT(pthread_rwlockattr_destroy(NULL), EINVAL);
+
+    TEST_ASSERT_EQUAL_INT(pthread_rwlockattr_init(&attr), 0);
+    TEST_ASSERT_EQUAL_INT(pthread_rwlockattr_setkind_np(&attr, -1), EINVAL);
+    TEST_ASSERT_EQUAL_INT(pthread_rwlockattr_getkind_np(&attr, NULL), EINVAL);
+    TEST_ASSERT_EQUAL_INT(pthread_rwlockattr_setpshared(&attr, PTHREAD_PROCESS_SHARED), ENOTSUP);
+    TEST_ASSERT_EQUAL_INT(pthread_rwlockattr_destroy(&attr), 0);
+
+    // Destroyed attributes can neither be used nor queried
+    TEST_ASSERT_EQUAL_INT(pthread_rwlock_init(&rwlock, &attr), EINVAL);
+    TEST_ASSERT_EQUAL_INT(pthread_rwlockattr_getkind_np(&attr, &kind), EINVAL);
+}
+
+TEST_CASE("rwlockattr get and set", "[pthread][rwlock]")
+{
+    pthread_rwlockattr_t attr;
+    int kind;
+    int pshared;
+
+    TEST_ASSERT_EQUAL_INT(pthread_rwlockattr_init(&attr), 0);
+
+    TEST_ASSERT_EQUAL_INT(pthread_rwlockattr_getkind_np(&attr, &kind), 0);
+    TEST_ASSERT_EQUAL_INT(kind, PTHREAD_RWLOCK_DEFAULT_NP);
+    TEST_ASSERT_EQUAL_INT(pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP), 0);
+    TEST_ASSERT_EQUAL_INT(pthread_rwlockattr_getkind_np(&attr, &kind), 0);
+    TEST_ASSERT_EQUAL_INT(kind, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+
+    TEST_ASSERT_EQUAL_INT(pthread_rwlockattr_getpshared(&attr, &pshared), 0);
+    TEST_ASSERT_EQUAL_INT(pshared, PTHREAD_PROCESS_PRIVATE);
+    TEST_ASSERT_EQUAL_INT(pthread_rwlockattr_setpshared(&attr, PTHREAD_PROCESS_PRIVATE), 0);
+
+    TEST_ASSERT_EQUAL_INT(pthread_rwlockattr_destroy(&attr), 0);
+}
+
+static void *waiting_writer(void *arg)
+{
+    pthread_rwlock_t *rwlock = (pthread_rwlock_t *) arg;
+
+    // The result is checked by the test task, Unity assertions must not fail in other threads
+    int res = pthread_rwlock_wrlock(rwlock);
+    if (res == 0) {
+        res = pthread_rwlock_unlock(rwlock);
+    }
+
+    return (void *) (intptr_t) res;
+}
+
+static void test_rwlock_waiting_writer(int kind, int expected_tryrdlock_result)
+{
+    pthread_rwlockattr_t attr;
+    pthread_rwlock_t rwlock;
+    pthread_t writer_thread;
+    void *writer_result;
+
+    TEST_ASSERT_EQUAL_INT(pthread_rwlockattr_init(&attr), 0);
+    TEST_ASSERT_EQUAL_INT(pthread_rwlockattr_setkind_np(&attr, kind), 0);
+    TEST_ASSERT_EQUAL_INT(pthread_rwlock_init(&rwlock, &attr), 0);
+    TEST_ASSERT_EQUAL_INT(pthread_rwlockattr_destroy(&attr), 0);
+
+    TEST_ASSERT_EQUAL_INT(pthread_rwlock_rdlock(&rwlock), 0);
+    TEST_ASSERT_EQUAL(pthread_create(&writer_thread, NULL, waiting_writer, &rwlock), 0);
+    vTaskDelay(20 / portTICK_PERIOD_MS); // let the writer block on the read-locked rwlock
+
+    int res = pthread_rwlock_tryrdlock(&rwlock);
+    TEST_ASSERT_EQUAL_INT(expected_tryrdlock_result, res);
+    if (res == 0) {
+        TEST_ASSERT_EQUAL_INT(pthread_rwlock_unlock(&rwlock), 0);
+    }
+
+    TEST_ASSERT_EQUAL_INT(pthread_rwlock_unlock(&rwlock), 0);
+    TEST_ASSERT_EQUAL(pthread_join(writer_thread, &writer_result), 0);
+    TEST_ASSERT_EQUAL_INT(0, (intptr_t) writer_result);
+    TEST_ASSERT_EQUAL_INT(pthread_rwlock_destroy(&rwlock), 0);
+}
+
+TEST_CASE("reader preference lets readers in while a writer waits", "[pthread][rwlock]")
+{
+    test_rwlock_waiting_writer(PTHREAD_RWLOCK_PREFER_READER_NP, 0);
+    // As in glibc, PTHREAD_RWLOCK_PREFER_WRITER_NP is reader preferring so that recursive read locks cannot deadlock
+    test_rwlock_waiting_writer(PTHREAD_RWLOCK_PREFER_WRITER_NP, 0);
+}
+
+TEST_CASE("non-recursive writer preference blocks readers while a writer waits", "[pthread][rwlock]")
+{
+    test_rwlock_waiting_writer(PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP, EBUSY);
+}
@@ -0,0 +1,186 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/*
+ * Read scalability benchmark for pthread_rwlock. Only standard pthread and clock functions are used so that the same
+ * benchmark runs on the chips and on the Linux target. On the Linux target pthread_rwlock_t is the host's, so the
+ * IDF implementation behind it is benchmarked separately through esp_pthread_rwlock_t.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+#include "sdkconfig.h"
+#include "unity.h"
+#include "esp_private/pthread_rwlock_core.h"
+
+#define RWLOCK_PERF_MAX_THREADS     4
+#define RWLOCK_PERF_ITERATIONS      20000
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int ready;
+    bool go;
+} rwlock_perf_gate_t;
+
+typedef struct {
+    const char *name;
+    int (*rdlock)(void *rwlock);
+    int (*unlock)(void *rwlock);
+} rwlock_perf_impl_t;
+
+typedef struct {
+    const rwlock_perf_impl_t *impl;
+    void *rwlock;
+    rwlock_perf_gate_t *gate;
+    volatile uint32_t *shared_value;
+    uint32_t sum;
+    uint32_t errors;
+} rwlock_perf_args_t;
+
+static int pthread_rwlock_perf_rdlock(void *rwlock)
+{
+    return pthread_rwlock_rdlock((pthread_rwlock_t *) rwlock);
+}
+
+static int pthread_rwlock_perf_unlock(void *rwlock)
+{
+    return pthread_rwlock_unlock((pthread_rwlock_t *) rwlock);
+}
+
+static int esp_pthread_rwlock_perf_rdlock(void *rwlock)
+{
+    return esp_pthread_rwlock_rdlock((esp_pthread_rwlock_t *) rwlock);
+}
+
+static int esp_pthread_rwlock_perf_unlock(void *rwlock)
+{
+    return esp_pthread_rwlock_unlock((esp_pthread_rwlock_t *) rwlock);
+}
+
+static const rwlock_perf_impl_t pthread_rwlock_perf_impl = {
+    .name = "pthread_rwlock_t",
+    .rdlock = pthread_rwlock_perf_rdlock,
+    .unlock = pthread_rwlock_perf_unlock,
+};
+
+static const rwlock_perf_impl_t esp_pthread_rwlock_perf_impl = {
+    .name = "esp_pthread_rwlock_t",
+    .rdlock = esp_pthread_rwlock_perf_rdlock,
+    .unlock = esp_pthread_rwlock_perf_unlock,
+};
+
+static void *rwlock_perf_reader(void *arg)
+{
+    rwlock_perf_args_t *args = (rwlock_perf_args_t *) arg;
+
+    // Report readiness, then wait until all readers are ready and timing has started
+    pthread_mutex_lock(&args->gate->mutex);
+    args->gate->ready++;
+    pthread_cond_broadcast(&args->gate->cond);
+    while (!args->gate->go) {
+        pthread_cond_wait(&args->gate->cond, &args->gate->mutex);
+    }
+    pthread_mutex_unlock(&args->gate->mutex);
+
+    // Unity assertions must not fail outside of the test task, so errors are only counted here
+    for (int i = 0; i < RWLOCK_PERF_ITERATIONS; i++) {
+        if (args->impl->rdlock(args->rwlock) != 0) {
+            args->errors++;
+            continue;
+        }
+        args->sum += *args->shared_value;
+        if (args->impl->unlock(args->rwlock) != 0) {
+            args->errors++;
+        }
+    }
+
+    return NULL;
+}
+
+static uint64_t rwlock_perf_time_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void rwlock_perf_run(const rwlock_perf_impl_t *impl, void *rwlock)
+{
+    volatile uint32_t shared_value = 1;
+
+    for (int thread_num = 1; thread_num <= RWLOCK_PERF_MAX_THREADS; thread_num++) {
+        pthread_t threads[RWLOCK_PERF_MAX_THREADS];
+        rwlock_perf_args_t args[RWLOCK_PERF_MAX_THREADS];
+        rwlock_perf_gate_t gate = { .ready = 0, .go = false };
+
+        TEST_ASSERT_EQUAL_INT(0, pthread_mutex_init(&gate.mutex, NULL));
+        TEST_ASSERT_EQUAL_INT(0, pthread_cond_init(&gate.cond, NULL));
+        for (int i = 0; i < thread_num; i++) {
+            args[i] = (rwlock_perf_args_t) {
+                .impl = impl,
+                .rwlock = rwlock,
+                .gate = &gate,
+                .shared_value = &shared_value,
+            };
+            TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[i], NULL, rwlock_perf_reader, &args[i]));
+        }
+
+        // Start timing once all readers are ready, so that thread creation is not measured
+        pthread_mutex_lock(&gate.mutex);
+        while (gate.ready < thread_num) {
+            pthread_cond_wait(&gate.cond, &gate.mutex);
+        }
+        uint64_t start_us = rwlock_perf_time_us();
+        gate.go = true;
+        pthread_cond_broadcast(&gate.cond);
+        pthread_mutex_unlock(&gate.mutex);
+
+        for (int i = 0; i < thread_num; i++) {
+            TEST_ASSERT_EQUAL_INT(0, pthread_join(threads[i], NULL));
+            TEST_ASSERT_EQUAL_UINT32(0, args[i].errors);
+            TEST_ASSERT_EQUAL_UINT32(RWLOCK_PERF_ITERATIONS, args[i].sum);
+        }
+        uint64_t elapsed_us = rwlock_perf_time_us() - start_us;
+        TEST_ASSERT_EQUAL_INT(0, pthread_cond_destroy(&gate.cond));
+        TEST_ASSERT_EQUAL_INT(0, pthread_mutex_destroy(&gate.mutex));
+
+        uint64_t pairs = (uint64_t) thread_num * RWLOCK_PERF_ITERATIONS;
+        printf("%s, %d reader thread(s): %llu rdlock/unlock pairs in %llu us (%llu pairs/s)\n", impl->name,
+               thread_num, (unsigned long long) pairs, (unsigned long long) elapsed_us,
+               (unsigned long long) (pairs * 1000000 / (elapsed_us ? elapsed_us : 1)));
+    }
+
+}
+
+/*
+Benchmark read lock scalability of pthread_rwlock
+
+Procedure:
+    - For 1 to RWLOCK_PERF_MAX_THREADS reader threads, each thread takes and releases a read lock
+      RWLOCK_PERF_ITERATIONS times, reading a value protected by the lock
+    - Do this once with pthread_rwlock_t and once with esp_pthread_rwlock_t, the IDF implementation behind
+      pthread_rwlock_t on the chips
+
+Expected:
+    - All read locks succeed, the number of read lock/unlock pairs per second is printed for each thread count
+*/
+TEST_CASE("rwlock read scalability", "[pthread][rwlock][perf]")
+{
+    pthread_rwlock_t rwlock;
+    TEST_ASSERT_EQUAL_INT(0, pthread_rwlock_init(&rwlock, NULL));
+    rwlock_perf_run(&pthread_rwlock_perf_impl, &rwlock);
+    TEST_ASSERT_EQUAL_INT(0, pthread_rwlock_destroy(&rwlock));
+
+    esp_pthread_rwlock_t esp_rwlock;
+    TEST_ASSERT_EQUAL_INT(0, esp_pthread_rwlock_init(&esp_rwlock, false));
+    rwlock_perf_run(&esp_pthread_rwlock_perf_impl, &esp_rwlock);
+    TEST_ASSERT_EQUAL_INT(0, esp_pthread_rwlock_destroy(&esp_rwlock));
+}
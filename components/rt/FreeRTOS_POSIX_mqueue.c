@@ -6,7 +6,7 @@
  *
  * SPDX-License-Identifier: MIT
  *
- * SPDX-FileContributor: 2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileContributor: 2024-2025 Espressif Systems (Shanghai) CO LTD
  *
  * Permission is hereby granted, free of charge, to any person obtaining a copy of
  * this software and associated documentation files (the "Software"), to deal in
@@ -35,6 +35,7 @@
  */
 
 /* C standard library includes. */
+#include <stdint.h>
 #include <string.h>
 
 #include <errno.h>
@@ -48,30 +49,80 @@
 
 #include "aws_doubly_linked_list.h"
 #include "esp_private/critical_section.h"
+#include "esp_mqueue.h"
 
 /**
- * @brief Element of the FreeRTOS queues that store mq data.
+ * @brief Number of buckets of the hash tables used to find queues by name and
+ * by descriptor. Must be a power of 2.
  */
-typedef struct QueueElement
+#define mqHASH_BUCKETS           16
+
+/**
+ * @brief Alignment of the message slots, and of the message data in them.
+ */
+#define mqMESSAGE_ALIGNMENT      8
+
+/**
+ * @brief Round x up to the message alignment.
+ */
+#define mqALIGN_UP( x )          ( ( ( x ) + mqMESSAGE_ALIGNMENT - 1 ) & ~( ( size_t ) mqMESSAGE_ALIGNMENT - 1 ) )
+
+/**
+ * @brief Header of a message slot. The message data follows the header.
+ */
+typedef struct MessageHeader
 {
-    char * pcData;    /**< Data in queue. Type char* to match msg_ptr. */
-    size_t xDataSize; /**< Size of data pointed by pcData. */
-} QueueElement_t;
+    struct MessageHeader * pxNext; /**< Next message in the free list or in the list of queued messages. */
+    size_t xDataSize;              /**< Size of the message data. */
+    unsigned int uxPriority;       /**< Priority of the message. */
+    BaseType_t xBorrowed;          /**< pdTRUE while the message is borrowed by esp_mq_timedreceive_borrow(). */
+} MessageHeader_t;
+
+/**
+ * @brief Offset of the message data in a message slot.
+ */
+#define mqMESSAGE_DATA_OFFSET    mqALIGN_UP( sizeof( MessageHeader_t ) )
 
 /**
  * @brief Data structure of an mq.
  *
  * FreeRTOS isn't guaranteed to have a file-like abstraction, so message
- * queues in this implementation are stored as a linked list (in RAM).
+ * queues in this implementation are stored in hash tables (in RAM), indexed
+ * by name and by descriptor.
+ *
+ * The storage of all the messages is allocated when the queue is created.
+ * Free message slots are kept in a free list, queued messages are kept in a
+ * list sorted by decreasing priority, in the order they were sent for equal
+ * priorities. Two counting semaphores count the free slots and the queued
+ * messages, so that senders and receivers can block on them.
+ *
+ * Senders and receivers use the queue after releasing the queue list mutex,
+ * so the queue counts the operations in progress and the borrowed messages. A
+ * queue removed from the queue list is only deleted once both counts are 0.
+ * Until its borrowed messages are returned, it stays in the hash table of
+ * descriptors, so that esp_mq_return() can find it.
  */
 typedef struct QueueListElement
 {
-    Link_t xLink;              /**< Pointer to the next element in the list. */
-    QueueHandle_t xQueue;      /**< FreeRTOS queue handle. */
-    size_t xOpenDescriptors;   /**< Number of threads that have opened this queue. */
-    char * pcName;             /**< Null-terminated queue name. */
-    struct mq_attr xAttr;      /**< Queue attributes. */
-    BaseType_t xPendingUnlink; /**< If pdTRUE, this queue will be unlinked once all descriptors close. */
+    Link_t xLink;                            /**< Link in the hash bucket of the queue name. */
+    Link_t xDescriptorLink;                  /**< Link in the hash bucket of the queue descriptor. */
+    size_t xOpenDescriptors;                 /**< Number of threads that have opened this queue. */
+    char * pcName;                           /**< Null-terminated queue name. */
+    struct mq_attr xAttr;                    /**< Queue attributes. */
+    BaseType_t xPendingUnlink;               /**< If pdTRUE, this queue will be unlinked once all descriptors close. */
+    StaticSemaphore_t xFreeSlotsBuffer;      /**< Storage of xFreeSlots. */
+    StaticSemaphore_t xQueuedMessagesBuffer; /**< Storage of xQueuedMessages. */
+    SemaphoreHandle_t xFreeSlots;            /**< Counts the message slots in pxFreeList. */
+    SemaphoreHandle_t xQueuedMessages;       /**< Counts the messages in the list of queued messages. */
+    char * pcStorage;                        /**< Storage of the mq_maxmsg message slots. */
+    size_t xSlotSize;                        /**< Size of a message slot, header included. */
+    MessageHeader_t * pxFreeList;            /**< Free message slots. */
+    MessageHeader_t * pxHead;                /**< Queued message received next. */
+    MessageHeader_t * pxTail;                /**< Queued message with the lowest priority, sent last. */
+    size_t xOperations;                      /**< Number of operations in progress on the queue. */
+    size_t xBorrowedMessages;                /**< Number of messages borrowed and not yet returned. */
+    BaseType_t xRemoved;                     /**< If pdTRUE, the queue was closed and unlinked, only its borrowed messages can be returned. */
+    DECLARE_CRIT_SECTION_LOCK_IN_STRUCT( xLock )
 } QueueListElement_t;
 
 /*-----------------------------------------------------------*/
@@ -115,10 +166,59 @@ static BaseType_t prvCreateNewMessageQueue( QueueListElement_t ** ppxMessageQueu
  */
 static void prvDeleteMessageQueue( const QueueListElement_t * const pxMessageQueue );
 
+/**
+ * @brief Remove a queue from the queue list.
+ *
+ * The queue stays in the hash table of descriptors while messages are
+ * borrowed from it, the last esp_mq_return() removes it from there.
+ * Must be called with xQueueListMutex held.
+ * @param[in] pxMessageQueue The queue to remove.
+ *
+ * @return pdTRUE if the queue must be deleted by the caller once
+ * xQueueListMutex is released; pdFALSE if it is deleted by prvEndOperation()
+ * or esp_mq_return() once the operations in progress are done and the
+ * borrowed messages are returned.
+ */
+static BaseType_t prvRemoveMessageQueue( QueueListElement_t * pxMessageQueue );
+
+/**
+ * @brief Check that a descriptor refers to a queue that can be used, i.e. a
+ * queue of the queue list that was not removed.
+ *
+ * Must be called with xQueueListMutex held.
+ * @param[in] xMessageQueueDescriptor The queue descriptor.
+ *
+ * @return pdTRUE if the queue can be used; pdFALSE otherwise.
+ */
+static BaseType_t prvFindOpenQueue( mqd_t xMessageQueueDescriptor );
+
+/**
+ * @brief Start an operation on a queue, so that the queue is not deleted
+ * while the operation uses it.
+ *
+ * Must be called with xQueueListMutex held, on a queue of the queue list.
+ * @param[in] pxMessageQueue The queue.
+ *
+ * @return nothing
+ */
+static void prvBeginOperation( QueueListElement_t * pxMessageQueue );
+
+/**
+ * @brief End an operation started with prvBeginOperation().
+ *
+ * Deletes the queue if it was removed from the queue list and nothing uses
+ * it anymore.
+ * @param[in] pxMessageQueue The queue.
+ *
+ * @return nothing
+ */
+static void prvEndOperation( QueueListElement_t * pxMessageQueue );
+
 /**
  * @brief Attempt to find the queue identified by pcName or xMqId in the queue list.
  *
- * Matches queues by pcName first; if pcName is NULL, matches by xMqId.
+ * Matches queues by pcName if provided; if pcName is NULL, matches by xMqId.
+ * Both lookups only search a single hash bucket.
  * @param[out] ppxQueueListElement Output parameter set when queue is found.
  * @param[in] pcName A queue name to match.
  * @param[in] xMessageQueueDescriptor A queue descriptor to match.
@@ -150,15 +250,71 @@ static void prvInitializeQueueList( void );
 static BaseType_t prvValidateQueueName( const char * const pcName,
                                         size_t * pxNameLength );
 
+/**
+ * @brief Hash a queue name.
+ *
+ * @param[in] pcName The name to hash.
+ *
+ * @return Index of the hash bucket of the name.
+ */
+static size_t prvHashName( const char * pcName );
+
+/**
+ * @brief Hash a queue descriptor.
+ *
+ * @param[in] xMessageQueueDescriptor The descriptor to hash.
+ *
+ * @return Index of the hash bucket of the descriptor.
+ */
+static size_t prvHashDescriptor( mqd_t xMessageQueueDescriptor );
+
+/**
+ * @brief Take a message from a queue, blocking until one is available.
+ *
+ * On success, the caller owns the message slot until it is given back with
+ * prvReleaseMessage(), and must end the operation on the queue with
+ * prvEndOperation().
+ *
+ * @param[in] mqdes The queue descriptor.
+ * @param[in] msg_len Size of the buffer the message will be copied to, or
+ * SIZE_MAX if the message is not copied.
+ * @param[in] abstime The absolute timeout, or NULL to block forever.
+ * @param[in] xBorrow pdTRUE if the message is borrowed until esp_mq_return().
+ * @param[out] ppxMessage Output parameter of the message.
+ *
+ * @return 0 if successful; -1 with errno set otherwise.
+ */
+static int prvReceiveMessage( mqd_t mqdes,
+                              size_t msg_len,
+                              const struct timespec * abstime,
+                              BaseType_t xBorrow,
+                              MessageHeader_t ** ppxMessage );
+
+/**
+ * @brief Give a message slot back to the free list of its queue.
+ *
+ * @param[in] pxMessageQueue The queue the message belongs to.
+ * @param[in] pxMessage The message slot.
+ *
+ * @return nothing
+ */
+static void prvReleaseMessage( QueueListElement_t * pxMessageQueue,
+                               MessageHeader_t * pxMessage );
+
 /**
  * @brief Guards access to the list of message queues.
  */
 static StaticSemaphore_t xQueueListMutex = { { 0 }, .u = { 0 } };
 
 /**
- * @brief Head of the linked list of queues.
+ * @brief Heads of the hash buckets of queues, indexed by name.
+ */
+static Link_t xQueueNameBuckets[ mqHASH_BUCKETS ] = { 0 };
+
+/**
+ * @brief Heads of the hash buckets of queues, indexed by descriptor.
  */
-static Link_t xQueueListHead = { 0 };
+static Link_t xQueueDescriptorBuckets[ mqHASH_BUCKETS ] = { 0 };
 
 DEFINE_CRIT_SECTION_LOCK_STATIC( critical_section_lock );
 
@@ -211,26 +367,28 @@ static BaseType_t prvCreateNewMessageQueue( QueueListElement_t ** ppxMessageQueu
                                             size_t xNameLength )
 {
     BaseType_t xStatus = pdTRUE;
+    size_t xSlotSize = mqMESSAGE_DATA_OFFSET + mqALIGN_UP( ( size_t ) pxAttr->mq_msgsize );
+    size_t xHeaderSize = mqALIGN_UP( sizeof( QueueListElement_t ) );
+    size_t xMaxMessages = ( size_t ) pxAttr->mq_maxmsg;
+    QueueListElement_t * pxMessageQueue = NULL;
 
-    /* Allocate space for a new queue element. */
-    *ppxMessageQueue = pvPortMalloc( sizeof( QueueListElement_t ) );
-
-    /* Check that memory allocation succeeded. */
-    if( *ppxMessageQueue == NULL )
+    /* Check that the size of the storage of all the messages does not overflow. */
+    if( ( xSlotSize < ( size_t ) pxAttr->mq_msgsize ) ||
+        ( xMaxMessages > ( ( SIZE_MAX - xHeaderSize ) / xSlotSize ) ) ||
+        ( xMaxMessages > ( size_t ) ( ( UBaseType_t ) -1 ) ) )
     {
         xStatus = pdFALSE;
     }
 
-    /* Create the FreeRTOS queue. */
+    /* Allocate space for a new queue element, followed by the storage of its
+     * messages. */
     if( xStatus == pdTRUE )
     {
-        ( *ppxMessageQueue )->xQueue =
-            xQueueCreate( pxAttr->mq_maxmsg, sizeof( QueueElement_t ) );
+        pxMessageQueue = pvPortMalloc( xHeaderSize + xMaxMessages * xSlotSize );
 
-        /* Check that queue creation succeeded. */
-        if( ( *ppxMessageQueue )->xQueue == NULL )
+        /* Check that memory allocation succeeded. */
+        if( pxMessageQueue == NULL )
         {
-            vPortFree( *ppxMessageQueue );
             xStatus = pdFALSE;
         }
     }
@@ -238,38 +396,70 @@ static BaseType_t prvCreateNewMessageQueue( QueueListElement_t ** ppxMessageQueu
     if( xStatus == pdTRUE )
     {
         /* Allocate space for the queue name plus null-terminator. */
-        ( *ppxMessageQueue )->pcName = pvPortMalloc( xNameLength + 1 );
+        pxMessageQueue->pcName = pvPortMalloc( xNameLength + 1 );
 
         /* Check that memory was successfully allocated for queue name. */
-        if( ( *ppxMessageQueue )->pcName == NULL )
+        if( pxMessageQueue->pcName == NULL )
         {
-            vQueueDelete( ( *ppxMessageQueue )->xQueue );
-            vPortFree( *ppxMessageQueue );
+            vPortFree( pxMessageQueue );
             xStatus = pdFALSE;
         }
         else
         {
             /* Copy queue name. Copying xNameLength+1 will cause strncpy to add
              * the null-terminator. */
-            ( void ) strncpy( ( *ppxMessageQueue )->pcName, pcName, xNameLength + 1 );
+            ( void ) strncpy( pxMessageQueue->pcName, pcName, xNameLength + 1 );
         }
     }
 
     if( xStatus == pdTRUE )
     {
+        /* Create the semaphores counting the free slots and the queued
+         * messages. They are statically allocated, so this cannot fail. */
+        pxMessageQueue->xFreeSlots = xSemaphoreCreateCountingStatic( ( UBaseType_t ) xMaxMessages,
+                                                                     ( UBaseType_t ) xMaxMessages,
+                                                                     &pxMessageQueue->xFreeSlotsBuffer );
+        pxMessageQueue->xQueuedMessages = xSemaphoreCreateCountingStatic( ( UBaseType_t ) xMaxMessages,
+                                                                          0,
+                                                                          &pxMessageQueue->xQueuedMessagesBuffer );
+        INIT_CRIT_SECTION_LOCK_RUNTIME( &pxMessageQueue->xLock );
+
+        /* Put all the message slots in the free list. */
+        pxMessageQueue->pcStorage = ( char * ) pxMessageQueue + xHeaderSize;
+        pxMessageQueue->xSlotSize = xSlotSize;
+        pxMessageQueue->pxFreeList = NULL;
+        pxMessageQueue->pxHead = NULL;
+        pxMessageQueue->pxTail = NULL;
+        pxMessageQueue->xOperations = 0;
+        pxMessageQueue->xBorrowedMessages = 0;
+        pxMessageQueue->xRemoved = pdFALSE;
+
+        for( size_t i = xMaxMessages; i > 0; i-- )
+        {
+            MessageHeader_t * pxMessage = ( MessageHeader_t * ) ( pxMessageQueue->pcStorage + ( i - 1 ) * xSlotSize );
+            pxMessage->pxNext = pxMessageQueue->pxFreeList;
+            pxMessage->xBorrowed = pdFALSE;
+            pxMessageQueue->pxFreeList = pxMessage;
+        }
+
         /* Copy attributes. */
-        ( *ppxMessageQueue )->xAttr = *pxAttr;
+        pxMessageQueue->xAttr = *pxAttr;
+        pxMessageQueue->xAttr.mq_curmsgs = 0;
 
         /* A newly-created queue will have 1 open descriptor for it. */
-        ( *ppxMessageQueue )->xOpenDescriptors = 1;
+        pxMessageQueue->xOpenDescriptors = 1;
 
         /* A newly-created queue will not be pending unlink. */
-        ( *ppxMessageQueue )->xPendingUnlink = pdFALSE;
+        pxMessageQueue->xPendingUnlink = pdFALSE;
 
-        /* Add the new queue to the list. */
-        listADD( &xQueueListHead, &( *ppxMessageQueue )->xLink );
+        /* Add the new queue to the hash tables. */
+        listADD( &xQueueNameBuckets[ prvHashName( pcName ) ], &pxMessageQueue->xLink );
+        listADD( &xQueueDescriptorBuckets[ prvHashDescriptor( ( mqd_t ) pxMessageQueue ) ],
+                 &pxMessageQueue->xDescriptorLink );
     }
 
+    *ppxMessageQueue = pxMessageQueue;
+
     return xStatus;
 }
 
@@ -277,21 +467,73 @@ static BaseType_t prvCreateNewMessageQueue( QueueListElement_t ** ppxMessageQueu
 
 static void prvDeleteMessageQueue( const QueueListElement_t * const pxMessageQueue )
 {
-    QueueElement_t xQueueElement = { 0 };
+    /* The messages are stored together with the queue element, so freeing
+     * the queue element also frees all the messages still in the queue. */
+    vSemaphoreDelete( pxMessageQueue->xFreeSlots );
+    vSemaphoreDelete( pxMessageQueue->xQueuedMessages );
+    vPortFree( ( void * ) pxMessageQueue->pcName );
+    vPortFree( ( void * ) pxMessageQueue );
+}
+
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvRemoveMessageQueue( QueueListElement_t * pxMessageQueue )
+{
+    BaseType_t xBorrowed = pdFALSE;
+    BaseType_t xUnused = pdFALSE;
 
-    /* Free all data in the queue. It's assumed that no more data will be added
-     * to the queue, so xQueueReceive does not block. */
-    while( xQueueReceive( pxMessageQueue->xQueue,
-                          ( void * ) &xQueueElement,
-                          0 ) == pdTRUE )
+    listREMOVE( &pxMessageQueue->xLink );
+
+    /* No new operation can start once the queue is removed. If one is still
+     * in progress, the last one to end deletes the queue. */
+    esp_os_enter_critical( &pxMessageQueue->xLock );
+    pxMessageQueue->xRemoved = pdTRUE;
+    xBorrowed = ( pxMessageQueue->xBorrowedMessages != 0 );
+    xUnused = ( pxMessageQueue->xOperations == 0 ) && ( xBorrowed == pdFALSE );
+    esp_os_exit_critical( &pxMessageQueue->xLock );
+
+    if( xBorrowed == pdFALSE )
     {
-        vPortFree( xQueueElement.pcData );
+        listREMOVE( &pxMessageQueue->xDescriptorLink );
     }
 
-    /* Free memory used by this message queue. */
-    vQueueDelete( pxMessageQueue->xQueue );
-    vPortFree( ( void * ) pxMessageQueue->pcName );
-    vPortFree( ( void * ) pxMessageQueue );
+    return xUnused;
+}
+
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvFindOpenQueue( mqd_t xMessageQueueDescriptor )
+{
+    return ( prvFindQueueInList( NULL, NULL, xMessageQueueDescriptor ) == pdTRUE ) &&
+           ( ( ( QueueListElement_t * ) xMessageQueueDescriptor )->xRemoved == pdFALSE );
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvBeginOperation( QueueListElement_t * pxMessageQueue )
+{
+    esp_os_enter_critical( &pxMessageQueue->xLock );
+    pxMessageQueue->xOperations++;
+    esp_os_exit_critical( &pxMessageQueue->xLock );
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvEndOperation( QueueListElement_t * pxMessageQueue )
+{
+    BaseType_t xDelete = pdFALSE;
+
+    esp_os_enter_critical( &pxMessageQueue->xLock );
+    pxMessageQueue->xOperations--;
+    xDelete = ( pxMessageQueue->xRemoved == pdTRUE ) &&
+              ( pxMessageQueue->xOperations == 0 ) &&
+              ( pxMessageQueue->xBorrowedMessages == 0 );
+    esp_os_exit_critical( &pxMessageQueue->xLock );
+
+    if( xDelete == pdTRUE )
+    {
+        prvDeleteMessageQueue( pxMessageQueue );
+    }
 }
 
 /*-----------------------------------------------------------*/
@@ -304,20 +546,30 @@ static BaseType_t prvFindQueueInList( QueueListElement_t ** const ppxQueueListEl
     QueueListElement_t * pxMessageQueue = NULL;
     BaseType_t xQueueFound = pdFALSE;
 
-    /* Iterate through the list of queues. */
-    listFOR_EACH( pxQueueListLink, &xQueueListHead )
+    /* Match by name if provided. */
+    if( pcName != NULL )
     {
-        pxMessageQueue = listCONTAINER( pxQueueListLink, QueueListElement_t, xLink );
-
-        /* Match by name first if provided. */
-        if( ( pcName != NULL ) && ( strcmp( pxMessageQueue->pcName, pcName ) == 0 ) )
+        /* Iterate through the queues whose name has the same hash. */
+        listFOR_EACH( pxQueueListLink, &xQueueNameBuckets[ prvHashName( pcName ) ] )
         {
-            xQueueFound = pdTRUE;
-            break;
+            pxMessageQueue = listCONTAINER( pxQueueListLink, QueueListElement_t, xLink );
+
+            if( strcmp( pxMessageQueue->pcName, pcName ) == 0 )
+            {
+                xQueueFound = pdTRUE;
+                break;
+            }
         }
-        /* If name doesn't match, match by descriptor. */
-        else
+    }
+    /* Otherwise, match by descriptor. */
+    else
+    {
+        /* Iterate through the queues whose descriptor has the same hash. The
+         * descriptor is not dereferenced unless it matches a queue. */
+        listFOR_EACH( pxQueueListLink, &xQueueDescriptorBuckets[ prvHashDescriptor( xMessageQueueDescriptor ) ] )
         {
+            pxMessageQueue = listCONTAINER( pxQueueListLink, QueueListElement_t, xDescriptorLink );
+
             if( ( mqd_t ) pxMessageQueue == xMessageQueueDescriptor )
             {
                 xQueueFound = pdTRUE;
@@ -354,9 +606,15 @@ static void prvInitializeQueueList( void )
          * section. */
         if( xQueueListInitialized == pdFALSE )
         {
-            /* Initialize the queue list mutex and list head. */
+            /* Initialize the queue list mutex and the heads of the hash buckets. */
             ( void ) xSemaphoreCreateMutexStatic( &xQueueListMutex );
-            listINIT_HEAD( &xQueueListHead );
+
+            for( size_t i = 0; i < mqHASH_BUCKETS; i++ )
+            {
+                listINIT_HEAD( &xQueueNameBuckets[ i ] );
+                listINIT_HEAD( &xQueueDescriptorBuckets[ i ] );
+            }
+
             xQueueListInitialized = pdTRUE;
         }
 
@@ -400,6 +658,177 @@ static BaseType_t prvValidateQueueName( const char * const pcName,
 
 /*-----------------------------------------------------------*/
 
+static size_t prvHashName( const char * pcName )
+{
+    /* 32-bit FNV-1a hash. */
+    uint32_t ulHash = 2166136261U;
+
+    while( *pcName != '\0' )
+    {
+        ulHash ^= ( uint8_t ) *pcName++;
+        ulHash *= 16777619U;
+    }
+
+    return ( size_t ) ( ulHash & ( mqHASH_BUCKETS - 1 ) );
+}
+
+/*-----------------------------------------------------------*/
+
+static size_t prvHashDescriptor( mqd_t xMessageQueueDescriptor )
+{
+    /* Queue elements are allocated from the heap, so the low bits of their
+     * address carry little information. */
+    uintptr_t uxAddress = ( uintptr_t ) xMessageQueueDescriptor;
+
+    return ( size_t ) ( ( uxAddress >> 3 ) ^ ( uxAddress >> 9 ) ) & ( mqHASH_BUCKETS - 1 );
+}
+
+/*-----------------------------------------------------------*/
+
+static int prvReceiveMessage( mqd_t mqdes,
+                              size_t msg_len,
+                              const struct timespec * abstime,
+                              BaseType_t xBorrow,
+                              MessageHeader_t ** ppxMessage )
+{
+    int iStatus = 0;
+    int iCalculateTimeoutReturn = 0;
+    TickType_t xTimeoutTicks = 0;
+    QueueListElement_t * pxMessageQueue = ( QueueListElement_t * ) mqdes;
+    MessageHeader_t * pxMessage = NULL;
+
+    /* Lock the mutex that guards access to the queue list. This call will
+     * never fail because it blocks forever. */
+    ( void ) xSemaphoreTake( ( SemaphoreHandle_t ) &xQueueListMutex, portMAX_DELAY );
+
+    /* Find the mq referenced by mqdes. */
+    if( prvFindOpenQueue( mqdes ) == pdFALSE )
+    {
+        /* Queue not found; bad descriptor. */
+        errno = EBADF;
+        iStatus = -1;
+    }
+
+    /* Verify that msg_len is large enough. */
+    if( iStatus == 0 )
+    {
+        if( msg_len < ( size_t ) pxMessageQueue->xAttr.mq_msgsize )
+        {
+            /* msg_len too small. */
+            errno = EMSGSIZE;
+            iStatus = -1;
+        }
+    }
+
+    if( iStatus == 0 )
+    {
+        /* Convert abstime to a tick timeout. */
+        iCalculateTimeoutReturn = prvCalculateTickTimeout( pxMessageQueue->xAttr.mq_flags,
+                                                           abstime,
+                                                           &xTimeoutTicks );
+
+        if( iCalculateTimeoutReturn != 0 )
+        {
+            errno = iCalculateTimeoutReturn;
+            iStatus = -1;
+        }
+    }
+
+    /* Keep the queue alive while waiting for a message. */
+    if( iStatus == 0 )
+    {
+        prvBeginOperation( pxMessageQueue );
+    }
+
+    /* Release the mutex protecting the queue list. */
+    ( void ) xSemaphoreGive( ( SemaphoreHandle_t ) &xQueueListMutex );
+
+    if( iStatus == 0 )
+    {
+        /* Wait for a message to be queued. */
+        if( xSemaphoreTake( pxMessageQueue->xQueuedMessages, xTimeoutTicks ) == pdFALSE )
+        {
+            /* If waiting fails, set the appropriate errno. */
+            if( pxMessageQueue->xAttr.mq_flags & O_NONBLOCK )
+            {
+                /* Set errno to EAGAIN for nonblocking mq. */
+                errno = EAGAIN;
+            }
+            else
+            {
+                /* Otherwise, set errno to ETIMEDOUT. */
+                errno = ETIMEDOUT;
+            }
+
+            iStatus = -1;
+            prvEndOperation( pxMessageQueue );
+        }
+    }
+
+    if( iStatus == 0 )
+    {
+        /* Take the queued message with the highest priority. Taking
+         * xQueuedMessages guarantees that the list is not empty. A message
+         * borrowed once the queue is removed could not be returned, so the
+         * message is left in the queue then. */
+        esp_os_enter_critical( &pxMessageQueue->xLock );
+
+        if( ( xBorrow == pdTRUE ) && ( pxMessageQueue->xRemoved == pdTRUE ) )
+        {
+            iStatus = -1;
+        }
+        else
+        {
+            pxMessage = pxMessageQueue->pxHead;
+            pxMessageQueue->pxHead = pxMessage->pxNext;
+
+            if( pxMessageQueue->pxHead == NULL )
+            {
+                pxMessageQueue->pxTail = NULL;
+            }
+
+            pxMessageQueue->xAttr.mq_curmsgs--;
+
+            if( xBorrow == pdTRUE )
+            {
+                pxMessage->xBorrowed = pdTRUE;
+                pxMessageQueue->xBorrowedMessages++;
+            }
+        }
+
+        esp_os_exit_critical( &pxMessageQueue->xLock );
+
+        if( iStatus == 0 )
+        {
+            *ppxMessage = pxMessage;
+        }
+        else
+        {
+            ( void ) xSemaphoreGive( pxMessageQueue->xQueuedMessages );
+            prvEndOperation( pxMessageQueue );
+            errno = EBADF;
+        }
+    }
+
+    return iStatus;
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvReleaseMessage( QueueListElement_t * pxMessageQueue,
+                               MessageHeader_t * pxMessage )
+{
+    /* Put the slot back in the free list, then let a sender use it. */
+    esp_os_enter_critical( &pxMessageQueue->xLock );
+    pxMessage->pxNext = pxMessageQueue->pxFreeList;
+    pxMessageQueue->pxFreeList = pxMessage;
+    esp_os_exit_critical( &pxMessageQueue->xLock );
+
+    ( void ) xSemaphoreGive( pxMessageQueue->xFreeSlots );
+}
+
+/*-----------------------------------------------------------*/
+
 int mq_close( mqd_t mqdes )
 {
     int iStatus = 0;
@@ -414,7 +843,7 @@ int mq_close( mqd_t mqdes )
     ( void ) xSemaphoreTake( ( SemaphoreHandle_t ) &xQueueListMutex, portMAX_DELAY );
 
     /* Attempt to find the message queue based on the given descriptor. */
-    if( prvFindQueueInList( NULL, NULL, mqdes ) == pdTRUE )
+    if( prvFindOpenQueue( mqdes ) == pdTRUE )
     {
         /* Decrement the number of open descriptors. */
         if( pxMessageQueue->xOpenDescriptors > 0 )
@@ -426,14 +855,11 @@ int mq_close( mqd_t mqdes )
         if( pxMessageQueue->xOpenDescriptors == 0 )
         {
             /* If no open descriptors remain and mq_unlink has already been called,
-             * remove the queue. */
+             * remove the queue. Deleting the queue is deferred until
+             * xQueueListMutex is released. */
             if( pxMessageQueue->xPendingUnlink == pdTRUE )
             {
-                listREMOVE( &pxMessageQueue->xLink );
-
-                /* Set the flag to delete the queue. Deleting the queue is deferred
-                 * until xQueueListMutex is released. */
-                xQueueRemoved = pdTRUE;
+                xQueueRemoved = prvRemoveMessageQueue( pxMessageQueue );
             }
             /* Otherwise, wait for the call to mq_unlink. */
             else
@@ -474,12 +900,13 @@ int mq_getattr( mqd_t mqdes,
     ( void ) xSemaphoreTake( ( SemaphoreHandle_t ) &xQueueListMutex, portMAX_DELAY );
 
     /* Find the mq referenced by mqdes. */
-    if( prvFindQueueInList( NULL, NULL, mqdes ) == pdTRUE )
+    if( prvFindOpenQueue( mqdes ) == pdTRUE )
     {
-        /* Update the number of messages in the queue and copy the attributes
-         * into mqstat. */
-        pxMessageQueue->xAttr.mq_curmsgs = ( long ) uxQueueMessagesWaiting( pxMessageQueue->xQueue );
+        /* Copy the attributes into mqstat. The number of messages in the
+         * queue is updated under the lock of the queue. */
+        esp_os_enter_critical( &pxMessageQueue->xLock );
         *mqstat = pxMessageQueue->xAttr;
+        esp_os_exit_critical( &pxMessageQueue->xLock );
     }
     else
     {
@@ -651,86 +1078,24 @@ ssize_t mq_timedreceive( mqd_t mqdes,
                          unsigned * msg_prio,
                          const struct timespec * abstime )
 {
-    ssize_t xStatus = 0;
-    int iCalculateTimeoutReturn = 0;
-    TickType_t xTimeoutTicks = 0;
+    ssize_t xStatus = -1;
     QueueListElement_t * pxMessageQueue = ( QueueListElement_t * ) mqdes;
-    QueueElement_t xReceiveData = { 0 };
-
-    /* Silence warnings about unused parameters. */
-    ( void ) msg_prio;
-
-    /* Lock the mutex that guards access to the queue list. This call will
-     * never fail because it blocks forever. */
-    ( void ) xSemaphoreTake( ( SemaphoreHandle_t ) &xQueueListMutex, portMAX_DELAY );
-
-    /* Find the mq referenced by mqdes. */
-    if( prvFindQueueInList( NULL, NULL, mqdes ) == pdFALSE )
-    {
-        /* Queue not found; bad descriptor. */
-        errno = EBADF;
-        xStatus = -1;
-    }
+    MessageHeader_t * pxMessage = NULL;
 
-    /* Verify that msg_len is large enough. */
-    if( xStatus == 0 )
+    if( prvReceiveMessage( mqdes, msg_len, abstime, pdFALSE, &pxMessage ) == 0 )
     {
-        if( msg_len < ( size_t ) pxMessageQueue->xAttr.mq_msgsize )
-        {
-            /* msg_len too small. */
-            errno = EMSGSIZE;
-            xStatus = -1;
-        }
-    }
-
-    if( xStatus == 0 )
-    {
-        /* Convert abstime to a tick timeout. */
-        iCalculateTimeoutReturn = prvCalculateTickTimeout( pxMessageQueue->xAttr.mq_flags,
-                                                           abstime,
-                                                           &xTimeoutTicks );
-
-        if( iCalculateTimeoutReturn != 0 )
-        {
-            errno = iCalculateTimeoutReturn;
-            xStatus = -1;
-        }
-    }
-
-    /* Release the mutex protecting the queue list. */
-    ( void ) xSemaphoreGive( ( SemaphoreHandle_t ) &xQueueListMutex );
+        /* Get the length of data for return value. */
+        xStatus = ( ssize_t ) pxMessage->xDataSize;
 
-    if( xStatus == 0 )
-    {
-        /* Receive data from the FreeRTOS queue. */
-        if( xQueueReceive( pxMessageQueue->xQueue,
-                           &xReceiveData,
-                           xTimeoutTicks ) == pdFALSE )
+        if( msg_prio != NULL )
         {
-            /* If queue receive fails, set the appropriate errno. */
-            if( pxMessageQueue->xAttr.mq_flags & O_NONBLOCK )
-            {
-                /* Set errno to EAGAIN for nonblocking mq. */
-                errno = EAGAIN;
-            }
-            else
-            {
-                /* Otherwise, set errno to ETIMEDOUT. */
-                errno = ETIMEDOUT;
-            }
-
-            xStatus = -1;
+            *msg_prio = pxMessage->uxPriority;
         }
-    }
-
-    if( xStatus == 0 )
-    {
-        /* Get the length of data for return value. */
-        xStatus = ( ssize_t ) xReceiveData.xDataSize;
 
-        /* Copy received data into given buffer, then free it. */
-        ( void ) memcpy( msg_ptr, xReceiveData.pcData, xReceiveData.xDataSize );
-        vPortFree( xReceiveData.pcData );
+        /* Copy received data into given buffer, then free the message slot. */
+        ( void ) memcpy( msg_ptr, ( char * ) pxMessage + mqMESSAGE_DATA_OFFSET, pxMessage->xDataSize );
+        prvReleaseMessage( pxMessageQueue, pxMessage );
+        prvEndOperation( pxMessageQueue );
     }
 
     return xStatus;
@@ -747,17 +1112,14 @@ int mq_timedsend( mqd_t mqdes,
     int iStatus = 0, iCalculateTimeoutReturn = 0;
     TickType_t xTimeoutTicks = 0;
     QueueListElement_t * pxMessageQueue = ( QueueListElement_t * ) mqdes;
-    QueueElement_t xSendData = { 0 };
-
-    /* Silence warnings about unused parameters. */
-    ( void ) msg_prio;
+    MessageHeader_t * pxMessage = NULL;
 
     /* Lock the mutex that guards access to the queue list. This call will
      * never fail because it blocks forever. */
     ( void ) xSemaphoreTake( ( SemaphoreHandle_t ) &xQueueListMutex, portMAX_DELAY );
 
     /* Find the mq referenced by mqdes. */
-    if( prvFindQueueInList( NULL, NULL, mqdes ) == pdFALSE )
+    if( prvFindOpenQueue( mqdes ) == pdFALSE )
     {
         /* Queue not found; bad descriptor. */
         errno = EBADF;
@@ -775,6 +1137,16 @@ int mq_timedsend( mqd_t mqdes,
         }
     }
 
+    /* Verify that msg_prio is valid. */
+    if( iStatus == 0 )
+    {
+        if( msg_prio >= MQ_PRIO_MAX )
+        {
+            errno = EINVAL;
+            iStatus = -1;
+        }
+    }
+
     if( iStatus == 0 )
     {
         /* Convert abstime to a tick timeout. */
@@ -789,53 +1161,96 @@ int mq_timedsend( mqd_t mqdes,
         }
     }
 
+    /* Keep the queue alive while waiting for a free message slot. */
+    if( iStatus == 0 )
+    {
+        prvBeginOperation( pxMessageQueue );
+    }
+
     /* Release the mutex protecting the queue list. */
     ( void ) xSemaphoreGive( ( SemaphoreHandle_t ) &xQueueListMutex );
 
-    /* Allocate memory for the message. */
     if( iStatus == 0 )
     {
-        xSendData.xDataSize = msg_len;
-        xSendData.pcData = pvPortMalloc( msg_len );
-
-        /* Check that memory allocation succeeded. */
-        if( xSendData.pcData == NULL )
+        /* Wait for a free message slot. */
+        if( xSemaphoreTake( pxMessageQueue->xFreeSlots, xTimeoutTicks ) == pdFALSE )
         {
-            /* msg_len too large. */
-            errno = EMSGSIZE;
+            /* If waiting fails, set the appropriate errno. */
+            if( pxMessageQueue->xAttr.mq_flags & O_NONBLOCK )
+            {
+                /* Set errno to EAGAIN for nonblocking mq. */
+                errno = EAGAIN;
+            }
+            else
+            {
+                /* Otherwise, set errno to ETIMEDOUT. */
+                errno = ETIMEDOUT;
+            }
+
             iStatus = -1;
-        }
-        else
-        {
-            /* Copy the data to send. */
-            ( void ) memcpy( xSendData.pcData, msg_ptr, msg_len );
+            prvEndOperation( pxMessageQueue );
         }
     }
 
     if( iStatus == 0 )
     {
-        /* Send data to the FreeRTOS queue. */
-        if( xQueueSend( pxMessageQueue->xQueue,
-                        &xSendData,
-                        xTimeoutTicks ) == pdFALSE )
+        /* Take a free message slot. Taking xFreeSlots guarantees that the
+         * free list is not empty. */
+        esp_os_enter_critical( &pxMessageQueue->xLock );
+        pxMessage = pxMessageQueue->pxFreeList;
+        pxMessageQueue->pxFreeList = pxMessage->pxNext;
+        esp_os_exit_critical( &pxMessageQueue->xLock );
+
+        /* Copy the data to send. The slot is owned by this thread until it
+         * is queued. */
+        pxMessage->xDataSize = msg_len;
+        pxMessage->uxPriority = msg_prio;
+        ( void ) memcpy( ( char * ) pxMessage + mqMESSAGE_DATA_OFFSET, msg_ptr, msg_len );
+
+        /* Queue the message after all the messages with the same or a higher
+         * priority. Sending with a single priority, or with decreasing
+         * priorities, only appends to the tail. */
+        esp_os_enter_critical( &pxMessageQueue->xLock );
+
+        if( ( pxMessageQueue->pxTail == NULL ) || ( pxMessageQueue->pxTail->uxPriority >= msg_prio ) )
         {
-            /* If queue send fails, set the appropriate errno. */
-            if( pxMessageQueue->xAttr.mq_flags & O_NONBLOCK )
+            pxMessage->pxNext = NULL;
+
+            if( pxMessageQueue->pxTail == NULL )
             {
-                /* Set errno to EAGAIN for nonblocking mq. */
-                errno = EAGAIN;
+                pxMessageQueue->pxHead = pxMessage;
             }
             else
             {
-                /* Otherwise, set errno to ETIMEDOUT. */
-                errno = ETIMEDOUT;
+                pxMessageQueue->pxTail->pxNext = pxMessage;
             }
 
-            /* Free the allocated queue data. */
-            vPortFree( xSendData.pcData );
+            pxMessageQueue->pxTail = pxMessage;
+        }
+        else if( pxMessageQueue->pxHead->uxPriority < msg_prio )
+        {
+            pxMessage->pxNext = pxMessageQueue->pxHead;
+            pxMessageQueue->pxHead = pxMessage;
+        }
+        else
+        {
+            MessageHeader_t * pxPrevious = pxMessageQueue->pxHead;
+
+            while( pxPrevious->pxNext->uxPriority >= msg_prio )
+            {
+                pxPrevious = pxPrevious->pxNext;
+            }
 
-            iStatus = -1;
+            pxMessage->pxNext = pxPrevious->pxNext;
+            pxPrevious->pxNext = pxMessage;
         }
+
+        pxMessageQueue->xAttr.mq_curmsgs++;
+        esp_os_exit_critical( &pxMessageQueue->xLock );
+
+        /* Let a receiver take the message. */
+        ( void ) xSemaphoreGive( pxMessageQueue->xQueuedMessages );
+        prvEndOperation( pxMessageQueue );
     }
 
     return iStatus;
@@ -874,11 +1289,9 @@ int mq_unlink( const char * name )
              * remove it from the list. */
             if( pxMessageQueue->xOpenDescriptors == 0 )
             {
-                listREMOVE( &pxMessageQueue->xLink );
-
-                /* Set the flag to delete the queue. Deleting the queue is deferred
-                 * until xQueueListMutex is released. */
-                xQueueRemoved = pdTRUE;
+                /* Deleting the queue is deferred until xQueueListMutex is
+                 * released. */
+                xQueueRemoved = prvRemoveMessageQueue( pxMessageQueue );
             }
             else
             {
@@ -907,6 +1320,153 @@ int mq_unlink( const char * name )
     return iStatus;
 }
 
+/*-----------------------------------------------------------*/
+
+/* Added by Espressif - receive messages without copying them */
+ssize_t esp_mq_receive_borrow( mqd_t mqdes,
+                               char ** msg_ptr,
+                               unsigned int * msg_prio )
+{
+    return esp_mq_timedreceive_borrow( mqdes, msg_ptr, msg_prio, NULL );
+}
+
+/*-----------------------------------------------------------*/
+
+ssize_t esp_mq_timedreceive_borrow( mqd_t mqdes,
+                                    char ** msg_ptr,
+                                    unsigned int * msg_prio,
+                                    const struct timespec * abstime )
+{
+    ssize_t xStatus = -1;
+    QueueListElement_t * pxMessageQueue = ( QueueListElement_t * ) mqdes;
+    MessageHeader_t * pxMessage = NULL;
+
+    if( msg_ptr == NULL )
+    {
+        errno = EINVAL;
+    }
+    /* The message is not copied, so any message size fits. */
+    else if( prvReceiveMessage( mqdes, SIZE_MAX, abstime, pdTRUE, &pxMessage ) == 0 )
+    {
+        xStatus = ( ssize_t ) pxMessage->xDataSize;
+
+        if( msg_prio != NULL )
+        {
+            *msg_prio = pxMessage->uxPriority;
+        }
+
+        /* The message slot stays owned by the caller until esp_mq_return(),
+         * the borrowed message keeps the queue alive. */
+        *msg_ptr = ( char * ) pxMessage + mqMESSAGE_DATA_OFFSET;
+        prvEndOperation( pxMessageQueue );
+    }
+
+    return xStatus;
+}
+
+/*-----------------------------------------------------------*/
+
+int esp_mq_return( mqd_t mqdes,
+                   char * msg_ptr )
+{
+    int iStatus = 0;
+    QueueListElement_t * pxMessageQueue = ( QueueListElement_t * ) mqdes;
+    MessageHeader_t * pxMessage = NULL;
+    size_t xOffset = 0;
+    BaseType_t xLastBorrowed = pdFALSE;
+    BaseType_t xQueueRemoved = pdFALSE;
+
+    /* Lock the mutex that guards access to the queue list. This call will
+     * never fail because it blocks forever. */
+    ( void ) xSemaphoreTake( ( SemaphoreHandle_t ) &xQueueListMutex, portMAX_DELAY );
+
+    /* Find the mq referenced by mqdes. A queue that was closed and unlinked
+     * is still found while messages are borrowed from it. */
+    if( prvFindQueueInList( NULL, NULL, mqdes ) == pdFALSE )
+    {
+        /* Queue not found; bad descriptor. */
+        errno = EBADF;
+        iStatus = -1;
+    }
+
+    /* Verify that msg_ptr is the data of one of the message slots of the queue. */
+    if( iStatus == 0 )
+    {
+        if( ( msg_ptr == NULL ) || ( msg_ptr < pxMessageQueue->pcStorage + mqMESSAGE_DATA_OFFSET ) )
+        {
+            errno = EINVAL;
+            iStatus = -1;
+        }
+        else
+        {
+            xOffset = ( size_t ) ( msg_ptr - pxMessageQueue->pcStorage ) - mqMESSAGE_DATA_OFFSET;
+
+            if( ( ( xOffset % pxMessageQueue->xSlotSize ) != 0 ) ||
+                ( ( xOffset / pxMessageQueue->xSlotSize ) >= ( size_t ) pxMessageQueue->xAttr.mq_maxmsg ) )
+            {
+                errno = EINVAL;
+                iStatus = -1;
+            }
+        }
+    }
+
+    if( iStatus == 0 )
+    {
+        /* Only a borrowed message can be returned, and only once. */
+        pxMessage = ( MessageHeader_t * ) ( msg_ptr - mqMESSAGE_DATA_OFFSET );
+
+        esp_os_enter_critical( &pxMessageQueue->xLock );
+
+        if( pxMessage->xBorrowed == pdTRUE )
+        {
+            pxMessage->xBorrowed = pdFALSE;
+        }
+        else
+        {
+            iStatus = -1;
+        }
+
+        esp_os_exit_critical( &pxMessageQueue->xLock );
+
+        if( iStatus == 0 )
+        {
+            /* The message keeps the queue alive until it is back in the free
+             * list. */
+            prvReleaseMessage( pxMessageQueue, pxMessage );
+
+            esp_os_enter_critical( &pxMessageQueue->xLock );
+            pxMessageQueue->xBorrowedMessages--;
+            xLastBorrowed = ( pxMessageQueue->xRemoved == pdTRUE ) && ( pxMessageQueue->xBorrowedMessages == 0 );
+            xQueueRemoved = ( xLastBorrowed == pdTRUE ) && ( pxMessageQueue->xOperations == 0 );
+            esp_os_exit_critical( &pxMessageQueue->xLock );
+
+            /* The last message returned to a closed and unlinked queue
+             * finishes its removal. */
+            if( xLastBorrowed == pdTRUE )
+            {
+                listREMOVE( &pxMessageQueue->xDescriptorLink );
+            }
+        }
+        else
+        {
+            errno = EINVAL;
+        }
+    }
+
+    /* Release the mutex protecting the queue list. */
+    ( void ) xSemaphoreGive( ( SemaphoreHandle_t ) &xQueueListMutex );
+
+    /* Delete all resources used by the queue if needed. */
+    if( xQueueRemoved == pdTRUE )
+    {
+        prvDeleteMessageQueue( pxMessageQueue );
+    }
+
+    return iStatus;
+}
+
+/*-----------------------------------------------------------*/
+
 /* specified but not implemented functions, return ENOSYS */
 int mq_notify( mqd_t,
                const struct sigevent * )
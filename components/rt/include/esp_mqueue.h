@@ -0,0 +1,74 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <mqueue.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Receive a message from a message queue without copying it
+ *
+ * Works like mq_receive(), except that the message is not copied to a buffer of the caller. Instead, \c msg_ptr is
+ * set to the message in the storage of the queue. The caller may read and modify the message in place, and must give
+ * it back to the queue with esp_mq_return() once done with it. Until then, the storage of the message cannot be used
+ * by senders, i.e., a borrowed message counts against mq_maxmsg, but not against mq_curmsgs.
+ *
+ * A queue closed by its last descriptor and unlinked while messages are borrowed from it is only deleted once the last
+ * of them is returned with esp_mq_return(). Until then, the descriptor can only be used to return them, other calls
+ * fail with EBADF.
+ *
+ * @param[in]   mqdes       Message queue descriptor
+ * @param[out]  msg_ptr     Set to the data of the received message, valid until it is returned
+ * @param[out]  msg_prio    If not NULL, set to the priority of the received message
+ *
+ * @return
+ *      - The size of the received message in bytes on success
+ *      - -1 on failure, with errno set as by mq_receive(). errno is EINVAL if \c msg_ptr is NULL.
+ */
+ssize_t esp_mq_receive_borrow(mqd_t mqdes, char **msg_ptr, unsigned int *msg_prio);
+
+/**
+ * @brief Receive a message from a message queue with timeout, without copying it
+ *
+ * Works like esp_mq_receive_borrow(), with the timeout semantics of mq_timedreceive().
+ *
+ * @param[in]   mqdes       Message queue descriptor
+ * @param[out]  msg_ptr     Set to the data of the received message, valid until it is returned
+ * @param[out]  msg_prio    If not NULL, set to the priority of the received message
+ * @param[in]   abstime     Absolute timeout, or NULL to block until a message is received
+ *
+ * @return
+ *      - The size of the received message in bytes on success
+ *      - -1 on failure, with errno set as by mq_timedreceive(). errno is EINVAL if \c msg_ptr is NULL.
+ */
+ssize_t esp_mq_timedreceive_borrow(mqd_t mqdes, char **msg_ptr, unsigned int *msg_prio,
+                                   const struct timespec *abstime);
+
+/**
+ * @brief Give a message received with esp_mq_receive_borrow() back to its message queue
+ *
+ * The storage of the message becomes available to senders again, \c msg_ptr must not be used anymore. Each borrowed
+ * message can only be returned once.
+ *
+ * @param[in]   mqdes       Message queue descriptor the message was received from
+ * @param[in]   msg_ptr     Message data, as set by esp_mq_receive_borrow() or esp_mq_timedreceive_borrow()
+ *
+ * @return
+ *      - 0 on success
+ *      - -1 on failure, with errno set to:
+ *          - EBADF if \c mqdes is not a valid message queue descriptor
+ *          - EINVAL if \c msg_ptr is not a message of the queue, or is not borrowed, e.g., because it was already
+ *            returned
+ */
+int esp_mq_return(mqd_t mqdes, char *msg_ptr);
+
+#ifdef __cplusplus
+}
+#endif
@@ -6,7 +6,7 @@
  *
  * SPDX-License-Identifier: MIT
  *
- * SPDX-FileContributor: 2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileContributor: 2024-2025 Espressif Systems (Shanghai) CO LTD
  *
  * Permission is hereby granted, free of charge, to any person obtaining a copy of
  * this software and associated documentation files (the "Software"), to deal in
@@ -38,12 +38,22 @@
 
 #pragma once
 
+#include <sys/types.h>
 #include <time.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* Added by Espressif - not defined by newlib's limits.h */
+#ifndef MQ_PRIO_MAX
+
+/**
+ * @brief Number of message priorities, the valid priorities are 0 to MQ_PRIO_MAX - 1.
+ */
+    #define MQ_PRIO_MAX    32
+#endif
+
 /**
  * @brief Message queue descriptor.
  */
@@ -94,7 +104,7 @@ mqd_t mq_open( const char * name,
  *
  * Please refer to http://pubs.opengroup.org/onlinepubs/9699919799/functions/mq_receive.html for more details.
  *
- * @note msg_prio argument is not supported. Messages are not checked for corruption.
+ * @note Messages are not checked for corruption.
  */
 ssize_t mq_receive( mqd_t mqdes,
                     char * msg_ptr,
@@ -105,8 +115,6 @@ ssize_t mq_receive( mqd_t mqdes,
  * @brief Send a message to a message queue.
  *
  * Please refer to http://pubs.opengroup.org/onlinepubs/9699919799/functions/mq_send.html for more details.
- *
- * @note msg_prio argument is not supported.
  */
 int mq_send( mqd_t mqdes,
              const char * msg_ptr,
@@ -118,7 +126,7 @@ int mq_send( mqd_t mqdes,
  *
  * Please refer to http://pubs.opengroup.org/onlinepubs/9699919799/functions/mq_timedreceive.html for more details.
  *
- * @note msg_prio argument is not supported. Messages are not checked for corruption.
+ * @note Messages are not checked for corruption.
  */
 ssize_t mq_timedreceive( mqd_t mqdes,
                          char * msg_ptr,
@@ -130,8 +138,6 @@ ssize_t mq_timedreceive( mqd_t mqdes,
  * @brief Send a message to a message queue with timeout.
  *
  * Please refer to http://pubs.opengroup.org/onlinepubs/9699919799/functions/mq_timedsend.html for more details.
- *
- * @note msg_prio argument is not supported.
  */
 int mq_timedsend( mqd_t mqdes,
                   const char * msg_ptr,
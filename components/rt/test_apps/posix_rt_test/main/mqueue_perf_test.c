@@ -0,0 +1,135 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/*
+ * Benchmarks of the message throughput of POSIX message queues. Each iteration fills the queue and then drains it
+ * from the same task, so that the cost of the queue operations is measured instead of the cost of context switches.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "unity.h"
+#include "mqueue.h"
+#include "esp_mqueue.h"
+
+#define PERF_QUEUE_NAME     "/perf_queue"
+#define PERF_QUEUE_LEN      16
+#define PERF_NUM_MESSAGES   20000
+
+static uint64_t perf_time_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void print_result(const char *name, size_t msg_size, uint64_t elapsed_us)
+{
+    printf("%s, %u byte messages: %llu us, %llu msgs/s\n", name, (unsigned) msg_size,
+           (unsigned long long) elapsed_us,
+           (unsigned long long) ((uint64_t) PERF_NUM_MESSAGES * 1000000 / (elapsed_us ? elapsed_us : 1)));
+}
+
+static mqd_t perf_open(size_t msg_size)
+{
+    struct mq_attr attr = {
+        .mq_maxmsg = PERF_QUEUE_LEN,
+        .mq_msgsize = msg_size,
+    };
+    mqd_t mq = mq_open(PERF_QUEUE_NAME, O_CREAT | O_EXCL | O_RDWR | O_NONBLOCK, S_IRUSR | S_IWUSR, &attr);
+    TEST_ASSERT_NOT_EQUAL((mqd_t) -1, mq);
+    return mq;
+}
+
+static void perf_close(mqd_t mq)
+{
+    TEST_ASSERT_EQUAL(0, mq_close(mq));
+    TEST_ASSERT_EQUAL(0, mq_unlink(PERF_QUEUE_NAME));
+}
+
+/* Send and receive PERF_NUM_MESSAGES messages with mq_send() and mq_receive(), returns the elapsed time */
+static uint64_t run_copy(size_t msg_size, char *tx, char *rx)
+{
+    mqd_t mq = perf_open(msg_size);
+    uint32_t checksum = 0;
+
+    uint64_t start_us = perf_time_us();
+    for (int i = 0; i < PERF_NUM_MESSAGES; i += PERF_QUEUE_LEN) {
+        for (int j = 0; j < PERF_QUEUE_LEN; j++) {
+            tx[0] = (char) j;
+            TEST_ASSERT_EQUAL(0, mq_send(mq, tx, msg_size, j % 4));
+        }
+        for (int j = 0; j < PERF_QUEUE_LEN; j++) {
+            TEST_ASSERT_EQUAL(msg_size, mq_receive(mq, rx, msg_size, NULL));
+            checksum += (uint8_t) rx[0];
+        }
+    }
+    uint64_t elapsed_us = perf_time_us() - start_us;
+
+    TEST_ASSERT_EQUAL(PERF_NUM_MESSAGES / PERF_QUEUE_LEN * (PERF_QUEUE_LEN * (PERF_QUEUE_LEN - 1) / 2), checksum);
+    perf_close(mq);
+    return elapsed_us;
+}
+
+/* Send and receive PERF_NUM_MESSAGES messages with mq_send() and esp_mq_receive_borrow(), returns the elapsed time */
+static uint64_t run_borrow(size_t msg_size, char *tx)
+{
+    mqd_t mq = perf_open(msg_size);
+    uint32_t checksum = 0;
+    char *msg;
+
+    uint64_t start_us = perf_time_us();
+    for (int i = 0; i < PERF_NUM_MESSAGES; i += PERF_QUEUE_LEN) {
+        for (int j = 0; j < PERF_QUEUE_LEN; j++) {
+            tx[0] = (char) j;
+            TEST_ASSERT_EQUAL(0, mq_send(mq, tx, msg_size, j % 4));
+        }
+        for (int j = 0; j < PERF_QUEUE_LEN; j++) {
+            TEST_ASSERT_EQUAL(msg_size, esp_mq_receive_borrow(mq, &msg, NULL));
+            checksum += (uint8_t) msg[0];
+            TEST_ASSERT_EQUAL(0, esp_mq_return(mq, msg));
+        }
+    }
+    uint64_t elapsed_us = perf_time_us() - start_us;
+
+    TEST_ASSERT_EQUAL(PERF_NUM_MESSAGES / PERF_QUEUE_LEN * (PERF_QUEUE_LEN * (PERF_QUEUE_LEN - 1) / 2), checksum);
+    perf_close(mq);
+    return elapsed_us;
+}
+
+/*
+Benchmark message queue throughput
+
+Procedure:
+    - Fill a queue of 16 messages with messages of 4 different priorities, then drain it, until 20000 messages were
+      sent and received
+    - Receive the messages once with mq_receive() and once with esp_mq_receive_borrow() and esp_mq_return()
+    - Do both for 64 byte and 1 KiB messages
+
+Expected:
+    - All messages are received, the throughput in messages per second is printed
+*/
+TEST_CASE("message queue throughput of 64 byte and 1 KiB messages", "[mqueue][perf]")
+{
+    const size_t msg_sizes[] = {64, 1024};
+    char *tx = calloc(1, 1024);
+    char *rx = calloc(1, 1024);
+    TEST_ASSERT_NOT_NULL(tx);
+    TEST_ASSERT_NOT_NULL(rx);
+
+    for (size_t i = 0; i < sizeof(msg_sizes) / sizeof(msg_sizes[0]); i++) {
+        print_result("mq_receive", msg_sizes[i], run_copy(msg_sizes[i], tx, rx));
+        print_result("esp_mq_receive_borrow", msg_sizes[i], run_borrow(msg_sizes[i], tx));
+    }
+
+    free(rx);
+    free(tx);
+}
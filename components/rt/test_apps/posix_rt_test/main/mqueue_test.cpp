@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2024-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Unlicense OR CC0-1.0
  */
@@ -7,12 +7,17 @@
 #include <errno.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <cstdio>
+#include <cstring>
 #include <thread>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "unity.h"
 #include "mqueue.h"
+#include "esp_mqueue.h"
 
 // Note: implementation does not support mode argument
-// Note: implementation does not support message priorities (msg_prio arguments)
 
 struct MessageQueueFixture {
     MessageQueueFixture(const char *name = "/test_queue",
@@ -284,5 +289,268 @@ TEST_CASE("queue sends and receives multiple messages", "[mqueue]")
     TEST_ASSERT_EQUAL(47, received);
     TEST_ASSERT_EQUAL(4, mq_receive(mq_fix.mq, (char*) &received, sizeof(received), nullptr));
     TEST_ASSERT_EQUAL(48, received);
+}
+
+TEST_CASE("messages are received in order of priority", "[mqueue]")
+{
+    MessageQueueFixture mq_fix("/test", 8, sizeof(int), O_CREAT | O_RDWR | O_NONBLOCK);
+    const unsigned int priorities[] = {1, 5, 3, 5, 0, MQ_PRIO_MAX - 1, 3};
+    // Highest priority first, messages of the same priority in the order they were sent
+    const int expected_order[] = {5, 1, 3, 2, 6, 0, 4};
+    int received;
+    unsigned int prio;
+
+    for (int i = 0; i < 7; i++) {
+        TEST_ASSERT_EQUAL(0, mq_send(mq_fix.mq, (const char*) &i, sizeof(i), priorities[i]));
+    }
+
+    for (int i = 0; i < 7; i++) {
+        TEST_ASSERT_EQUAL(sizeof(received), mq_receive(mq_fix.mq, (char*) &received, sizeof(received), &prio));
+        TEST_ASSERT_EQUAL(expected_order[i], received);
+        TEST_ASSERT_EQUAL(priorities[expected_order[i]], prio);
+    }
+}
+
+TEST_CASE("sending with invalid priority fails", "[mqueue]")
+{
+    MessageQueueFixture mq_fix("/test", 1, sizeof(int));
+    int to_send = 47;
+
+    TEST_ASSERT_EQUAL(-1, mq_send(mq_fix.mq, (const char*) &to_send, sizeof(to_send), MQ_PRIO_MAX));
+    TEST_ASSERT_EQUAL(EINVAL, errno);
+}
+
+TEST_CASE("receiving updates mq_curmsgs", "[mqueue]")
+{
+    MessageQueueFixture mq_fix("/test", 2, sizeof(int), O_CREAT | O_RDWR | O_NONBLOCK);
+    struct mq_attr attr;
+    int to_send = 47;
+
+    TEST_ASSERT_EQUAL(0, mq_send(mq_fix.mq, (const char*) &to_send, sizeof(to_send), 0));
+    TEST_ASSERT_EQUAL(0, mq_send(mq_fix.mq, (const char*) &to_send, sizeof(to_send), 0));
+    TEST_ASSERT_EQUAL(0, mq_getattr(mq_fix.mq, &attr));
+    TEST_ASSERT_EQUAL(2, attr.mq_curmsgs);
+
+    TEST_ASSERT_EQUAL(sizeof(to_send), mq_receive(mq_fix.mq, (char*) &to_send, sizeof(to_send), nullptr));
+    TEST_ASSERT_EQUAL(0, mq_getattr(mq_fix.mq, &attr));
+    TEST_ASSERT_EQUAL(1, attr.mq_curmsgs);
+}
+
+TEST_CASE("many message queues can be opened by name", "[mqueue]")
+{
+    constexpr int NUM_QUEUES = 40;
+    char name[24];
+    mqd_t queues[NUM_QUEUES];
+
+    for (int i = 0; i < NUM_QUEUES; i++) {
+        snprintf(name, sizeof(name), "/queue_%d", i);
+        queues[i] = mq_open(name, O_CREAT | O_EXCL | O_RDWR | O_NONBLOCK, S_IRUSR, nullptr);
+        TEST_ASSERT_NOT_EQUAL((mqd_t) -1, queues[i]);
+        TEST_ASSERT_EQUAL(0, mq_send(queues[i], (const char*) &i, sizeof(i), 0));
+    }
+
+    // Opening by name finds the existing queue
+    for (int i = 0; i < NUM_QUEUES; i++) {
+        snprintf(name, sizeof(name), "/queue_%d", i);
+        TEST_ASSERT_EQUAL(queues[i], mq_open(name, O_RDWR | O_NONBLOCK));
+    }
+
+    for (int i = 0; i < NUM_QUEUES; i++) {
+        char received[128];
+        snprintf(name, sizeof(name), "/queue_%d", i);
+        TEST_ASSERT_EQUAL(sizeof(i), mq_receive(queues[i], received, sizeof(received), nullptr));
+        TEST_ASSERT_EQUAL(i, *(int*) received);
+        TEST_ASSERT_EQUAL(0, mq_close(queues[i]));
+        TEST_ASSERT_EQUAL(0, mq_close(queues[i]));
+        TEST_ASSERT_EQUAL(0, mq_unlink(name));
+        TEST_ASSERT_EQUAL((mqd_t) -1, mq_open(name, O_RDWR));
+        TEST_ASSERT_EQUAL(ENOENT, errno);
+    }
+}
+
+TEST_CASE("borrowed message can be read and returned", "[mqueue]")
+{
+    MessageQueueFixture mq_fix("/test", 1, 16, O_CREAT | O_RDWR | O_NONBLOCK);
+    const char to_send[] = "borrowed";
+    char *msg;
+    unsigned int prio;
+    struct mq_attr attr;
+
+    TEST_ASSERT_EQUAL(0, mq_send(mq_fix.mq, to_send, sizeof(to_send), 7));
+    TEST_ASSERT_EQUAL(sizeof(to_send), esp_mq_receive_borrow(mq_fix.mq, &msg, &prio));
+    TEST_ASSERT_EQUAL_STRING(to_send, msg);
+    TEST_ASSERT_EQUAL(7, prio);
+    TEST_ASSERT_EQUAL(0, mq_getattr(mq_fix.mq, &attr));
+    TEST_ASSERT_EQUAL(0, attr.mq_curmsgs);
+
+    // The borrowed message still occupies the only slot of the queue
+    TEST_ASSERT_EQUAL(-1, mq_send(mq_fix.mq, to_send, sizeof(to_send), 0));
+    TEST_ASSERT_EQUAL(EAGAIN, errno);
+
+    TEST_ASSERT_EQUAL(0, esp_mq_return(mq_fix.mq, msg));
+    TEST_ASSERT_EQUAL(0, mq_send(mq_fix.mq, to_send, sizeof(to_send), 0));
+    TEST_ASSERT_EQUAL(sizeof(to_send), esp_mq_receive_borrow(mq_fix.mq, &msg, nullptr));
+    TEST_ASSERT_EQUAL(0, esp_mq_return(mq_fix.mq, msg));
+}
+
+TEST_CASE("borrowing with timeout on empty message queue times out", "[mqueue]")
+{
+    MessageQueueFixture mq_fix("/test", 1, sizeof(int));
+    const struct timespec zero_time = {0, 0};
+    char *msg;
 
+    TEST_ASSERT_EQUAL(-1, esp_mq_timedreceive_borrow(mq_fix.mq, &msg, nullptr, &zero_time));
+    TEST_ASSERT_EQUAL(ETIMEDOUT, errno);
+    TEST_ASSERT_EQUAL(-1, esp_mq_receive_borrow(mq_fix.mq, nullptr, nullptr));
+    TEST_ASSERT_EQUAL(EINVAL, errno);
+}
+
+TEST_CASE("returning invalid message fails", "[mqueue]")
+{
+    MessageQueueFixture mq_fix("/test", 2, sizeof(int), O_CREAT | O_RDWR | O_NONBLOCK);
+    int to_send = 47;
+    char *msg;
+
+    TEST_ASSERT_EQUAL(0, mq_send(mq_fix.mq, (const char*) &to_send, sizeof(to_send), 0));
+    TEST_ASSERT_EQUAL(sizeof(to_send), esp_mq_receive_borrow(mq_fix.mq, &msg, nullptr));
+
+    TEST_ASSERT_EQUAL(-1, esp_mq_return(nullptr, msg));
+    TEST_ASSERT_EQUAL(EBADF, errno);
+    TEST_ASSERT_EQUAL(-1, esp_mq_return(mq_fix.mq, (char*) &to_send));
+    TEST_ASSERT_EQUAL(EINVAL, errno);
+    TEST_ASSERT_EQUAL(-1, esp_mq_return(mq_fix.mq, msg + 1));
+    TEST_ASSERT_EQUAL(EINVAL, errno);
+
+    TEST_ASSERT_EQUAL(0, esp_mq_return(mq_fix.mq, msg));
+}
+
+TEST_CASE("returning a message twice or a message that is not borrowed fails", "[mqueue]")
+{
+    MessageQueueFixture mq_fix("/test", 2, sizeof(int), O_CREAT | O_RDWR | O_NONBLOCK);
+    int to_send = 47;
+    char *msg;
+    char *queued;
+
+    TEST_ASSERT_EQUAL(0, mq_send(mq_fix.mq, (const char*) &to_send, sizeof(to_send), 0));
+    TEST_ASSERT_EQUAL(sizeof(to_send), esp_mq_receive_borrow(mq_fix.mq, &msg, nullptr));
+    TEST_ASSERT_EQUAL(0, esp_mq_return(mq_fix.mq, msg));
+    TEST_ASSERT_EQUAL(-1, esp_mq_return(mq_fix.mq, msg));
+    TEST_ASSERT_EQUAL(EINVAL, errno);
+
+    // The slot of a queued message is not borrowed either
+    TEST_ASSERT_EQUAL(0, mq_send(mq_fix.mq, (const char*) &to_send, sizeof(to_send), 0));
+    TEST_ASSERT_EQUAL(sizeof(to_send), esp_mq_receive_borrow(mq_fix.mq, &msg, nullptr));
+    TEST_ASSERT_EQUAL(0, mq_send(mq_fix.mq, (const char*) &to_send, sizeof(to_send), 0));
+    TEST_ASSERT_EQUAL(0, esp_mq_return(mq_fix.mq, msg));
+    TEST_ASSERT_EQUAL(sizeof(to_send), esp_mq_receive_borrow(mq_fix.mq, &queued, nullptr));
+    TEST_ASSERT_EQUAL(0, esp_mq_return(mq_fix.mq, queued));
+
+    // Both slots are free again
+    TEST_ASSERT_EQUAL(0, mq_send(mq_fix.mq, (const char*) &to_send, sizeof(to_send), 0));
+    TEST_ASSERT_EQUAL(0, mq_send(mq_fix.mq, (const char*) &to_send, sizeof(to_send), 0));
+    TEST_ASSERT_EQUAL(-1, mq_send(mq_fix.mq, (const char*) &to_send, sizeof(to_send), 0));
+    TEST_ASSERT_EQUAL(EAGAIN, errno);
+}
+
+TEST_CASE("message queue closed and unlinked while a message is borrowed is deleted when it is returned", "[mqueue]")
+{
+    struct mq_attr conf = {
+        .mq_flags = 0, // ignored by mq_open
+        .mq_maxmsg = 2,
+        .mq_msgsize = sizeof(int),
+        .mq_curmsgs = 0 // ignored by mq_open
+    };
+    int to_send = 47;
+    char received[sizeof(int)];
+    char *msg;
+
+    mqd_t mq = mq_open("/test", O_CREAT | O_EXCL | O_RDWR | O_NONBLOCK, S_IRUSR, &conf);
+    TEST_ASSERT_NOT_EQUAL((mqd_t) -1, mq);
+    TEST_ASSERT_EQUAL(0, mq_send(mq, (const char*) &to_send, sizeof(to_send), 0));
+    TEST_ASSERT_EQUAL(0, mq_send(mq, (const char*) &to_send, sizeof(to_send), 0));
+    TEST_ASSERT_EQUAL(sizeof(to_send), esp_mq_receive_borrow(mq, &msg, nullptr));
+    TEST_ASSERT_EQUAL(0, mq_close(mq));
+    TEST_ASSERT_EQUAL(0, mq_unlink("/test"));
+
+    // The descriptor can only be used to return the borrowed message
+    TEST_ASSERT_EQUAL(-1, mq_send(mq, (const char*) &to_send, sizeof(to_send), 0));
+    TEST_ASSERT_EQUAL(EBADF, errno);
+    TEST_ASSERT_EQUAL(-1, mq_receive(mq, received, sizeof(received), nullptr));
+    TEST_ASSERT_EQUAL(EBADF, errno);
+    char *queued;
+    TEST_ASSERT_EQUAL(-1, esp_mq_receive_borrow(mq, &queued, nullptr));
+    TEST_ASSERT_EQUAL(EBADF, errno);
+    TEST_ASSERT_EQUAL(-1, mq_close(mq));
+    TEST_ASSERT_EQUAL(EBADF, errno);
+
+    // The name was released when the queue was unlinked
+    mqd_t reopened = mq_open("/test", O_CREAT | O_EXCL | O_RDONLY, S_IRUSR, &conf);
+    TEST_ASSERT_NOT_EQUAL((mqd_t) -1, reopened);
+    TEST_ASSERT_EQUAL(0, mq_close(reopened));
+    TEST_ASSERT_EQUAL(0, mq_unlink("/test"));
+
+    TEST_ASSERT_EQUAL(to_send, *(int*) msg);
+    TEST_ASSERT_EQUAL(0, esp_mq_return(mq, msg));
+
+    // The queue was deleted with the last borrowed message
+    TEST_ASSERT_EQUAL(-1, esp_mq_return(mq, msg));
+    TEST_ASSERT_EQUAL(EBADF, errno);
+}
+
+struct WaitingReceiver {
+    mqd_t mq;
+    struct timespec timeout;
+    ssize_t received;
+    int received_errno;
+    SemaphoreHandle_t done;
+};
+
+static void waiting_receiver(void *arg)
+{
+    WaitingReceiver *receiver = (WaitingReceiver*) arg;
+    int msg;
+
+    receiver->received = mq_timedreceive(receiver->mq, (char*) &msg, sizeof(msg), nullptr, &receiver->timeout);
+    receiver->received_errno = errno;
+    xSemaphoreGive(receiver->done);
+    vTaskDelete(nullptr);
+}
+
+TEST_CASE("message queue closed and unlinked while a receiver waits is deleted after the receiver", "[mqueue]")
+{
+    struct mq_attr conf = {
+        .mq_flags = 0, // ignored by mq_open
+        .mq_maxmsg = 1,
+        .mq_msgsize = sizeof(int),
+        .mq_curmsgs = 0 // ignored by mq_open
+    };
+    WaitingReceiver receiver = {};
+    receiver.mq = mq_open("/test", O_CREAT | O_EXCL | O_RDONLY, S_IRUSR, &conf);
+    TEST_ASSERT_NOT_EQUAL((mqd_t) -1, receiver.mq);
+    receiver.done = xSemaphoreCreateBinary();
+    TEST_ASSERT_NOT_NULL(receiver.done);
+
+    TEST_ASSERT_EQUAL(0, clock_gettime(CLOCK_REALTIME, &receiver.timeout));
+    receiver.timeout.tv_nsec += 100'000'000;
+    if (receiver.timeout.tv_nsec >= 1'000'000'000) {
+        receiver.timeout.tv_sec++;
+        receiver.timeout.tv_nsec -= 1'000'000'000;
+    }
+
+    // The receiver preempts this task and blocks on the queue, which is deleted once the receiver times out
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreatePinnedToCore(waiting_receiver, "receiver", 4096, &receiver,
+                                                      uxTaskPriorityGet(nullptr) + 1, nullptr, xPortGetCoreID()));
+    TEST_ASSERT_EQUAL(0, mq_close(receiver.mq));
+    TEST_ASSERT_EQUAL(0, mq_unlink("/test"));
+    TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(receiver.done, portMAX_DELAY));
+    vSemaphoreDelete(receiver.done);
+
+    TEST_ASSERT_EQUAL(-1, receiver.received);
+    TEST_ASSERT_EQUAL(ETIMEDOUT, receiver.received_errno);
+
+    // The name was released when the queue was unlinked
+    mqd_t mq = mq_open("/test", O_CREAT | O_EXCL | O_RDONLY, S_IRUSR, &conf);
+    TEST_ASSERT_NOT_EQUAL((mqd_t) -1, mq);
+    TEST_ASSERT_EQUAL(0, mq_close(mq));
+    TEST_ASSERT_EQUAL(0, mq_unlink("/test"));
 }
@@ -9,3 +9,9 @@ from pytest_embedded_idf.utils import idf_parametrize
 @idf_parametrize('target', ['esp32', 'esp32c3', 'esp32p4', 'esp32s2'], indirect=['target'])
 def test_rt_mqueue(dut: Dut) -> None:
     dut.run_all_single_board_cases()
+
+
+@pytest.mark.host_test
+@idf_parametrize('target', ['linux'], indirect=['target'])
+def test_rt_mqueue_linux(dut: Dut) -> None:
+    dut.run_all_single_board_cases()
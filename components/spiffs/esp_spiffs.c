@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -97,6 +97,12 @@ static void esp_spiffs_free(esp_spiffs_t ** efs)
         free(e->fs);
     }
     vSemaphoreDelete(e->lock);
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+    if (e->index_lock) {
+        vSemaphoreDelete(e->index_lock);
+    }
+    spiffs_name_index_free(&e->index);
+#endif
     free(e->fds);
     free(e->cache);
     free(e->work);
@@ -133,6 +139,32 @@ static esp_err_t esp_spiffs_get_empty(int * index){
     return ESP_ERR_NOT_FOUND;
 }
 
+/* The name index lock is held while the file system is reformatted, so that no lookup uses a stale index */
+static void esp_spiffs_index_lock(esp_spiffs_t *efs)
+{
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+    xSemaphoreTake(efs->index_lock, portMAX_DELAY);
+#endif
+}
+
+static void esp_spiffs_index_unlock(esp_spiffs_t *efs)
+{
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+    xSemaphoreGive(efs->index_lock);
+#endif
+}
+
+/* Has to be called with the index lock held once the file system is visible to the VFS */
+static void esp_spiffs_build_index(esp_spiffs_t *efs)
+{
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+    s32_t res = spiffs_name_index_build(&efs->index, efs->fs);
+    if (res != SPIFFS_OK) {
+        ESP_LOGW(TAG, "name index incomplete (%" PRId32 "), missing files are looked up on flash", res);
+    }
+#endif
+}
+
 static esp_err_t esp_spiffs_init(const esp_vfs_spiffs_conf_t* conf)
 {
     int index;
@@ -228,6 +260,15 @@ static esp_err_t esp_spiffs_init(const esp_vfs_spiffs_conf_t* conf)
         return ESP_ERR_NO_MEM;
     }
 
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+    efs->index_lock = xSemaphoreCreateMutex();
+    if (efs->index_lock == NULL) {
+        ESP_LOGE(TAG, "name index lock could not be created");
+        esp_spiffs_free(&efs);
+        return ESP_ERR_NO_MEM;
+    }
+#endif
+
     efs->fds_sz = conf->max_files * sizeof(spiffs_fd);
     efs->fds = calloc(1, efs->fds_sz);
     if (efs->fds == NULL) {
@@ -237,7 +278,8 @@ static esp_err_t esp_spiffs_init(const esp_vfs_spiffs_conf_t* conf)
     }
 
 #if SPIFFS_CACHE
-    efs->cache_sz = sizeof(spiffs_cache) + conf->max_files * (sizeof(spiffs_cache_page)
+    const uint32_t cache_pages = CONFIG_SPIFFS_CACHE_PAGES ? CONFIG_SPIFFS_CACHE_PAGES : conf->max_files;
+    efs->cache_sz = sizeof(spiffs_cache) + cache_pages * (sizeof(spiffs_cache_page)
                           + efs->cfg.log_page_size);
     efs->cache = calloc(1, efs->cache_sz);
     if (efs->cache == NULL) {
@@ -287,6 +329,7 @@ static esp_err_t esp_spiffs_init(const esp_vfs_spiffs_conf_t* conf)
         esp_spiffs_free(&efs);
         return ESP_FAIL;
     }
+    esp_spiffs_build_index(efs);
     _efs[index] = efs;
     return ESP_OK;
 }
@@ -351,6 +394,7 @@ esp_err_t esp_spiffs_format(const char* partition_label)
         partition_was_mounted = true;
     }
 
+    esp_spiffs_index_lock(_efs[index]);
     SPIFFS_unmount(_efs[index]->fs);
 
     s32_t res = SPIFFS_format(_efs[index]->fs);
@@ -361,6 +405,7 @@ esp_err_t esp_spiffs_format(const char* partition_label)
          * try to mount the partition back (it will probably fail). On the
          * other hand, if it was not mounted, need to clean up.
          */
+        esp_spiffs_index_unlock(_efs[index]);
         if (!partition_was_mounted) {
             esp_spiffs_free(&_efs[index]);
         }
@@ -374,9 +419,13 @@ esp_err_t esp_spiffs_format(const char* partition_label)
         if (res != SPIFFS_OK) {
             ESP_LOGE(TAG, "mount failed, %" PRId32, SPIFFS_errno(_efs[index]->fs));
             SPIFFS_clearerr(_efs[index]->fs);
+            esp_spiffs_index_unlock(_efs[index]);
             return ESP_FAIL;
         }
+        esp_spiffs_build_index(_efs[index]);
+        esp_spiffs_index_unlock(_efs[index]);
     } else {
+        esp_spiffs_index_unlock(_efs[index]);
         esp_spiffs_free(&_efs[index]);
     }
     return ESP_OK;
@@ -539,14 +588,49 @@ static int spiffs_mode_conv(int m)
     return res;
 }
 
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+/* The index_lock has to be held by the callers of the vfs_spiffs_index_* functions */
+
+static s32_t vfs_spiffs_index_stat(esp_spiffs_t *efs, const char *path, spiffs_stat *s)
+{
+    spiffs_file fd = spiffs_name_index_open(&efs->index, efs->fs, path, SPIFFS_RDONLY, s);
+    if (fd == SPIFFS_ERR_OUT_OF_FILE_DESCS) {
+        SPIFFS_clearerr(efs->fs);
+        return SPIFFS_stat(efs->fs, path, s);
+    }
+    if (fd < 0) {
+        return fd;
+    }
+    return SPIFFS_close(efs->fs, fd);
+}
+
+static void vfs_spiffs_index_refresh(esp_spiffs_t *efs, spiffs_file fd)
+{
+    // writing to a file moves its object index header
+    spiffs_stat s;
+    if (SPIFFS_fstat(efs->fs, fd, &s) == SPIFFS_OK) {
+        spiffs_name_index_refresh(&efs->index, (const char *)s.name, s.obj_id, s.pix);
+    } else {
+        SPIFFS_clearerr(efs->fs);
+    }
+}
+#endif // CONFIG_SPIFFS_NAME_INDEX
+
 static int vfs_spiffs_open(void* ctx, const char * path, int flags, int mode)
 {
     assert(path);
     esp_spiffs_t * efs = (esp_spiffs_t *)ctx;
     int spiffs_flags = spiffs_mode_conv(flags);
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+    spiffs_stat s;
+    xSemaphoreTake(efs->index_lock, portMAX_DELAY);
+    int fd = spiffs_name_index_open(&efs->index, efs->fs, path, spiffs_flags, &s);
+    xSemaphoreGive(efs->index_lock);
+#else
     int fd = SPIFFS_open(efs->fs, path, spiffs_flags, mode);
+#endif
     if (fd < 0) {
-        errno = spiffs_res_to_errno(SPIFFS_errno(efs->fs));
+        errno = spiffs_res_to_errno(fd);
         SPIFFS_clearerr(efs->fs);
         return -1;
     }
@@ -583,6 +667,11 @@ static ssize_t vfs_spiffs_read(void* ctx, int fd, void * dst, size_t size)
 static int vfs_spiffs_close(void* ctx, int fd)
 {
     esp_spiffs_t * efs = (esp_spiffs_t *)ctx;
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+    xSemaphoreTake(efs->index_lock, portMAX_DELAY);
+    vfs_spiffs_index_refresh(efs, fd);
+    xSemaphoreGive(efs->index_lock);
+#endif
     int res = SPIFFS_close(efs->fs, fd);
     if (res < 0) {
         errno = spiffs_res_to_errno(SPIFFS_errno(efs->fs));
@@ -644,9 +733,15 @@ static int vfs_spiffs_stat(void* ctx, const char * path, struct stat * st)
     assert(st);
     spiffs_stat s;
     esp_spiffs_t * efs = (esp_spiffs_t *)ctx;
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+    xSemaphoreTake(efs->index_lock, portMAX_DELAY);
+    off_t res = vfs_spiffs_index_stat(efs, path, &s);
+    xSemaphoreGive(efs->index_lock);
+#else
     off_t res = SPIFFS_stat(efs->fs, path, &s);
+#endif
     if (res < 0) {
-        errno = spiffs_res_to_errno(SPIFFS_errno(efs->fs));
+        errno = spiffs_res_to_errno(res);
         SPIFFS_clearerr(efs->fs);
         return -1;
     }
@@ -665,9 +760,23 @@ static int vfs_spiffs_rename(void* ctx, const char *src, const char *dst)
     assert(src);
     assert(dst);
     esp_spiffs_t * efs = (esp_spiffs_t *)ctx;
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+    spiffs_stat s;
+    xSemaphoreTake(efs->index_lock, portMAX_DELAY);
+    int res = vfs_spiffs_index_stat(efs, src, &s);
+    if (res == SPIFFS_OK) {
+        res = SPIFFS_rename(efs->fs, src, dst);
+    }
+    if (res == SPIFFS_OK) {
+        // the header has been rewritten, its page is looked up again on the next open
+        spiffs_name_index_update(&efs->index, dst, s.obj_id, 0);
+    }
+    xSemaphoreGive(efs->index_lock);
+#else
     int res = SPIFFS_rename(efs->fs, src, dst);
+#endif
     if (res < 0) {
-        errno = spiffs_res_to_errno(SPIFFS_errno(efs->fs));
+        errno = spiffs_res_to_errno(res);
         SPIFFS_clearerr(efs->fs);
         return -1;
     }
@@ -678,9 +787,30 @@ static int vfs_spiffs_unlink(void* ctx, const char *path)
 {
     assert(path);
     esp_spiffs_t * efs = (esp_spiffs_t *)ctx;
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+    spiffs_stat s;
+    xSemaphoreTake(efs->index_lock, portMAX_DELAY);
+    int res = spiffs_name_index_open(&efs->index, efs->fs, path, SPIFFS_RDWR, &s);
+    if (res >= 0) {
+        spiffs_file fd = res;
+        res = SPIFFS_fremove(efs->fs, fd);
+        (void)SPIFFS_close(efs->fs, fd);
+    } else if (res == SPIFFS_ERR_OUT_OF_FILE_DESCS) {
+        SPIFFS_clearerr(efs->fs);
+        res = SPIFFS_stat(efs->fs, path, &s);
+        if (res == SPIFFS_OK) {
+            res = SPIFFS_remove(efs->fs, path);
+        }
+    }
+    if (res == SPIFFS_OK) {
+        spiffs_name_index_remove(&efs->index, s.obj_id);
+    }
+    xSemaphoreGive(efs->index_lock);
+#else
     int res = SPIFFS_remove(efs->fs, path);
+#endif
     if (res < 0) {
-        errno = spiffs_res_to_errno(SPIFFS_errno(efs->fs));
+        errno = spiffs_res_to_errno(res);
         SPIFFS_clearerr(efs->fs);
         return -1;
     }
@@ -827,10 +957,22 @@ static int vfs_spiffs_truncate(void* ctx, const char *path, off_t length)
 {
     assert(path);
     esp_spiffs_t * efs = (esp_spiffs_t *)ctx;
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+    spiffs_stat s;
+    xSemaphoreTake(efs->index_lock, portMAX_DELAY);
+    int fd = spiffs_name_index_open(&efs->index, efs->fs, path, SPIFFS_WRONLY, &s);
+    xSemaphoreGive(efs->index_lock);
+    if (fd < 0) {
+        errno = spiffs_res_to_errno(fd);
+        SPIFFS_clearerr(efs->fs);
+        return -1;
+    }
+#else
     int fd = SPIFFS_open(efs->fs, path, SPIFFS_WRONLY, 0);
     if (fd < 0) {
         goto err;
     }
+#endif
 
     int res = SPIFFS_ftruncate(efs->fs, fd, length);
     if (res < 0) {
@@ -838,6 +980,12 @@ static int vfs_spiffs_truncate(void* ctx, const char *path, off_t length)
         goto err;
     }
 
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+    xSemaphoreTake(efs->index_lock, portMAX_DELAY);
+    vfs_spiffs_index_refresh(efs, fd);
+    xSemaphoreGive(efs->index_lock);
+#endif
+
     res = SPIFFS_close(efs->fs, fd);
     if (res < 0) {
        goto err;
@@ -1,17 +1,19 @@
 /*
- * SPDX-FileCopyrightText: 2016-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2016-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <stdlib.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <dirent.h>
 #include <limits.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "Mockqueue.h"
@@ -20,6 +22,7 @@
 #include "spiffs.h"
 #include "spiffs_nucleus.h"
 #include "spiffs_api.h"
+#include "spiffs_name_index.h"
 
 #include "unity.h"
 #include "unity_fixture.h"
@@ -310,10 +313,150 @@ TEST(spiffs, erase_check)
 #endif
 }
 
+static uint32_t s_flash_reads;
+
+static s32_t counting_read(spiffs *fs, uint32_t addr, uint32_t size, uint8_t *dst)
+{
+    s_flash_reads++;
+    return spiffs_api_read(fs, addr, size, dst);
+}
+
+static uint64_t time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Opens every file by name and through the name index, prints the average open latency */
+static void open_latency(size_t file_count)
+{
+    spiffs fs;
+    spiffs_name_index_t index = {};
+    spiffs_stat s;
+    char name[16];
+
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, "storage");
+    TEST_ASSERT_NOT_NULL(partition);
+    esp_partition_erase_range(partition, 0, partition->size);
+    init_spiffs(&fs, 5);
+
+    for (size_t i = 0; i < file_count; i++) {
+        snprintf(name, sizeof(name), "/file%04zu", i);
+        spiffs_file f = SPIFFS_open(&fs, name, SPIFFS_CREAT | SPIFFS_EXCL | SPIFFS_RDWR, 0);
+        TEST_ASSERT_TRUE(f >= SPIFFS_OK);
+        TEST_ASSERT_EQUAL(strlen(name), SPIFFS_write(&fs, f, name, strlen(name)));
+        TEST_ASSERT_EQUAL(SPIFFS_OK, SPIFFS_close(&fs, f));
+    }
+    TEST_ASSERT_EQUAL(SPIFFS_OK, spiffs_name_index_build(&index, &fs));
+    TEST_ASSERT_EQUAL(file_count, index.count);
+    TEST_ASSERT_TRUE(index.complete);
+
+    fs.cfg.hal_read_f = counting_read;
+    uint64_t name_ns = 0, index_ns = 0;
+    uint32_t name_reads = 0, index_reads = 0;
+    for (size_t i = 0; i < file_count; i++) {
+        snprintf(name, sizeof(name), "/file%04zu", i);
+
+        s_flash_reads = 0;
+        uint64_t start = time_ns();
+        spiffs_file f = SPIFFS_open(&fs, name, SPIFFS_RDONLY, 0);
+        name_ns += time_ns() - start;
+        name_reads += s_flash_reads;
+        TEST_ASSERT_TRUE(f >= SPIFFS_OK);
+        TEST_ASSERT_EQUAL(SPIFFS_OK, SPIFFS_close(&fs, f));
+
+        s_flash_reads = 0;
+        start = time_ns();
+        f = spiffs_name_index_open(&index, &fs, name, SPIFFS_RDONLY, &s);
+        index_ns += time_ns() - start;
+        index_reads += s_flash_reads;
+        TEST_ASSERT_TRUE(f >= SPIFFS_OK);
+        TEST_ASSERT_EQUAL_STRING(name, (const char *) s.name);
+        char data[16] = {};
+        TEST_ASSERT_EQUAL(strlen(name), SPIFFS_read(&fs, f, data, sizeof(data)));
+        TEST_ASSERT_EQUAL_STRING(name, data);
+        TEST_ASSERT_EQUAL(SPIFFS_OK, SPIFFS_close(&fs, f));
+    }
+    TEST_ASSERT_LESS_THAN(name_reads, index_reads);
+
+    // Missing names are resolved without accessing the flash
+    s_flash_reads = 0;
+    TEST_ASSERT_EQUAL(SPIFFS_ERR_NOT_FOUND, spiffs_name_index_open(&index, &fs, "/missing", SPIFFS_RDONLY, &s));
+    TEST_ASSERT_EQUAL(0, s_flash_reads);
+
+    printf("%zu files: open by name %" PRIu64 " ns (%" PRIu32 " reads), through index %" PRIu64 " ns (%" PRIu32 " reads)\n",
+           file_count, name_ns / file_count, name_reads / (uint32_t) file_count,
+           index_ns / file_count, index_reads / (uint32_t) file_count);
+
+    spiffs_name_index_free(&index);
+    deinit_spiffs(&fs);
+}
+
+TEST(spiffs, open_latency_with_name_index)
+{
+    open_latency(100);
+    open_latency(1000);
+}
+
+TEST(spiffs, name_index_follows_changes)
+{
+    spiffs fs;
+    spiffs_name_index_t index = {};
+    spiffs_stat s;
+
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, "storage");
+    TEST_ASSERT_NOT_NULL(partition);
+    esp_partition_erase_range(partition, 0, partition->size);
+    init_spiffs(&fs, 5);
+    TEST_ASSERT_EQUAL(SPIFFS_OK, spiffs_name_index_build(&index, &fs));
+    TEST_ASSERT_EQUAL(0, index.count);
+
+    // Created files are added to the index
+    TEST_ASSERT_EQUAL(SPIFFS_ERR_NOT_FOUND, spiffs_name_index_open(&index, &fs, "/a", SPIFFS_RDONLY, &s));
+    spiffs_file f = spiffs_name_index_open(&index, &fs, "/a", SPIFFS_CREAT | SPIFFS_RDWR, &s);
+    TEST_ASSERT_TRUE(f >= SPIFFS_OK);
+    TEST_ASSERT_EQUAL(1, index.count);
+    TEST_ASSERT_EQUAL(4, SPIFFS_write(&fs, f, "data", 4));
+    TEST_ASSERT_EQUAL(SPIFFS_OK, SPIFFS_fstat(&fs, f, &s));
+    spiffs_name_index_refresh(&index, (const char *) s.name, s.obj_id, s.pix);
+    TEST_ASSERT_EQUAL(SPIFFS_OK, SPIFFS_close(&fs, f));
+    TEST_ASSERT_EQUAL(SPIFFS_ERR_FILE_EXISTS,
+                      spiffs_name_index_open(&index, &fs, "/a", SPIFFS_CREAT | SPIFFS_EXCL | SPIFFS_RDWR, &s));
+
+    // Renamed files are found under the new name only
+    spiffs_obj_id obj_id = s.obj_id;
+    TEST_ASSERT_EQUAL(SPIFFS_OK, SPIFFS_rename(&fs, "/a", "/b"));
+    spiffs_name_index_update(&index, "/b", obj_id, 0);
+    TEST_ASSERT_EQUAL(SPIFFS_ERR_NOT_FOUND, spiffs_name_index_open(&index, &fs, "/a", SPIFFS_RDONLY, &s));
+    f = spiffs_name_index_open(&index, &fs, "/b", SPIFFS_RDONLY, &s);
+    TEST_ASSERT_TRUE(f >= SPIFFS_OK);
+    TEST_ASSERT_EQUAL(obj_id, s.obj_id);
+    TEST_ASSERT_EQUAL(4, s.size);
+    TEST_ASSERT_EQUAL(SPIFFS_OK, SPIFFS_close(&fs, f));
+
+    // Truncation only applies to the file found by name
+    f = spiffs_name_index_open(&index, &fs, "/b", SPIFFS_TRUNC | SPIFFS_RDWR, &s);
+    TEST_ASSERT_TRUE(f >= SPIFFS_OK);
+    TEST_ASSERT_EQUAL(0, s.size);
+    TEST_ASSERT_EQUAL(SPIFFS_OK, SPIFFS_close(&fs, f));
+
+    // Removed files are not found anymore
+    TEST_ASSERT_EQUAL(SPIFFS_OK, SPIFFS_remove(&fs, "/b"));
+    spiffs_name_index_remove(&index, obj_id);
+    TEST_ASSERT_EQUAL(0, index.count);
+    TEST_ASSERT_EQUAL(SPIFFS_ERR_NOT_FOUND, spiffs_name_index_open(&index, &fs, "/b", SPIFFS_RDONLY, &s));
+
+    spiffs_name_index_free(&index);
+    deinit_spiffs(&fs);
+}
+
 TEST_GROUP_RUNNER(spiffs)
 {
     RUN_TEST_CASE(spiffs, format_disk_open_file_write_and_read_file);
     RUN_TEST_CASE(spiffs, can_read_spiffs_image);
+    RUN_TEST_CASE(spiffs, open_latency_with_name_index);
+    RUN_TEST_CASE(spiffs, name_index_follows_changes);
     RUN_TEST_CASE(spiffs, erase_check);
 }
 
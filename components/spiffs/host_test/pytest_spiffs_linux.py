@@ -9,4 +9,4 @@ from pytest_embedded_idf.utils import idf_parametrize
 @pytest.mark.parametrize('config', ['erase_check', 'no_erase_check'])
 @idf_parametrize('target', ['linux'], indirect=['target'])
 def test_spiffs_linux(dut: Dut) -> None:
-    dut.expect_unity_test_output(timeout=5)
+    dut.expect_unity_test_output(timeout=60)
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2022 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -13,6 +13,10 @@
 #include "freertos/semphr.h"
 #include "spiffs.h"
 #include "esp_compiler.h"
+#include "sdkconfig.h"
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+#include "spiffs_name_index.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -35,6 +39,10 @@ typedef struct {
     uint32_t fds_sz;                        /*!< File Descriptor Buffer Length */
     uint8_t *cache;                         /*!< Cache Buffer */
     uint32_t cache_sz;                      /*!< Cache Buffer Length */
+#ifdef CONFIG_SPIFFS_NAME_INDEX
+    SemaphoreHandle_t index_lock;           /*!< Serializes the operations which use or change the name index */
+    spiffs_name_index_t index;              /*!< Name to object index */
+#endif
 } esp_spiffs_t;
 
 s32_t spiffs_api_read(spiffs *fs, uint32_t addr, uint32_t size, uint8_t *dst);
@@ -0,0 +1,202 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "spiffs_name_index.h"
+
+#define NAME_INDEX_MIN_CAPACITY 16
+
+static uint32_t name_hash(const char *name)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < SPIFFS_OBJ_NAME_LEN && name[i] != '\0'; i++) {
+        hash ^= (uint8_t) name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static size_t lower_bound(const spiffs_name_index_t *index, uint32_t hash)
+{
+    size_t lo = 0, hi = index->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (index->entries[mid].hash < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static bool insert(spiffs_name_index_t *index, uint32_t hash, spiffs_obj_id obj_id, spiffs_page_ix pix)
+{
+    if (index->count == index->capacity) {
+        size_t capacity = index->capacity ? index->capacity * 2 : NAME_INDEX_MIN_CAPACITY;
+        spiffs_name_index_entry_t *entries = realloc(index->entries, capacity * sizeof(*entries));
+        if (entries == NULL) {
+            // the object is no longer found without scanning the file system
+            index->complete = false;
+            return false;
+        }
+        index->entries = entries;
+        index->capacity = capacity;
+    }
+    size_t pos = lower_bound(index, hash);
+    memmove(&index->entries[pos + 1], &index->entries[pos], (index->count - pos) * sizeof(index->entries[0]));
+    index->entries[pos] = (spiffs_name_index_entry_t) {
+        .hash = hash,
+        .obj_id = obj_id,
+        .pix = pix,
+    };
+    index->count++;
+    return true;
+}
+
+s32_t spiffs_name_index_build(spiffs_name_index_t *index, spiffs *fs)
+{
+    spiffs_DIR d;
+    struct spiffs_dirent e;
+
+    index->count = 0;
+    index->complete = true;
+    if (SPIFFS_opendir(fs, "/", &d) == NULL) {
+        s32_t res = SPIFFS_errno(fs);
+        SPIFFS_clearerr(fs);
+        index->complete = false;
+        return res;
+    }
+    while (SPIFFS_readdir(&d, &e) != NULL) {
+        insert(index, name_hash((const char *) e.name), e.obj_id, e.pix);
+    }
+    s32_t res = SPIFFS_errno(fs);
+    if (res != SPIFFS_OK && res != SPIFFS_VIS_END) {
+        SPIFFS_clearerr(fs);
+        index->complete = false;
+    } else {
+        res = SPIFFS_OK;
+    }
+    SPIFFS_closedir(&d);
+    return res;
+}
+
+void spiffs_name_index_free(spiffs_name_index_t *index)
+{
+    free(index->entries);
+    *index = (spiffs_name_index_t) {};
+}
+
+void spiffs_name_index_remove(spiffs_name_index_t *index, spiffs_obj_id obj_id)
+{
+    for (size_t i = 0; i < index->count; i++) {
+        if (index->entries[i].obj_id == obj_id) {
+            index->count--;
+            memmove(&index->entries[i], &index->entries[i + 1], (index->count - i) * sizeof(index->entries[0]));
+            return;
+        }
+    }
+}
+
+static spiffs_name_index_entry_t *find(spiffs_name_index_t *index, uint32_t hash, spiffs_obj_id obj_id)
+{
+    for (size_t i = lower_bound(index, hash); i < index->count && index->entries[i].hash == hash; i++) {
+        if (index->entries[i].obj_id == obj_id) {
+            return &index->entries[i];
+        }
+    }
+    return NULL;
+}
+
+void spiffs_name_index_update(spiffs_name_index_t *index, const char *name,
+                              spiffs_obj_id obj_id, spiffs_page_ix pix)
+{
+    uint32_t hash = name_hash(name);
+    spiffs_name_index_entry_t *entry = find(index, hash, obj_id);
+    if (entry) {
+        entry->pix = pix;
+        return;
+    }
+    // new object, or an object known under another name
+    spiffs_name_index_remove(index, obj_id);
+    insert(index, hash, obj_id, pix);
+}
+
+void spiffs_name_index_refresh(spiffs_name_index_t *index, const char *name,
+                               spiffs_obj_id obj_id, spiffs_page_ix pix)
+{
+    spiffs_name_index_entry_t *entry = find(index, name_hash(name), obj_id);
+    if (entry) {
+        entry->pix = pix;
+    }
+}
+
+spiffs_file spiffs_name_index_open(spiffs_name_index_t *index, spiffs *fs, const char *path,
+                                   spiffs_flags flags, spiffs_stat *s)
+{
+    const uint32_t hash = name_hash(path);
+    // Truncation has to wait until the right file is found
+    const spiffs_flags page_flags = flags & ~(SPIFFS_O_CREAT | SPIFFS_O_EXCL | SPIFFS_O_TRUNC);
+    bool unresolved = false;
+    spiffs_file fd;
+
+    for (size_t i = lower_bound(index, hash); i < index->count && index->entries[i].hash == hash; i++) {
+        const spiffs_name_index_entry_t *entry = &index->entries[i];
+        if (entry->pix == 0) {
+            unresolved = true;
+            continue;
+        }
+        fd = SPIFFS_open_by_page(fs, entry->pix, page_flags, 0);
+        if (fd < 0) {
+            // the header has moved, e.g. it was rewritten or garbage collected
+            SPIFFS_clearerr(fs);
+            unresolved = true;
+            continue;
+        }
+        if (SPIFFS_fstat(fs, fd, s) != SPIFFS_OK || s->obj_id != entry->obj_id) {
+            SPIFFS_close(fs, fd);
+            SPIFFS_clearerr(fs);
+            unresolved = true;
+            continue;
+        }
+        if (strncmp((const char *) s->name, path, SPIFFS_OBJ_NAME_LEN) != 0) {
+            // another object with the same hash
+            SPIFFS_close(fs, fd);
+            continue;
+        }
+        if ((flags & SPIFFS_O_CREAT) && (flags & SPIFFS_O_EXCL)) {
+            SPIFFS_close(fs, fd);
+            return SPIFFS_ERR_FILE_EXISTS;
+        }
+        if (flags & SPIFFS_O_TRUNC) {
+            if (SPIFFS_ftruncate(fs, fd, 0) != SPIFFS_OK || SPIFFS_fstat(fs, fd, s) != SPIFFS_OK) {
+                s32_t res = SPIFFS_errno(fs);
+                SPIFFS_close(fs, fd);
+                return res;
+            }
+            spiffs_name_index_update(index, path, s->obj_id, s->pix);
+        }
+        return fd;
+    }
+
+    if (index->complete && !unresolved && !(flags & SPIFFS_O_CREAT)) {
+        return SPIFFS_ERR_NOT_FOUND;
+    }
+
+    fd = SPIFFS_open(fs, path, flags, 0);
+    if (fd < 0) {
+        return SPIFFS_errno(fs);
+    }
+    if (SPIFFS_fstat(fs, fd, s) == SPIFFS_OK) {
+        spiffs_name_index_update(index, path, s->obj_id, s->pix);
+    } else {
+        SPIFFS_clearerr(fs);
+        index->complete = false;
+    }
+    return fd;
+}
@@ -0,0 +1,107 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "spiffs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Name index entry
+ *
+ * Names are not stored, an entry only tells where the object with a name of the given hash
+ * was last seen. Every hit is verified against the object index header.
+ */
+typedef struct {
+    uint32_t hash;              /*!< Hash of the object name */
+    spiffs_obj_id obj_id;       /*!< Object ID */
+    spiffs_page_ix pix;         /*!< Last known object index header page, 0 if unknown */
+} spiffs_name_index_entry_t;
+
+/**
+ * @brief In-RAM index of object names, sorted by hash
+ */
+typedef struct {
+    spiffs_name_index_entry_t *entries; /*!< Entries sorted by hash */
+    size_t count;                       /*!< Number of used entries */
+    size_t capacity;                    /*!< Number of allocated entries */
+    bool complete;                      /*!< Every object of the file system has an entry */
+} spiffs_name_index_t;
+
+/**
+ * @brief Build the index from the objects of a mounted file system
+ *
+ * @param index  index to (re)build
+ * @param fs     mounted file system
+ *
+ * @return SPIFFS_OK, or an error if the file system could not be listed. The index is then
+ *         incomplete, opening names which are not in it falls back to a lookup by name.
+ */
+s32_t spiffs_name_index_build(spiffs_name_index_t *index, spiffs *fs);
+
+/**
+ * @brief Free the entries of the index
+ */
+void spiffs_name_index_free(spiffs_name_index_t *index);
+
+/**
+ * @brief Open a file, using the index to find its object index header
+ *
+ * Equivalent to SPIFFS_open, except that the object lookup pages are only scanned if the
+ * index does not know where the file is. If the index is complete and has no entry for the
+ * name, SPIFFS_ERR_NOT_FOUND is returned without accessing the flash, unless SPIFFS_O_CREAT
+ * is given. Files opened or created by name are added to the index.
+ *
+ * @param index  name index of the file system
+ * @param fs     file system
+ * @param path   name of the file
+ * @param flags  SPIFFS_O_* flags
+ * @param[out] s status of the opened file
+ *
+ * @return file handle, or a negative SPIFFS error code
+ */
+spiffs_file spiffs_name_index_open(spiffs_name_index_t *index, spiffs *fs, const char *path,
+                                   spiffs_flags flags, spiffs_stat *s);
+
+/**
+ * @brief Add an object to the index or update its name and header page
+ *
+ * @param index   name index
+ * @param name    current name of the object
+ * @param obj_id  object ID
+ * @param pix     object index header page, 0 if unknown
+ */
+void spiffs_name_index_update(spiffs_name_index_t *index, const char *name,
+                              spiffs_obj_id obj_id, spiffs_page_ix pix);
+
+/**
+ * @brief Update the header page of an object which is already in the index
+ *
+ * Unlike spiffs_name_index_update, objects which are not in the index are ignored. Used with
+ * the status of open files, which may have been removed in the meantime.
+ *
+ * @param index   name index
+ * @param name    name of the object
+ * @param obj_id  object ID
+ * @param pix     object index header page
+ */
+void spiffs_name_index_refresh(spiffs_name_index_t *index, const char *name,
+                               spiffs_obj_id obj_id, spiffs_page_ix pix);
+
+/**
+ * @brief Remove an object from the index
+ */
+void spiffs_name_index_remove(spiffs_name_index_t *index, spiffs_obj_id obj_id);
+
+#ifdef __cplusplus
+}
+#endif
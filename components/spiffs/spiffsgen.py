@@ -2,13 +2,19 @@
 #
 # spiffsgen is a tool used to generate a spiffs image from a directory
 #
-# SPDX-FileCopyrightText: 2019-2024 Espressif Systems (Shanghai) CO LTD
+# SPDX-FileCopyrightText: 2019-2025 Espressif Systems (Shanghai) CO LTD
 # SPDX-License-Identifier: Apache-2.0
 import argparse
+import csv
+import hashlib
 import io
 import math
 import os
+import pickle
+import stat
 import struct
+import sys
+from concurrent.futures import ProcessPoolExecutor
 
 try:
     import typing
@@ -156,13 +162,11 @@ class SpiffsObjLuPage(SpiffsPage):
         self.obj_ids_limit -= 1
 
     def to_binary(self):  # type: () -> bytes
-        img = b''
-
-        for (obj_id, page_type) in self.obj_ids:
-            if page_type == SpiffsObjIndexPage:
-                obj_id ^= (1 << ((self.build_config.obj_id_len * 8) - 1))
-            img += struct.pack(SpiffsPage._endianness_dict[self.build_config.endianness] +
-                               SpiffsPage._len_dict[self.build_config.obj_id_len], obj_id)
+        index_flag = 1 << ((self.build_config.obj_id_len * 8) - 1)
+        obj_ids = [obj_id ^ index_flag if page_type == SpiffsObjIndexPage else obj_id
+                   for (obj_id, page_type) in self.obj_ids]
+        img = struct.pack(SpiffsPage._endianness_dict[self.build_config.endianness] +
+                          SpiffsPage._len_dict[self.build_config.obj_id_len] * len(obj_ids), *obj_ids)
 
         assert len(img) <= self.build_config.page_size
 
@@ -359,17 +363,12 @@ class SpiffsBlock(object):
         return self.remaining_pages <= 0
 
     def to_binary(self, blocks_lim):  # type: (int) -> bytes
-        img = b''
-
         if self.build_config.use_magic:
-            for (idx, page) in enumerate(self.pages):
-                if idx == self.build_config.OBJ_LU_PAGES_PER_BLOCK - 1:
-                    assert isinstance(page, SpiffsObjLuPage)
-                    page.magicfy(blocks_lim)
-                img += page.to_binary()
-        else:
-            for page in self.pages:
-                img += page.to_binary()
+            page = self.pages[self.build_config.OBJ_LU_PAGES_PER_BLOCK - 1]
+            assert isinstance(page, SpiffsObjLuPage)
+            page.magicfy(blocks_lim)
+
+        img = b''.join([page.to_binary() for page in self.pages])
 
         assert len(img) <= self.build_config.block_size
 
@@ -456,24 +455,161 @@ class SpiffsFS(object):
 
         self.cur_obj_id += 1
 
-    def to_binary(self):  # type: () -> bytes
-        img = b''
-        all_blocks = []
+    def write_to(self, stream):  # type: (typing.BinaryIO) -> None
+        # Blocks are written as soon as they are converted, so the whole image is never held in memory.
+        # Converting finalizes the lookup pages, no files can be added afterwards.
         for block in self.blocks:
-            all_blocks.append(block.to_binary(self.blocks_lim))
-        bix = len(self.blocks)
+            stream.write(block.to_binary(self.blocks_lim))
         if self.build_config.use_magic:
             # Create empty blocks with magic numbers
-            while self.remaining_blocks > 0:
-                block = SpiffsBlock(bix, self.build_config)
-                all_blocks.append(block.to_binary(self.blocks_lim))
-                self.remaining_blocks -= 1
-                bix += 1
+            for bix in range(len(self.blocks), self.blocks_lim):
+                stream.write(SpiffsBlock(bix, self.build_config).to_binary(self.blocks_lim))
         else:
             # Just fill remaining spaces FF's
-            all_blocks.append(b'\xFF' * (self.img_size - len(all_blocks) * self.build_config.block_size))
-        img += b''.join([blk for blk in all_blocks])
-        return img
+            stream.write(b'\xFF' * (self.img_size - len(self.blocks) * self.build_config.block_size))
+        self.remaining_blocks = 0
+
+    def to_binary(self):  # type: () -> bytes
+        img = io.BytesIO()
+        self.write_to(img)
+        return img.getvalue()
+
+
+def read_batch_overrides(csv_path):  # type: (str) -> typing.Dict[str, typing.Dict[str, str]]
+    """
+    Reads the per-device files for the batch mode. Each row contains the name of the device, the path of
+    the file in the image and the path of the source file (relative to the CSV file). Rows starting with
+    '#' are ignored.
+    """
+    overrides = dict()  # type: typing.Dict[str, typing.Dict[str, str]]
+    base_dir = os.path.dirname(os.path.abspath(csv_path))
+    with open(csv_path, newline='') as csv_file:
+        for row in csv.reader(csv_file):
+            if not row or row[0].strip().startswith('#'):
+                continue
+            if len(row) != 3:
+                raise RuntimeError('invalid batch row %s, expected: device, path, source' % row)
+            device, img_path, source = (column.strip() for column in row)
+            overrides.setdefault(device, dict())['/' + img_path.lstrip('/')] = os.path.join(base_dir, source)
+    return overrides
+
+
+def list_files(base_dir, follow_symlinks=False):  # type: (str, bool) -> typing.Dict[str, str]
+    """
+    Returns the files of the directory by their path in the image, in the order they are added to it.
+    """
+    files = dict()  # type: typing.Dict[str, str]
+    for root, dirs, names in os.walk(base_dir, followlinks=follow_symlinks):
+        for f in names:
+            full_path = os.path.join(root, f)
+            files['/' + os.path.relpath(full_path, base_dir).replace('\\', '/')] = full_path
+    return files
+
+
+def _is_private(path):  # type: (str) -> bool
+    """
+    Tells whether the file or directory is owned by the current user and cannot be modified by other users.
+    Where ownership is not available (Windows), nothing is considered private.
+    """
+    if not hasattr(os, 'getuid'):
+        return False
+    path_stat = os.stat(path)
+    return path_stat.st_uid == os.getuid() and not path_stat.st_mode & (stat.S_IWGRP | stat.S_IWOTH)
+
+
+def _read_cached_template(cache_dir, cache_path):  # type: (str, str) -> typing.Optional[bytes]
+    """
+    Returns the cached template, or None if there is none. Templates are unpickled, which can execute code,
+    so a cache file is only used if it and the cache directory can only be modified by the current user.
+    """
+    if not os.path.isfile(cache_path):
+        return None
+    if not (_is_private(cache_dir) and _is_private(cache_path)):
+        print('Ignoring %s: the cache directory and its files must be owned by the current user '
+              'and must not be writable by other users' % cache_path, file=sys.stderr)
+        return None
+    with open(cache_path, 'rb') as cache_file:
+        return cache_file.read()
+
+
+def _write_cached_template(cache_dir, cache_path, template):  # type: (str, str, bytes) -> None
+    os.makedirs(cache_dir, mode=0o700, exist_ok=True)
+    tmp_path = cache_path + '.tmp'
+    with open(os.open(tmp_path, os.O_WRONLY | os.O_CREAT | os.O_TRUNC, 0o600), 'wb') as cache_file:
+        cache_file.write(template)
+    os.replace(tmp_path, cache_path)
+
+
+def generate_template(image_size, build_config, files, cache_dir=None):
+    # type: (int, SpiffsBuildConfig, typing.Dict[str, str], typing.Optional[str]) -> bytes
+    """
+    Adds the files to a new file system and returns it serialized, so that more files can be added to
+    copies of it. With a cache directory, the result is reused as long as the names and contents of the
+    files and the configuration do not change. The cache directory has to be private to the current
+    user, see `_read_cached_template`.
+    """
+    cache_path = None
+    if cache_dir is not None:
+        key = hashlib.sha256(repr((image_size, sorted(vars(build_config).items()))).encode())
+        for img_path, file_path in files.items():
+            with open(file_path, 'rb') as f:
+                key.update(img_path.encode() + b'\0' + hashlib.sha256(f.read()).digest())
+        cache_path = os.path.join(cache_dir, 'spiffs-%s.pickle' % key.hexdigest())
+        cached = _read_cached_template(cache_dir, cache_path)
+        if cached is not None:
+            return cached
+
+    spiffs = SpiffsFS(image_size, build_config)
+    for img_path, file_path in files.items():
+        spiffs.create_file(img_path, file_path)
+    template = pickle.dumps(spiffs, protocol=pickle.HIGHEST_PROTOCOL)
+
+    if cache_path is not None:
+        _write_cached_template(cache_dir, cache_path, template)  # type: ignore
+    return template
+
+
+_batch_template = b''
+
+
+def _init_batch_worker(template):  # type: (bytes) -> None
+    global _batch_template
+    _batch_template = template
+
+
+def _generate_device_image(files, output_path):  # type: (typing.Dict[str, str], str) -> str
+    spiffs = pickle.loads(_batch_template)  # type: SpiffsFS
+    for img_path, file_path in files.items():
+        spiffs.create_file(img_path, file_path)
+    with open(output_path, 'wb') as image_file:
+        spiffs.write_to(image_file)
+    return output_path
+
+
+def generate_batch(image_size, build_config, files, overrides, output_dir, jobs=1, cache_dir=None):
+    # type: (int, SpiffsBuildConfig, typing.Dict[str, str], typing.Dict[str, typing.Dict[str, str]], str, int, typing.Optional[str]) -> typing.List[str]
+    """
+    Generates an image named <device>.img for each device, containing the common files with the
+    per-device files added or replaced. The common files are only added once, to a template which is
+    copied for each device; the files replaced on any device are left out of it and added afterwards.
+    """
+    replaced = set(img_path for device_files in overrides.values() for img_path in device_files if img_path in files)
+    template = generate_template(image_size, build_config,
+                                 dict((k, v) for k, v in files.items() if k not in replaced), cache_dir)
+
+    if not os.path.isdir(output_dir):
+        os.makedirs(output_dir)
+    tasks = []
+    for device, device_overrides in overrides.items():
+        device_files = dict((k, files[k]) for k in sorted(replaced) if k not in device_overrides)
+        device_files.update(device_overrides)
+        tasks.append((device_files, os.path.join(output_dir, device + '.img')))
+
+    if jobs <= 1:
+        _init_batch_worker(template)
+        return [_generate_device_image(*task) for task in tasks]
+    with ProcessPoolExecutor(max_workers=jobs, initializer=_init_batch_worker, initargs=(template,)) as executor:
+        return list(executor.map(_generate_device_image, *zip(*tasks)))
 
 
 class CustomHelpFormatter(argparse.HelpFormatter):
@@ -505,7 +641,8 @@ def main():  # type: () -> None
                         help='Path to directory from which the image will be created')
 
     parser.add_argument('output_file',
-                        help='Created image output file path')
+                        help='Created image output file path, "-" for the standard output. '
+                             'With --batch, the directory for the images.')
 
     parser.add_argument('--page-size',
                         help='Logical page size. Set to value same as CONFIG_SPIFFS_PAGE_SIZE.',
@@ -559,6 +696,20 @@ def main():  # type: () -> None
                         action='store_true',
                         help='Use aligned object index tables. Specify if SPIFFS_ALIGNED_OBJECT_INDEX_TABLES is set.')
 
+    parser.add_argument('--batch',
+                        help='CSV file with the per-device files (device, path in the image, source file). '
+                             'An image is generated for each device, containing the files of base_dir '
+                             'with the per-device files added or replaced.')
+
+    parser.add_argument('--jobs',
+                        help='Number of processes generating the images in batch mode.',
+                        type=int,
+                        default=1)
+
+    parser.add_argument('--cache-dir',
+                        help='Directory in which the image of base_dir is cached, so that it is only '
+                             'regenerated when the files or the options change.')
+
     parser.set_defaults(use_magic=True, use_magic_len=True)
 
     args = parser.parse_args()
@@ -566,24 +717,33 @@ def main():  # type: () -> None
     if not os.path.exists(args.base_dir):
         raise RuntimeError('given base directory %s does not exist' % args.base_dir)
 
-    with open(args.output_file, 'wb') as image_file:
-        image_size = int(args.image_size, 0)
-        spiffs_build_default = SpiffsBuildConfig(args.page_size, SPIFFS_PAGE_IX_LEN,
-                                                 args.block_size, SPIFFS_BLOCK_IX_LEN, args.meta_len,
-                                                 args.obj_name_len, SPIFFS_OBJ_ID_LEN, SPIFFS_SPAN_IX_LEN,
-                                                 True, True, 'big' if args.big_endian else 'little',
-                                                 args.use_magic, args.use_magic_len, args.aligned_obj_ix_tables)
-
+    image_size = int(args.image_size, 0)
+    spiffs_build_default = SpiffsBuildConfig(args.page_size, SPIFFS_PAGE_IX_LEN,
+                                             args.block_size, SPIFFS_BLOCK_IX_LEN, args.meta_len,
+                                             args.obj_name_len, SPIFFS_OBJ_ID_LEN, SPIFFS_SPAN_IX_LEN,
+                                             True, True, 'big' if args.big_endian else 'little',
+                                             args.use_magic, args.use_magic_len, args.aligned_obj_ix_tables)
+    files = list_files(args.base_dir, args.follow_symlinks)
+
+    if args.batch:
+        generate_batch(image_size, spiffs_build_default, files, read_batch_overrides(args.batch),
+                       args.output_file, args.jobs, args.cache_dir)
+        return
+
+    if args.cache_dir:
+        spiffs = pickle.loads(generate_template(image_size, spiffs_build_default, files, args.cache_dir))
+    else:
         spiffs = SpiffsFS(image_size, spiffs_build_default)
+        for img_path, file_path in files.items():
+            spiffs.create_file(img_path, file_path)
 
-        for root, dirs, files in os.walk(args.base_dir, followlinks=args.follow_symlinks):
-            for f in files:
-                full_path = os.path.join(root, f)
-                spiffs.create_file('/' + os.path.relpath(full_path, args.base_dir).replace('\\', '/'), full_path)
-
-        image = spiffs.to_binary()
+    if args.output_file == '-':
+        spiffs.write_to(sys.stdout.buffer)
+        sys.stdout.buffer.flush()
+        return
 
-        image_file.write(image)
+    with open(args.output_file, 'wb') as image_file:
+        spiffs.write_to(image_file)
 
 
 if __name__ == '__main__':
@@ -9,6 +9,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <sys/time.h>
 #include <sys/unistd.h>
@@ -776,6 +777,76 @@ TEST_CASE("multiple tasks can use same volume", "[spiffs]")
     test_teardown();
 }
 
+typedef struct {
+    const char* filename;
+    volatile bool stop;
+    SemaphoreHandle_t done;
+    int lookups;
+} stat_loop_arg_t;
+
+static void stat_loop_task(void* param)
+{
+    stat_loop_arg_t* args = (stat_loop_arg_t*) param;
+    struct stat st;
+    while (!args->stop) {
+        // the file exists before the format and is gone after it, either result is fine
+        stat(args->filename, &st);
+        args->lookups++;
+        vTaskDelay(1);
+    }
+    xSemaphoreGive(args->done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("lookups through the VFS follow file changes and formatting", "[spiffs]")
+{
+    const esp_partition_t* part = get_partition();
+    test_setup();
+    struct stat st;
+    const char* name_a = "/spiffs/index_a.txt";
+    const char* name_b = "/spiffs/index_b.txt";
+    unlink(name_a);
+    unlink(name_b);
+
+    // creation, rename, truncation and removal are visible to the following lookups
+    TEST_ASSERT_EQUAL(-1, stat(name_a, &st));
+    TEST_ASSERT_EQUAL(ENOENT, errno);
+    test_spiffs_create_file_with_text(name_a, spiffs_test_hello_str);
+    TEST_ASSERT_EQUAL(0, stat(name_a, &st));
+    TEST_ASSERT_EQUAL(strlen(spiffs_test_hello_str), st.st_size);
+    TEST_ASSERT_EQUAL(0, rename(name_a, name_b));
+    TEST_ASSERT_EQUAL(-1, stat(name_a, &st));
+    TEST_ASSERT_EQUAL(0, stat(name_b, &st));
+    TEST_ASSERT_EQUAL(0, truncate(name_b, 4));
+    TEST_ASSERT_EQUAL(0, stat(name_b, &st));
+    TEST_ASSERT_EQUAL(4, st.st_size);
+    TEST_ASSERT_EQUAL(0, unlink(name_b));
+    TEST_ASSERT_EQUAL(-1, stat(name_b, &st));
+    TEST_ASSERT_EQUAL(ENOENT, errno);
+
+    // formatting the mounted partition while another task looks up a file
+    test_spiffs_create_file_with_text(name_a, spiffs_test_hello_str);
+    stat_loop_arg_t args = {
+        .filename = name_a,
+        .done = xSemaphoreCreateBinary(),
+    };
+    TEST_ASSERT_NOT_NULL(args.done);
+    xTaskCreatePinnedToCore(&stat_loop_task, "stat_loop", 3072, &args, 5, NULL, CONFIG_FREERTOS_NUMBER_OF_CORES - 1);
+    vTaskDelay(2);
+    TEST_ESP_OK(esp_spiffs_format(part->label));
+    args.stop = true;
+    xSemaphoreTake(args.done, portMAX_DELAY);
+    vSemaphoreDelete(args.done);
+    TEST_ASSERT_GREATER_THAN(0, args.lookups);
+
+    TEST_ASSERT_EQUAL(-1, stat(name_a, &st));
+    TEST_ASSERT_EQUAL(ENOENT, errno);
+    test_spiffs_create_file_with_text(name_b, spiffs_test_hello_str);
+    TEST_ASSERT_EQUAL(0, stat(name_b, &st));
+    test_spiffs_read_file(name_b);
+    test_teardown();
+}
+
 #ifdef CONFIG_SPIFFS_USE_MTIME
 TEST_CASE("mtime is updated when file is opened", "[spiffs]")
 {
@@ -11,6 +11,7 @@ from pytest_embedded_idf.utils import idf_parametrize
     [
         'default',
         'release',
+        'name_index',
     ],
     indirect=True,
 )
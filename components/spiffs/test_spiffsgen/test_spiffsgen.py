@@ -1,8 +1,11 @@
 #!/usr/bin/env python
-# SPDX-FileCopyrightText: 2019-2022 Espressif Systems (Shanghai) CO LTD
+# SPDX-FileCopyrightText: 2019-2025 Espressif Systems (Shanghai) CO LTD
 # SPDX-License-Identifier: Apache-2.0
 import os
+import shutil
 import sys
+import tempfile
+import time
 import unittest
 
 try:
@@ -65,6 +68,89 @@ class SpiffsgenTest(unittest.TestCase):
             # Note: it would be nice to compile spiffs for host with the given
             # config, and verify that the image is parsed correctly.
 
+    def setUp(self):  # type: () -> None
+        self.work_dir = tempfile.mkdtemp()
+        self.config = spiffsgen.SpiffsBuildConfig(256, spiffsgen.SPIFFS_PAGE_IX_LEN, 4096, spiffsgen.SPIFFS_BLOCK_IX_LEN,
+                                                  4, 32, spiffsgen.SPIFFS_OBJ_ID_LEN, spiffsgen.SPIFFS_SPAN_IX_LEN,
+                                                  True, True, 'little', True, True, False)
+
+    def tearDown(self):  # type: () -> None
+        shutil.rmtree(self.work_dir)
+
+    def _make_batch_input(self, devices):  # type: (int) -> typing.Tuple[str, str]
+        """Create a base directory with a few files, and a CSV replacing
+        one of them and adding another one on each device.
+        """
+        os.makedirs(os.path.join(self.work_dir, 'base', 'sub'))
+        os.makedirs(os.path.join(self.work_dir, 'devices'))
+        for name in ('a.txt', 'sub/b.txt', 'sub/cfg.txt'):
+            with open(os.path.join(self.work_dir, 'base', name), 'w') as f:
+                f.write(name * 100)
+        csv_path = os.path.join(self.work_dir, 'batch.csv')
+        with open(csv_path, 'w') as csv_file:
+            csv_file.write('# device, path in the image, source\n')
+            for i in range(devices):
+                with open(os.path.join(self.work_dir, 'devices', 'id%d' % i), 'w') as f:
+                    f.write('device %d' % i)
+                csv_file.write('dev%d,sub/cfg.txt,devices/id%d\n' % (i, i))
+                csv_file.write('dev%d,/id.bin,devices/id%d\n' % (i, i))
+        return os.path.join(self.work_dir, 'base'), csv_path
+
+    def test_batch(self):  # type: () -> None
+        """Check that a batch image equals the image generated from the
+        same files, added in the same order.
+        """
+        base_dir, csv_path = self._make_batch_input(2)
+        files = spiffsgen.list_files(base_dir)
+        output_dir = os.path.join(self.work_dir, 'images')
+        cache_dir = os.path.join(self.work_dir, 'cache')
+        for _ in range(2):  # the second run uses the cached template
+            images = spiffsgen.generate_batch(64 * 1024, self.config, files, spiffsgen.read_batch_overrides(csv_path),
+                                              output_dir, jobs=2, cache_dir=cache_dir)
+        self.assertEqual(len(os.listdir(cache_dir)), 1)
+        self.assertEqual(images, [os.path.join(output_dir, 'dev0.img'), os.path.join(output_dir, 'dev1.img')])
+
+        spiffs = spiffsgen.SpiffsFS(64 * 1024, self.config)
+        for img_path in ('/a.txt', '/sub/b.txt'):
+            spiffs.create_file(img_path, files[img_path])
+        spiffs.create_file('/sub/cfg.txt', os.path.join(self.work_dir, 'devices', 'id1'))
+        spiffs.create_file('/id.bin', os.path.join(self.work_dir, 'devices', 'id1'))
+        with open(images[1], 'rb') as f:
+            self.assertEqual(f.read(), spiffs.to_binary())
+
+    @unittest.skipUnless(hasattr(os, 'getuid'), 'requires POSIX file ownership')
+    def test_batch_cache_permissions(self):  # type: () -> None
+        """Check that the cache is private, and that a cache file other users can modify is not unpickled."""
+        base_dir, csv_path = self._make_batch_input(1)
+        files = spiffsgen.list_files(base_dir)
+        output_dir = os.path.join(self.work_dir, 'images')
+        cache_dir = os.path.join(self.work_dir, 'cache')
+        spiffsgen.generate_batch(64 * 1024, self.config, files, spiffsgen.read_batch_overrides(csv_path),
+                                 output_dir, cache_dir=cache_dir)
+        cache_path = os.path.join(cache_dir, os.listdir(cache_dir)[0])
+        self.assertEqual(os.stat(cache_dir).st_mode & 0o777, 0o700)
+        self.assertEqual(os.stat(cache_path).st_mode & 0o777, 0o600)
+        with open(os.path.join(output_dir, 'dev0.img'), 'rb') as f:
+            expected = f.read()
+
+        with open(cache_path, 'wb') as f:
+            f.write(b'not a pickle')
+        os.chmod(cache_path, 0o666)
+        spiffsgen.generate_batch(64 * 1024, self.config, files, spiffsgen.read_batch_overrides(csv_path),
+                                 output_dir, cache_dir=cache_dir)
+        with open(os.path.join(output_dir, 'dev0.img'), 'rb') as f:
+            self.assertEqual(f.read(), expected)
+
+    def test_batch_benchmark(self):  # type: () -> None
+        devices = 100
+        base_dir, csv_path = self._make_batch_input(devices)
+        start = time.perf_counter()
+        images = spiffsgen.generate_batch(64 * 1024, self.config, spiffsgen.list_files(base_dir),
+                                          spiffsgen.read_batch_overrides(csv_path), os.path.join(self.work_dir, 'images'))
+        elapsed = time.perf_counter() - start
+        self.assertEqual(len(images), devices)
+        print('\nspiffsgen batch: %d images in %.2f s, %.0f images/min' % (devices, elapsed, devices * 60 / elapsed))
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -250,6 +250,22 @@ typedef struct
     /** get_socket_select_semaphore returns semaphore allocated in the socket driver; set only for the socket driver */
     esp_err_t (*end_select)(void *end_select_args);
 #endif // CONFIG_VFS_SUPPORT_SELECT || defined __DOXYGEN__
+    union {
+        ssize_t (*readv_p)(void* ctx, int fd, const struct iovec *iov, int iovcnt);                 /*!< readv with context pointer */
+        ssize_t (*readv)(int fd, const struct iovec *iov, int iovcnt);                              /*!< readv without context pointer */
+    };
+    union {
+        ssize_t (*writev_p)(void* ctx, int fd, const struct iovec *iov, int iovcnt);                /*!< writev with context pointer */
+        ssize_t (*writev)(int fd, const struct iovec *iov, int iovcnt);                             /*!< writev without context pointer */
+    };
+    union {
+        ssize_t (*preadv_p)(void* ctx, int fd, const struct iovec *iov, int iovcnt, off_t offset);  /*!< preadv with context pointer */
+        ssize_t (*preadv)(int fd, const struct iovec *iov, int iovcnt, off_t offset);               /*!< preadv without context pointer */
+    };
+    union {
+        ssize_t (*pwritev_p)(void* ctx, int fd, const struct iovec *iov, int iovcnt, off_t offset); /*!< pwritev with context pointer */
+        ssize_t (*pwritev)(int fd, const struct iovec *iov, int iovcnt, off_t offset);              /*!< pwritev without context pointer */
+    };
 } esp_vfs_t;
 
 
@@ -467,6 +483,66 @@ ssize_t esp_vfs_pread(int fd, void *dst, size_t size, off_t offset);
  */
 ssize_t esp_vfs_pwrite(int fd, const void *src, size_t size, off_t offset);
 
+/**
+ *
+ * @brief Implements the VFS layer of POSIX readv()
+ *
+ * If the driver does not implement readv, small transfers are read with a single read call and
+ * scattered into the buffers, larger ones are read with one call per buffer.
+ *
+ * @param fd         File descriptor used for read
+ * @param iov        Array of buffers to fill, in order
+ * @param iovcnt     Number of buffers
+ *
+ * @return           A positive return value indicates the number of bytes read. -1 is return on failure and errno is
+ *                   set accordingly.
+ */
+ssize_t esp_vfs_readv(int fd, const struct iovec *iov, int iovcnt);
+
+/**
+ *
+ * @brief Implements the VFS layer of POSIX writev()
+ *
+ * If the driver does not implement writev, small transfers are gathered and written with a single
+ * write call, larger ones are written with one call per buffer.
+ *
+ * @param fd         File descriptor used for write
+ * @param iov        Array of buffers to write, in order
+ * @param iovcnt     Number of buffers
+ *
+ * @return           A positive return value indicates the number of bytes written. -1 is return on failure and errno is
+ *                   set accordingly.
+ */
+ssize_t esp_vfs_writev(int fd, const struct iovec *iov, int iovcnt);
+
+/**
+ *
+ * @brief Implements the VFS layer of POSIX preadv()
+ *
+ * @param fd         File descriptor used for read
+ * @param iov        Array of buffers to fill, in order
+ * @param iovcnt     Number of buffers
+ * @param offset     Starting offset of the read
+ *
+ * @return           A positive return value indicates the number of bytes read. -1 is return on failure and errno is
+ *                   set accordingly.
+ */
+ssize_t esp_vfs_preadv(int fd, const struct iovec *iov, int iovcnt, off_t offset);
+
+/**
+ *
+ * @brief Implements the VFS layer of POSIX pwritev()
+ *
+ * @param fd         File descriptor used for write
+ * @param iov        Array of buffers to write, in order
+ * @param iovcnt     Number of buffers
+ * @param offset     Starting offset of the write
+ *
+ * @return           A positive return value indicates the number of bytes written. -1 is return on failure and errno is
+ *                   set accordingly.
+ */
+ssize_t esp_vfs_pwritev(int fd, const struct iovec *iov, int iovcnt, off_t offset);
+
 /**
  *
  * @brief Dump the existing VFS FDs data to FILE* fp
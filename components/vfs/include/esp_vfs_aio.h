@@ -0,0 +1,121 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Operation of an asynchronous I/O request
+ */
+typedef enum {
+    ESP_VFS_AIO_READ,       /*!< read(), pread(), readv() or preadv() */
+    ESP_VFS_AIO_WRITE,      /*!< write(), pwrite(), writev() or pwritev() */
+    ESP_VFS_AIO_FSYNC,      /*!< fsync() */
+} esp_vfs_aio_op_t;
+
+typedef struct esp_vfs_aio_req esp_vfs_aio_req_t;
+
+/**
+ * @brief Completion callback, called from an AIO task
+ */
+typedef void (*esp_vfs_aio_cb_t)(esp_vfs_aio_req_t *req);
+
+/**
+ * @brief Asynchronous I/O request
+ *
+ * The request is owned by the caller and must stay valid until it completes.
+ */
+struct esp_vfs_aio_req {
+    int fd;                     /*!< File descriptor */
+    esp_vfs_aio_op_t op;        /*!< Operation */
+    void *buf;                  /*!< Buffer to read into or write from, unused if iov is set */
+    size_t size;                /*!< Size of buf */
+    const struct iovec *iov;    /*!< Buffers of a vectored transfer, or NULL */
+    int iovcnt;                 /*!< Number of buffers in iov */
+    off_t offset;               /*!< File offset, or -1 to use and advance the file position */
+    esp_vfs_aio_cb_t callback;  /*!< Called when the request completes, may be NULL */
+    void *arg;                  /*!< User argument, not used by the VFS */
+    int notify_fd;              /*!< eventfd incremented when the request completes, -1 if not used */
+    ssize_t result;             /*!< Set on completion: return value of the operation */
+    int error;                  /*!< Set on completion: errno if result is -1, 0 otherwise */
+};
+
+/**
+ * @brief Asynchronous I/O initialization settings
+ */
+typedef struct {
+    size_t queue_size;          /*!< Number of submitted requests waiting for a task */
+    size_t task_count;          /*!< Number of tasks executing requests. With more than one task,
+                                     requests may complete out of order */
+    int task_priority;          /*!< Priority of the tasks */
+    size_t task_stack_size;     /*!< Stack size of the tasks, must fit the file system drivers used */
+} esp_vfs_aio_config_t;
+
+#define ESP_VFS_AIO_CONFIG_DEFAULT() (esp_vfs_aio_config_t) { \
+    .queue_size = 8, \
+    .task_count = 1, \
+    .task_priority = 5, \
+    .task_stack_size = 4096, \
+}
+
+/**
+ * @brief  Start the tasks executing asynchronous I/O requests
+ *
+ * Requests are executed by calling the regular VFS functions from these tasks, so they work with
+ * any file descriptor and let the caller overlap slow I/O (e.g. FAT on SD card, UART) with computation.
+ *
+ * @param config  Settings, see ESP_VFS_AIO_CONFIG_DEFAULT()
+ *
+ * @return
+ *      - ESP_OK if successful
+ *      - ESP_ERR_INVALID_ARG if the settings are invalid
+ *      - ESP_ERR_INVALID_STATE if already initialized
+ *      - ESP_ERR_NO_MEM if the queue or the tasks could not be created
+ */
+esp_err_t esp_vfs_aio_init(const esp_vfs_aio_config_t *config);
+
+/**
+ * @brief  Stop the asynchronous I/O tasks, after the requests already submitted have completed
+ *
+ * Submissions made concurrently either fail with ESP_ERR_INVALID_STATE or are queued before the
+ * tasks stop, in which case they complete normally.
+ *
+ * @return
+ *      - ESP_OK if successful
+ *      - ESP_ERR_INVALID_STATE if not initialized
+ */
+esp_err_t esp_vfs_aio_deinit(void);
+
+/**
+ * @brief  Submit an asynchronous I/O request
+ *
+ * When the request completes, its result and error members are set, then the callback is called
+ * and the notify_fd eventfd is incremented. The request may be reused or freed from that point.
+ *
+ * @param req            The request
+ * @param ticks_to_wait  Time to wait for room in the submission queue
+ *
+ * @return
+ *      - ESP_OK if the request was queued
+ *      - ESP_ERR_INVALID_ARG if the request is invalid
+ *      - ESP_ERR_INVALID_STATE if asynchronous I/O is not initialized
+ *      - ESP_ERR_TIMEOUT if the submission queue stayed full
+ */
+esp_err_t esp_vfs_aio_submit(esp_vfs_aio_req_t *req, TickType_t ticks_to_wait);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2024-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -19,6 +19,7 @@
 #include <sys/time.h>
 #include <sys/termios.h>
 #include <sys/poll.h>
+#include <sys/uio.h>
 #ifdef __clang__ // TODO LLVM-330
 #include <sys/dirent.h>
 #else
@@ -270,6 +271,14 @@ typedef     int (*esp_vfs_ioctl_ctx_op_t)  (void *ctx, int fd, int cmd, va_list
 typedef     int (*esp_vfs_ioctl_op_t)      (           int fd, int cmd, va_list args);                      /*!< ioctl without context pointer */
 typedef     int (*esp_vfs_fsync_ctx_op_t)  (void *ctx, int fd);                                             /*!< fsync with context pointer */
 typedef     int (*esp_vfs_fsync_op_t)      (           int fd);                                             /*!< fsync without context pointer */
+typedef ssize_t (*esp_vfs_readv_ctx_op_t)  (void *ctx, int fd, const struct iovec *iov, int iovcnt);       /*!< readv with context pointer */
+typedef ssize_t (*esp_vfs_readv_op_t)      (           int fd, const struct iovec *iov, int iovcnt);       /*!< readv without context pointer */
+typedef ssize_t (*esp_vfs_writev_ctx_op_t) (void *ctx, int fd, const struct iovec *iov, int iovcnt);       /*!< writev with context pointer */
+typedef ssize_t (*esp_vfs_writev_op_t)     (           int fd, const struct iovec *iov, int iovcnt);       /*!< writev without context pointer */
+typedef ssize_t (*esp_vfs_preadv_ctx_op_t) (void *ctx, int fd, const struct iovec *iov, int iovcnt, off_t offset); /*!< preadv with context pointer */
+typedef ssize_t (*esp_vfs_preadv_op_t)     (           int fd, const struct iovec *iov, int iovcnt, off_t offset); /*!< preadv without context pointer */
+typedef ssize_t (*esp_vfs_pwritev_ctx_op_t)(void *ctx, int fd, const struct iovec *iov, int iovcnt, off_t offset); /*!< pwritev with context pointer */
+typedef ssize_t (*esp_vfs_pwritev_op_t)    (           int fd, const struct iovec *iov, int iovcnt, off_t offset); /*!< pwritev without context pointer */
 
 /**
  * @brief Main struct of the minified vfs API, containing basic function pointers as well as pointers to the other subcomponents.
@@ -321,6 +330,25 @@ typedef struct {
         const esp_vfs_fsync_op_t      fsync;    /*!< fsync without context pointer */
     };
 
+    /* Vectored I/O. These are optional: when a driver leaves them NULL, the VFS layer gathers small
+     * transfers into a single read/write (pread/pwrite) call, or issues one call per buffer */
+    union {
+        const esp_vfs_readv_ctx_op_t   readv_p;   /*!< readv with context pointer */
+        const esp_vfs_readv_op_t       readv;     /*!< readv without context pointer */
+    };
+    union {
+        const esp_vfs_writev_ctx_op_t  writev_p;  /*!< writev with context pointer */
+        const esp_vfs_writev_op_t      writev;    /*!< writev without context pointer */
+    };
+    union {
+        const esp_vfs_preadv_ctx_op_t  preadv_p;  /*!< preadv with context pointer */
+        const esp_vfs_preadv_op_t      preadv;    /*!< preadv without context pointer */
+    };
+    union {
+        const esp_vfs_pwritev_ctx_op_t pwritev_p; /*!< pwritev with context pointer */
+        const esp_vfs_pwritev_op_t     pwritev;   /*!< pwritev without context pointer */
+    };
+
 #ifdef CONFIG_VFS_SUPPORT_DIR
     const esp_vfs_dir_ops_t *const dir;         /*!< pointer to the dir subcomponent */
 #endif
@@ -0,0 +1,352 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/param.h>
+#include <sys/uio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "unity.h"
+#include "esp_timer.h"
+#include "esp_vfs.h"
+#include "esp_vfs_aio.h"
+#include "esp_vfs_eventfd.h"
+
+/* RAM backed single file, guarded by a mutex like a real file system driver */
+typedef struct {
+    SemaphoreHandle_t lock;
+    char data[4096];
+    size_t size;
+    size_t pos;
+    int write_calls;
+} ram_file_t;
+
+static int ram_open(void *ctx, const char *path, int flags, int mode)
+{
+    ram_file_t *f = ctx;
+    f->pos = 0;
+    if (flags & O_TRUNC) {
+        f->size = 0;
+    }
+    return 0;
+}
+
+static int ram_close(void *ctx, int fd)
+{
+    return 0;
+}
+
+static size_t ram_put(ram_file_t *f, size_t pos, const void *src, size_t size)
+{
+    if (pos >= sizeof(f->data)) {
+        /* Wrap around, the benchmark only cares about the call overhead */
+        pos = 0;
+    }
+    size = MIN(size, sizeof(f->data) - pos);
+    memcpy(f->data + pos, src, size);
+    f->size = MAX(f->size, pos + size);
+    return size;
+}
+
+static ssize_t ram_write(void *ctx, int fd, const void *src, size_t size)
+{
+    ram_file_t *f = ctx;
+    xSemaphoreTake(f->lock, portMAX_DELAY);
+    f->write_calls++;
+    size = ram_put(f, f->pos, src, size);
+    f->pos = (f->pos + size) % sizeof(f->data);
+    xSemaphoreGive(f->lock);
+    return size;
+}
+
+static ssize_t ram_pwrite(void *ctx, int fd, const void *src, size_t size, off_t offset)
+{
+    ram_file_t *f = ctx;
+    xSemaphoreTake(f->lock, portMAX_DELAY);
+    f->write_calls++;
+    size = ram_put(f, offset, src, size);
+    xSemaphoreGive(f->lock);
+    return size;
+}
+
+static ssize_t ram_writev(void *ctx, int fd, const struct iovec *iov, int iovcnt)
+{
+    ram_file_t *f = ctx;
+    ssize_t done = 0;
+    xSemaphoreTake(f->lock, portMAX_DELAY);
+    f->write_calls++;
+    for (int i = 0; i < iovcnt; i++) {
+        size_t size = ram_put(f, f->pos, iov[i].iov_base, iov[i].iov_len);
+        f->pos = (f->pos + size) % sizeof(f->data);
+        done += size;
+    }
+    xSemaphoreGive(f->lock);
+    return done;
+}
+
+static ssize_t ram_read(void *ctx, int fd, void *dst, size_t size)
+{
+    ram_file_t *f = ctx;
+    xSemaphoreTake(f->lock, portMAX_DELAY);
+    size = MIN(size, f->size - f->pos);
+    memcpy(dst, f->data + f->pos, size);
+    f->pos += size;
+    xSemaphoreGive(f->lock);
+    return size;
+}
+
+static ssize_t ram_pread(void *ctx, int fd, void *dst, size_t size, off_t offset)
+{
+    ram_file_t *f = ctx;
+    xSemaphoreTake(f->lock, portMAX_DELAY);
+    size = (size_t) offset < f->size ? MIN(size, f->size - offset) : 0;
+    memcpy(dst, f->data + offset, size);
+    xSemaphoreGive(f->lock);
+    return size;
+}
+
+static const esp_vfs_fs_ops_t s_ram_scalar_ops = {
+    .open_p = ram_open,
+    .close_p = ram_close,
+    .write_p = ram_write,
+    .pwrite_p = ram_pwrite,
+    .read_p = ram_read,
+    .pread_p = ram_pread,
+};
+
+static const esp_vfs_fs_ops_t s_ram_vector_ops = {
+    .open_p = ram_open,
+    .close_p = ram_close,
+    .write_p = ram_write,
+    .pwrite_p = ram_pwrite,
+    .read_p = ram_read,
+    .pread_p = ram_pread,
+    .writev_p = ram_writev,
+};
+
+static ram_file_t s_ram_file;
+
+static int ram_file_open(const esp_vfs_fs_ops_t *ops)
+{
+    memset(&s_ram_file, 0, sizeof(s_ram_file));
+    s_ram_file.lock = xSemaphoreCreateMutex();
+    TEST_ASSERT_NOT_NULL(s_ram_file.lock);
+    TEST_ESP_OK(esp_vfs_register_fs("/ram", ops, ESP_VFS_FLAG_CONTEXT_PTR | ESP_VFS_FLAG_STATIC, &s_ram_file));
+    int fd = open("/ram/log", O_RDWR | O_CREAT | O_TRUNC);
+    TEST_ASSERT_GREATER_OR_EQUAL(0, fd);
+    return fd;
+}
+
+static void ram_file_close(int fd)
+{
+    TEST_ASSERT_EQUAL(0, close(fd));
+    TEST_ESP_OK(esp_vfs_unregister_fs("/ram"));
+    vSemaphoreDelete(s_ram_file.lock);
+}
+
+TEST_CASE("writev and readv without driver support", "[vfs][iov]")
+{
+    int fd = ram_file_open(&s_ram_scalar_ops);
+
+    char a[] = "hello ", b[] = "vectored ", c[] = "world";
+    struct iovec wr[] = {
+        { .iov_base = a, .iov_len = strlen(a) },
+        { .iov_base = NULL, .iov_len = 0 },
+        { .iov_base = b, .iov_len = strlen(b) },
+        { .iov_base = c, .iov_len = strlen(c) },
+    };
+    TEST_ASSERT_EQUAL(20, writev(fd, wr, 4));
+    /* Small transfers are gathered into a single driver call */
+    TEST_ASSERT_EQUAL(1, s_ram_file.write_calls);
+
+    char x[8] = { 0 }, y[32] = { 0 };
+    struct iovec rd[] = {
+        { .iov_base = x, .iov_len = 6 },
+        { .iov_base = y, .iov_len = sizeof(y) },
+    };
+    TEST_ASSERT_EQUAL(20, preadv(fd, rd, 2, 0));
+    TEST_ASSERT_EQUAL_STRING("hello ", x);
+    TEST_ASSERT_EQUAL_STRING("vectored world", y);
+
+    /* Positional transfers do not touch the file position */
+    TEST_ASSERT_EQUAL(5, pwritev(fd, &wr[3], 1, 0));
+    memset(x, 0, sizeof(x));
+    TEST_ASSERT_EQUAL(6, esp_vfs_preadv(fd, rd, 1, 0));
+    TEST_ASSERT_EQUAL_STRING("world ", x);
+
+    TEST_ASSERT_EQUAL(-1, writev(fd, wr, -1));
+    TEST_ASSERT_EQUAL(EINVAL, errno);
+    TEST_ASSERT_EQUAL(-1, preadv(fd, rd, 1, -1));
+    TEST_ASSERT_EQUAL(EINVAL, errno);
+    ram_file_close(fd);
+}
+
+#define IOV_BENCH_RECORDS   2000
+
+/* Writes log-like records of three fields (timestamp, tag, message) and returns records/s */
+static int64_t iov_bench(int fd, bool vectored)
+{
+    char stamp[16], tag[] = " I (app): ", msg[] = "sensor value updated\n";
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < IOV_BENCH_RECORDS; i++) {
+        int len = snprintf(stamp, sizeof(stamp), "%08d", i);
+        if (vectored) {
+            struct iovec iov[] = {
+                { .iov_base = stamp, .iov_len = len },
+                { .iov_base = tag, .iov_len = sizeof(tag) - 1 },
+                { .iov_base = msg, .iov_len = sizeof(msg) - 1 },
+            };
+            TEST_ASSERT_EQUAL(len + sizeof(tag) - 1 + sizeof(msg) - 1, writev(fd, iov, 3));
+        } else {
+            TEST_ASSERT_EQUAL(len, write(fd, stamp, len));
+            TEST_ASSERT_EQUAL(sizeof(tag) - 1, write(fd, tag, sizeof(tag) - 1));
+            TEST_ASSERT_EQUAL(sizeof(msg) - 1, write(fd, msg, sizeof(msg) - 1));
+        }
+    }
+    return IOV_BENCH_RECORDS * 1000000LL / (esp_timer_get_time() - start);
+}
+
+TEST_CASE("small record writes per second with write and writev", "[vfs][iov]")
+{
+    int fd = ram_file_open(&s_ram_scalar_ops);
+    int64_t write_rate = iov_bench(fd, false);
+    TEST_ASSERT_EQUAL(3 * IOV_BENCH_RECORDS, s_ram_file.write_calls);
+    s_ram_file.write_calls = 0;
+    int64_t fallback_rate = iov_bench(fd, true);
+    TEST_ASSERT_EQUAL(IOV_BENCH_RECORDS, s_ram_file.write_calls);
+    ram_file_close(fd);
+
+    fd = ram_file_open(&s_ram_vector_ops);
+    int64_t writev_rate = iov_bench(fd, true);
+    TEST_ASSERT_EQUAL(IOV_BENCH_RECORDS, s_ram_file.write_calls);
+    ram_file_close(fd);
+
+    printf("records/s: write %" PRId64 ", writev (gathered by VFS) %" PRId64 ", writev (driver) %" PRId64 "\n",
+           write_rate, fallback_rate, writev_rate);
+}
+
+static void aio_test_callback(esp_vfs_aio_req_t *req)
+{
+    xSemaphoreGive((SemaphoreHandle_t) req->arg);
+}
+
+TEST_CASE("asynchronous write with callback and eventfd completion", "[vfs][iov]")
+{
+    esp_vfs_eventfd_config_t eventfd_config = ESP_VFS_EVENTD_CONFIG_DEFAULT();
+    TEST_ESP_OK(esp_vfs_eventfd_register(&eventfd_config));
+    esp_vfs_aio_config_t config = ESP_VFS_AIO_CONFIG_DEFAULT();
+    TEST_ESP_OK(esp_vfs_aio_init(&config));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, esp_vfs_aio_init(&config));
+    int fd = ram_file_open(&s_ram_vector_ops);
+
+    SemaphoreHandle_t done = xSemaphoreCreateBinary();
+    TEST_ASSERT_NOT_NULL(done);
+    char data[] = "asynchronous";
+    esp_vfs_aio_req_t req = {
+        .fd = fd,
+        .op = ESP_VFS_AIO_WRITE,
+        .buf = data,
+        .size = strlen(data),
+        .offset = -1,
+        .callback = aio_test_callback,
+        .arg = done,
+        .notify_fd = -1,
+    };
+    TEST_ESP_OK(esp_vfs_aio_submit(&req, portMAX_DELAY));
+    TEST_ASSERT_TRUE(xSemaphoreTake(done, pdMS_TO_TICKS(1000)));
+    TEST_ASSERT_EQUAL(strlen(data), req.result);
+    TEST_ASSERT_EQUAL(0, req.error);
+
+    int efd = eventfd(0, 0);
+    TEST_ASSERT_GREATER_OR_EQUAL(0, efd);
+    char out[16] = { 0 };
+    esp_vfs_aio_req_t read_req = {
+        .fd = fd,
+        .op = ESP_VFS_AIO_READ,
+        .buf = out,
+        .size = sizeof(out) - 1,
+        .offset = 0,
+        .notify_fd = efd,
+    };
+    TEST_ESP_OK(esp_vfs_aio_submit(&read_req, portMAX_DELAY));
+    uint64_t count = 0;
+    TEST_ASSERT_EQUAL(sizeof(count), read(efd, &count, sizeof(count)));
+    TEST_ASSERT_EQUAL(1, count);
+    TEST_ASSERT_EQUAL(strlen(data), read_req.result);
+    TEST_ASSERT_EQUAL_STRING(data, out);
+
+    TEST_ASSERT_EQUAL(0, close(efd));
+    vSemaphoreDelete(done);
+    ram_file_close(fd);
+    TEST_ESP_OK(esp_vfs_aio_deinit());
+    TEST_ESP_OK(esp_vfs_eventfd_unregister());
+}
+
+typedef struct {
+    int fd;
+    int completed;
+    bool lost;
+    SemaphoreHandle_t exited;
+} aio_submitter_ctx_t;
+
+static void aio_submitter_task(void *arg)
+{
+    aio_submitter_ctx_t *ctx = arg;
+    SemaphoreHandle_t done = xSemaphoreCreateBinary();
+    TEST_ASSERT_NOT_NULL(done);
+    esp_vfs_aio_req_t req = {
+        .fd = ctx->fd,
+        .op = ESP_VFS_AIO_FSYNC,
+        .offset = -1,
+        .callback = aio_test_callback,
+        .arg = done,
+        .notify_fd = -1,
+    };
+    /* Submit until the AIO tasks are stopped, every accepted request must still complete */
+    while (esp_vfs_aio_submit(&req, portMAX_DELAY) == ESP_OK) {
+        if (xSemaphoreTake(done, pdMS_TO_TICKS(1000)) != pdTRUE) {
+            ctx->lost = true;
+            break;
+        }
+        ctx->completed++;
+    }
+    vSemaphoreDelete(done);
+    xSemaphoreGive(ctx->exited);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("asynchronous I/O deinit with concurrent submitters", "[vfs][iov]")
+{
+    esp_vfs_aio_config_t config = ESP_VFS_AIO_CONFIG_DEFAULT();
+    int fd = ram_file_open(&s_ram_vector_ops);
+    aio_submitter_ctx_t ctx[2];
+    for (int round = 0; round < 10; round++) {
+        TEST_ESP_OK(esp_vfs_aio_init(&config));
+        for (int i = 0; i < 2; i++) {
+            ctx[i] = (aio_submitter_ctx_t) {
+                .fd = fd, .exited = xSemaphoreCreateBinary()
+            };
+            TEST_ASSERT_NOT_NULL(ctx[i].exited);
+            TEST_ASSERT_EQUAL(pdPASS, xTaskCreatePinnedToCore(aio_submitter_task, "aio_submit", 4096, &ctx[i],
+                                                              uxTaskPriorityGet(NULL), NULL, i % CONFIG_FREERTOS_NUMBER_OF_CORES));
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+        TEST_ESP_OK(esp_vfs_aio_deinit());
+        for (int i = 0; i < 2; i++) {
+            TEST_ASSERT_TRUE(xSemaphoreTake(ctx[i].exited, pdMS_TO_TICKS(2000)));
+            vSemaphoreDelete(ctx[i].exited);
+            TEST_ASSERT_FALSE(ctx[i].lost);
+            TEST_ASSERT_GREATER_THAN(0, ctx[i].completed);
+        }
+    }
+    ram_file_close(fd);
+}
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2023 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -8,8 +8,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <inttypes.h>
 #include <errno.h>
 #include <sys/fcntl.h>
+#include <sys/stat.h>
 #ifdef __clang__ // TODO LLVM-330
 #include <sys/dirent.h>
 #else
@@ -18,6 +20,10 @@
 #include "esp_vfs.h"
 #include "unity.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 
 /* Dummy VFS implementation to check if VFS is called or not with expected path
  */
@@ -277,3 +283,96 @@ TEST_CASE("vfs checks mount point path", "[vfs]")
     test_register_ok("/23456789012345");
     test_register_fail("/234567890123456");
 }
+
+#define PATH_LOOKUP_ITERATIONS  10000
+
+TEST_CASE("vfs path lookup time with 2 to 16 mount points", "[vfs]")
+{
+    static dummy_vfs_t inst[16];
+    static char prefixes[16][16];
+    esp_vfs_t desc = DUMMY_VFS();
+    char path[48];
+    struct stat st;
+
+    int mounted = 0;
+    for (int mounts = 2; mounts <= 16; mounts *= 2) {
+        for (; mounted < mounts; mounted++) {
+            snprintf(prefixes[mounted], sizeof(prefixes[mounted]), "/mount%02d", mounted);
+            inst[mounted].match_path = "/dir/file.txt";
+            TEST_ESP_OK( esp_vfs_register(prefixes[mounted], &desc, &inst[mounted]) );
+        }
+        /* Files under the last mount point are not dispatched to the first one */
+        snprintf(path, sizeof(path), "%s/dir/file.txt", prefixes[mounts - 1]);
+        test_opened(&inst[mounts - 1], path);
+        test_not_called(&inst[0], path);
+
+        /* The dummy VFS has no stat, so this only measures resolving the path to a mount point */
+        int64_t start = esp_timer_get_time();
+        for (int i = 0; i < PATH_LOOKUP_ITERATIONS; i++) {
+            snprintf(path, sizeof(path), "%s/dir/file.txt", prefixes[i % mounts]);
+            stat(path, &st);
+        }
+        int64_t lookup_us = esp_timer_get_time() - start;
+        start = esp_timer_get_time();
+        for (int i = 0; i < PATH_LOOKUP_ITERATIONS; i++) {
+            snprintf(path, sizeof(path), "%s/dir/file.txt", prefixes[i % mounts]);
+        }
+        lookup_us -= esp_timer_get_time() - start;
+        printf("%d mount points: %" PRId64 " ns per path lookup\n", mounts, lookup_us * 1000 / PATH_LOOKUP_ITERATIONS);
+    }
+
+    for (int i = 0; i < mounted; i++) {
+        TEST_ESP_OK( esp_vfs_unregister(prefixes[i]) );
+    }
+}
+
+typedef struct {
+    volatile bool stop;
+    int lookups;
+    int failures;
+    SemaphoreHandle_t done;
+} lookup_task_ctx_t;
+
+static void lookup_task(void* arg)
+{
+    lookup_task_ctx_t* ctx = (lookup_task_ctx_t*) arg;
+    while (!ctx->stop) {
+        int fd = esp_vfs_open(__getreent(), "/stable/dir/file.txt", O_RDONLY, 0);
+        if (fd < 0) {
+            ctx->failures++;
+        } else {
+            esp_vfs_close(__getreent(), fd);
+        }
+        ctx->lookups++;
+    }
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("vfs path lookups stay valid while mount points change", "[vfs]")
+{
+    static dummy_vfs_t stable = { .match_path = "/dir/file.txt" };
+    static dummy_vfs_t churn = { .match_path = "/dir/file.txt" };
+    esp_vfs_t desc = DUMMY_VFS();
+    TEST_ESP_OK( esp_vfs_register("/stable", &desc, &stable) );
+
+    lookup_task_ctx_t ctx = { .done = xSemaphoreCreateBinary() };
+    TEST_ASSERT_NOT_NULL(ctx.done);
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreatePinnedToCore(lookup_task, "lookup", 4096, &ctx, uxTaskPriorityGet(NULL),
+                                                      NULL, CONFIG_FREERTOS_NUMBER_OF_CORES - 1));
+    /* Each change rebuilds the table the lookups are not walking, and unregistering frees the entry */
+    for (int i = 0; i < 500; i++) {
+        TEST_ESP_OK( esp_vfs_register("/churn", &desc, &churn) );
+        TEST_ESP_OK( esp_vfs_unregister("/churn") );
+        if (i % 50 == 0) {
+            vTaskDelay(1);
+        }
+    }
+    ctx.stop = true;
+    TEST_ASSERT(xSemaphoreTake(ctx.done, pdMS_TO_TICKS(1000)));
+    vSemaphoreDelete(ctx.done);
+    printf("%d lookups during mount point changes\n", ctx.lookups);
+    TEST_ASSERT_GREATER_THAN(0, ctx.lookups);
+    TEST_ASSERT_EQUAL(0, ctx.failures);
+    TEST_ESP_OK( esp_vfs_unregister("/stable") );
+}
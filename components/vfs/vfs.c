@@ -6,17 +6,21 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <assert.h>
+#include <stdatomic.h>
 #include <sys/errno.h>
 #include <sys/fcntl.h>
 #include <sys/ioctl.h>
 #include <sys/reent.h>
 #include <sys/unistd.h>
 #include <sys/lock.h>
+#include <sys/uio.h>
 #include <sys/param.h>
 #include <dirent.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/task.h"
 #include "esp_vfs.h"
 #include "esp_vfs_private.h"
 #include "include/esp_vfs.h"
@@ -73,6 +77,22 @@ typedef struct {
 static vfs_entry_t* s_vfs[VFS_MAX_COUNT] = { 0 };
 static size_t s_vfs_count = 0;
 
+/* Path based entries of s_vfs sorted by decreasing prefix length, so that the first prefix matching
+ * a path is the longest one. Two tables are kept: the table not in use is rebuilt when a VFS is
+ * registered or unregistered and then published. Lookups count themselves as readers of the table
+ * they walk, and after publishing, the writer waits for the readers of the previous table to leave.
+ * Only then may that table be rebuilt or an entry dropped from it be freed.
+ */
+typedef struct {
+    const vfs_entry_t* entries[VFS_MAX_COUNT];
+    size_t count;
+    atomic_uint readers;    // lookups walking this table
+} vfs_prefix_table_t;
+
+static vfs_prefix_table_t s_vfs_prefix_tables[2];
+static _Atomic(vfs_prefix_table_t*) s_vfs_prefix_table = &s_vfs_prefix_tables[0];
+static _lock_t s_vfs_prefix_table_lock;
+
 static fd_table_t s_fd_table[MAX_FDS] = { [0 ... MAX_FDS-1] = FD_TABLE_ENTRY_UNUSED };
 static _lock_t s_fd_table_lock;
 
@@ -85,6 +105,35 @@ static ssize_t esp_get_free_index(void) {
     return -1;
 }
 
+static void esp_vfs_update_prefix_table(void)
+{
+    _lock_acquire(&s_vfs_prefix_table_lock);
+    vfs_prefix_table_t *current = atomic_load_explicit(&s_vfs_prefix_table, memory_order_relaxed);
+    vfs_prefix_table_t *table = (current == &s_vfs_prefix_tables[0]) ? &s_vfs_prefix_tables[1] : &s_vfs_prefix_tables[0];
+    size_t count = 0;
+    for (size_t i = 0; i < s_vfs_count; ++i) {
+        const vfs_entry_t *vfs = s_vfs[i];
+        if (vfs == NULL || vfs->path_prefix_len == LEN_PATH_PREFIX_IGNORED) {
+            continue;
+        }
+        // insertion sort, entries with the same prefix length stay in index order
+        size_t pos = count++;
+        while (pos > 0 && table->entries[pos - 1]->path_prefix_len < vfs->path_prefix_len) {
+            table->entries[pos] = table->entries[pos - 1];
+            pos--;
+        }
+        table->entries[pos] = vfs;
+    }
+    table->count = count;
+    atomic_store(&s_vfs_prefix_table, table);
+    // Lookups that started before the store may still walk the previous table.
+    // They only compare a few prefixes, so wait for them by yielding
+    while (atomic_load(&current->readers) != 0) {
+        vTaskDelay(1);
+    }
+    _lock_release(&s_vfs_prefix_table_lock);
+}
+
 static void esp_vfs_free_fs_ops(esp_vfs_fs_ops_t *vfs) {
 // We can afford to cast away the const qualifier here, because we know that we allocated the struct and therefore its safe
 #ifdef CONFIG_VFS_SUPPORT_TERMIOS
@@ -212,6 +261,10 @@ static esp_vfs_fs_ops_t *esp_minify_vfs(const esp_vfs_t * const vfs, vfs_compone
         .fcntl = vfs->fcntl,
         .ioctl = vfs->ioctl,
         .fsync = vfs->fsync,
+        .readv = vfs->readv,
+        .writev = vfs->writev,
+        .preadv = vfs->preadv,
+        .pwritev = vfs->pwritev,
 #ifdef CONFIG_VFS_SUPPORT_DIR
         .dir = proxy.dir,
 #endif
@@ -281,6 +334,10 @@ static esp_vfs_fs_ops_t* esp_vfs_duplicate_fs_ops(const esp_vfs_fs_ops_t *orig)
         .fcntl = orig->fcntl,
         .ioctl = orig->ioctl,
         .fsync = orig->fsync,
+        .readv = orig->readv,
+        .writev = orig->writev,
+        .preadv = orig->preadv,
+        .pwritev = orig->pwritev,
 #ifdef CONFIG_VFS_SUPPORT_DIR
         .dir = proxy.dir,
 #endif
@@ -458,6 +515,7 @@ static esp_err_t esp_vfs_register_fs_common(
     entry->flags = flags;
 
     memcpy((char *)(entry->path_prefix), _base_path, base_path_len + 1);
+    esp_vfs_update_prefix_table();
 
     if (vfs_index) {
         *vfs_index = index;
@@ -607,8 +665,10 @@ esp_err_t esp_vfs_unregister_with_id(esp_vfs_id_t vfs_id)
         return ESP_ERR_INVALID_ARG;
     }
     vfs_entry_t* vfs = s_vfs[vfs_id];
-    esp_vfs_free_entry(vfs);
     s_vfs[vfs_id] = NULL;
+    // drop the entry from path lookups, once this returns no lookup can return it anymore
+    esp_vfs_update_prefix_table();
+    esp_vfs_free_entry(vfs);
 
     _lock_acquire(&s_fd_table_lock);
     // Delete all references from the FD lookup-table
@@ -799,51 +859,53 @@ static inline int get_local_fd(const vfs_entry_t *vfs, int fd)
 static const char* translate_path(const vfs_entry_t* vfs, const char* src_path)
 {
     assert(strncmp(src_path, vfs->path_prefix, vfs->path_prefix_len) == 0);
-    if (strlen(src_path) == vfs->path_prefix_len) {
+    if (src_path[vfs->path_prefix_len] == '\0') {
         // special case when src_path matches the path prefix exactly
         return "/";
     }
     return src_path + vfs->path_prefix_len;
 }
 
+static vfs_prefix_table_t* prefix_table_enter(void)
+{
+    while (true) {
+        vfs_prefix_table_t* table = atomic_load(&s_vfs_prefix_table);
+        atomic_fetch_add(&table->readers, 1);
+        // if the table was replaced meanwhile, the writer may be rebuilding it
+        if (atomic_load(&s_vfs_prefix_table) == table) {
+            return table;
+        }
+        atomic_fetch_sub(&table->readers, 1);
+    }
+}
+
 const vfs_entry_t* get_vfs_for_path(const char* path)
 {
-    const vfs_entry_t* best_match = NULL;
-    ssize_t best_match_prefix_len = -1;
+    vfs_prefix_table_t* table = prefix_table_enter();
+    const vfs_entry_t* found = NULL;
     size_t len = strlen(path);
-    for (size_t i = 0; i < s_vfs_count; ++i) {
-        const vfs_entry_t* vfs = s_vfs[i];
-        if (vfs == NULL || vfs->path_prefix_len == LEN_PATH_PREFIX_IGNORED) {
-            continue;
-        }
-        // match path prefix
-        if (len < vfs->path_prefix_len ||
-            memcmp(path, vfs->path_prefix, vfs->path_prefix_len) != 0) {
-            continue;
-        }
-        // this is the default VFS and we don't have a better match yet.
-        if (vfs->path_prefix_len == 0 && !best_match) {
-            best_match = vfs;
+    // Entries are sorted by decreasing prefix length, so the first match is the longest one;
+    // i.e. if "/dev" and "/dev/uart" both match, for "/dev/uart/1" path, choose "/dev/uart".
+    // The default VFS (empty prefix) comes last and matches any path.
+    for (size_t i = 0; i < table->count; ++i) {
+        const vfs_entry_t* vfs = table->entries[i];
+        const size_t prefix_len = vfs->path_prefix_len;
+        if (prefix_len > len) {
             continue;
         }
         // if path is not equal to the prefix, expect to see a path separator
-        // i.e. don't match "/data" prefix for "/data1/foo.txt" path
-        if (len > vfs->path_prefix_len &&
-                path[vfs->path_prefix_len] != '/') {
+        // i.e. don't match "/data" prefix for "/data1/foo.txt" path.
+        // Checked first, as it rejects most candidates without comparing the prefix
+        if (prefix_len != 0 && len > prefix_len && path[prefix_len] != '/') {
             continue;
         }
-        // Out of all matching path prefixes, select the longest one;
-        // i.e. if "/dev" and "/dev/uart" both match, for "/dev/uart/1" path,
-        // choose "/dev/uart",
-        // This causes all s_vfs_count VFS entries to be scanned when opening
-        // a file by name. This can be optimized by introducing a table for
-        // FS search order, sorted so that longer prefixes are checked first.
-        if (best_match_prefix_len < (ssize_t) vfs->path_prefix_len) {
-            best_match_prefix_len = (ssize_t) vfs->path_prefix_len;
-            best_match = vfs;
+        if (memcmp(path, vfs->path_prefix, prefix_len) == 0) {
+            found = vfs;
+            break;
         }
     }
-    return best_match;
+    atomic_fetch_sub(&table->readers, 1);
+    return found;
 }
 
 /*
@@ -1037,6 +1099,156 @@ ssize_t esp_vfs_pwrite(int fd, const void *src, size_t size, off_t offset)
     return ret;
 }
 
+/* Vectored transfers up to this size are gathered into a single call of drivers without vectored I/O */
+#define VFS_IOV_GATHER_SIZE 128
+
+#ifdef IOV_MAX
+#define VFS_IOV_MAX IOV_MAX
+#else
+#define VFS_IOV_MAX 1024
+#endif
+
+static ssize_t esp_vfs_iov_transfer(const vfs_entry_t *vfs, int local_fd, void *buf, size_t size, bool write, off_t offset)
+{
+    const esp_vfs_fs_ops_t *ops = vfs->vfs;
+    const bool ctx = vfs->flags & ESP_VFS_FLAG_CONTEXT_PTR;
+    if (write) {
+        if (offset < 0) {
+            return ctx ? ops->write_p(vfs->ctx, local_fd, buf, size) : ops->write(local_fd, buf, size);
+        }
+        return ctx ? ops->pwrite_p(vfs->ctx, local_fd, buf, size, offset) : ops->pwrite(local_fd, buf, size, offset);
+    }
+    if (offset < 0) {
+        return ctx ? ops->read_p(vfs->ctx, local_fd, buf, size) : ops->read(local_fd, buf, size);
+    }
+    return ctx ? ops->pread_p(vfs->ctx, local_fd, buf, size, offset) : ops->pread(local_fd, buf, size, offset);
+}
+
+/*
+ * Emulates readv/writev (offset < 0) or preadv/pwritev for drivers which only implement the scalar
+ * functions. Small transfers are gathered into one call, so that the driver (and its lock) is only
+ * entered once, larger ones are split into one call per buffer and stop at the first short transfer.
+ */
+static ssize_t esp_vfs_iov_fallback(struct _reent *r, const vfs_entry_t *vfs, int local_fd,
+                                    const struct iovec *iov, int iovcnt, size_t total, bool write, off_t offset)
+{
+    const esp_vfs_fs_ops_t *ops = vfs->vfs;
+    bool supported;
+    if (write) {
+        supported = (offset < 0) ? ops->write != NULL : ops->pwrite != NULL;
+    } else {
+        supported = (offset < 0) ? ops->read != NULL : ops->pread != NULL;
+    }
+    if (!supported) {
+        __errno_r(r) = ENOSYS;
+        return -1;
+    }
+
+    if (total <= VFS_IOV_GATHER_SIZE) {
+        char buf[VFS_IOV_GATHER_SIZE];
+        size_t pos = 0;
+        if (write) {
+            for (int i = 0; i < iovcnt; i++) {
+                memcpy(buf + pos, iov[i].iov_base, iov[i].iov_len);
+                pos += iov[i].iov_len;
+            }
+            return esp_vfs_iov_transfer(vfs, local_fd, buf, total, true, offset);
+        }
+        ssize_t ret = esp_vfs_iov_transfer(vfs, local_fd, buf, total, false, offset);
+        for (int i = 0; i < iovcnt && ret > 0 && pos < (size_t) ret; i++) {
+            size_t len = MIN(iov[i].iov_len, (size_t) ret - pos);
+            memcpy(iov[i].iov_base, buf + pos, len);
+            pos += len;
+        }
+        return ret;
+    }
+
+    ssize_t done = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].iov_len == 0) {
+            continue;
+        }
+        ssize_t ret = esp_vfs_iov_transfer(vfs, local_fd, iov[i].iov_base, iov[i].iov_len, write,
+                                           offset < 0 ? offset : offset + done);
+        if (ret < 0) {
+            // report the data already transferred, the error will be seen by the next call
+            return done > 0 ? done : -1;
+        }
+        done += ret;
+        if ((size_t) ret < iov[i].iov_len) {
+            break;
+        }
+    }
+    return done;
+}
+
+static ssize_t esp_vfs_iov_common(int fd, const struct iovec *iov, int iovcnt, bool write, off_t offset)
+{
+    [[maybe_unused]] struct _reent *r = __getreent();
+    const vfs_entry_t* vfs = get_vfs_for_fd(fd);
+    const int local_fd = get_local_fd(vfs, fd);
+    if (vfs == NULL || local_fd < 0) {
+        __errno_r(r) = EBADF;
+        return -1;
+    }
+    if (iovcnt < 0 || iovcnt > VFS_IOV_MAX || (iovcnt > 0 && iov == NULL)) {
+        __errno_r(r) = EINVAL;
+        return -1;
+    }
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].iov_len > SSIZE_MAX - total) {
+            __errno_r(r) = EINVAL;
+            return -1;
+        }
+        total += iov[i].iov_len;
+    }
+
+    const esp_vfs_fs_ops_t *ops = vfs->vfs;
+    const bool ctx = vfs->flags & ESP_VFS_FLAG_CONTEXT_PTR;
+    if (write && offset < 0 && ops->writev != NULL) {
+        return ctx ? ops->writev_p(vfs->ctx, local_fd, iov, iovcnt) : ops->writev(local_fd, iov, iovcnt);
+    }
+    if (!write && offset < 0 && ops->readv != NULL) {
+        return ctx ? ops->readv_p(vfs->ctx, local_fd, iov, iovcnt) : ops->readv(local_fd, iov, iovcnt);
+    }
+    if (write && offset >= 0 && ops->pwritev != NULL) {
+        return ctx ? ops->pwritev_p(vfs->ctx, local_fd, iov, iovcnt, offset) : ops->pwritev(local_fd, iov, iovcnt, offset);
+    }
+    if (!write && offset >= 0 && ops->preadv != NULL) {
+        return ctx ? ops->preadv_p(vfs->ctx, local_fd, iov, iovcnt, offset) : ops->preadv(local_fd, iov, iovcnt, offset);
+    }
+    return esp_vfs_iov_fallback(r, vfs, local_fd, iov, iovcnt, total, write, offset);
+}
+
+ssize_t esp_vfs_readv(int fd, const struct iovec *iov, int iovcnt)
+{
+    return esp_vfs_iov_common(fd, iov, iovcnt, false, -1);
+}
+
+ssize_t esp_vfs_writev(int fd, const struct iovec *iov, int iovcnt)
+{
+    return esp_vfs_iov_common(fd, iov, iovcnt, true, -1);
+}
+
+ssize_t esp_vfs_preadv(int fd, const struct iovec *iov, int iovcnt, off_t offset)
+{
+    if (offset < 0) {
+        __errno_r(__getreent()) = EINVAL;
+        return -1;
+    }
+    return esp_vfs_iov_common(fd, iov, iovcnt, false, offset);
+}
+
+ssize_t esp_vfs_pwritev(int fd, const struct iovec *iov, int iovcnt, off_t offset)
+{
+    if (offset < 0) {
+        __errno_r(__getreent()) = EINVAL;
+        return -1;
+    }
+    return esp_vfs_iov_common(fd, iov, iovcnt, true, offset);
+}
+
 int esp_vfs_close(struct _reent *r, int fd)
 {
     const vfs_entry_t* vfs = get_vfs_for_fd(fd);
@@ -1852,6 +2064,15 @@ ssize_t pread(int fd, void *dst, size_t size, off_t offset)
     __attribute__((alias("esp_vfs_pread")));
 ssize_t pwrite(int fd, const void *src, size_t size, off_t offset)
     __attribute__((alias("esp_vfs_pwrite")));
+ssize_t preadv(int fd, const struct iovec *iov, int iovcnt, off_t offset)
+    __attribute__((alias("esp_vfs_preadv")));
+ssize_t pwritev(int fd, const struct iovec *iov, int iovcnt, off_t offset)
+    __attribute__((alias("esp_vfs_pwritev")));
+/* readv() and writev() on sockets reach lwip_readv() and lwip_writev() through the lwIP VFS */
+ssize_t readv(int fd, const struct iovec *iov, int iovcnt)
+    __attribute__((alias("esp_vfs_readv")));
+ssize_t writev(int fd, const struct iovec *iov, int iovcnt)
+    __attribute__((alias("esp_vfs_writev")));
 off_t _lseek_r(struct _reent *r, int fd, off_t size, int mode)
     __attribute__((alias("esp_vfs_lseek")));
 int _fcntl_r(struct _reent *r, int fd, int cmd, int arg)
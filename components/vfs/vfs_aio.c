@@ -0,0 +1,181 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_vfs.h"
+#include "esp_vfs_aio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "vfs_aio";
+
+typedef struct {
+    QueueHandle_t       queue;      // esp_vfs_aio_req_t pointers, NULL stops a task
+    SemaphoreHandle_t   stopped;    // given by each task when it exits
+    size_t              task_count;
+} vfs_aio_context_t;
+
+static _Atomic(vfs_aio_context_t *) s_aio;
+// number of esp_vfs_aio_submit() calls in progress, deinit waits for them before freeing the context
+static atomic_uint s_aio_submitters;
+
+static ssize_t vfs_aio_execute(esp_vfs_aio_req_t *req)
+{
+    const bool positional = req->offset >= 0;
+    switch (req->op) {
+    case ESP_VFS_AIO_READ:
+        if (req->iov) {
+            return positional ? esp_vfs_preadv(req->fd, req->iov, req->iovcnt, req->offset)
+                              : esp_vfs_readv(req->fd, req->iov, req->iovcnt);
+        }
+        return positional ? pread(req->fd, req->buf, req->size, req->offset)
+                          : read(req->fd, req->buf, req->size);
+    case ESP_VFS_AIO_WRITE:
+        if (req->iov) {
+            return positional ? esp_vfs_pwritev(req->fd, req->iov, req->iovcnt, req->offset)
+                              : esp_vfs_writev(req->fd, req->iov, req->iovcnt);
+        }
+        return positional ? pwrite(req->fd, req->buf, req->size, req->offset)
+                          : write(req->fd, req->buf, req->size);
+    case ESP_VFS_AIO_FSYNC:
+        return fsync(req->fd);
+    default:
+        errno = EINVAL;
+        return -1;
+    }
+}
+
+static void vfs_aio_task(void *arg)
+{
+    vfs_aio_context_t *aio = arg;
+    esp_vfs_aio_req_t *req;
+    while (xQueueReceive(aio->queue, &req, portMAX_DELAY) == pdTRUE && req != NULL) {
+        errno = 0;
+        ssize_t result = vfs_aio_execute(req);
+        req->error = result < 0 ? errno : 0;
+        req->result = result;
+
+        // the request may be released by the callback or as soon as the eventfd is signaled
+        const int notify_fd = req->notify_fd;
+        if (req->callback) {
+            req->callback(req);
+        }
+        if (notify_fd >= 0) {
+            const uint64_t one = 1;
+            write(notify_fd, &one, sizeof(one));
+        }
+    }
+    xSemaphoreGive(aio->stopped);
+    vTaskDelete(NULL);
+}
+
+static void vfs_aio_free(vfs_aio_context_t *aio)
+{
+    if (aio->queue) {
+        vQueueDelete(aio->queue);
+    }
+    if (aio->stopped) {
+        vSemaphoreDelete(aio->stopped);
+    }
+    free(aio);
+}
+
+static void vfs_aio_stop_tasks(vfs_aio_context_t *aio)
+{
+    esp_vfs_aio_req_t *stop = NULL;
+    for (size_t i = 0; i < aio->task_count; i++) {
+        xQueueSend(aio->queue, &stop, portMAX_DELAY);
+    }
+    for (size_t i = 0; i < aio->task_count; i++) {
+        xSemaphoreTake(aio->stopped, portMAX_DELAY);
+    }
+}
+
+esp_err_t esp_vfs_aio_init(const esp_vfs_aio_config_t *config)
+{
+    if (config == NULL || config->queue_size == 0 || config->task_count == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (atomic_load(&s_aio) != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    vfs_aio_context_t *aio = calloc(1, sizeof(vfs_aio_context_t));
+    if (aio == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    aio->queue = xQueueCreate(config->queue_size, sizeof(esp_vfs_aio_req_t *));
+    aio->stopped = xSemaphoreCreateCounting(config->task_count, 0);
+    if (aio->queue == NULL || aio->stopped == NULL) {
+        vfs_aio_free(aio);
+        return ESP_ERR_NO_MEM;
+    }
+    for (size_t i = 0; i < config->task_count; i++) {
+        if (xTaskCreate(vfs_aio_task, "vfs_aio", config->task_stack_size, aio, config->task_priority, NULL) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create AIO task");
+            vfs_aio_stop_tasks(aio);
+            vfs_aio_free(aio);
+            return ESP_ERR_NO_MEM;
+        }
+        aio->task_count++;
+    }
+    vfs_aio_context_t *expected = NULL;
+    if (!atomic_compare_exchange_strong(&s_aio, &expected, aio)) {
+        // initialized concurrently
+        vfs_aio_stop_tasks(aio);
+        vfs_aio_free(aio);
+        return ESP_ERR_INVALID_STATE;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_vfs_aio_deinit(void)
+{
+    vfs_aio_context_t *aio = atomic_exchange(&s_aio, NULL);
+    if (aio == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // Submitters that loaded the context before the exchange may still be queueing requests.
+    // The tasks keep draining the queue, so even those blocked on a full queue finish
+    while (atomic_load(&s_aio_submitters) != 0) {
+        vTaskDelay(1);
+    }
+    // the stop requests are queued after the pending ones, which are executed first
+    vfs_aio_stop_tasks(aio);
+    vfs_aio_free(aio);
+    return ESP_OK;
+}
+
+esp_err_t esp_vfs_aio_submit(esp_vfs_aio_req_t *req, TickType_t ticks_to_wait)
+{
+    if (req == NULL || (req->iov == NULL && req->buf == NULL && req->op != ESP_VFS_AIO_FSYNC)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    atomic_fetch_add(&s_aio_submitters, 1);
+    vfs_aio_context_t *aio = atomic_load(&s_aio);
+    esp_err_t ret = ESP_OK;
+    if (aio == NULL) {
+        ret = ESP_ERR_INVALID_STATE;
+    } else {
+        req->result = -1;
+        req->error = EINPROGRESS;
+        if (xQueueSend(aio->queue, &req, ticks_to_wait) != pdTRUE) {
+            ret = ESP_ERR_TIMEOUT;
+        }
+    }
+    atomic_fetch_sub(&s_aio_submitters, 1);
+    return ret;
+}
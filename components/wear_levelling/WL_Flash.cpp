@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2024 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -13,6 +13,7 @@
 #include <string.h>
 #include <stddef.h>
 #include <inttypes.h>
+#include <sys/param.h>
 
 static const char *TAG = "wl_flash";
 #ifndef WL_CFG_CRC_CONST
@@ -36,6 +37,7 @@ WL_Flash::WL_Flash()
 
 WL_Flash::~WL_Flash()
 {
+    free(this->page_buff);
     free(this->temp_buff);
 }
 
@@ -106,6 +108,8 @@ esp_err_t WL_Flash::config(wl_config_t *cfg, Partition *partition)
         result = ESP_ERR_NO_MEM;
     }
     WL_RESULT_CHECK(result);
+    // Used to move the dummy page in one go, copyPage() falls back to temp_buff if there is no memory for it
+    this->page_buff = (uint8_t *)malloc(this->cfg.wl_page_size);
     this->configured = true;
     return ESP_OK;
 }
@@ -422,6 +426,31 @@ bool WL_Flash::OkBuffSet(int n)
 }
 
 
+esp_err_t WL_Flash::copyPage(size_t src_addr, size_t dest_addr)
+{
+    esp_err_t result = ESP_OK;
+    // Copy the page in one go if there is memory for it, otherwise through temp_buff
+    size_t chunk_size = this->cfg.wl_page_size;
+    uint8_t *copy_buff = this->page_buff;
+    if (copy_buff == NULL) {
+        chunk_size = this->cfg.wl_temp_buff_size;
+        copy_buff = this->temp_buff;
+    }
+    for (size_t offset = 0; offset < this->cfg.wl_page_size; offset += chunk_size) {
+        result = this->partition->read(src_addr + offset, copy_buff, chunk_size);
+        if (result != ESP_OK) {
+            ESP_LOGE(TAG, "%s - not possible to read buffer, will try next time, result= 0x%08x" , __func__, result);
+            break;
+        }
+        result = this->partition->write(dest_addr + offset, copy_buff, chunk_size);
+        if (result != ESP_OK) {
+            ESP_LOGE(TAG, "%s - not possible to write buffer, will try next time, result= 0x%08x" , __func__, result);
+            break;
+        }
+    }
+    return result;
+}
+
 esp_err_t WL_Flash::updateWL()
 {
     esp_err_t result = ESP_OK;
@@ -446,20 +475,10 @@ esp_err_t WL_Flash::updateWL()
         return result;
     }
 
-    size_t copy_count = this->cfg.wl_page_size / this->cfg.wl_temp_buff_size;
-    for (size_t i = 0; i < copy_count; i++) {
-        result = this->partition->read(data_addr + i * this->cfg.wl_temp_buff_size, this->temp_buff, this->cfg.wl_temp_buff_size);
-        if (result != ESP_OK) {
-            ESP_LOGE(TAG, "%s - not possible to read buffer, will try next time, result= 0x%08x" , __func__, result);
-            this->state.wl_sec_erase_cycle_count = this->state.wl_max_sec_erase_cycle_count - 1; // we will update next time
-            return result;
-        }
-        result = this->partition->write(this->dummy_addr + i * this->cfg.wl_temp_buff_size, this->temp_buff, this->cfg.wl_temp_buff_size);
-        if (result != ESP_OK) {
-            ESP_LOGE(TAG, "%s - not possible to write buffer, will try next time, result= 0x%08x" , __func__, result);
-            this->state.wl_sec_erase_cycle_count = this->state.wl_max_sec_erase_cycle_count - 1; // we will update next time
-            return result;
-        }
+    result = this->copyPage(data_addr, this->dummy_addr);
+    if (result != ESP_OK) {
+        this->state.wl_sec_erase_cycle_count = this->state.wl_max_sec_erase_cycle_count - 1; // we will update next time
+        return result;
     }
     // done... block moved.
     // Here we will update structures...
@@ -523,6 +542,20 @@ size_t WL_Flash::calcAddr(size_t addr)
     return result;
 }
 
+size_t WL_Flash::calcRun(size_t addr, size_t size, size_t *out_addr)
+{
+    size_t result = (this->flash_size - this->state.wl_dummy_sec_move_count * this->cfg.wl_page_size + addr) % this->flash_size;
+    size_t dummy_addr = this->state.wl_dummy_sec_pos * this->cfg.wl_page_size;
+    // The mapping is linear up to the end of the data area, and up to the dummy page if it is ahead
+    size_t run = this->flash_size - result;
+    if (result < dummy_addr) {
+        run = MIN(run, dummy_addr - result);
+    } else {
+        result += this->cfg.wl_page_size;
+    }
+    *out_addr = this->cfg.wl_partition_start_addr + result;
+    return MIN(size, run);
+}
 
 size_t WL_Flash::get_flash_size()
 {
@@ -563,10 +596,31 @@ esp_err_t WL_Flash::erase_range(size_t start_address, size_t size)
     }
     ESP_LOGD(TAG, "%s - start_address= 0x%08" PRIx32 ", size= 0x%08" PRIx32 , __func__, (uint32_t) start_address, (uint32_t) size);
     size_t erase_count = (size + this->cfg.flash_sector_size - 1) / this->cfg.flash_sector_size;
-    size_t start_sector = start_address / this->cfg.flash_sector_size;
-    for (size_t i = 0; i < erase_count; i++) {
-        result = this->erase_sector(start_sector + i);
-        WL_RESULT_CHECK(result);
+    size_t sector = start_address / this->cfg.flash_sector_size;
+    while (erase_count > 0) {
+        // Erases which do not reach the update rate do not move the dummy page, so the mapping stays
+        // the same for all of them and the range can be erased in as few physical runs as possible
+        size_t batch = 0;
+        if (this->state.wl_sec_erase_cycle_count + 1 < this->state.wl_max_sec_erase_cycle_count) {
+            batch = MIN(erase_count, this->state.wl_max_sec_erase_cycle_count - 1 - this->state.wl_sec_erase_cycle_count);
+            this->state.wl_sec_erase_cycle_count += batch;
+        } else {
+            result = this->updateWL();
+            WL_RESULT_CHECK(result);
+            batch = 1;
+        }
+        size_t addr = sector * this->cfg.flash_sector_size;
+        size_t left = batch * this->cfg.flash_sector_size;
+        while (left > 0) {
+            size_t phys_addr;
+            size_t run = this->calcRun(addr, left, &phys_addr);
+            result = this->partition->erase_range(phys_addr, run);
+            WL_RESULT_CHECK(result);
+            addr += run;
+            left -= run;
+        }
+        sector += batch;
+        erase_count -= batch;
     }
     ESP_LOGV(TAG, "%s - result= 0x%08x" , __func__, result);
     return result;
@@ -579,15 +633,16 @@ esp_err_t WL_Flash::write(size_t dest_addr, const void *src, size_t size)
         return ESP_ERR_INVALID_STATE;
     }
     ESP_LOGD(TAG, "%s - dest_addr= 0x%08" PRIx32 ", size= 0x%08" PRIx32 , __func__, (uint32_t) dest_addr, (uint32_t) size);
-    uint32_t count = (size - 1) / this->cfg.wl_page_size;
-    for (size_t i = 0; i < count; i++) {
-        size_t virt_addr = this->calcAddr(dest_addr + i * this->cfg.wl_page_size);
-        result = this->partition->write(this->cfg.wl_partition_start_addr + virt_addr, &((uint8_t *)src)[i * this->cfg.wl_page_size], this->cfg.wl_page_size);
+    const uint8_t *data = (const uint8_t *)src;
+    while (size > 0) {
+        size_t phys_addr;
+        size_t run = this->calcRun(dest_addr, size, &phys_addr);
+        result = this->partition->write(phys_addr, data, run);
         WL_RESULT_CHECK(result);
+        dest_addr += run;
+        data += run;
+        size -= run;
     }
-    size_t virt_addr_last = this->calcAddr(dest_addr + count * this->cfg.wl_page_size);
-    result = this->partition->write(this->cfg.wl_partition_start_addr + virt_addr_last, &((uint8_t *)src)[count * this->cfg.wl_page_size], size - count * this->cfg.wl_page_size);
-    WL_RESULT_CHECK(result);
     return result;
 }
 
@@ -598,16 +653,17 @@ esp_err_t WL_Flash::read(size_t src_addr, void *dest, size_t size)
         return ESP_ERR_INVALID_STATE;
     }
     ESP_LOGD(TAG, "%s - src_addr= 0x%08" PRIx32 ", size= 0x%08" PRIx32 , __func__, (uint32_t) src_addr, (uint32_t) size);
-    uint32_t count = (size - 1) / this->cfg.wl_page_size;
-    for (size_t i = 0; i < count; i++) {
-        size_t virt_addr = this->calcAddr(src_addr + i * this->cfg.wl_page_size);
-        ESP_LOGV(TAG, "%s - real_addr= 0x%08" PRIx32 ", size= 0x%08" PRIx32 , __func__, (uint32_t) (this->cfg.wl_partition_start_addr + virt_addr), (uint32_t) size);
-        result = this->partition->read(this->cfg.wl_partition_start_addr + virt_addr, &((uint8_t *)dest)[i * this->cfg.wl_page_size], this->cfg.wl_page_size);
+    uint8_t *data = (uint8_t *)dest;
+    while (size > 0) {
+        size_t phys_addr;
+        size_t run = this->calcRun(src_addr, size, &phys_addr);
+        ESP_LOGV(TAG, "%s - real_addr= 0x%08" PRIx32 ", size= 0x%08" PRIx32 , __func__, (uint32_t) phys_addr, (uint32_t) run);
+        result = this->partition->read(phys_addr, data, run);
         WL_RESULT_CHECK(result);
+        src_addr += run;
+        data += run;
+        size -= run;
     }
-    size_t virt_addr_last = this->calcAddr(src_addr + count * this->cfg.wl_page_size);
-    result = this->partition->read(this->cfg.wl_partition_start_addr + virt_addr_last, &((uint8_t *)dest)[count * this->cfg.wl_page_size], size - count * this->cfg.wl_page_size);
-    WL_RESULT_CHECK(result);
     return result;
 }
 
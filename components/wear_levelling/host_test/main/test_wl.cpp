@@ -1,11 +1,12 @@
 /*
- * SPDX-FileCopyrightText: 2016-2023 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2016-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "esp_partition.h"
 #include "esp_private/partition_linux.h"
@@ -421,3 +422,75 @@ TEST_CASE("power down between WL status 1 and WL status 2 update", "[wear_levell
 
     free(tmp_state);
 }
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static void print_write_throughput(const char *name, size_t bytes, uint64_t elapsed_us)
+{
+    printf("%-36s %7.1f kB/s, partition ops: %zu write, %zu erase, %zu read, emulated flash time %zu ms\n",
+           name, bytes * 1000.0 / 1024.0 / (elapsed_us ? elapsed_us : 1),
+           esp_partition_get_write_ops(), esp_partition_get_erase_ops(), esp_partition_get_read_ops(),
+           esp_partition_get_total_time());
+}
+
+TEST_CASE("sequential and random write throughput", "[wear_levelling]")
+{
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "storage");
+    wl_handle_t wl_handle;
+    REQUIRE(wl_mount(partition, &wl_handle) == ESP_OK);
+
+    const size_t sector_size = wl_sector_size(wl_handle);
+    const size_t total_size = 256 * 1024;
+    const size_t sectors = total_size / sector_size;
+    REQUIRE(wl_size(wl_handle) >= total_size);
+
+    uint8_t *data = (uint8_t *) malloc(total_size);
+    uint8_t *read = (uint8_t *) malloc(total_size);
+    REQUIRE(data != NULL);
+    REQUIRE(read != NULL);
+    for (size_t i = 0; i < total_size / sizeof(uint32_t); i++) {
+        ((uint32_t *) data)[i] = i * 2654435761u;
+    }
+
+    // One sector at a time, as FATFS writes partial data and metadata
+    esp_partition_clear_stats();
+    uint64_t start = now_us();
+    for (size_t s = 0; s < sectors; s++) {
+        REQUIRE(wl_erase_range(wl_handle, s * sector_size, sector_size) == ESP_OK);
+        REQUIRE(wl_write(wl_handle, s * sector_size, data + s * sector_size, sector_size) == ESP_OK);
+    }
+    print_write_throughput("sequential, sector by sector:", total_size, now_us() - start);
+
+    // Whole range at once, as FATFS writes full clusters of a large file
+    esp_partition_clear_stats();
+    start = now_us();
+    REQUIRE(wl_erase_range(wl_handle, 0, total_size) == ESP_OK);
+    REQUIRE(wl_write(wl_handle, 0, data, total_size) == ESP_OK);
+    print_write_throughput("sequential, whole range:", total_size, now_us() - start);
+
+    REQUIRE(wl_read(wl_handle, 0, read, total_size) == ESP_OK);
+    REQUIRE(memcmp(data, read, total_size) == 0);
+
+    // Random sectors
+    srand(1);
+    esp_partition_clear_stats();
+    start = now_us();
+    for (size_t i = 0; i < sectors; i++) {
+        size_t s = rand() % sectors;
+        REQUIRE(wl_erase_range(wl_handle, s * sector_size, sector_size) == ESP_OK);
+        REQUIRE(wl_write(wl_handle, s * sector_size, data + s * sector_size, sector_size) == ESP_OK);
+    }
+    print_write_throughput("random sectors:", total_size, now_us() - start);
+
+    REQUIRE(wl_read(wl_handle, 0, read, total_size) == ESP_OK);
+    REQUIRE(memcmp(data, read, total_size) == 0);
+
+    REQUIRE(wl_unmount(wl_handle) == ESP_OK);
+    free(data);
+    free(read);
+}
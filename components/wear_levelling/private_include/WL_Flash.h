@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: 2015-2023 Espressif Systems (Shanghai) CO LTD
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
  *
  * SPDX-License-Identifier: Apache-2.0
  */
@@ -56,13 +56,17 @@ protected:
     uint32_t state_size;
     uint32_t cfg_size;
     uint8_t *temp_buff = NULL;
+    uint8_t *page_buff = NULL;  // one page for copyPage(), NULL if it could not be allocated
     size_t dummy_addr;
     uint32_t pos_data[4];
 
     esp_err_t initSections();
     esp_err_t updateWL();
+    esp_err_t copyPage(size_t src_addr, size_t dest_addr);
     esp_err_t recoverPos();
     size_t calcAddr(size_t addr);
+    // Map the logical range [addr, addr + size) to a physical address, return the size of the contiguous part
+    size_t calcRun(size_t addr, size_t size, size_t *out_addr);
 
     esp_err_t updateVersion();
     esp_err_t updateV1_V2();
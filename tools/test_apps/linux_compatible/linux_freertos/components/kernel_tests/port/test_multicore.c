@@ -0,0 +1,153 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "sdkconfig.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "unity.h"
+#include "portTestMacro.h"
+
+#if ( configNUM_CORES > 1 )
+
+/*
+Test that tasks pinned to different cores run in parallel
+
+Purpose:
+    - Test that each simulated core runs its own task at the same time as the other cores
+    - Test that core affinity is honored
+
+Procedure:
+    - Create a task pinned to core 0 and a task pinned to core 1, both at the same priority
+    - The tasks exchange a counter by busy waiting on each other, without ever blocking or yielding
+    - Each task records if it ever runs on another core than the one it is pinned to
+
+Expected:
+    - The exchange completes. With a single running task at a time, the task which busy waits first never gives the
+      other task a chance to make progress on its core.
+    - The tasks always run on the core they are pinned to
+*/
+
+#define PING_PONG_ROUNDS    50
+
+static volatile int ping;
+static volatile int pong;
+static volatile int wrong_core_count;
+static SemaphoreHandle_t ping_pong_done;
+
+static void ping_pong_task(void *arg)
+{
+    const BaseType_t core_id = (BaseType_t) arg;
+
+    for (int round = 1; round <= PING_PONG_ROUNDS; round++) {
+        if (xPortGetCoreID() != core_id) {
+            wrong_core_count++;
+        }
+        if (core_id == 0) {
+            while (ping != round) {
+            }
+            pong = round;
+        } else {
+            ping = round;
+            while (pong != round) {
+            }
+        }
+    }
+
+    xSemaphoreGive(ping_pong_done);
+    vTaskSuspend(NULL);
+}
+
+TEST_CASE("Tasks pinned to different cores run in parallel", "[freertos]")
+{
+    ping_pong_done = xSemaphoreCreateCounting(2, 0);
+    TEST_ASSERT_NOT_NULL(ping_pong_done);
+    TaskHandle_t tasks[2];
+
+    ping = 0;
+    pong = 0;
+    wrong_core_count = 0;
+
+    // Keep the unity task from being preempted while creating the tasks
+    vTaskPrioritySet(NULL, configTEST_UNITY_TASK_PRIORITY + 2);
+    for (BaseType_t i = 0; i < 2; i++) {
+        TEST_ASSERT_EQUAL(pdTRUE, xTaskCreatePinnedToCore(ping_pong_task, "ping_pong", configTEST_DEFAULT_STACK_SIZE,
+                                                          (void *) i, configTEST_UNITY_TASK_PRIORITY + 1, &tasks[i], i));
+    }
+    vTaskPrioritySet(NULL, configTEST_UNITY_TASK_PRIORITY);
+
+    for (int i = 0; i < 2; i++) {
+        TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(ping_pong_done, pdMS_TO_TICKS(10000)));
+    }
+    TEST_ASSERT_EQUAL(PING_PONG_ROUNDS, pong);
+    TEST_ASSERT_EQUAL(0, wrong_core_count);
+
+    for (int i = 0; i < 2; i++) {
+        vTaskDelete(tasks[i]);
+    }
+    vSemaphoreDelete(ping_pong_done);
+}
+
+/*
+Test that spinlocks provide mutual exclusion between cores
+
+Purpose:
+    - Test that IDF style critical sections taken on different cores exclude each other
+
+Procedure:
+    - Create a task on each core, which increments a shared counter inside a critical section many times
+    - The counter is read and written with separate accesses, so lost updates show up if both cores are in the
+      critical section at the same time
+
+Expected:
+    - The counter equals the total number of increments
+*/
+
+#define CRIT_INCREMENTS     10000
+
+static portMUX_TYPE crit_mux = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint32_t crit_counter;
+
+static void crit_task(void *arg)
+{
+    SemaphoreHandle_t done_sem = (SemaphoreHandle_t) arg;
+
+    for (int i = 0; i < CRIT_INCREMENTS; i++) {
+        portENTER_CRITICAL(&crit_mux);
+        uint32_t value = crit_counter;
+        crit_counter = value + 1;
+        portEXIT_CRITICAL(&crit_mux);
+    }
+
+    xSemaphoreGive(done_sem);
+    vTaskSuspend(NULL);
+}
+
+TEST_CASE("Spinlocks provide mutual exclusion between cores", "[freertos]")
+{
+    SemaphoreHandle_t done_sem = xSemaphoreCreateCounting(configNUM_CORES, 0);
+    TEST_ASSERT_NOT_NULL(done_sem);
+    TaskHandle_t tasks[configNUM_CORES];
+
+    crit_counter = 0;
+    for (int i = 0; i < configNUM_CORES; i++) {
+        TEST_ASSERT_EQUAL(pdTRUE, xTaskCreatePinnedToCore(crit_task, "crit", configTEST_DEFAULT_STACK_SIZE, done_sem,
+                                                          configTEST_UNITY_TASK_PRIORITY - 1, &tasks[i], i));
+    }
+
+    for (int i = 0; i < configNUM_CORES; i++) {
+        TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(done_sem, pdMS_TO_TICKS(10000)));
+    }
+    TEST_ASSERT_EQUAL(configNUM_CORES * CRIT_INCREMENTS, crit_counter);
+
+    for (int i = 0; i < configNUM_CORES; i++) {
+        vTaskDelete(tasks[i]);
+    }
+    vSemaphoreDelete(done_sem);
+}
+
+#endif // configNUM_CORES > 1
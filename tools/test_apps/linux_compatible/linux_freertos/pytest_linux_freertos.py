@@ -6,6 +6,14 @@ from pytest_embedded_idf.utils import idf_parametrize
 
 
 @pytest.mark.host_test
+@pytest.mark.parametrize(
+    'config',
+    [
+        'default',
+        'dual_core',
+    ],
+    indirect=True,
+)
 @idf_parametrize('target', ['linux'], indirect=['target'])
 def test_linux_freertos_SMP(dut: Dut) -> None:
     dut.expect_exact('Press ENTER to see the list of tests.')
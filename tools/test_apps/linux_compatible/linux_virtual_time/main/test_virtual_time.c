@@ -0,0 +1,267 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/timers.h"
+#include "unity.h"
+
+static int64_t wall_time_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*
+Test that a long vTaskDelay() does not take real time
+
+Procedure:
+    - vTaskDelay() for 30 seconds
+Expected:
+    - Exactly 30 seconds worth of ticks have elapsed
+    - Far less than 30 seconds of real time have elapsed
+*/
+#define TEST_LONG_DELAY_MS      30000
+
+TEST_CASE("Virtual time: long vTaskDelay completes without waiting", "[freertos][virtual_time]")
+{
+    // Align to a tick boundary
+    vTaskDelay(1);
+
+    TickType_t tick_start = xTaskGetTickCount();
+    int64_t wall_start = wall_time_us();
+    vTaskDelay(pdMS_TO_TICKS(TEST_LONG_DELAY_MS));
+    int64_t wall_elapsed = wall_time_us() - wall_start;
+    TickType_t ticks_elapsed = xTaskGetTickCount() - tick_start;
+
+    printf("%d ms of FreeRTOS time took %lld us, speedup x%lld\n", TEST_LONG_DELAY_MS,
+           (long long) wall_elapsed, (long long) TEST_LONG_DELAY_MS * 1000 / (wall_elapsed + 1));
+    // The delayed task unblocks at the exact tick, unless real ticks arrived in the meantime
+    TEST_ASSERT_UINT32_WITHIN(2, pdMS_TO_TICKS(TEST_LONG_DELAY_MS), ticks_elapsed);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(pdMS_TO_TICKS(TEST_LONG_DELAY_MS), ticks_elapsed);
+    TEST_ASSERT_LESS_THAN(TEST_LONG_DELAY_MS / 10, (int) (wall_elapsed / 1000));
+}
+
+/*
+Test that tasks and timers wake up in the same order and at the same ticks as with the periodic tick
+
+Procedure:
+    - Create TEST_ORDER_NUM_TASKS tasks of different priorities. Task n wakes up every (n + 2) * TEST_ORDER_PERIOD_TICKS
+      ticks using vTaskDelayUntil(), and logs an event with its wake up tick.
+    - Start an auto-reload software timer which logs an event every TEST_ORDER_TIMER_TICKS ticks, and a task that
+      blocks on a queue with a timeout of TEST_ORDER_QUEUE_TIMEOUT_TICKS
+    - Everything is started at the same tick. Several events are due at the same tick (e.g. all of them at 60 seconds).
+    - Wait until all tasks are done
+Expected:
+    - Each event happens at exactly the tick count it would happen at with the periodic tick
+    - The events are logged in the order of their ticks, and in order of priority for events of the same tick. This
+      is the order in which the kernel would run the tasks with the periodic tick.
+*/
+#define TEST_ORDER_NUM_TASKS            2
+#define TEST_ORDER_ITERATIONS           4
+#define TEST_ORDER_PERIOD_TICKS         pdMS_TO_TICKS(10000)
+#define TEST_ORDER_TIMER_TICKS          pdMS_TO_TICKS(30000)
+#define TEST_ORDER_TIMER_ITERATIONS     3
+#define TEST_ORDER_QUEUE_TIMEOUT_TICKS  pdMS_TO_TICKS(60000)
+#define TEST_ORDER_PRIORITY             (configTIMER_TASK_PRIORITY + 1)     // Priority of task 0
+#define TEST_ORDER_MAX_EVENTS           (TEST_ORDER_NUM_TASKS * TEST_ORDER_ITERATIONS + TEST_ORDER_TIMER_ITERATIONS + 1)
+#define TEST_ORDER_ID_TIMER             TEST_ORDER_NUM_TASKS
+#define TEST_ORDER_ID_QUEUE             (TEST_ORDER_NUM_TASKS + 1)
+
+typedef struct {
+    TickType_t offset;  // ticks since the start of the test
+    int id;
+    UBaseType_t priority;
+} order_event_t;
+
+typedef struct {
+    TickType_t start;
+    order_event_t events[TEST_ORDER_MAX_EVENTS];
+    int num_events;
+    int timer_count;
+    BaseType_t queue_result;
+    SemaphoreHandle_t done;
+} order_ctx_t;
+
+static order_ctx_t *s_order_ctx;
+
+static void log_event(order_ctx_t *ctx, int id, UBaseType_t priority)
+{
+    // Checked by the test task, Unity asserts only work in the test task
+    if (ctx->num_events == TEST_ORDER_MAX_EVENTS) {
+        return;
+    }
+    ctx->events[ctx->num_events++] = (order_event_t) {
+        .offset = xTaskGetTickCount() - ctx->start,
+        .id = id,
+        .priority = priority,
+    };
+}
+
+static void order_task(void *arg)
+{
+    int id = (int) (intptr_t) arg;
+    TickType_t last_wake = s_order_ctx->start;
+
+    for (int i = 0; i < TEST_ORDER_ITERATIONS; i++) {
+        vTaskDelayUntil(&last_wake, (id + 2) * TEST_ORDER_PERIOD_TICKS);
+        log_event(s_order_ctx, id, uxTaskPriorityGet(NULL));
+    }
+    xSemaphoreGive(s_order_ctx->done);
+    vTaskSuspend(NULL);
+}
+
+static void order_queue_task(void *arg)
+{
+    QueueHandle_t queue = (QueueHandle_t) arg;
+    uint32_t item;
+
+    s_order_ctx->queue_result = xQueueReceive(queue, &item, TEST_ORDER_QUEUE_TIMEOUT_TICKS);
+    log_event(s_order_ctx, TEST_ORDER_ID_QUEUE, uxTaskPriorityGet(NULL));
+    xSemaphoreGive(s_order_ctx->done);
+    vTaskSuspend(NULL);
+}
+
+static void order_timer_cb(TimerHandle_t timer)
+{
+    log_event(s_order_ctx, TEST_ORDER_ID_TIMER, configTIMER_TASK_PRIORITY);
+    if (++s_order_ctx->timer_count == TEST_ORDER_TIMER_ITERATIONS) {
+        xTimerStop(timer, 0);
+        xSemaphoreGive(s_order_ctx->done);
+    }
+}
+
+static TickType_t expected_offset(int id, int iteration)
+{
+    if (id == TEST_ORDER_ID_TIMER) {
+        return (iteration + 1) * TEST_ORDER_TIMER_TICKS;
+    }
+    if (id == TEST_ORDER_ID_QUEUE) {
+        return TEST_ORDER_QUEUE_TIMEOUT_TICKS;
+    }
+    return (iteration + 1) * (id + 2) * TEST_ORDER_PERIOD_TICKS;
+}
+
+TEST_CASE("Virtual time: tasks and timers wake up in tick order", "[freertos][virtual_time]")
+{
+    order_ctx_t *ctx = calloc(1, sizeof(order_ctx_t));
+    TEST_ASSERT_NOT_NULL(ctx);
+    ctx->done = xSemaphoreCreateCounting(TEST_ORDER_NUM_TASKS + 2, 0);
+    TEST_ASSERT_NOT_NULL(ctx->done);
+    QueueHandle_t queue = xQueueCreate(1, sizeof(uint32_t));
+    TEST_ASSERT_NOT_NULL(queue);
+    TimerHandle_t timer = xTimerCreate("vt_timer", TEST_ORDER_TIMER_TICKS, pdTRUE, NULL, order_timer_cb);
+    TEST_ASSERT_NOT_NULL(timer);
+    s_order_ctx = ctx;
+
+    // Distinct priorities above the timer task and below the test task
+    TEST_ASSERT_LESS_THAN(uxTaskPriorityGet(NULL), TEST_ORDER_PRIORITY + TEST_ORDER_NUM_TASKS);
+    TaskHandle_t tasks[TEST_ORDER_NUM_TASKS + 1];
+    for (int i = 0; i < TEST_ORDER_NUM_TASKS; i++) {
+        TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(order_task, "vt_order", 4096, (void *) (intptr_t) i, TEST_ORDER_PRIORITY + i, &tasks[i]));
+        vTaskSuspend(tasks[i]);
+    }
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(order_queue_task, "vt_queue", 4096, queue, TEST_ORDER_PRIORITY + TEST_ORDER_NUM_TASKS, &tasks[TEST_ORDER_NUM_TASKS]));
+    vTaskSuspend(tasks[TEST_ORDER_NUM_TASKS]);
+
+    // Suspend the scheduler so that everything starts at the same tick
+    vTaskSuspendAll();
+    ctx->start = xTaskGetTickCount();
+    // The timer period starts at the tick of this call
+    TEST_ASSERT_EQUAL(pdPASS, xTimerStart(timer, 0));
+    for (int i = 0; i < TEST_ORDER_NUM_TASKS + 1; i++) {
+        vTaskResume(tasks[i]);
+    }
+    xTaskResumeAll();
+
+    int64_t wall_start = wall_time_us();
+    for (int i = 0; i < TEST_ORDER_NUM_TASKS + 2; i++) {
+        TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(ctx->done, portMAX_DELAY));
+    }
+    int64_t wall_elapsed = wall_time_us() - wall_start;
+    TickType_t ticks_elapsed = xTaskGetTickCount() - ctx->start;
+    printf("%lu ticks of FreeRTOS time took %lld us\n", (unsigned long) ticks_elapsed, (long long) wall_elapsed);
+
+    TEST_ASSERT_EQUAL(pdFALSE, ctx->queue_result);
+    int iterations[TEST_ORDER_NUM_TASKS + 2] = { 0 };
+    TEST_ASSERT_EQUAL(TEST_ORDER_MAX_EVENTS, ctx->num_events);
+    for (int i = 0; i < ctx->num_events; i++) {
+        const order_event_t *event = &ctx->events[i];
+        printf("tick %5lu: %d\n", (unsigned long) event->offset, event->id);
+        TEST_ASSERT_EQUAL(expected_offset(event->id, iterations[event->id]++), event->offset);
+        if (i > 0) {
+            const order_event_t *prev = &ctx->events[i - 1];
+            TEST_ASSERT_GREATER_OR_EQUAL_UINT32(prev->offset, event->offset);
+            if (prev->offset == event->offset) {
+                TEST_ASSERT_GREATER_THAN(event->priority, prev->priority);
+            }
+        }
+    }
+    TEST_ASSERT_LESS_THAN(pdTICKS_TO_MS(ticks_elapsed) / 10, (int) (wall_elapsed / 1000));
+
+    for (int i = 0; i < TEST_ORDER_NUM_TASKS + 1; i++) {
+        vTaskDelete(tasks[i]);
+    }
+    TEST_ASSERT_EQUAL(pdPASS, xTimerDelete(timer, portMAX_DELAY));
+    vQueueDelete(queue);
+    vSemaphoreDelete(ctx->done);
+    s_order_ctx = NULL;
+    free(ctx);
+    // Give the idle task a chance to free the deleted tasks
+    vTaskDelay(1);
+}
+
+/*
+Test that time is not advanced while a task is ready to run
+
+Procedure:
+    - Create a task of idle priority which busy-waits TEST_BUSY_WAIT_US of real time, then records the ticks elapsed.
+      The task shares the CPU with the idle task, which must not advance the time while the task is ready.
+    - The test task meanwhile delays for TEST_BUSY_DELAY_TICKS
+Expected:
+    - While the busy task runs, only the real ticks elapse
+    - The test task still wakes up after exactly TEST_BUSY_DELAY_TICKS
+*/
+#define TEST_BUSY_WAIT_US       100000
+#define TEST_BUSY_DELAY_TICKS   pdMS_TO_TICKS(10000)
+
+static void busy_task(void *arg)
+{
+    TickType_t *ticks_elapsed = (TickType_t *) arg;
+    TickType_t tick_start = xTaskGetTickCount();
+    int64_t wall_start = wall_time_us();
+
+    while (wall_time_us() - wall_start < TEST_BUSY_WAIT_US) {
+    }
+    *ticks_elapsed = xTaskGetTickCount() - tick_start;
+    vTaskSuspend(NULL);
+}
+
+TEST_CASE("Virtual time: time does not jump while a task is ready", "[freertos][virtual_time]")
+{
+    TickType_t busy_ticks = portMAX_DELAY;
+    TaskHandle_t task;
+
+    vTaskDelay(1);
+    TickType_t tick_start = xTaskGetTickCount();
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(busy_task, "vt_busy", 4096, &busy_ticks, tskIDLE_PRIORITY, &task));
+    vTaskDelay(TEST_BUSY_DELAY_TICKS);
+    TickType_t ticks_elapsed = xTaskGetTickCount() - tick_start;
+
+    TEST_ASSERT_NOT_EQUAL(portMAX_DELAY, busy_ticks);
+    // Only real ticks have elapsed, with some margin
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(pdMS_TO_TICKS(TEST_BUSY_WAIT_US / 1000) * 2, busy_ticks);
+    TEST_ASSERT_UINT32_WITHIN(2, TEST_BUSY_DELAY_TICKS, ticks_elapsed);
+    vTaskDelete(task);
+    vTaskDelay(1);
+}
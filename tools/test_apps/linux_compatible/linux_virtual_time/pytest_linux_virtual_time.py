@@ -0,0 +1,14 @@
+# SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: Apache-2.0
+import pytest
+from pytest_embedded import Dut
+from pytest_embedded_idf.utils import idf_parametrize
+
+
+@pytest.mark.host_test
+@idf_parametrize('target', ['linux'], indirect=['target'])
+def test_linux_virtual_time(dut: Dut) -> None:
+    dut.expect_exact('Press ENTER to see the list of tests.')
+    dut.write('![ignore]')
+    # The tests delay for several minutes of FreeRTOS time
+    dut.expect(r'\d+ Tests 0 Failures 0 Ignored', timeout=30)